@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace TinaToolBox {
+    // 任务被取消或超过截止时间时，通过 future 抛出的异常
+    class TaskCancelledException : public std::runtime_error {
+    public:
+        TaskCancelledException() : std::runtime_error("Task was cancelled") {
+        }
+
+        explicit TaskCancelledException(const std::string &message) : std::runtime_error(message) {
+        }
+    };
+
+    // 协作式取消令牌（只读端）。默认构造的令牌永远不会被取消。
+    // 令牌可以随意拷贝，所有拷贝共享同一个取消标志。
+    class CancellationToken {
+    public:
+        CancellationToken() = default;
+
+        [[nodiscard]] bool isCancelled() const {
+            return flag_ && flag_->load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] bool canBeCancelled() const { return flag_ != nullptr; }
+
+        void throwIfCancelled() const {
+            if (isCancelled()) {
+                throw TaskCancelledException();
+            }
+        }
+
+    private:
+        friend class CancellationSource;
+
+        explicit CancellationToken(std::shared_ptr<const std::atomic_bool> flag) : flag_(std::move(flag)) {
+        }
+
+        std::shared_ptr<const std::atomic_bool> flag_;
+    };
+
+    // 取消令牌的控制端：cancel() 只是翻转一个原子标志，O(1) 完成。
+    // 排队中的任务在出队时被直接丢弃，正在运行的任务需要自行检查令牌。
+    class CancellationSource {
+    public:
+        CancellationSource() : flag_(std::make_shared<std::atomic_bool>(false)) {
+        }
+
+        [[nodiscard]] CancellationToken token() const {
+            return CancellationToken(flag_);
+        }
+
+        void cancel() {
+            flag_->store(true, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool isCancelled() const {
+            return flag_->load(std::memory_order_acquire);
+        }
+
+    private:
+        std::shared_ptr<std::atomic_bool> flag_;
+    };
+} // namespace TinaToolBox
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <arrow/api.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace TinaToolBox {
+    // DataFrame 分组和连接共用的键哈希：直接读取 Arrow 缓冲区，不把值转换成字符串或 Scalar
+    namespace ColumnHash {
+        constexpr std::uint64_t SEED = 0x9E3779B97F4A7C15ULL;
+        constexpr std::uint64_t NULL_HASH = 0x5BD1E9955BD1E995ULL;
+
+        // splitmix64 的终结步骤，让低位（哈希表槽位）和高位（分区）都足够均匀
+        inline std::uint64_t mix(std::uint64_t h) {
+            h ^= h >> 30;
+            h *= 0xBF58476D1CE4E5B9ULL;
+            h ^= h >> 27;
+            h *= 0x94D049BB133111EBULL;
+            h ^= h >> 31;
+            return h;
+        }
+
+        inline std::uint64_t combine(std::uint64_t seed, std::uint64_t value) {
+            return mix(seed ^ (value + SEED + (seed << 6) + (seed >> 2)));
+        }
+
+        // 按数组的具体类型调用 fn(typed_array)，不支持的类型返回 false
+        template<typename Fn>
+        bool visitArray(const arrow::Array &array, Fn &&fn) {
+            switch (array.type_id()) {
+                case arrow::Type::BOOL: fn(static_cast<const arrow::BooleanArray &>(array)); return true;
+                case arrow::Type::INT8: fn(static_cast<const arrow::Int8Array &>(array)); return true;
+                case arrow::Type::INT16: fn(static_cast<const arrow::Int16Array &>(array)); return true;
+                case arrow::Type::INT32: fn(static_cast<const arrow::Int32Array &>(array)); return true;
+                case arrow::Type::INT64: fn(static_cast<const arrow::Int64Array &>(array)); return true;
+                case arrow::Type::UINT8: fn(static_cast<const arrow::UInt8Array &>(array)); return true;
+                case arrow::Type::UINT16: fn(static_cast<const arrow::UInt16Array &>(array)); return true;
+                case arrow::Type::UINT32: fn(static_cast<const arrow::UInt32Array &>(array)); return true;
+                case arrow::Type::UINT64: fn(static_cast<const arrow::UInt64Array &>(array)); return true;
+                case arrow::Type::FLOAT: fn(static_cast<const arrow::FloatArray &>(array)); return true;
+                case arrow::Type::DOUBLE: fn(static_cast<const arrow::DoubleArray &>(array)); return true;
+                case arrow::Type::STRING: fn(static_cast<const arrow::StringArray &>(array)); return true;
+                case arrow::Type::LARGE_STRING: fn(static_cast<const arrow::LargeStringArray &>(array)); return true;
+                case arrow::Type::DATE32: fn(static_cast<const arrow::Date32Array &>(array)); return true;
+                case arrow::Type::DATE64: fn(static_cast<const arrow::Date64Array &>(array)); return true;
+                case arrow::Type::TIMESTAMP: fn(static_cast<const arrow::TimestampArray &>(array)); return true;
+                case arrow::Type::TIME32: fn(static_cast<const arrow::Time32Array &>(array)); return true;
+                case arrow::Type::TIME64: fn(static_cast<const arrow::Time64Array &>(array)); return true;
+                case arrow::Type::DURATION: fn(static_cast<const arrow::DurationArray &>(array)); return true;
+                default: return false;
+            }
+        }
+
+        template<typename ArrayType>
+        using ValueType = decltype(std::declval<const ArrayType &>().GetView(0));
+
+        // 一列值的哈希和相等比较。空值与空值相等，浮点数 -0.0 与 0.0 相等、所有 NaN 相等
+        class HashColumn {
+        public:
+            virtual ~HashColumn() = default;
+
+            // 把 [begin, end) 行的哈希组合进 hashes[0, end - begin)
+            virtual void hash(int64_t begin, int64_t end, std::uint64_t *hashes) const = 0;
+
+            virtual std::uint64_t hash(int64_t row) const = 0;
+
+            virtual bool equal(int64_t a, int64_t b) const = 0;
+
+            // 与另一列的某行比较，other 必须由同一类型的数组创建
+            virtual bool equal(int64_t row, const HashColumn &other, int64_t other_row) const = 0;
+
+            virtual bool isNull(int64_t row) const = 0;
+        };
+
+        template<typename ArrayType>
+        class TypedHashColumn final : public HashColumn {
+        public:
+            explicit TypedHashColumn(const arrow::Array &array) : array_(static_cast<const ArrayType &>(array)) {}
+
+            void hash(int64_t begin, int64_t end, std::uint64_t *hashes) const override {
+                for (int64_t row = begin; row < end; ++row) {
+                    hashes[row - begin] = combine(hashes[row - begin], hash(row));
+                }
+            }
+
+            std::uint64_t hash(int64_t row) const override {
+                return array_.IsNull(row) ? NULL_HASH : valueHash(array_.GetView(row));
+            }
+
+            bool equal(int64_t a, int64_t b) const override {
+                return equalRows(array_, a, array_, b);
+            }
+
+            bool equal(int64_t row, const HashColumn &other, int64_t other_row) const override {
+                return equalRows(array_, row, static_cast<const TypedHashColumn &>(other).array_, other_row);
+            }
+
+            bool isNull(int64_t row) const override { return array_.IsNull(row); }
+
+        private:
+            static bool equalRows(const ArrayType &left, int64_t a, const ArrayType &right, int64_t b) {
+                const bool null_a = left.IsNull(a);
+                const bool null_b = right.IsNull(b);
+                if (null_a || null_b) {
+                    return null_a == null_b;
+                }
+                const auto value_a = left.GetView(a);
+                const auto value_b = right.GetView(b);
+                if constexpr (std::is_floating_point_v<decltype(value_a)>) {
+                    return value_a == value_b || (std::isnan(value_a) && std::isnan(value_b));
+                } else {
+                    return value_a == value_b;
+                }
+            }
+
+            template<typename T>
+            static std::uint64_t valueHash(T value) {
+                if constexpr (std::is_same_v<T, std::string_view>) {
+                    return std::hash<std::string_view>{}(value);
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    double normalized = static_cast<double>(value);
+                    if (std::isnan(normalized)) {
+                        normalized = std::numeric_limits<double>::quiet_NaN();
+                    } else if (normalized == 0.0) {
+                        normalized = 0.0;
+                    }
+                    std::uint64_t bits;
+                    std::memcpy(&bits, &normalized, sizeof(bits));
+                    return mix(bits);
+                } else {
+                    return mix(static_cast<std::uint64_t>(value));
+                }
+            }
+
+            const ArrayType &array_;
+        };
+
+        // 不支持的类型返回空指针。字典列按编码比较，两列比较时调用方需保证它们共用同一个字典；
+        // 返回的对象引用 array，使用期间 array 必须有效
+        std::unique_ptr<HashColumn> makeHashColumn(const arrow::Array &array);
+
+        // 把一列合并为连续数组；字典列先统一各分块的字典，使编码可以直接比较
+        arrow::Result<std::shared_ptr<arrow::Array>> contiguous(std::shared_ptr<arrow::ChunkedArray> column);
+
+        // 开放寻址（线性探测）哈希表，只保存编号。槽中保存哈希的一部分作为标记，标记相同时才调用 equal 逐列比较，
+        // 探测过程只访问连续的 8 字节槽位
+        class HashTable {
+        public:
+            explicit HashTable(size_t expected) {
+                size_t capacity = 16;
+                while (capacity < expected * 2) {
+                    capacity <<= 1;
+                }
+                slots_.assign(capacity, Slot{});
+                mask_ = capacity - 1;
+            }
+
+            // 返回 (编号, 是否新插入)。编号从 0 开始按插入顺序递增
+            template<typename Equal>
+            std::pair<std::uint32_t, bool> findOrInsert(std::uint64_t hash, Equal &&equal) {
+                const auto tag = tagOf(hash);
+                for (size_t index = hash & mask_;; index = (index + 1) & mask_) {
+                    Slot &slot = slots_[index];
+                    if (slot.id == 0) {
+                        if ((hashes_.size() + 1) * 2 > slots_.size()) {
+                            grow();
+                            return findOrInsert(hash, equal);
+                        }
+                        hashes_.push_back(hash);
+                        slot.tag = tag;
+                        slot.id = static_cast<std::uint32_t>(hashes_.size());
+                        return {slot.id - 1, true};
+                    }
+                    if (slot.tag == tag && equal(slot.id - 1)) {
+                        return {slot.id - 1, false};
+                    }
+                }
+            }
+
+            // 只查找不插入，可以在多个线程中同时调用；没有找到时返回 -1
+            template<typename Equal>
+            int64_t find(std::uint64_t hash, Equal &&equal) const {
+                const auto tag = tagOf(hash);
+                for (size_t index = hash & mask_;; index = (index + 1) & mask_) {
+                    const Slot &slot = slots_[index];
+                    if (slot.id == 0) {
+                        return -1;
+                    }
+                    if (slot.tag == tag && equal(slot.id - 1)) {
+                        return slot.id - 1;
+                    }
+                }
+            }
+
+            [[nodiscard]] size_t size() const { return hashes_.size(); }
+
+        private:
+            struct Slot {
+                std::uint32_t tag = 0;
+                // 编号 + 1，0 表示空槽
+                std::uint32_t id = 0;
+            };
+
+            static std::uint32_t tagOf(std::uint64_t hash) { return static_cast<std::uint32_t>(hash >> 20); }
+
+            void grow() {
+                std::vector<Slot> slots(slots_.size() * 2);
+                const size_t mask = slots.size() - 1;
+                for (size_t id = 0; id < hashes_.size(); ++id) {
+                    size_t index = hashes_[id] & mask;
+                    while (slots[index].id != 0) {
+                        index = (index + 1) & mask;
+                    }
+                    slots[index].tag = tagOf(hashes_[id]);
+                    slots[index].id = static_cast<std::uint32_t>(id + 1);
+                }
+                slots_ = std::move(slots);
+                mask_ = mask;
+            }
+
+            std::vector<Slot> slots_;
+            size_t mask_ = 0;
+            std::vector<std::uint64_t> hashes_;
+        };
+    }
+} // namespace TinaToolBox
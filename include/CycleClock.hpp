@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TTB_CYCLE_CLOCK_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define TTB_CYCLE_CLOCK_TSC 1
+#endif
+
+namespace TinaToolBox {
+    // 低开销的单调时钟，用于每个任务都要打点的遥测。
+    // x86 上直接读取 TSC（几纳秒），其余平台退化为 steady_clock（tick 即纳秒）。
+    // 某些虚拟机上 steady_clock::now() 要几十纳秒，每个任务打三次点会明显拖慢小任务。
+    class CycleClock {
+    public:
+        static std::uint64_t now() {
+#ifdef TTB_CYCLE_CLOCK_TSC
+            return __rdtsc();
+#else
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        // 每个 tick 对应的纳秒数，首次调用时对照 steady_clock 校准（约 2ms），之后直接返回
+        static double nanosecondsPerTick() {
+            static const double ratio = calibrate();
+            return ratio;
+        }
+
+    private:
+        static double calibrate() {
+#ifdef TTB_CYCLE_CLOCK_TSC
+            using Clock = std::chrono::steady_clock;
+            const auto wall_start = Clock::now();
+            const auto ticks_start = now();
+            while (Clock::now() - wall_start < std::chrono::milliseconds(2)) {
+            }
+            const auto ticks = now() - ticks_start;
+            const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - wall_start).count();
+            return ticks > 0 ? static_cast<double>(wall) / static_cast<double>(ticks) : 1.0;
+#else
+            return 1.0;
+#endif
+        }
+    };
+} // namespace TinaToolBox
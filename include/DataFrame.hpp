@@ -1,7 +1,14 @@
 #pragma once
 
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <variant>
 #include <arrow/compute/api.h>
@@ -14,16 +21,213 @@
 #include <thread>
 #include <mutex>
 #include <ThreadPool.hpp>
+#include <ThreadPoolGroup.hpp>
 
 
 namespace TinaToolBox {
     
+    // 列式文件（Parquet / Feather）的压缩算法；Feather 只支持 LZ4 和 ZSTD
+    enum class ColumnarCompression { None, Snappy, LZ4, ZSTD };
+
+    struct ColumnarWriteOptions {
+        ColumnarCompression compression = ColumnarCompression::ZSTD;
+        // 压缩级别，0 表示使用算法的默认级别
+        int compression_level = 0;
+        // Parquet 行组 / Feather 记录批次的行数，也是读取 Parquet 时按条件跳过数据的粒度
+        std::int64_t row_group_size = 128 * 1024;
+    };
+
+    struct CsvReadOptions {
+        // 分隔符，TSV 使用 '\t'
+        char delimiter = ',';
+        // 文件编码（如 "GBK"、"GB18030"），为空时由 EncodingDetector 按文件开头检测；非 UTF-8 文件边读边转码
+        std::string encoding;
+        // 第一行是否为列名，否则列名为 f0、f1……
+        bool has_header = true;
+        // 指定部分列的类型，其余列自动推断
+        std::unordered_map<std::string, std::shared_ptr<arrow::DataType>> column_types;
+        // 只读取这些列（按给出的顺序），为空时读取全部
+        std::vector<std::string> columns;
+        // 每个解析块的字节数，各块在 Arrow 的线程池上并行解析
+        std::int32_t block_size = 4 << 20;
+    };
+
+    struct CsvWriteOptions {
+        char delimiter = ',';
+        // 输出编码，为空或 "UTF-8" 时不转码；目标编码无法表示的字符由 QTextCodec 替换为 ?
+        std::string encoding;
+        // UTF-8 输出时在开头写入 BOM，Excel 据此识别编码
+        bool utf8_bom = false;
+        bool include_header = true;
+        // 每批写出的行数
+        std::int32_t batch_rows = 64 * 1024;
+    };
+
+    // 与 DataFrame::filter() 相同的比较条件
+    struct ColumnFilter {
+        std::string column;
+        std::shared_ptr<arrow::Scalar> value;
+        std::string comparison_operator = "equal";
+    };
+
+    struct ColumnarReadOptions {
+        // 只读取这些列（按给出的顺序），为空时读取全部
+        std::vector<std::string> columns;
+        // 只保留同时满足所有条件的行，条件中的列不必出现在 columns 中。
+        // Parquet 先用各行组的 min/max 统计跳过不可能满足条件的行组，不会读取和解压；
+        // Feather 没有统计信息，读取后再过滤
+        std::vector<ColumnFilter> filters;
+    };
+
+    // DataFrame::filter(Expression) 的条件构造函数，多个条件用 arrow::compute::and_ / or_ / not_ 组合
+    namespace Predicate {
+        using arrow::compute::Expression;
+
+        Expression column(const std::string &name);
+
+        // comparison 为 equal / not_equal / greater / greater_equal / less / less_equal
+        Expression compare(const std::string &column, const std::string &comparison,
+                           std::shared_ptr<arrow::Scalar> value);
+
+        // 值在 values 中；values 里的空值可以匹配空单元格
+        Expression isIn(const std::string &column, std::shared_ptr<arrow::Array> values);
+
+        // lower <= 值 <= upper
+        Expression between(const std::string &column, std::shared_ptr<arrow::Scalar> lower,
+                           std::shared_ptr<arrow::Scalar> upper);
+
+        // 文本包含 pattern
+        Expression contains(const std::string &column, const std::string &pattern, bool ignore_case = false);
+
+        // 文本中有与 RE2 正则表达式 regex 匹配的部分；需要完整匹配时使用 ^...$
+        Expression matches(const std::string &column, const std::string &regex, bool ignore_case = false);
+
+        Expression isNull(const std::string &column);
+
+        Expression isValid(const std::string &column);
+    }
+
+    // Inner：只保留两边都有的键；Left：保留左表所有行，没有匹配的右侧列为空值；
+    // Semi / Anti：只返回左表中有 / 没有匹配的行，不添加右表的列
+    enum class JoinType { Inner, Left, Semi, Anti };
+
+    class GroupBy;
+    class LazyFrame;
+    class DataFrame;
+
+    // 按行号读取一列，由 DataFrame::columnAccessor<T>() 创建：列名和类型只解析一次。
+    // 随机访问在 DataFrame 缓存的分块起始行号上二分查找（O(log 分块数)），落在当前分块内时直接读取，
+    // 顺序扫描均摊 O(1)。T 为 int64_t、double、bool、std::string 或 std::string_view（字符串列和字符串字典列，
+    // 视图在列数据存活期间有效）。访问器记录当前分块，不能在多个线程间共享
+    template<typename T>
+    class ColumnAccessor {
+    public:
+        [[nodiscard]] int64_t length() const { return offsets_->back(); }
+
+        // 调用方保证 0 <= row < length()
+        [[nodiscard]] bool isNull(int64_t row) const {
+            const int64_t offset = locate(row);
+            return array_->IsNull(offset);
+        }
+
+        // 调用方保证 0 <= row < length() 且该行不为空值
+        [[nodiscard]] T value(int64_t row) const {
+            const int64_t offset = locate(row);
+            if constexpr (std::is_same_v<T, int64_t>) {
+                return static_cast<const arrow::Int64Array *>(array_)->Value(offset);
+            } else if constexpr (std::is_same_v<T, double>) {
+                return static_cast<const arrow::DoubleArray *>(array_)->Value(offset);
+            } else if constexpr (std::is_same_v<T, bool>) {
+                return static_cast<const arrow::BooleanArray *>(array_)->Value(offset);
+            } else {
+                return T(stringView(offset));
+            }
+        }
+
+        // 越界或空值时返回 std::nullopt
+        [[nodiscard]] std::optional<T> get(int64_t row) const {
+            if (row < 0 || row >= length() || isNull(row)) {
+                return std::nullopt;
+            }
+            return value(row);
+        }
+
+    private:
+        friend class DataFrame;
+
+        ColumnAccessor(std::shared_ptr<arrow::ChunkedArray> column, std::shared_ptr<const std::vector<int64_t>> offsets)
+            : column_(std::move(column)), offsets_(std::move(offsets)) {}
+
+        // 返回 row 在所在分块中的偏移
+        int64_t locate(int64_t row) const {
+            if (row < begin_ || row >= end_) {
+                // 第一个起始行号大于 row 的分块的前一个；空分块的起始行号与下一块相同，会被跳过
+                const auto next = std::upper_bound(offsets_->begin(), offsets_->end(), row);
+                const auto chunk = static_cast<int>(next - offsets_->begin()) - 1;
+                begin_ = (*offsets_)[chunk];
+                end_ = (*offsets_)[chunk + 1];
+                array_ = column_->chunk(chunk).get();
+                if (array_->type_id() == arrow::Type::DICTIONARY) {
+                    dictionary_ = static_cast<const arrow::DictionaryArray *>(array_)->dictionary().get();
+                }
+            }
+            return row - begin_;
+        }
+
+        std::string_view stringView(int64_t offset) const {
+            switch (array_->type_id()) {
+                case arrow::Type::DICTIONARY: {
+                    const auto index = static_cast<const arrow::DictionaryArray *>(array_)->GetValueIndex(offset);
+                    return static_cast<const arrow::StringArray *>(dictionary_)->GetView(index);
+                }
+                case arrow::Type::LARGE_STRING:
+                    return static_cast<const arrow::LargeStringArray *>(array_)->GetView(offset);
+                default:
+                    return static_cast<const arrow::StringArray *>(array_)->GetView(offset);
+            }
+        }
+
+        std::shared_ptr<arrow::ChunkedArray> column_;
+        // offsets_[i] 为第 i 个分块的起始行号，最后一项为总行数
+        std::shared_ptr<const std::vector<int64_t>> offsets_;
+        // 当前分块及其行范围 [begin_, end_)
+        mutable int64_t begin_ = 0;
+        mutable int64_t end_ = 0;
+        mutable const arrow::Array *array_ = nullptr;
+        mutable const arrow::Array *dictionary_ = nullptr;
+    };
+
     class DataFrame {
+        // 命中缓存时恢复 load_report_
+        friend class DataFrameCache;
+        // 在 DataFrame 的线程池上并行聚合
+        friend class GroupBy;
+        // 执行计划时只计算行号，最后统一取行
+        friend class LazyFrame;
+        friend class SpillableTableBuilder;
+
     public:
         DataFrame() = default;
         explicit DataFrame(std::shared_ptr<arrow::Table> table);
 
-        static DataFrame fromExcel(const std::string &filePath);
+        // 读取进度：已解析的工作表 XML 字节数和总字节数（均为解压后的大小）
+        using ProgressCallback = std::function<void(std::uint64_t bytes_parsed, std::uint64_t total_bytes)>;
+
+        // fromExcel 中一列的类型收敛结果。values 是非空单元格数，coerced 是没有按原始类型保存的单元格数，
+        // 例如整数列放宽为 DOUBLE 后的整数、字符串列中的数字和日期
+        struct ColumnLoadReport {
+            std::string column;
+            std::shared_ptr<arrow::DataType> type;
+            std::int64_t values = 0;
+            std::int64_t coerced = 0;
+        };
+
+        // 流式读取激活工作表，第一行作为列名。只扫描一遍：每列从最窄的类型开始，
+        // 遇到放不下的值时放宽（INT64 -> DOUBLE -> 字符串，时间戳/布尔 -> 字符串），不会把值丢成空值。
+        // token 被取消时（例如文档已关闭）在分块边界抛出 TaskCancelledException。
+        // DataFrameCache 启用时先查缓存，命中则直接映射缓存文件（不回调进度），未命中时解析后在后台写入缓存
+        static DataFrame fromExcel(const std::string &filePath, CancellationToken token = {},
+                                   ProgressCallback progress = {});
         
         // 基本操作
         [[nodiscard]] size_t rowCount() const { return table_ ? table_->num_rows() : 0; }
@@ -43,26 +247,155 @@ namespace TinaToolBox {
             const std::string& comparison_operator = "equal"
         ) const;
 
+        // 按任意布尔表达式过滤（见 Predicate），结果为空值的行不保留。
+        // 每个记录批次只求值一次得到整张表的选择掩码，最后统一取行，不产生中间表；
+        // 只引用一个字典列的子条件在字典上求值，不解码每行的字符串
+        arrow::Result<DataFrame> filter(const arrow::compute::Expression& predicate) const;
+
         arrow::Result<DataFrame> sort(
             const std::string& column, 
             bool ascending = true
         ) const;
+
+        // 多列排序中的一个键
+        struct SortKey {
+            std::string column;
+            bool ascending = true;
+            // 空值（以及浮点列的 NaN，位于空值内侧）排在最前还是最后，与升降序无关
+            bool nulls_first = false;
+        };
+
+        // 超过该行数时分段并行排序，再 k 路归并
+        static constexpr int64_t PARALLEL_SORT_ROWS = 1000000;
+
+        // 按多个键稳定排序，键都相同的行保持原有顺序；只在最后取一次行。
+        // 表的数据超过内存预算时改为外部归并排序，结果是溢出到临时文件的 DataFrame（见 setMemoryBudget）
+        arrow::Result<DataFrame> sort(const std::vector<SortKey>& keys) const;
+
+        // 排序后的前 k 行（用于只显示开头若干行的视图）。各段用大小为 k 的堆筛选后归并，不对整张表排序，
+        // 结果与 sort(keys) 的前 k 行相同
+        arrow::Result<DataFrame> topK(const std::vector<SortKey>& keys, int64_t k) const;
         
-        // 类型安全的值获取
+        // 按 keys 列分组，随后调用 GroupBy::agg()（见 DataFrameGroupBy.hpp）
+        [[nodiscard]] GroupBy groupBy(std::vector<std::string> keys) const;
+
+        // 延迟执行：后续操作只记录为逻辑计划，优化后在 collect() 时一次执行（见 DataFrameLazy.hpp）
+        [[nodiscard]] LazyFrame lazy() const;
+
+        // 哈希连接（VLOOKUP）：在行数较少的一侧建开放寻址哈希表，另一侧在线程池上分块并行探测，
+        // 最后用 Take 一次性取出两边的行，不逐行复制字符串。
+        // 结果按左表的行序排列，同一左行匹配的多个右行按右表的行序排列；结果列为左表的全部列加上右表的非键列，
+        // 与左表重名的右表列加上 right_suffix。空值键不与任何行匹配；两边的键类型不同时把右表的键转换为左表的类型
+        arrow::Result<DataFrame> join(const DataFrame &right, const std::vector<std::string> &left_keys,
+                                      const std::vector<std::string> &right_keys, JoinType type = JoinType::Inner,
+                                      const std::string &right_suffix = "_right") const;
+
+        // 两边的键列同名
+        arrow::Result<DataFrame> join(const DataFrame &right, const std::vector<std::string> &keys,
+                                      JoinType type = JoinType::Inner,
+                                      const std::string &right_suffix = "_right") const;
+
+        // 分块并行探测时每块的行数
+        static constexpr int64_t JOIN_PROBE_BLOCK_ROWS = 64 * 1024;
+
+        // 类型安全的值获取，空值返回 Invalid。每次调用都要解析列名，逐行读取大量值时使用 columnAccessor
         template<typename T>
         arrow::Result<T> getValue(int64_t row, const std::string &column) const;
-        
+
+        // 列不存在或类型与 T 不符时返回错误，T 的取值见 ColumnAccessor
+        template<typename T>
+        arrow::Result<ColumnAccessor<T>> columnAccessor(const std::string &column) const;
+
+        // 流式写出 xlsx：按列分批遍历所有 chunk，行数据直接压缩写入文件，内存占用与行数无关。
+        // 文本和字典列写入共享字符串表，时间戳写为带日期格式的序列日期（本地时间）。
+        // 超过 Excel 的行列上限或写入失败时返回 false，并删除不完整的文件
         [[nodiscard]] bool toSaveExcel(const std::string &filePath, bool forceOverwrite = false) const;
+
+        using Compression = ColumnarCompression;
+        using WriteOptions = ColumnarWriteOptions;
+        using ReadOptions = ColumnarReadOptions;
+
+        // 保留完整的 Arrow 类型（时间戳单位、字典列），读回后与保存前一致
+        [[nodiscard]] arrow::Status toParquet(const std::string &filePath, const WriteOptions &options = {}) const;
+        static arrow::Result<DataFrame> fromParquet(const std::string &filePath, const ReadOptions &options = {});
+
+        // Feather V2（Arrow IPC 文件格式）。不压缩时通过内存映射零拷贝读取，打开大文件只需要读取元数据
+        [[nodiscard]] arrow::Status toFeather(const std::string &filePath, const WriteOptions &options = {}) const;
+        static arrow::Result<DataFrame> fromFeather(const std::string &filePath, const ReadOptions &options = {});
+        
+        // 空字段读为空值；时间戳支持 ISO 8601 和 "yyyy/mm/dd [hh:mm:ss]"
+        static arrow::Result<DataFrame> fromCsv(const std::string &filePath, const CsvReadOptions &options = {});
+
+        // 按批次流式写出，字典列写出字符串，空值写为空字段
+        [[nodiscard]] arrow::Status toCsv(const std::string &filePath, const CsvWriteOptions &options = {}) const;
         
         // Arrow Table 访问器
         [[nodiscard]] std::shared_ptr<arrow::Table> table() const { return table_; }
         [[nodiscard]] std::shared_ptr<arrow::Schema> schema() const { return table_ ? table_->schema() : nullptr; }
+
+        // 由 fromExcel 创建时各列的类型收敛结果，其它方式创建时为空
+        [[nodiscard]] const std::vector<ColumnLoadReport> &loadReport() const { return load_report_; }
+
+        // 内存预算（字节），0 表示不限制（默认）。设置后进入 out-of-core 模式：
+        //   fromExcel / fromCsv / fromParquet 读取过程中 Arrow 默认内存池的占用超过预算后，之后读到的批次
+        //   （Excel 为封装好的分块）直接写入临时文件，结果从文件映射读回；
+        //   sort 和 groupBy().agg() 用到的数据超过预算时，改用外部归并排序和按哈希分区落盘的聚合
+        static void setMemoryBudget(int64_t bytes);
+        [[nodiscard]] static int64_t memoryBudget();
+
+        // 把表写入临时 Arrow IPC 文件，返回引用其内存映射的 DataFrame，原来的表可以释放。
+        // 文件由映射的缓冲区持有，所有共享这些缓冲区的表（包括 table() 返回的表和切片、投影）都释放后才删除
+        arrow::Result<DataFrame> spill() const;
+
+        // 由 spill() 或外部排序创建；从它派生的 DataFrame 不再标记，但仍然引用同一个文件
+        [[nodiscard]] bool isSpilled() const { return spilled_; }
+
+        // 外部排序每个临时文件批次和归并窗口中每段的行数
+        static constexpr int64_t SPILL_BATCH_ROWS = 64 * 1024;
     private:
         std::shared_ptr<arrow::Table> table_;
+        std::vector<ColumnLoadReport> load_report_;
+
+        // 各列分块起始行号的前缀和，按列号在第一次访问时建立。table_ 创建后不再修改，副本共享同一份缓存
+        struct ChunkOffsetCache {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<const std::vector<int64_t>>> offsets;
+        };
+        std::shared_ptr<ChunkOffsetCache> chunk_offsets_ = std::make_shared<ChunkOffsetCache>();
+
+        bool spilled_ = false;
+
+        std::shared_ptr<const std::vector<int64_t>> chunkOffsets(int column) const;
+
+        // filter(Expression) 的选择掩码，与 table_ 的行一一对应
+        arrow::Result<std::shared_ptr<arrow::ChunkedArray>> filterMask(const arrow::compute::Expression &predicate) const;
+
+        // sort / topK 的行号；limit < 0 时全部排序
+        arrow::Result<std::shared_ptr<arrow::Array>> sortedRowIndices(const std::vector<SortKey> &keys,
+                                                                      int64_t limit) const;
+
+        // bytes 超过内存预算（设置了预算时）
+        static bool exceedsMemoryBudget(int64_t bytes);
+
+        // 按不超过一半预算的段排序后分别溢出，再逐窗口归并到新的临时文件
+        arrow::Result<DataFrame> externalSort(const std::vector<SortKey> &keys) const;
+
         static ThreadPool& getThreadPool() {
-            static ThreadPool pool;  // 单例线程池
+            // 单例线程池，列任务粒度细，使用工作窃取调度减少队列锁竞争
+            static ThreadPool pool(std::thread::hardware_concurrency(), ThreadPool::SchedulingMode::WorkStealing);
             return pool;
         }
+
+        // 多 NUMA 节点机器上按节点划分的子线程池，列构建固定在某个节点上执行
+        static ThreadPoolGroup& getNodePools() {
+            static ThreadPoolGroup pools([] {
+                ThreadPool::Config config;
+                config.mode = ThreadPool::SchedulingMode::WorkStealing;
+                config.thread_name_prefix = "TTBDataFrame";
+                return config;
+            }());
+            return pools;
+        }
         // 将 appendBatch 改为非静态成员函数
        static void appendBatch(std::shared_ptr<arrow::ArrayBuilder>& builder,
                         const std::vector<std::variant<std::string, double, int64_t>>& batch,
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "DataFrame.hpp"
+#include "Singleton.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace TinaToolBox {
+    // 解码结果的磁盘缓存：把 DataFrame 保存为未压缩的 Arrow IPC 文件，命中时通过内存映射零拷贝打开。
+    // 缓存文件名由源文件路径、大小、修改时间和内容哈希决定，源文件变化后自然失效；
+    // 目录总大小超过上限时按最近使用时间（缓存文件的修改时间，命中时刷新）淘汰。
+    // 目录为空时缓存关闭，所有操作都不会抛出异常，失败只记录日志
+    class DataFrameCache final : public Singleton<DataFrameCache> {
+        friend class Singleton<DataFrameCache>;
+
+    public:
+        struct Key {
+            // 规范化后的绝对路径
+            std::string path;
+            std::uint64_t size = 0;
+            std::int64_t mtime = 0;
+            // 由调用方提供，例如 xlsx 中央目录里各条目的 CRC32 的哈希
+            std::uint64_t content_hash = 0;
+        };
+
+        struct Stats {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t stores = 0;
+            std::uint64_t evictions = 0;
+        };
+
+        static constexpr std::uint64_t DEFAULT_CAPACITY = 2ULL * 1024 * 1024 * 1024;
+        static constexpr std::uint64_t HASH_SEED = 14695981039346656037ULL;
+
+        // 64 位 FNV-1a，可以传入上一次的结果继续累加，用于计算 Key::content_hash
+        static std::uint64_t hash(const void *data, size_t size, std::uint64_t seed = HASH_SEED);
+
+        void setDirectory(const std::filesystem::path &directory);
+
+        [[nodiscard]] std::filesystem::path directory() const;
+
+        [[nodiscard]] bool enabled() const;
+
+        // 缓存目录的总大小上限（字节）
+        void setCapacity(std::uint64_t bytes);
+
+        [[nodiscard]] std::uint64_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+        // 读取源文件的大小和修改时间；文件不存在时返回 std::nullopt
+        static std::optional<Key> makeKey(const std::string &path, std::uint64_t content_hash);
+
+        // 命中时返回的 DataFrame 直接引用映射的文件，loadReport() 与写入时一致
+        std::optional<DataFrame> lookup(const Key &key);
+
+        void store(const Key &key, const DataFrame &frame);
+
+        // 删除所有缓存文件，计数器不清零
+        void clear();
+
+        [[nodiscard]] Stats stats() const;
+
+    private:
+        DataFrameCache() = default;
+
+        static std::string keyString(const Key &key);
+
+        std::filesystem::path entryPath(const Key &key) const;
+
+        // 调用方持有 mutex_
+        void evict(const std::filesystem::path &keep);
+
+        mutable std::mutex mutex_;
+        std::filesystem::path directory_;
+        std::atomic<std::uint64_t> capacity_{DEFAULT_CAPACITY};
+        std::atomic<std::uint64_t> hits_{0};
+        std::atomic<std::uint64_t> misses_{0};
+        std::atomic<std::uint64_t> stores_{0};
+        std::atomic<std::uint64_t> evictions_{0};
+        std::atomic<std::uint64_t> temp_counter_{0};
+    };
+} // namespace TinaToolBox
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "DataFrame.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace TinaToolBox {
+    enum class AggregateFunction { Sum, Mean, Count, Min, Max, CountDistinct };
+
+    struct Aggregation {
+        AggregateFunction function = AggregateFunction::Count;
+        // Count 时为空表示统计行数
+        std::string column;
+        // 结果列名，为空时使用 "sum(column)" 这样的形式
+        std::string name;
+    };
+
+    // DataFrame::groupBy() 的结果。分组键相同（空值也算一个取值）的行为一组，结果每组一行，
+    // 按各组第一次出现的顺序排列：先是分组键列，再依次是各聚合列。
+    // 分组使用开放寻址的哈希表直接读取 Arrow 缓冲区；行数较多时按键的哈希分区，各分区在 DataFrame 的线程池上并行聚合。
+    // 字典列按编码分组，不解码字符串。
+    // 键列和聚合列超过 DataFrame 的内存预算时，先按键的哈希把这些列分区写入临时文件，再逐个分区聚合，结果与全部在内存中时相同。
+    //   Count / CountDistinct：非空值的个数 / 不同非空值的个数，INT64
+    //   Sum：整数和布尔列为 INT64，浮点列为 DOUBLE；Mean 为 DOUBLE；组内没有非空值时为空值
+    //   Min / Max：与输入列类型相同，忽略空值和 NaN；字符串和字典列按字节比较
+    class GroupBy {
+    public:
+        GroupBy(DataFrame frame, std::vector<std::string> keys);
+
+        arrow::Result<DataFrame> agg(const std::vector<Aggregation> &aggregations) const;
+
+        // 超过该行数时分区并行
+        static constexpr std::int64_t PARALLEL_ROWS = 64 * 1024;
+
+    private:
+        // 全部在内存中聚合
+        arrow::Result<DataFrame> aggregate(const std::vector<Aggregation> &aggregations) const;
+
+        // columns 为键列和聚合用到的列；每个分区不超过一半预算
+        arrow::Result<DataFrame> aggregatePartitioned(const std::vector<Aggregation> &aggregations,
+                                                      std::shared_ptr<arrow::Table> columns) const;
+
+        DataFrame frame_;
+        std::vector<std::string> keys_;
+    };
+} // namespace TinaToolBox
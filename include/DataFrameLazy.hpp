@@ -0,0 +1,72 @@
+#pragma once
+
+#include "DataFrame.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace TinaToolBox {
+    // 延迟执行的 DataFrame 查询：filter / select / sort / limit 只追加到逻辑计划（扫描 → 过滤 → 投影 → 排序 → 截取），
+    // collect() 时先优化再执行：
+    //   过滤条件越过排序和投影下推到扫描之后，Parquet / Feather 源中的简单比较下推到读取（按行组统计跳过）；
+    //   只读取输出和各操作用到的列；相邻的过滤、排序、截取合并，排序后截取折叠为 topK。
+    // 执行时过滤和排序只计算行号，最后对输出列统一取一次行，不产生中间表。
+    // 计划中的错误（列不存在、比较运算符无效等）在 collect() 时返回
+    class LazyFrame {
+    public:
+        explicit LazyFrame(DataFrame source);
+
+        // 文件在 collect() 时才读取
+        static LazyFrame scanParquet(std::string filePath);
+        static LazyFrame scanFeather(std::string filePath);
+
+        [[nodiscard]] LazyFrame filter(arrow::compute::Expression predicate) const;
+
+        // 与 DataFrame::filter(column, value, comparison_operator) 相同的比较，可以下推到 Parquet 行组统计
+        [[nodiscard]] LazyFrame filter(const std::string &column, std::shared_ptr<arrow::Scalar> value,
+                                       const std::string &comparison_operator = "equal") const;
+
+        // 只保留这些列（按给出的顺序）
+        [[nodiscard]] LazyFrame select(std::vector<std::string> columns) const;
+
+        [[nodiscard]] LazyFrame sort(std::vector<DataFrame::SortKey> keys) const;
+
+        [[nodiscard]] LazyFrame limit(int64_t rows) const;
+
+        // 优化后的计划，每行一个步骤
+        [[nodiscard]] std::string explain() const;
+
+        arrow::Result<DataFrame> collect() const;
+
+    private:
+        enum class SourceFormat { Frame, Parquet, Feather };
+
+        enum class Step { Filter, Select, Sort, Limit };
+
+        struct Operation {
+            Step step = Step::Filter;
+            // Filter：各项同时满足。comparisons 可以下推到文件读取
+            std::vector<arrow::compute::Expression> predicates;
+            std::vector<ColumnFilter> comparisons;
+            // Select
+            std::vector<std::string> columns;
+            // Sort
+            std::vector<DataFrame::SortKey> keys;
+            // Limit
+            int64_t rows = 0;
+        };
+
+        struct Plan;
+
+        LazyFrame(SourceFormat format, std::string path);
+
+        [[nodiscard]] LazyFrame with(Operation operation) const;
+
+        [[nodiscard]] arrow::Result<Plan> optimize() const;
+
+        SourceFormat format_ = SourceFormat::Frame;
+        DataFrame frame_;
+        std::string path_;
+        std::vector<Operation> operations_;
+    };
+} // namespace TinaToolBox
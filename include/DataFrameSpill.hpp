@@ -0,0 +1,87 @@
+#pragma once
+
+#include "TTBTemporaryFile.hpp"
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace TinaToolBox {
+    // out-of-core 模式的临时 Arrow IPC 文件（不压缩）。先顺序写入记录批次，关闭后通过内存映射读回，
+    // 数据由操作系统按需换入换出，不占用 Arrow 内存池。
+    // 读回的缓冲区共同持有文件：SpillFile 和所有读回的表（包括切片、投影等共享缓冲区的派生表）都释放后，
+    // 先解除映射再删除文件（Windows 上映射中的文件不能删除）
+    class SpillFile {
+    public:
+        SpillFile();
+
+        SpillFile(const SpillFile &) = delete;
+        SpillFile &operator=(const SpillFile &) = delete;
+
+        // 外部排序和分区聚合在临时文件中附加的原行号列
+        static constexpr const char *ROW_COLUMN = "__ttb_spill_row";
+
+        // 合并每个字典列各分块的字典，使表可以分批写入同一个文件
+        static arrow::Result<std::shared_ptr<arrow::Table>> unifyDictionaries(std::shared_ptr<arrow::Table> table);
+
+        // IPC 文件格式不支持替换字典：字典与之前批次不同时合并到已写入的字典之后，以增量字典写入
+        arrow::Status write(const arrow::RecordBatch &batch);
+
+        // 按 batch_rows 行切分写入，写入前合并各分块的字典
+        arrow::Status write(const arrow::Table &table, int64_t batch_rows);
+
+        // 没有写入任何批次时不创建文件
+        arrow::Status close();
+
+        [[nodiscard]] int64_t rowCount() const { return rows_; }
+
+        // 关闭后调用。num_record_batches() 个批次可以逐个读取，不必整表映射
+        arrow::Result<std::shared_ptr<arrow::ipc::RecordBatchFileReader>> reader() const;
+
+        // 关闭后调用。没有写入任何批次时返回空指针
+        arrow::Result<std::shared_ptr<arrow::Table>> read() const;
+
+        [[nodiscard]] const std::filesystem::path &path() const { return file_->path(); }
+
+    private:
+        arrow::Status open(const std::shared_ptr<arrow::Schema> &schema);
+
+        // 把 batch 中各字典列的编码换成相对于合并后字典的编码
+        arrow::Result<std::shared_ptr<arrow::RecordBatch>> extendDictionaries(const arrow::RecordBatch &batch);
+
+        // 声明在写入流之前，写到一半析构时先关闭文件再删除
+        std::shared_ptr<TTBTemporaryFile> file_;
+        std::shared_ptr<arrow::io::FileOutputStream> output_;
+        std::shared_ptr<arrow::ipc::RecordBatchWriter> writer_;
+        int64_t rows_ = 0;
+        bool closed_ = false;
+        bool written_ = false;
+        // 各字典列已写入的字典（按列下标，非字典列为空），之后的字典只在它后面追加
+        std::vector<std::shared_ptr<arrow::Array>> dictionaries_;
+    };
+
+    // 加载文件时逐批收集记录批次。Arrow 默认内存池的占用超过 DataFrame::memoryBudget() 后，
+    // 已收集的批次写入溢出文件并释放，之后的批次直接写入文件；finish() 从文件映射读回，整表不会同时驻留内存
+    class SpillableTableBuilder {
+    public:
+        // 内存池的占用超过内存预算（设置了预算时）
+        static bool overBudget();
+
+        arrow::Status append(const std::shared_ptr<arrow::RecordBatch> &batch);
+
+        // 不再等到超过预算，已收集的和之后的批次都写入溢出文件
+        arrow::Status spill();
+
+        [[nodiscard]] bool spilled() const { return file_ != nullptr; }
+
+        // 没有任何批次时返回 schema 的空表
+        arrow::Result<std::shared_ptr<arrow::Table>> finish(const std::shared_ptr<arrow::Schema> &schema);
+
+    private:
+        std::vector<std::shared_ptr<arrow::RecordBatch>> batches_;
+        std::unique_ptr<SpillFile> file_;
+    };
+} // namespace TinaToolBox
@@ -2,6 +2,7 @@
 #include <QFileInfo>
 #include <QObject>
 #include <QString>
+#include "CancellationToken.hpp"
 
 namespace TinaToolBox {
     class Document : public QObject {
@@ -69,6 +70,12 @@ namespace TinaToolBox {
 
         void setState(State newState);
 
+        // 与文档绑定的后台任务使用的取消令牌，DocumentManager::closeDocument 关闭文档时取消。
+        // 目前 ExcelDocumentView 的加载还是空实现，尚无任务持有它；接入导入时传给 DataFrame::fromExcel 或 ThreadPool::submit
+        [[nodiscard]] CancellationToken cancellationToken() const;
+
+        void cancelBackgroundWork();
+
     signals:
         void stateChanged(State newState);
 
@@ -89,6 +96,7 @@ namespace TinaToolBox {
         QFileInfo fileInfo_;
         Type type_;
         LoadingProgress currentProgress_;
+        CancellationSource cancellationSource_;
         [[nodiscard]] Type determineType(const QString &extension) const;
     };
 }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace TinaToolBox {
+
+// 事件计数器（eventcount）：让消费者在“检查条件 -> 休眠”之间不丢失唤醒。
+// 用法：
+//     auto key = ec.prepareWait();
+//     if (条件已满足) { ec.cancelWait(); } else { ec.commitWait(key); }
+// 生产者在发布数据后调用 notifyOne()/notifyAll()，没有等待者时只有一次原子读的开销。
+class EventCount {
+public:
+    using Key = std::uint64_t;
+
+    Key prepareWait() {
+        _waiters.fetch_add(1, std::memory_order_seq_cst);
+        return _epoch.load(std::memory_order_acquire);
+    }
+
+    void cancelWait() {
+        _waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void commitWait(Key key) {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _cv.wait(lock, [this, key] { return _epoch.load(std::memory_order_acquire) != key; });
+        _waiters.fetch_sub(1, std::memory_order_seq_cst);
+        _wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 带超时的等待，返回 false 表示超时前没有收到通知
+    template<typename Rep, typename Period>
+    bool commitWaitFor(Key key, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock{_mutex};
+        bool notified = _cv.wait_for(lock, timeout, [this, key] {
+            return _epoch.load(std::memory_order_acquire) != key;
+        });
+        _waiters.fetch_sub(1, std::memory_order_seq_cst);
+        if (notified) {
+            _wakeups.fetch_add(1, std::memory_order_relaxed);
+        }
+        return notified;
+    }
+
+    void notifyOne() {
+        if (!hasWaiters()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _epoch.fetch_add(1, std::memory_order_release);
+        }
+        _cv.notify_one();
+    }
+
+    void notifyAll() {
+        if (!hasWaiters()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _epoch.fetch_add(1, std::memory_order_release);
+        }
+        _cv.notify_all();
+    }
+
+    // 等待者因收到通知而醒来的累计次数（不含超时和 cancelWait），用于检查空闲时是否被无谓唤醒
+    std::uint64_t wakeups() const {
+        return _wakeups.load(std::memory_order_relaxed);
+    }
+
+private:
+    bool hasWaiters() const {
+        // 与 prepareWait 中的 fetch_add 配对：发布数据和读取等待者计数之间需要全序
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return _waiters.load(std::memory_order_seq_cst) != 0;
+    }
+
+    std::atomic<std::uint64_t> _epoch{0};
+    std::atomic<std::uint32_t> _waiters{0};
+    std::atomic<std::uint64_t> _wakeups{0};
+    std::mutex _mutex;
+    std::condition_variable _cv;
+};
+
+} // namespace TinaToolBox
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace TinaToolBox {
+    // LatencyHistogram 的只读快照，可以合并多个快照并查询分位数
+    struct HistogramSnapshot {
+        // 每个 2 的幂区间再线性划分为 2^SUB_BITS 个子桶，相对误差不超过 1/2^SUB_BITS
+        static constexpr unsigned SUB_BITS = 3;
+        static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+        static constexpr size_t BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+        std::array<std::uint64_t, BUCKET_COUNT> buckets{};
+        std::uint64_t count = 0;
+        std::uint64_t sum = 0;
+        std::uint64_t max = 0;
+
+        static size_t bucketIndex(std::uint64_t value) {
+            if (value < SUB_BUCKETS) {
+                return static_cast<size_t>(value);
+            }
+            const unsigned msb = highestBit(value);
+            const unsigned shift = msb - SUB_BITS;
+            return (msb - SUB_BITS + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+        }
+
+        // 桶的下界（包含）
+        static std::uint64_t bucketLowerBound(size_t index) {
+            if (index < SUB_BUCKETS) {
+                return index;
+            }
+            const size_t group = index / SUB_BUCKETS;
+            const size_t sub = index % SUB_BUCKETS;
+            return static_cast<std::uint64_t>(SUB_BUCKETS + sub) << (group - 1);
+        }
+
+        // 桶的上界（包含）
+        static std::uint64_t bucketUpperBound(size_t index) {
+            return index + 1 < BUCKET_COUNT ? bucketLowerBound(index + 1) - 1 : UINT64_MAX;
+        }
+
+        [[nodiscard]] double mean() const {
+            return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+        }
+
+        // 分位数（0~1），返回所在桶的上界，不超过记录到的最大值
+        [[nodiscard]] std::uint64_t percentile(double p) const {
+            if (count == 0) {
+                return 0;
+            }
+            const auto target = static_cast<std::uint64_t>(p * static_cast<double>(count - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                seen += buckets[i];
+                if (seen >= target) {
+                    return bucketUpperBound(i) < max ? bucketUpperBound(i) : max;
+                }
+            }
+            return max;
+        }
+
+        HistogramSnapshot &operator+=(const HistogramSnapshot &other) {
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                buckets[i] += other.buckets[i];
+            }
+            count += other.count;
+            sum += other.sum;
+            max = max > other.max ? max : other.max;
+            return *this;
+        }
+
+    private:
+        static unsigned highestBit(std::uint64_t value) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<unsigned>(index);
+#else
+            return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        }
+    };
+
+    // HDR 风格的对数-线性直方图，记录纳秒级耗时或队列深度等非负整数。
+    // 每个实例只允许一个线程写入（线程池中每个工作线程各有一份），
+    // 因此 record() 只有几次 relaxed 读写，不需要原子 RMW；任意线程都可以随时 snapshot()。
+    class LatencyHistogram {
+    public:
+        void record(std::uint64_t value) {
+            bump(buckets_[HistogramSnapshot::bucketIndex(value)], 1);
+            bump(sum_, value);
+            if (value > max_.load(std::memory_order_relaxed)) {
+                max_.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        [[nodiscard]] HistogramSnapshot snapshot() const {
+            HistogramSnapshot result;
+            for (size_t i = 0; i < HistogramSnapshot::BUCKET_COUNT; ++i) {
+                result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+                result.count += result.buckets[i];
+            }
+            result.sum = sum_.load(std::memory_order_relaxed);
+            result.max = max_.load(std::memory_order_relaxed);
+            return result;
+        }
+
+    private:
+        static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t delta) {
+            counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<std::uint64_t>, HistogramSnapshot::BUCKET_COUNT> buckets_{};
+        std::atomic<std::uint64_t> sum_{0};
+        std::atomic<std::uint64_t> max_{0};
+    };
+} // namespace TinaToolBox
@@ -4,8 +4,9 @@
 #include <spdlog/sinks/base_sink.h>
 #include <streambuf>
 #include <mutex>
-#include <queue>
+#include <deque>
 #include "Singleton.hpp"
+#include "ThreadSafeQueue.hpp"
 
 namespace TinaToolBox {
     class LogPanel;
@@ -92,8 +93,12 @@ namespace TinaToolBox {
 
         void cacheLog(const LogEntry& entry);
         
-        static constexpr size_t MAX_CACHED_LOGS = 1000;
-        std::queue<LogEntry> cachedLogs_;
+        static constexpr size_t MAX_CACHED_LOGS = 1024;
+        // 任意线程都会写日志，缓存使用无锁环形队列，写日志时不再争用 mutex_
+        ThreadSafeQueue<LogEntry, LockFreeRingPolicy<MAX_CACHED_LOGS> > cachedLogs_;
+        // 读取时把环形队列中的新日志按顺序转入这里，之后只复制不取出，多次读取得到相同的历史。
+        // 只在持有 mutex_ 时访问
+        std::deque<LogEntry> logHistory_;
         std::unique_ptr<StdoutRedirector> stdoutRedirector_;
         std::unique_ptr<StdoutRedirector> stderrRedirector_;
         std::shared_ptr<LogPanelSink<std::mutex> > sink_;
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace TinaToolBox {
+
+// 固定尺寸内存块的线程安全 slab 分配器，用于 promise/future 共享状态。
+// 释放的块回到空闲链表中复用，稳态下提交任务不再触发堆分配。
+class TaskArena {
+public:
+    static constexpr size_t SIZE_CLASSES = 3;
+    static constexpr std::array<size_t, SIZE_CLASSES> BLOCK_SIZES{64, 128, 256};
+    static constexpr size_t BLOCKS_PER_SLAB = 64;
+
+    // 计数器只在 allocate() 中更新，调用方需保证分配时计数器仍然有效
+    TaskArena(std::atomic_size_t *arena_allocations, std::atomic_size_t *heap_allocations)
+        : _arena_allocations(arena_allocations), _heap_allocations(heap_allocations) {
+    }
+
+    TaskArena(const TaskArena &) = delete;
+
+    TaskArena &operator=(const TaskArena &) = delete;
+
+    void *allocate(size_t bytes, size_t alignment) {
+        const size_t index = sizeClass(bytes, alignment);
+        if (index == SIZE_CLASSES) {
+            ++*_heap_allocations;
+            return ::operator new(bytes);
+        }
+
+        auto &size_class = _classes[index];
+        std::lock_guard<std::mutex> lock{size_class.mutex};
+        if (!size_class.free_list) {
+            refill(size_class, BLOCK_SIZES[index]);
+            ++*_heap_allocations;
+        }
+        FreeBlock *block = size_class.free_list;
+        size_class.free_list = block->next;
+        ++*_arena_allocations;
+        return block;
+    }
+
+    void deallocate(void *ptr, size_t bytes, size_t alignment) noexcept {
+        const size_t index = sizeClass(bytes, alignment);
+        if (index == SIZE_CLASSES) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        auto &size_class = _classes[index];
+        std::lock_guard<std::mutex> lock{size_class.mutex};
+        auto *block = ::new (ptr) FreeBlock{size_class.free_list};
+        size_class.free_list = block;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct SizeClass {
+        std::mutex mutex;
+        FreeBlock *free_list = nullptr;
+        std::vector<std::unique_ptr<std::byte[]> > slabs;
+    };
+
+    static size_t sizeClass(size_t bytes, size_t alignment) {
+        if (alignment > alignof(std::max_align_t)) {
+            return SIZE_CLASSES;
+        }
+        for (size_t i = 0; i < SIZE_CLASSES; ++i) {
+            if (bytes <= BLOCK_SIZES[i]) {
+                return i;
+            }
+        }
+        return SIZE_CLASSES;
+    }
+
+    static void refill(SizeClass &size_class, size_t block_size) {
+        auto slab = std::make_unique<std::byte[]>(block_size * BLOCKS_PER_SLAB);
+        for (size_t i = BLOCKS_PER_SLAB; i-- > 0;) {
+            size_class.free_list = ::new (slab.get() + i * block_size) FreeBlock{size_class.free_list};
+        }
+        size_class.slabs.push_back(std::move(slab));
+    }
+
+    std::array<SizeClass, SIZE_CLASSES> _classes;
+    std::atomic_size_t *_arena_allocations;
+    std::atomic_size_t *_heap_allocations;
+};
+
+// 基于 TaskArena 的标准分配器，可传给 std::promise(std::allocator_arg, alloc)。
+// 分配器持有 arena 的 shared_ptr，共享状态比线程池活得更久时 arena 依然有效。
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<TaskArena> arena) noexcept : _arena(std::move(arena)) {
+    }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : _arena(other._arena) {
+    }
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *ptr, size_t n) noexcept {
+        _arena->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U> &other) const noexcept {
+        return _arena == other._arena;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const noexcept {
+        return _arena != other._arena;
+    }
+
+private:
+    template<typename U>
+    friend class ArenaAllocator;
+
+    std::shared_ptr<TaskArena> _arena;
+};
+
+} // namespace TinaToolBox
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace TinaToolBox {
+
+// 只可移动的 void() 可调用对象包装。
+// 与 std::function 不同，它不要求可调用对象可拷贝（可以直接持有 std::promise），
+// 并且尺寸不超过 INLINE_SIZE 的可调用对象直接存放在内联缓冲区中，不产生堆分配。
+class TaskFunction {
+public:
+    static constexpr size_t INLINE_SIZE = 64;
+
+    TaskFunction() noexcept = default;
+
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, TaskFunction> > >
+    TaskFunction(F &&f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (fitsInline<Fn>()) {
+            ::new (static_cast<void *>(_storage)) Fn(std::forward<F>(f));
+            _vtable = &inlineVTable<Fn>;
+        } else {
+            ::new (static_cast<void *>(_storage)) Fn *(new Fn(std::forward<F>(f)));
+            _vtable = &heapVTable<Fn>;
+        }
+    }
+
+    TaskFunction(TaskFunction &&other) noexcept {
+        moveFrom(other);
+    }
+
+    TaskFunction &operator=(TaskFunction &&other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    TaskFunction(const TaskFunction &) = delete;
+
+    TaskFunction &operator=(const TaskFunction &) = delete;
+
+    ~TaskFunction() {
+        reset();
+    }
+
+    void operator()() {
+        _vtable->invoke(_storage);
+    }
+
+    explicit operator bool() const noexcept {
+        return _vtable != nullptr;
+    }
+
+    // 可调用对象是否存放在内联缓冲区（即构造时没有发生堆分配）
+    [[nodiscard]] bool isInline() const noexcept {
+        return _vtable == nullptr || _vtable->is_inline;
+    }
+
+    void reset() noexcept {
+        if (_vtable) {
+            if (_vtable->destroy) {
+                _vtable->destroy(_storage);
+            }
+            _vtable = nullptr;
+        }
+    }
+
+private:
+    // move/destroy 为空表示存储内容可以按字节搬移、无需析构（平凡类型或堆指针以外的情况）
+    struct VTable {
+        void (*invoke)(void *storage);
+        void (*move)(void *dst, void *src) noexcept;
+        void (*destroy)(void *storage) noexcept;
+        bool is_inline;
+    };
+
+    void moveFrom(TaskFunction &other) noexcept {
+        _vtable = other._vtable;
+        if (_vtable) {
+            if (_vtable->move) {
+                _vtable->move(_storage, other._storage);
+            } else {
+                std::memcpy(_storage, other._storage, INLINE_SIZE);
+            }
+            other._vtable = nullptr;
+        }
+    }
+
+    template<typename Fn>
+    static constexpr bool isTriviallyRelocatable() {
+        return std::is_trivially_copyable_v<Fn> && std::is_trivially_destructible_v<Fn>;
+    }
+
+    template<typename Fn>
+    static constexpr bool fitsInline() {
+        return sizeof(Fn) <= INLINE_SIZE
+               && alignof(Fn) <= alignof(std::max_align_t)
+               && std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template<typename Fn>
+    static void invokeInline(void *storage) {
+        (*std::launder(static_cast<Fn *>(storage)))();
+    }
+
+    template<typename Fn>
+    static void moveInline(void *dst, void *src) noexcept {
+        auto *from = std::launder(static_cast<Fn *>(src));
+        ::new (dst) Fn(std::move(*from));
+        from->~Fn();
+    }
+
+    template<typename Fn>
+    static void destroyInline(void *storage) noexcept {
+        std::launder(static_cast<Fn *>(storage))->~Fn();
+    }
+
+    template<typename Fn>
+    static constexpr VTable inlineVTable{
+        &invokeInline<Fn>,
+        isTriviallyRelocatable<Fn>() ? nullptr : &moveInline<Fn>,
+        isTriviallyRelocatable<Fn>() ? nullptr : &destroyInline<Fn>,
+        true
+    };
+
+    // 堆存储时缓冲区中只有一个指针，可以按字节搬移
+    template<typename Fn>
+    static constexpr VTable heapVTable{
+        [](void *storage) { (**std::launder(static_cast<Fn **>(storage)))(); },
+        nullptr,
+        [](void *storage) noexcept { delete *std::launder(static_cast<Fn **>(storage)); },
+        false
+    };
+
+    alignas(std::max_align_t) unsigned char _storage[INLINE_SIZE]{};
+    const VTable *_vtable = nullptr;
+};
+
+} // namespace TinaToolBox
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+#include "ThreadPool.hpp"
+
+namespace TinaToolBox {
+    namespace detail {
+        // TaskFuture 的共享状态：保存结果或异常，以及完成后要触发的续体
+        template<typename R>
+        class FutureState {
+        public:
+            using value_type = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+            template<typename... Args>
+            void setValue(Args &&... args) {
+                TaskFunction continuation;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    value_.emplace(std::forward<Args>(args)...);
+                    ready_ = true;
+                    continuation = std::move(continuation_);
+                }
+                cv_ready_.notify_all();
+                if (continuation) {
+                    continuation();
+                }
+            }
+
+            void setException(std::exception_ptr exception) {
+                TaskFunction continuation;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    exception_ = std::move(exception);
+                    ready_ = true;
+                    continuation = std::move(continuation_);
+                }
+                cv_ready_.notify_all();
+                if (continuation) {
+                    continuation();
+                }
+            }
+
+            // 注册完成回调；如果已经完成则立即在当前线程调用
+            void onReady(TaskFunction continuation) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!ready_) {
+                        continuation_ = std::move(continuation);
+                        return;
+                    }
+                }
+                continuation();
+            }
+
+            bool isReady() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return ready_;
+            }
+
+            void wait() const {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_ready_.wait(lock, [this] { return ready_; });
+            }
+
+            // 只能在 ready 之后调用
+            value_type takeValue() {
+                if (exception_) {
+                    std::rethrow_exception(exception_);
+                }
+                return std::move(*value_);
+            }
+
+            std::exception_ptr exception() const { return exception_; }
+
+        private:
+            mutable std::mutex mutex_;
+            mutable std::condition_variable cv_ready_;
+            bool ready_ = false;
+            std::optional<value_type> value_;
+            std::exception_ptr exception_;
+            TaskFunction continuation_;
+        };
+
+        // 与 PromiseGuard 相同：任务未执行就被销毁时，以 TaskCancelledException 完成共享状态，
+        // 保证续体链和等待者不会永远挂起
+        template<typename R>
+        class FutureStateGuard {
+        public:
+            explicit FutureStateGuard(std::shared_ptr<FutureState<R> > state) : state_(std::move(state)) {
+            }
+
+            FutureStateGuard(FutureStateGuard &&) noexcept = default;
+
+            FutureStateGuard &operator=(FutureStateGuard &&) = delete;
+
+            ~FutureStateGuard() {
+                if (state_ && !state_->isReady()) {
+                    state_->setException(std::make_exception_ptr(TaskCancelledException()));
+                }
+            }
+
+            FutureState<R> *operator->() const { return state_.get(); }
+
+        private:
+            std::shared_ptr<FutureState<R> > state_;
+        };
+    }
+
+    // ThreadPool::async 返回的 future，支持 then() 续体：
+    // 前一个任务完成后续体才被投递到线程池，不占用任何线程等待。
+    // 与 std::future 一样只能消费一次，get() 和 then() 都会使其失效。
+    template<typename R>
+    class TaskFuture {
+    public:
+        TaskFuture() = default;
+
+        [[nodiscard]] bool valid() const { return state_ != nullptr; }
+
+        [[nodiscard]] bool isReady() const {
+            checkValid();
+            return state_->isReady();
+        }
+
+        void wait() const {
+            checkValid();
+            state_->wait();
+        }
+
+        R get() {
+            checkValid();
+            auto state = std::move(state_);
+            state->wait();
+            if constexpr (std::is_void_v<R>) {
+                state->takeValue();
+            } else {
+                return state->takeValue();
+            }
+        }
+
+        // 注册续体：前驱成功时以其结果调用 f（void 前驱则无参调用），
+        // 前驱抛出异常时跳过 f，异常沿续体链传递
+        template<typename F>
+        auto then(F &&f, ThreadPool::TaskPriority priority = ThreadPool::TaskPriority::Normal) {
+            using next_type = typename std::conditional_t<std::is_void_v<R>,
+                std::invoke_result<F>, std::invoke_result<F, R> >::type;
+
+            checkValid();
+            auto state = std::move(state_);
+            ThreadPool *pool = pool_;
+            auto next = std::allocate_shared<detail::FutureState<next_type> >(
+                ArenaAllocator<detail::FutureState<next_type> >(pool->arena_));
+
+            state->onReady([state, next, pool, priority, f = std::forward<F>(f)]() mutable {
+                pool->post([state, next = detail::FutureStateGuard<next_type>(next), f = std::move(f)]() mutable {
+                    if (auto exception = state->exception()) {
+                        next->setException(exception);
+                        return;
+                    }
+                    try {
+                        if constexpr (std::is_void_v<R> && std::is_void_v<next_type>) {
+                            f();
+                            next->setValue();
+                        } else if constexpr (std::is_void_v<R>) {
+                            next->setValue(f());
+                        } else if constexpr (std::is_void_v<next_type>) {
+                            f(state->takeValue());
+                            next->setValue();
+                        } else {
+                            next->setValue(f(state->takeValue()));
+                        }
+                    } catch (...) {
+                        next->setException(std::current_exception());
+                    }
+                }, priority);
+            });
+            return TaskFuture<next_type>(std::move(next), pool);
+        }
+
+    private:
+        friend class ThreadPool;
+
+        template<typename>
+        friend class TaskFuture;
+
+        TaskFuture(std::shared_ptr<detail::FutureState<R> > state, ThreadPool *pool)
+            : state_(std::move(state)), pool_(pool) {
+        }
+
+        void checkValid() const {
+            if (!state_) {
+                throw std::logic_error("TaskFuture has no shared state");
+            }
+        }
+
+        std::shared_ptr<detail::FutureState<R> > state_;
+        ThreadPool *pool_ = nullptr;
+    };
+
+    template<typename F>
+    auto ThreadPool::async(F &&f, TaskPriority priority) -> TaskFuture<std::invoke_result_t<F> > {
+        return async(std::forward<F>(f), TaskOptions{priority});
+    }
+
+    template<typename F>
+    auto ThreadPool::async(F &&f, TaskOptions options) -> TaskFuture<std::invoke_result_t<F> > {
+        using return_type = std::invoke_result_t<F>;
+        auto state = std::allocate_shared<detail::FutureState<return_type> >(
+            ArenaAllocator<detail::FutureState<return_type> >(arena_));
+
+        post([state = detail::FutureStateGuard<return_type>(state), f = std::forward<F>(f), this]() mutable {
+            try {
+                if constexpr (std::is_void_v<return_type>) {
+                    f();
+                    ++stats_.tasks_completed;
+                    state->setValue();
+                } else {
+                    auto result = f();
+                    ++stats_.tasks_completed;
+                    state->setValue(std::move(result));
+                }
+            } catch (...) {
+                ++stats_.tasks_failed;
+                state->setException(std::current_exception());
+            }
+        }, std::move(options));
+        return TaskFuture<return_type>(std::move(state), this);
+    }
+} // namespace TinaToolBox
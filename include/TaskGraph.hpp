@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <vector>
+#include "ThreadPool.hpp"
+
+namespace TinaToolBox {
+    // 任务依赖图（DAG）执行器：节点在自身所有前驱完成后立即被调度，
+    // 而不是等待上一“阶段”的全部任务结束。
+    //
+    //     TaskGraph graph;
+    //     auto detect = graph.emplace([] { ... });
+    //     auto convert = detect.then([] { ... });   // detect 完成后执行
+    //     convert.precede(assemble);
+    //     graph.run(pool).get();
+    //
+    // 图在 run() 返回的 future 就绪之前必须保持有效；同一个图可以多次运行。
+    class TaskGraph {
+    public:
+        class Node {
+        public:
+            Node() = default;
+
+            // this 完成后才能执行 other
+            Node &precede(Node other);
+
+            // other 完成后才能执行 this
+            Node &succeed(Node other);
+
+            // 新建一个依赖于 this 的节点
+            template<typename F>
+            Node then(F &&f, ThreadPool::TaskPriority priority = ThreadPool::TaskPriority::Normal) {
+                Node next = graph_->emplace(std::forward<F>(f), priority);
+                precede(next);
+                return next;
+            }
+
+            [[nodiscard]] size_t id() const { return index_; }
+
+        private:
+            friend class TaskGraph;
+
+            Node(TaskGraph *graph, size_t index) : graph_(graph), index_(index) {
+            }
+
+            TaskGraph *graph_ = nullptr;
+            size_t index_ = 0;
+        };
+
+        TaskGraph() = default;
+
+        TaskGraph(const TaskGraph &) = delete;
+
+        TaskGraph &operator=(const TaskGraph &) = delete;
+
+        template<typename F>
+        Node emplace(F &&f, ThreadPool::TaskPriority priority = ThreadPool::TaskPriority::Normal) {
+            nodes_.push_back(NodeData{std::function<void()>(std::forward<F>(f)), {}, 0, priority});
+            return Node(this, nodes_.size() - 1);
+        }
+
+        [[nodiscard]] size_t size() const { return nodes_.size(); }
+
+        [[nodiscard]] bool empty() const { return nodes_.empty(); }
+
+        // 在线程池上运行整张图。某个节点抛出异常后，尚未开始的节点被跳过，
+        // 返回的 future 在所有节点结束后携带第一个异常。图中存在环时抛出 std::logic_error
+        std::future<void> run(ThreadPool &pool);
+
+        // 可取消的运行：令牌取消后尚未开始的节点被跳过，
+        // 若没有其他异常，返回的 future 携带 TaskCancelledException
+        std::future<void> run(ThreadPool &pool, CancellationToken token);
+
+    private:
+        struct NodeData {
+            std::function<void()> work;
+            std::vector<size_t> successors;
+            size_t predecessor_count;
+            ThreadPool::TaskPriority priority;
+        };
+
+        struct RunState;
+
+        void addEdge(size_t from, size_t to);
+
+        void checkAcyclic() const;
+
+        static void schedule(const std::shared_ptr<RunState> &state, size_t index);
+
+        static void execute(const std::shared_ptr<RunState> &state, size_t index);
+
+        std::vector<NodeData> nodes_;
+    };
+} // namespace TinaToolBox
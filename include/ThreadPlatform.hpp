@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace TinaToolBox {
+    // 一个 NUMA 节点及其包含的逻辑 CPU 编号
+    struct NumaNode {
+        int id = 0;
+        std::vector<int> cpus;
+    };
+
+    namespace ThreadPlatform {
+        // 枚举 NUMA 节点；平台不支持或只有一个节点时返回包含全部 CPU 的单个节点
+        std::vector<NumaNode> numaNodes();
+
+        // 把调用线程绑定到给定的逻辑 CPU 集合，失败或平台不支持时返回 false
+        bool setCurrentThreadAffinity(const std::vector<int> &cpus);
+
+        // 设置调用线程的名称，便于在调试器和 perf/htop 中区分工作线程。
+        // Linux 下名称最长 15 个字符，超出部分被截断
+        bool setCurrentThreadName(const std::string &name);
+    }
+
+    // 可以指定栈大小的线程，接口与 std::thread 一致（析构前必须 join）。
+    // stack_size 为 0 时使用系统默认栈大小
+    class NativeThread {
+    public:
+        NativeThread() = default;
+
+        NativeThread(std::function<void()> body, size_t stack_size);
+
+        NativeThread(NativeThread &&other) noexcept;
+
+        NativeThread &operator=(NativeThread &&other) noexcept;
+
+        NativeThread(const NativeThread &) = delete;
+
+        NativeThread &operator=(const NativeThread &) = delete;
+
+        ~NativeThread();
+
+        [[nodiscard]] bool joinable() const { return joinable_; }
+
+        void join();
+
+    private:
+#ifdef _WIN32
+        void *handle_ = nullptr;
+#else
+        pthread_t thread_{};
+#endif
+        bool joinable_ = false;
+    };
+} // namespace TinaToolBox
@@ -5,7 +5,22 @@
 #include <thread>
 #include <vector>
 #include <queue>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <chrono>
+#include <string>
 #include "ThreadSafeQueue.hpp"
+#include "EventCount.hpp"
+#include "TaskFunction.hpp"
+#include "TaskArena.hpp"
+#include "CancellationToken.hpp"
+#include "ThreadPlatform.hpp"
+#include "LatencyHistogram.hpp"
+#include "CycleClock.hpp"
 
 namespace TinaToolBox {
     struct use_future_tag {
@@ -16,6 +31,136 @@ namespace TinaToolBox {
         return std::make_tuple(use_future_tag{}, std::forward<Fn>(func));
     }
 
+    template<typename R>
+    class TaskFuture;
+
+    namespace detail {
+        // 持有 promise 的任务如果在执行前被丢弃（取消、超过截止时间或线程池关闭），
+        // 析构时向 future 报告 TaskCancelledException，而不是 broken_promise
+        template<typename R>
+        class PromiseGuard {
+        public:
+            explicit PromiseGuard(std::promise<R> promise) : promise_(std::move(promise)) {
+            }
+
+            PromiseGuard(PromiseGuard &&other) noexcept
+                : promise_(std::move(other.promise_)), settled_(other.settled_) {
+                other.settled_ = true;
+            }
+
+            PromiseGuard &operator=(PromiseGuard &&) = delete;
+
+            ~PromiseGuard() {
+                if (!settled_) {
+                    try {
+                        promise_.set_exception(std::make_exception_ptr(TaskCancelledException()));
+                    } catch (...) {
+                    }
+                }
+            }
+
+            template<typename... Args>
+            void setValue(Args &&... args) {
+                settled_ = true;
+                promise_.set_value(std::forward<Args>(args)...);
+            }
+
+            void setException(std::exception_ptr exception) {
+                settled_ = true;
+                promise_.set_exception(std::move(exception));
+            }
+
+        private:
+            std::promise<R> promise_;
+            bool settled_ = false;
+        };
+
+        // parallel_for 系列算法的共享调度状态。
+        // 各参与线程通过原子游标动态领取区间，每次领取“剩余量 / (2 × 参与者数)”，
+        // 区间随剩余工作量减少而不断对半细分，最小不低于 grain，快线程自然多领，实现负载均衡。
+        class ParallelRange {
+        public:
+            ParallelRange(size_t begin, size_t end, size_t grain, size_t participants)
+                : next_(begin), end_(end), grain_(std::max<size_t>(1, grain)),
+                  participants_(std::max<size_t>(1, participants)), total_(end - begin) {
+            }
+
+            // 循环领取区间并执行 body(chunk_begin, chunk_end)，没有剩余区间时返回。
+            // body 只在成功领取后才会被访问，晚启动的辅助任务不会触碰已失效的 body
+            template<typename Body>
+            void run(Body *body) {
+                size_t chunk_begin = 0;
+                size_t chunk_end = 0;
+                while (claim(chunk_begin, chunk_end)) {
+                    try {
+                        (*body)(chunk_begin, chunk_end);
+                    } catch (...) {
+                        fail(std::current_exception());
+                        finish(chunk_end - chunk_begin);
+                        return;
+                    }
+                    finish(chunk_end - chunk_begin);
+                }
+            }
+
+            // 等待所有已领取的区间执行完毕，如有异常则重新抛出第一个异常
+            void wait() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_done_.wait(lock, [this] { return completed_.load() == total_; });
+                if (exception_) {
+                    std::rethrow_exception(exception_);
+                }
+            }
+
+        private:
+            bool claim(size_t &chunk_begin, size_t &chunk_end) {
+                size_t current = next_.load(std::memory_order_relaxed);
+                size_t count;
+                do {
+                    if (current >= end_) {
+                        return false;
+                    }
+                    const size_t remaining = end_ - current;
+                    count = std::min(remaining, std::max(grain_, remaining / (2 * participants_)));
+                } while (!next_.compare_exchange_weak(current, current + count, std::memory_order_relaxed));
+                chunk_begin = current;
+                chunk_end = current + count;
+                return true;
+            }
+
+            void finish(size_t count) {
+                if (completed_.fetch_add(count) + count == total_) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    cv_done_.notify_all();
+                }
+            }
+
+            // 记录异常并放弃所有尚未领取的区间
+            void fail(std::exception_ptr exception) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!exception_) {
+                        exception_ = std::move(exception);
+                    }
+                }
+                const size_t previous = next_.exchange(end_);
+                if (previous < end_) {
+                    finish(end_ - previous);
+                }
+            }
+
+            std::atomic_size_t next_;
+            const size_t end_;
+            const size_t grain_;
+            const size_t participants_;
+            const size_t total_;
+            std::atomic_size_t completed_{0};
+            std::mutex mutex_;
+            std::condition_variable cv_done_;
+            std::exception_ptr exception_;
+        };
+    }
+
     class ThreadPool {
     public:
         enum class TaskPriority {
@@ -24,47 +169,220 @@ namespace TinaToolBox {
             High
         };
 
+        static constexpr size_t PRIORITY_LEVELS = 3;
+
+        // 调度模式：SharedQueue 为所有线程共享一个优先队列；
+        // WorkStealing 为每个工作线程维护本地双端队列，空闲线程从其他线程窃取任务
+        enum class SchedulingMode {
+            SharedQueue,
+            WorkStealing
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        // 提交任务时的可选参数：优先级、取消令牌和截止时间。
+        // 令牌已取消或已过截止时间的任务在出队时直接丢弃，不会执行
+        struct TaskOptions {
+            TaskOptions() = default;
+
+            explicit TaskOptions(TaskPriority priority, CancellationToken token = {},
+                                 Clock::time_point deadline = Clock::time_point::max())
+                : priority(priority), token(std::move(token)), deadline(deadline) {}
+
+            TaskPriority priority = TaskPriority::Normal;
+            CancellationToken token;
+            Clock::time_point deadline = Clock::time_point::max();
+        };
+
+        // 线程池配置：线程数、CPU 亲和性、NUMA 分组、线程名和栈大小
+        struct Config {
+            // 0 表示使用 hardware_concurrency()
+            size_t thread_count = 0;
+            SchedulingMode mode = SchedulingMode::SharedQueue;
+            // 第 i 个工作线程可运行的逻辑 CPU 列表；少于线程数时循环使用，为空表示不绑定
+            std::vector<std::vector<int> > affinity;
+            // 按 NUMA 节点分组：工作线程按各节点 CPU 数成比例地连续分配到各节点，并绑定到所在节点的 CPU。
+            // 同一节点的线程序号相邻，工作窃取时优先从相邻（同节点）线程窃取。与 affinity 同时设置时 affinity 优先
+            bool numa_aware = false;
+            // 工作线程名为 "<前缀>-<序号>"，为空则不设置
+            std::string thread_name_prefix;
+            // 工作线程栈大小（字节），0 表示系统默认
+            size_t stack_size = 0;
+            // 记录排队等待/执行耗时直方图和各线程利用率；关闭后 telemetry() 只有 uptime 有意义
+            bool telemetry = true;
+        };
+
         struct PoolStats {
             std::atomic_size_t tasks_completed{0};
             std::atomic_size_t tasks_failed{0};
             std::atomic_uint64_t total_task_time{0};
+            // 因取消或超过截止时间而未执行就被丢弃的任务数
+            std::atomic_size_t tasks_cancelled{0};
+            // 可调用对象超出 TaskFunction 内联缓冲区而发生堆分配的任务数
+            std::atomic_size_t task_heap_allocations{0};
+            // 从 TaskArena 空闲链表分配的 promise/future 共享状态数
+            std::atomic_size_t state_arena_allocations{0};
+            // TaskArena 扩容（新 slab）或共享状态过大而发生的堆分配次数
+            std::atomic_size_t state_heap_allocations{0};
         };
 
+        // telemetry() 返回的遥测快照。耗时单位均为纳秒，数组按 TaskPriority 下标
+        struct TelemetrySnapshot {
+            struct Worker {
+                std::uint64_t tasks_run = 0;
+                std::chrono::nanoseconds busy_time{0};
+                // 线程池创建以来执行任务的时间占比
+                double utilization = 0.0;
+            };
+
+            // 从入队到开始执行的等待时间
+            std::array<HistogramSnapshot, PRIORITY_LEVELS> queue_wait;
+            // 任务执行时间
+            std::array<HistogramSnapshot, PRIORITY_LEVELS> run_time;
+            // 每个工作线程每执行 DEPTH_SAMPLE_INTERVAL 个任务采样一次未完成任务数
+            HistogramSnapshot queue_depth;
+            // 共享队列模式下任务队列的累计加锁次数（入队、出队和空闲时的轮询）
+            std::uint64_t shared_queue_locks = 0;
+            std::vector<Worker> workers;
+            std::chrono::nanoseconds uptime{0};
+        };
+
+        static constexpr std::uint32_t DEPTH_SAMPLE_INTERVAL = 64;
+
     private:
         struct Task {
-            std::function<void()> func;
+            TaskFunction func;
             TaskPriority priority;
             std::exception_ptr exception;
+            CancellationToken token;
+            Clock::time_point deadline = Clock::time_point::max();
+            // 入队时刻（CycleClock tick），用于统计排队等待时间
+            std::uint64_t enqueue_ticks = 0;
 
             Task() : priority(TaskPriority::Normal) {
             }
 
-            explicit Task(std::function<void()> f, TaskPriority p = TaskPriority::Normal)
+            explicit Task(TaskFunction f, TaskPriority p = TaskPriority::Normal)
                 : func(std::move(f)), priority(p) {
             }
 
+            Task(TaskFunction f, TaskOptions options)
+                : func(std::move(f)), priority(options.priority), token(std::move(options.token)),
+                  deadline(options.deadline) {
+            }
+
+            // 已取消或已超过截止时间
+            bool isAbandoned() const {
+                return token.isCancelled() || (deadline != Clock::time_point::max() && Clock::now() >= deadline);
+            }
+
             bool operator>(const Task &other) const {
                 return priority < other.priority;
             }
         };
 
+        // 基于环形缓冲区的双端队列，容量只增不减，稳态下入队出队不分配内存
+        class TaskDeque {
+        public:
+            bool empty() const { return size_ == 0; }
+
+            void push_back(Task &&task) {
+                if (size_ == buffer_.size()) {
+                    grow();
+                }
+                buffer_[(head_ + size_) & (buffer_.size() - 1)] = std::move(task);
+                ++size_;
+            }
+
+            void pop_back(Task &out) {
+                --size_;
+                out = std::move(buffer_[(head_ + size_) & (buffer_.size() - 1)]);
+            }
+
+            void pop_front(Task &out) {
+                out = std::move(buffer_[head_]);
+                head_ = (head_ + 1) & (buffer_.size() - 1);
+                --size_;
+            }
+
+            void clear() {
+                for (auto &task: buffer_) {
+                    task = Task();
+                }
+                head_ = 0;
+                size_ = 0;
+            }
+
+        private:
+            void grow() {
+                std::vector<Task> bigger(buffer_.empty() ? 64 : buffer_.size() * 2);
+                for (size_t i = 0; i < size_; ++i) {
+                    bigger[i] = std::move(buffer_[(head_ + i) & (buffer_.size() - 1)]);
+                }
+                buffer_ = std::move(bigger);
+                head_ = 0;
+            }
+
+            std::vector<Task> buffer_;
+            size_t head_ = 0;
+            size_t size_ = 0;
+        };
+
+        // 每个工作线程独占写入的遥测数据，按缓存行对齐避免伪共享
+        struct alignas(64) WorkerTelemetry {
+            std::array<LatencyHistogram, PRIORITY_LEVELS> queue_wait;
+            std::array<LatencyHistogram, PRIORITY_LEVELS> run_time;
+            LatencyHistogram queue_depth;
+            std::atomic<std::uint64_t> tasks_run{0};
+            std::atomic<std::uint64_t> busy_ns{0};
+            std::uint32_t depth_sample_countdown = DEPTH_SAMPLE_INTERVAL;
+        };
+
+        // 工作窃取模式下每个工作线程的本地队列，每个优先级一条通道
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::array<TaskDeque, PRIORITY_LEVELS> lanes;
+            std::array<std::atomic_size_t, PRIORITY_LEVELS> lane_sizes{};
+            // 只由所属工作线程使用的窃取缓冲区，批量窃取时复用，避免分配
+            std::vector<Task> steal_buffer;
+        };
+
+        SchedulingMode mode_;
+        // 在启动工作线程之前确定，工作线程读取它不会与 workers_ 的构造产生数据竞争
+        size_t worker_count_ = 0;
         std::atomic_bool is_active_{true};
-        std::atomic_bool waiting_for_all_{false};
-        std::vector<std::thread> workers_;
+        std::atomic_size_t waiters_{0};
+        std::vector<NativeThread> workers_;
+        // 每个工作线程启动时应用的 CPU 绑定和线程名，在启动工作线程前确定
+        std::vector<std::vector<int> > worker_cpus_;
+        std::vector<std::string> worker_names_;
+        std::vector<std::unique_ptr<WorkerTelemetry> > telemetry_;
+        bool telemetry_enabled_ = true;
+        Clock::time_point start_time_ = Clock::now();
+        const double ns_per_tick_ = CycleClock::nanosecondsPerTick();
         ThreadSafeQueue<Task> task_queue_;
-        std::atomic_size_t active_tasks_{0};
+        std::vector<std::unique_ptr<WorkerQueue> > local_queues_;
+        std::atomic_size_t next_queue_{0};
+        // 已入队但尚未执行完成的任务数（包括正在执行的任务）
+        std::atomic_size_t pending_tasks_{0};
+        // 正在执行 enqueue/enqueueBatch 的线程数，shutdown 等它归零后再清空队列
+        std::atomic_size_t submitting_{0};
         PoolStats stats_{};
+        std::shared_ptr<TaskArena> arena_ = std::make_shared<TaskArena>(
+            &stats_.state_arena_allocations, &stats_.state_heap_allocations);
         static constexpr size_t BATCH_SIZE = 100;
+        // 进入休眠前的自旋次数，覆盖任务密集提交时的短暂空窗，避免频繁休眠/唤醒
+        static constexpr int IDLE_SPIN_ROUNDS = 64;
+        // 空闲工作线程在此休眠，有新任务或关闭时被唤醒
+        EventCount idle_workers_;
         std::condition_variable cv_all_tasks_done_;
         std::mutex all_tasks_done_mutex_;
 
     public:
-        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
-            workers_.reserve(threads);
-            for (size_t i = 0; i < threads; ++i) {
-                workers_.emplace_back(&ThreadPool::workerThread, this);
-            }
-        }
+        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency(),
+                            SchedulingMode mode = SchedulingMode::SharedQueue);
+
+        explicit ThreadPool(const Config &config);
 
         ~ThreadPool() {
             shutdown();
@@ -74,99 +392,238 @@ namespace TinaToolBox {
 
         ThreadPool &operator=(const ThreadPool &) = delete;
 
-        size_t threadCount() const { return workers_.size(); }
+        size_t threadCount() const { return worker_count_; }
+
+        SchedulingMode schedulingMode() const { return mode_; }
 
         template<typename F>
         auto post(use_future_tag, F &&f) -> std::future<std::invoke_result_t<F> > {
             using return_type = std::invoke_result_t<F>;
-            auto task = std::make_shared<std::packaged_task<return_type()> >(
-                std::forward<F>(f)
-            );
-            std::future<return_type> future = task->get_future();
+            auto promise = makePromise<return_type>();
+            std::future<return_type> future = promise.get_future();
 
-            post([task]() { (*task)(); });
+            post([promise = detail::PromiseGuard<return_type>(std::move(promise)), f = std::forward<F>(f)]() mutable {
+                try {
+                    if constexpr (std::is_void_v<return_type>) {
+                        f();
+                        promise.setValue();
+                    } else {
+                        promise.setValue(f());
+                    }
+                } catch (...) {
+                    promise.setException(std::current_exception());
+                }
+            });
             return future;
         }
 
         template<class F>
         void post(F &&f, TaskPriority priority = TaskPriority::Normal) {
-            task_queue_.push(Task(std::forward<F>(f), priority));
+            enqueue(Task(TaskFunction(std::forward<F>(f)), priority));
+        }
+
+        template<class F>
+        void post(F &&f, TaskOptions options) {
+            enqueue(Task(TaskFunction(std::forward<F>(f)), std::move(options)));
         }
 
         template<typename F>
         auto submit(F&& f, TaskPriority priority = TaskPriority::Normal)
             -> std::future<std::invoke_result_t<F>>
+        {
+            return submit(std::forward<F>(f), TaskOptions{priority});
+        }
+
+        template<typename F>
+        auto submit(F&& f, CancellationToken token, TaskPriority priority = TaskPriority::Normal)
+            -> std::future<std::invoke_result_t<F>>
+        {
+            return submit(std::forward<F>(f), TaskOptions{priority, std::move(token)});
+        }
+
+        // 被取消、超时或因关闭而未执行的任务，其 future 抛出 TaskCancelledException
+        template<typename F>
+        auto submit(F&& f, TaskOptions options)
+            -> std::future<std::invoke_result_t<F>>
         {
             using return_type = std::invoke_result_t<F>;
-            
-            // 特化处理void返回类型
-            if constexpr (std::is_void_v<return_type>) {
-                auto task = std::make_shared<std::packaged_task<void()>>(
-                    [f = std::forward<F>(f), this]() {
-                        try {
-                            f();
-                            ++stats_.tasks_completed;
-                        } catch (...) {
-                            ++stats_.tasks_failed;
-                            throw;
-                        }
-                    }
-                );
-                std::future<void> future = task->get_future();
-                post([task]() { (*task)(); }, priority);
-                return future;
-            } else {
-                auto task = std::make_shared<std::packaged_task<return_type()>>(
-                    [f = std::forward<F>(f), this]() -> return_type {
-                        try {
-                            auto result = f();
-                            ++stats_.tasks_completed;
-                            return result;
-                        } catch (...) {
-                            ++stats_.tasks_failed;
-                            throw;
-                        }
+            auto promise = makePromise<return_type>();
+            std::future<return_type> future = promise.get_future();
+
+            // promise 直接存放在任务中，共享状态由 arena 分配，小任务提交不产生堆分配
+            post([promise = detail::PromiseGuard<return_type>(std::move(promise)), f = std::forward<F>(f), this]() mutable {
+                try {
+                    if constexpr (std::is_void_v<return_type>) {
+                        f();
+                        ++stats_.tasks_completed;
+                        promise.setValue();
+                    } else {
+                        auto result = f();
+                        ++stats_.tasks_completed;
+                        promise.setValue(std::move(result));
                     }
-                );
-                std::future<return_type> future = task->get_future();
-                post([task]() { (*task)(); }, priority);
-                return future;
-            }
+                } catch (...) {
+                    ++stats_.tasks_failed;
+                    promise.setException(std::current_exception());
+                }
+            }, std::move(options));
+            return future;
         }
         
+        // 与 submit 类似，但返回支持 then() 续体的 TaskFuture（定义见 TaskFuture.hpp）
+        template<typename F>
+        auto async(F &&f, TaskPriority priority = TaskPriority::Normal) -> TaskFuture<std::invoke_result_t<F> >;
+
+        template<typename F>
+        auto async(F &&f, TaskOptions options) -> TaskFuture<std::invoke_result_t<F> >;
+
+        // 批量提交：任务先在锁外构造好，每 BATCH_SIZE 个任务只加一次队列锁、只唤醒一次空闲线程。
+        // 分段提交让工作线程可以在后续任务还在构造时就开始执行
         template<typename Iterator>
         void batch_post(Iterator begin, Iterator end, TaskPriority priority = TaskPriority::Normal) {
+            std::vector<Task> tasks;
+            tasks.reserve(BATCH_SIZE);
             for (auto it = begin; it != end; ++it) {
-                task_queue_.push(Task(*it, priority));
+                tasks.emplace_back(TaskFunction(*it), priority);
+                if (tasks.size() == BATCH_SIZE) {
+                    enqueueBatch(tasks);
+                }
             }
-            cv_all_tasks_done_.notify_all();
+            enqueueBatch(tasks);
         }
         
-        void waitForAll() {
-            std::unique_lock<std::mutex> lock(all_tasks_done_mutex_);
-            waiting_for_all_ = true;
-            while (!task_queue_.empty() || active_tasks_ > 0) {
-                cv_all_tasks_done_.wait(lock);
+        void waitForAll();
+
+        // 并行执行 fn：fn 可以接受单个下标 fn(i)，也可以接受区间 fn(begin, end)。
+        // grain 为每次领取的最小元素数，0 表示按线程数自动选择。
+        // 调用线程同样参与执行，而不是阻塞等待 future，因此也可以在工作线程内部嵌套调用。
+        template<typename Fn>
+        void parallel_for(size_t begin, size_t end, size_t grain, Fn &&fn) {
+            if (begin >= end) {
+                return;
+            }
+            if constexpr (std::is_invocable_v<Fn &, size_t, size_t>) {
+                runParallel(begin, end, grain, fn);
+            } else {
+                auto body = [&fn](size_t chunk_begin, size_t chunk_end) {
+                    for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                        fn(i);
+                    }
+                };
+                runParallel(begin, end, grain, body);
             }
-            waiting_for_all_ = false;
         }
 
-        const PoolStats &getStats() const { return stats_; }
+        template<typename Fn>
+        void parallel_for(size_t begin, size_t end, Fn &&fn) {
+            parallel_for(begin, end, 0, std::forward<Fn>(fn));
+        }
 
-        void shutdown() {
-            is_active_ = false;
-            task_queue_.clear();
-            cv_all_tasks_done_.notify_all();
+        // 并行归约：map 可以是 T(i) 或 T(begin, end)，reduce 需满足结合律。
+        // 各区间的部分结果按区间顺序合并，结果与串行计算一致（不要求交换律）
+        template<typename T, typename MapFn, typename ReduceFn>
+        T parallel_reduce(size_t begin, size_t end, size_t grain, T identity, MapFn &&map, ReduceFn &&reduce) {
+            std::vector<std::pair<size_t, T> > partials;
+            std::mutex partials_mutex;
 
-            for (auto &worker: workers_) {
-                if (worker.joinable()) {
-                    worker.join();
+            parallel_for(begin, end, grain, [&](size_t chunk_begin, size_t chunk_end) {
+                T partial = identity;
+                if constexpr (std::is_invocable_v<MapFn &, size_t, size_t>) {
+                    partial = reduce(std::move(partial), map(chunk_begin, chunk_end));
+                } else {
+                    for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                        partial = reduce(std::move(partial), map(i));
+                    }
                 }
+                std::lock_guard<std::mutex> lock(partials_mutex);
+                partials.emplace_back(chunk_begin, std::move(partial));
+            });
+
+            std::sort(partials.begin(), partials.end(),
+                      [](const auto &a, const auto &b) { return a.first < b.first; });
+            T result = std::move(identity);
+            for (auto &partial: partials) {
+                result = reduce(std::move(result), std::move(partial.second));
             }
+            return result;
         }
 
+        // 并行变换：*(out + i) = fn(*(first + i))，要求随机访问迭代器，返回输出末尾迭代器
+        template<typename InputIt, typename OutputIt, typename Fn>
+        OutputIt parallel_transform(InputIt first, InputIt last, OutputIt out, size_t grain, Fn &&fn) {
+            const auto count = static_cast<size_t>(std::distance(first, last));
+            parallel_for(0, count, grain, [&](size_t chunk_begin, size_t chunk_end) {
+                auto in = first;
+                std::advance(in, chunk_begin);
+                auto dst = out;
+                std::advance(dst, chunk_begin);
+                for (size_t i = chunk_begin; i < chunk_end; ++i, ++in, ++dst) {
+                    *dst = fn(*in);
+                }
+            });
+            std::advance(out, count);
+            return out;
+        }
+
+        const PoolStats &getStats() const { return stats_; }
+
+        // 工作线程从休眠中被唤醒的累计次数；线程池空闲时应保持不变
+        std::uint64_t idleWakeups() const { return idle_workers_.wakeups(); }
+
+        // 汇总各工作线程的直方图和利用率，可以在任意线程随时调用
+        TelemetrySnapshot telemetry() const;
+
+        void shutdown();
+
     private:
-        void workerThread();
+        template<typename R>
+        friend class TaskFuture;
+
+        template<typename R>
+        std::promise<R> makePromise() {
+            return std::promise<R>(std::allocator_arg, ArenaAllocator<R>(arena_));
+        }
+
+        template<typename Body>
+        void runParallel(size_t begin, size_t end, size_t grain, Body &body) {
+            const size_t count = end - begin;
+            const size_t threads = std::max<size_t>(1, threadCount());
+            if (grain == 0) {
+                grain = std::max<size_t>(1, count / (threads * 8));
+            }
+            const size_t max_chunks = (count + grain - 1) / grain;
+            const size_t helpers = is_active_ ? std::min(threads, max_chunks - 1) : 0;
+            if (helpers == 0) {
+                body(begin, end);
+                return;
+            }
+
+            auto range = std::make_shared<detail::ParallelRange>(begin, end, grain, helpers + 1);
+            Body *body_ptr = &body;
+            for (size_t i = 0; i < helpers; ++i) {
+                post([range, body_ptr] { range->run(body_ptr); });
+            }
+            range->run(body_ptr);
+            range->wait();
+        }
+
+        void enqueue(Task &&task);
+
+        void enqueueBatch(std::vector<Task> &tasks);
+
+        bool popBatch(size_t worker_index, std::vector<Task> &batch);
+
+        bool popTask(size_t worker_index, Task &task);
+
+        bool stealTask(size_t thief_index, size_t lane, Task &task);
+
+        void runTask(Task &task, WorkerTelemetry &telemetry);
+
+        void finishTask();
+
+        void workerThread(size_t worker_index);
+
+        void planWorkerPlacement(const Config &config);
     };
 
     template<typename F>
@@ -175,3 +632,5 @@ namespace TinaToolBox {
         return pool.post(use_future_tag{}, std::forward<F>(std::get<1>(task)));
     }
 } // namespace TinaToolBox
+
+#include "TaskFuture.hpp"
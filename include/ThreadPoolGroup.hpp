@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "ThreadPool.hpp"
+
+namespace TinaToolBox {
+    // 每个 NUMA 节点一个子线程池，子池的工作线程只在本节点的 CPU 上运行。
+    // 内存密集的任务（例如构建 Arrow 列）提交到同一个子池，
+    // 缓冲区由本节点的线程首次写入，后续访问也留在同一个插槽上。
+    // 单节点机器上只有一个子池，行为与普通 ThreadPool 相同。
+    class ThreadPoolGroup {
+    public:
+        // base 中的 thread_count 为 0 时每个子池使用其节点的全部 CPU，否则按节点 CPU 数比例拆分；
+        // affinity 与 numa_aware 会被忽略，由各节点的 CPU 列表决定
+        explicit ThreadPoolGroup(const ThreadPool::Config &base = ThreadPool::Config());
+
+        ThreadPoolGroup(const ThreadPoolGroup &) = delete;
+
+        ThreadPoolGroup &operator=(const ThreadPoolGroup &) = delete;
+
+        [[nodiscard]] size_t nodeCount() const { return pools_.size(); }
+
+        [[nodiscard]] const NumaNode &node(size_t index) const { return nodes_.at(index); }
+
+        ThreadPool &pool(size_t index) { return *pools_.at(index); }
+
+        // 把第 key 个工作单元（例如列序号）固定映射到某个子池
+        ThreadPool &poolFor(size_t key) { return *pools_[key % pools_.size()]; }
+
+        void waitForAll();
+
+        void shutdown();
+
+    private:
+        std::vector<NumaNode> nodes_;
+        std::vector<std::unique_ptr<ThreadPool> > pools_;
+    };
+} // namespace TinaToolBox
@@ -1,111 +1,393 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <new>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <chrono>
+#include "EventCount.hpp"
 
 namespace TinaToolBox {
 
+// 队列实现策略：
+// PriorityPolicy      互斥锁 + 二叉堆，按 operator> 排序出队（默认，线程池共享队列使用）
+// LockFreeRingPolicy  有界无锁 MPMC 环形缓冲区，先进先出，容量为编译期常量且必须是 2 的幂
+struct PriorityPolicy {
+};
+
+template<size_t Capacity>
+struct LockFreeRingPolicy {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "LockFreeRingPolicy capacity must be a power of two");
+};
+
+template <typename T, typename Policy = PriorityPolicy>
+class ThreadSafeQueue;
+
 template <typename T>
-class ThreadSafeQueue {
+class ThreadSafeQueue<T, PriorityPolicy> {
 public:
-    // 使用 priority_queue 作为内部容器
-    using PriorityQueue = std::priority_queue<T, std::vector<T>, std::greater<T>>;
-
     bool empty() const {
-        std::lock_guard<std::mutex> lock{_queue_mutex};
-        return _queue.empty();
+        auto lock = acquire();
+        return _heap.empty();
     }
 
     size_t size() const {
-        std::lock_guard<std::mutex> lock{_queue_mutex};
-        return _queue.size();
+        auto lock = acquire();
+        return _heap.size();
     }
 
     void clear() {
-        std::lock_guard<std::mutex> lock{_queue_mutex};
-        _queue = PriorityQueue();  // 创建新的空优先队列
+        auto lock = acquire();
+        _heap.clear();
         _queue_cv.notify_all();  // 通知所有等待的线程
     }
 
     void push(const T& value) {
         {
-            std::lock_guard<std::mutex> lock{_queue_mutex};
-            _queue.push(value);
+            auto lock = acquire();
+            _heap.push_back(value);
+            std::push_heap(_heap.begin(), _heap.end(), Compare());
         }
         _queue_cv.notify_one();  // 在锁外通知
     }
 
     void push(T&& value) {
         {
-            std::lock_guard<std::mutex> lock{_queue_mutex};
-            _queue.push(std::move(value));
+            auto lock = acquire();
+            _heap.push_back(std::move(value));
+            std::push_heap(_heap.begin(), _heap.end(), Compare());
         }
         _queue_cv.notify_one();  // 在锁外通知
     }
 
-    // 批量弹出
+    // 批量入队：整批只加一次锁
+    template<typename Iterator>
+    void push_batch(Iterator first, Iterator last) {
+        size_t count = 0;
+        {
+            auto lock = acquire();
+            for (; first != last; ++first, ++count) {
+                _heap.push_back(*first);
+                std::push_heap(_heap.begin(), _heap.end(), Compare());
+            }
+        }
+        if (count == 1) {
+            _queue_cv.notify_one();
+        } else if (count > 1) {
+            _queue_cv.notify_all();
+        }
+    }
+
+    // 批量弹出，按优先级顺序取出
     size_t try_pop_batch(std::vector<T>& out, size_t max_items) {
-        std::lock_guard<std::mutex> lock{_queue_mutex};
-        if (_queue.empty()) {
+        return try_pop_batch(out, max_items, 1);
+    }
+
+    // 公平份额的批量弹出：最多取走当前元素数的 1/share_divisor（至少 1 个，至多 max_items），
+    // 份额在同一次加锁内计算，多个消费者分批取用时不会一个取光而其他空闲
+    size_t try_pop_batch(std::vector<T>& out, size_t max_items, size_t share_divisor) {
+        auto lock = acquire();
+        if (_heap.empty()) {
             return 0;
         }
 
-        size_t items_to_pop = std::min(max_items, _queue.size());
+        const size_t share = _heap.size() / std::max<size_t>(1, share_divisor);
+        size_t items_to_pop = std::min(max_items, std::max<size_t>(1, share));
         out.clear();
         out.reserve(items_to_pop);
 
         for (size_t i = 0; i < items_to_pop; ++i) {
-            if (_queue.empty()) break;  // 安全检查
-            out.push_back(std::move(const_cast<T&>(_queue.top())));
-            _queue.pop();
+            out.push_back(popTop());
         }
 
         return out.size();  // 返回实际弹出的数量
     }
 
     bool try_pop(T& value) {
-        std::lock_guard<std::mutex> lock{_queue_mutex};
-        if (_queue.empty()) {
+        auto lock = acquire();
+        if (_heap.empty()) {
             return false;
         }
-        
-        value = std::move(const_cast<T&>(_queue.top()));
-        _queue.pop();
+
+        value = popTop();
         return true;
     }
 
     T pop() {
-        std::unique_lock<std::mutex> lock{_queue_mutex};
-        while (_queue.empty()) {  // 使用while循环防止虚假唤醒
+        auto lock = acquire();
+        while (_heap.empty()) {  // 使用while循环防止虚假唤醒
             _queue_cv.wait(lock);
         }
-        
-        T value = std::move(const_cast<T&>(_queue.top()));
-        _queue.pop();
-        return value;
+
+        return popTop();
     }
 
     // 添加带超时的pop
     template<typename Rep, typename Period>
     bool pop_for(T& value, const std::chrono::duration<Rep, Period>& timeout) {
-        std::unique_lock<std::mutex> lock{_queue_mutex};
-        if (!_queue_cv.wait_for(lock, timeout, [this] { return !_queue.empty(); })) {
+        auto lock = acquire();
+        if (!_queue_cv.wait_for(lock, timeout, [this] { return !_heap.empty(); })) {
             return false;
         }
-        
-        value = std::move(const_cast<T&>(_queue.top()));
-        _queue.pop();
+
+        value = popTop();
         return true;
     }
 
+    // 互斥锁的累计加锁次数（不含条件变量等待返回时的重新加锁），用于观察批量操作省下的加锁
+    size_t lockCount() const {
+        return _lock_count.load(std::memory_order_relaxed);
+    }
+
 private:
+    // 计数只在持有锁时更新，不需要原子的读-改-写
+    std::unique_lock<std::mutex> acquire() const {
+        std::unique_lock<std::mutex> lock{_queue_mutex};
+        _lock_count.store(_lock_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return lock;
+    }
+
+    // 与 std::priority_queue<T, vector<T>, greater<T>> 的出队顺序相同
+    using Compare = std::greater<T>;
+
+    // pop_heap 把堆顶换到末尾，之后可以合法地移动出来，不需要 const_cast top()
+    T popTop() {
+        std::pop_heap(_heap.begin(), _heap.end(), Compare());
+        T value = std::move(_heap.back());
+        _heap.pop_back();
+        return value;
+    }
+
     mutable std::mutex _queue_mutex;
+    mutable std::atomic<size_t> _lock_count{0};
     std::condition_variable _queue_cv;
-    PriorityQueue _queue;
+    std::vector<T> _heap;
 };
 
-} // namespace TinaToolBox
+// Dmitry Vyukov 的有界 MPMC 队列：每个槽位带一个序号，生产者和消费者各自只对
+// 一个位置计数器做 CAS，槽位的发布通过序号的 release/acquire 完成，没有互斥锁。
+// 队列满时 push 自旋让出 CPU 直到有空位，不希望阻塞的生产者使用 try_push。
+// 阻塞式的 pop/pop_for 在队列为空时通过 EventCount 休眠。
+template <typename T, size_t Capacity>
+class ThreadSafeQueue<T, LockFreeRingPolicy<Capacity>> {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "LockFreeRingPolicy requires a nothrow move constructible element type");
+
+public:
+    ThreadSafeQueue() : _cells(std::make_unique<Cell[]>(Capacity)) {
+        for (size_t i = 0; i < Capacity; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
 
+    ThreadSafeQueue(const ThreadSafeQueue&) = delete;
+
+    ThreadSafeQueue& operator=(const ThreadSafeQueue&) = delete;
+
+    ~ThreadSafeQueue() {
+        clear();
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    // 并发修改时 empty/size 只是近似值
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t size() const {
+        const size_t dequeue_pos = _dequeue_pos.load(std::memory_order_acquire);
+        const size_t enqueue_pos = _enqueue_pos.load(std::memory_order_acquire);
+        return enqueue_pos > dequeue_pos ? std::min(enqueue_pos - dequeue_pos, Capacity) : 0;
+    }
+
+    void clear() {
+        while (dequeue([](T&&) {
+        })) {
+        }
+    }
+
+    bool try_push(const T& value) {
+        T copy(value);
+        return enqueue(std::move(copy));
+    }
+
+    bool try_push(T&& value) {
+        return enqueue(std::move(value));
+    }
+
+    void push(const T& value) {
+        T copy(value);
+        push(std::move(copy));
+    }
+
+    void push(T&& value) {
+        // enqueue 只在成功时才移动 value，失败重试是安全的
+        for (size_t spins = 0; !enqueue(std::move(value)); ++spins) {
+            if (spins < SPIN_LIMIT) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    // 批量入队；无锁实现中每个元素仍单独占位，满时同 push 一样等待空位
+    template<typename Iterator>
+    void push_batch(Iterator first, Iterator last) {
+        for (; first != last; ++first) {
+            push(*first);
+        }
+    }
+
+    // 批量弹出
+    size_t try_pop_batch(std::vector<T>& out, size_t max_items) {
+        out.clear();
+        out.reserve(std::min(max_items, size()));
+        while (out.size() < max_items && dequeue([&out](T&& item) {
+            out.push_back(std::move(item));
+        })) {
+        }
+        return out.size();
+    }
+
+    // 公平份额的批量弹出，与互斥锁实现的语义相同；并发修改时份额按近似的 size() 计算
+    size_t try_pop_batch(std::vector<T>& out, size_t max_items, size_t share_divisor) {
+        const size_t share = size() / std::max<size_t>(1, share_divisor);
+        return try_pop_batch(out, std::min(max_items, std::max<size_t>(1, share)));
+    }
+
+    bool try_pop(T& value) {
+        return dequeue([&value](T&& item) {
+            value = std::move(item);
+        });
+    }
+
+    T pop() {
+        alignas(T) unsigned char buffer[sizeof(T)];
+        T* result = nullptr;
+        auto take = [&buffer, &result](T&& item) {
+            result = ::new(static_cast<void*>(buffer)) T(std::move(item));
+        };
+
+        while (!dequeue(take)) {
+            auto key = _not_empty.prepareWait();
+            if (dequeue(take)) {
+                _not_empty.cancelWait();
+                break;
+            }
+            _not_empty.commitWait(key);
+        }
+
+        T value(std::move(*result));
+        result->~T();
+        return value;
+    }
+
+    // 添加带超时的pop
+    template<typename Rep, typename Period>
+    bool pop_for(T& value, const std::chrono::duration<Rep, Period>& timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!try_pop(value)) {
+            auto key = _not_empty.prepareWait();
+            if (try_pop(value)) {
+                _not_empty.cancelWait();
+                return true;
+            }
+            auto remaining = deadline - std::chrono::steady_clock::now();
+            if (remaining <= std::chrono::steady_clock::duration::zero()) {
+                _not_empty.cancelWait();
+                return false;
+            }
+            _not_empty.commitWaitFor(key, remaining);
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t SPIN_LIMIT = 64;
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    bool enqueue(T&& value) {
+        Cell* cell;
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &_cells[pos & MASK];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // 队列已满
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        ::new(static_cast<void*>(cell->storage)) T(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        _not_empty.notifyOne();
+        return true;
+    }
+
+    // consume 接收槽位中的元素；无论 consume 是否抛出异常，槽位都会被释放
+    template<typename Consumer>
+    bool dequeue(Consumer&& consume) {
+        Cell* cell;
+        size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &_cells[pos & MASK];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // 队列为空
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        struct Release {
+            Cell* cell;
+            size_t next_sequence;
+
+            ~Release() {
+                cell->item()->~T();
+                cell->sequence.store(next_sequence, std::memory_order_release);
+            }
+        } release{cell, pos + Capacity};
+
+        consume(std::move(*cell->item()));
+        return true;
+    }
+
+    // 生产者和消费者的位置计数器放在不同缓存行，避免伪共享
+    alignas(CACHE_LINE) std::atomic<size_t> _enqueue_pos{0};
+    alignas(CACHE_LINE) std::atomic<size_t> _dequeue_pos{0};
+    alignas(CACHE_LINE) std::unique_ptr<Cell[]> _cells;
+    EventCount _not_empty;
+};
+
+} // namespace TinaToolBox
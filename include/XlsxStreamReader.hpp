@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ZipArchive.hpp"
+
+namespace TinaToolBox {
+    // 直接从 xlsx 压缩包中流式读取工作表，不构建完整的工作簿对象。
+    // 共享字符串表和样式在构造时一次性加载（单元格只保存索引，这部分无法避免），
+    // 工作表本身按固定大小的块解压和解析，逐行回调，内存占用与工作表大小无关。
+    class XlsxStreamReader {
+    public:
+        struct Sheet {
+            std::string name;
+            // 压缩包内的路径，例如 xl/worksheets/sheet1.xml
+            std::string path;
+        };
+
+        struct Cell {
+            enum class Type { Number, SharedString, String, Boolean, Error };
+
+            // 从 0 开始的列号
+            std::uint32_t column = 0;
+            Type type = Type::Number;
+            // Number 和 Boolean（0/1）的值
+            double number = 0.0;
+            // SharedString 的索引
+            std::uint32_t shared_index = 0;
+            // String 和 Error 的文本，只在行回调期间有效
+            std::string_view text;
+            // 数字单元格使用了日期/时间格式，number 是 Excel 序列日期
+            bool is_date = false;
+        };
+
+        // 工作表 <dimension> 给出的已用区域大小，缺失时为 0
+        struct Dimension {
+            std::uint32_t rows = 0;
+            std::uint32_t columns = 0;
+        };
+
+        // row 从 1 开始；cells 只包含有值的单元格，按列号递增
+        using RowCallback = std::function<void(std::uint64_t row, const std::vector<Cell> &cells)>;
+        // 已解析的解压后字节数和工作表 XML 的总字节数
+        using ProgressCallback = std::function<void(std::uint64_t bytes_parsed, std::uint64_t total_bytes)>;
+
+        // 文件不是有效的 xlsx 时抛出 std::runtime_error
+        explicit XlsxStreamReader(const std::string &path);
+
+        [[nodiscard]] const std::vector<Sheet> &sheets() const { return sheets_; }
+
+        // 工作簿中当前激活的工作表（workbookView activeTab）
+        [[nodiscard]] size_t activeSheet() const { return active_sheet_; }
+
+        // 使用 1904 日期系统
+        [[nodiscard]] bool date1904() const { return date1904_; }
+
+        [[nodiscard]] size_t sharedStringCount() const { return shared_string_offsets_.size(); }
+
+        [[nodiscard]] std::string_view sharedString(std::uint32_t index) const;
+
+        // 只解压工作表开头直到 <sheetData>，读取 <dimension>
+        [[nodiscard]] Dimension dimension(size_t sheet) const;
+
+        // 工作表 XML 的一段，可以交给 parseRange 独立解析
+        using RangeCallback = std::function<void(std::string &&xml)>;
+
+        // 顺序解析整个工作表；回调抛出的异常会中止解析并原样传出
+        void readSheet(size_t sheet, const RowCallback &on_row, const ProgressCallback &on_progress = {}) const;
+
+        // 解压工作表并在 <row> 边界处切分成约 range_bytes 大小的片段，在调用线程上按顺序回调。
+        // 除第一个片段外，每个片段都从带 r 行号属性的 <row> 开始，不依赖前面片段的解析状态。
+        // 整个工作表都没有行号属性时无法切分，只会回调一次
+        void splitSheet(size_t sheet, size_t range_bytes, const RangeCallback &on_range,
+                        const ProgressCallback &on_progress = {}) const;
+
+        // 解析 splitSheet 产生的一个片段；只读访问共享字符串和样式，可以在多个线程上同时调用
+        void parseRange(std::string_view xml, const RowCallback &on_row) const;
+
+        // 工作表 XML 解压后的字节数
+        [[nodiscard]] std::uint64_t sheetSize(size_t sheet) const { return sheetEntry(sheet).uncompressed_size; }
+
+        [[nodiscard]] const ZipArchive &archive() const { return archive_; }
+
+        // "B12" 这样的单元格引用中的列号，从 0 开始；没有列字母时返回 -1
+        static std::int64_t columnFromReference(std::string_view reference);
+
+        // Excel 内置日期格式编号，或自定义格式代码中包含日期/时间占位符
+        static bool isDateFormat(std::uint32_t num_fmt_id, std::string_view format_code);
+
+        // xml[from, end) 中最后一个带 r 属性的 <row> 开始标签的位置，没有时返回 npos
+        static size_t findRowBoundary(std::string_view xml, size_t from = 0);
+
+    private:
+        static constexpr size_t READ_BLOCK_SIZE = 64 * 1024;
+
+        const ZipArchive::Entry &sheetEntry(size_t sheet) const;
+
+        void loadWorkbook();
+
+        void loadSharedStrings(const std::string &path);
+
+        void loadStyles(const std::string &path);
+
+        ZipArchive archive_;
+        std::vector<Sheet> sheets_;
+        size_t active_sheet_ = 0;
+        bool date1904_ = false;
+        // 所有共享字符串连续存放，按偏移量索引，避免每个字符串一次分配
+        std::string shared_string_data_;
+        std::vector<std::pair<size_t, std::uint32_t> > shared_string_offsets_;
+        // cellXfs 下标 -> 是否为日期格式
+        std::vector<bool> date_styles_;
+    };
+} // namespace TinaToolBox
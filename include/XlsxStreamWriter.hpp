@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ZipWriter.hpp"
+
+namespace TinaToolBox {
+    // 流式写出只有一个工作表的 xlsx：行 XML 直接压缩写入 sheet1.xml，不在内存中保留单元格。
+    // 文本写入共享字符串表（相同文本只保存一次）；共享字符串总量超过上限后，新出现的文本改为内联字符串，
+    // 内存占用不随行数增长。共享字符串表、样式和工作簿在 finish() 时写出
+    class XlsxStreamWriter {
+    public:
+        struct Cell {
+            enum class Type { Number, Date, Boolean, String, SharedString };
+
+            // 从 0 开始的列号
+            std::uint32_t column = 0;
+            Type type = Type::Number;
+            // Number 和 Boolean（0/1）的值；Date 为 Excel 序列日期
+            double number = 0.0;
+            // SharedString 为 sharedString() 返回的索引
+            std::uint32_t shared_index = 0;
+            // String 的文本，只需要在 writeRow 期间有效
+            std::string_view text;
+        };
+
+        // 写入 <dimension>，为 0 时省略（默认值初始化为 0）
+        struct Dimension {
+            std::uint32_t rows;
+            std::uint32_t columns;
+        };
+
+        static constexpr std::uint32_t MAX_ROWS = 1048576;
+        static constexpr std::uint32_t MAX_COLUMNS = 16384;
+
+        // 文件无法创建时抛出 std::runtime_error
+        explicit XlsxStreamWriter(const std::string &path, Dimension dimension = {},
+                                  std::string sheet_name = "Sheet1");
+
+        // 把文本加入共享字符串表并返回索引，用于预先映射字典列；表已满时返回 NO_SHARED_STRING
+        std::uint32_t sharedString(std::string_view text);
+
+        static constexpr std::uint32_t NO_SHARED_STRING = 0xFFFFFFFF;
+
+        // row 从 1 开始且必须递增；cells 按列号递增，空单元格不需要出现，没有单元格的行不写出
+        void writeRow(std::uint64_t row, const std::vector<Cell> &cells);
+
+        // 写出其余部分并关闭文件，之后不能再写入
+        void finish();
+
+    private:
+        static constexpr size_t FLUSH_BYTES = 256 * 1024;
+        // 共享字符串表中文本的总字节数上限
+        static constexpr size_t SHARED_STRING_LIMIT = 64 * 1024 * 1024;
+
+        void appendCellReference(std::uint32_t column, std::uint64_t row);
+
+        void appendText(std::string_view text);
+
+        void flush();
+
+        void writeSharedStrings();
+
+        void writeWorkbookParts();
+
+        ZipWriter zip_;
+        std::string sheet_name_;
+        std::string buffer_;
+        std::uint64_t last_row_ = 0;
+        std::uint64_t shared_string_count_ = 0;
+        size_t shared_string_bytes_ = 0;
+        // 按索引顺序保存文本；deque 追加时不移动已有元素，索引表的键直接引用这里的文本，
+        // 用 string_view 查找，不需要为每个单元格构造临时 std::string
+        std::deque<std::string> shared_strings_;
+        std::unordered_map<std::string_view, std::uint32_t> shared_string_index_;
+        bool finished_ = false;
+    };
+} // namespace TinaToolBox
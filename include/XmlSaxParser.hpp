@@ -0,0 +1,360 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace TinaToolBox {
+    // 开始标签的属性列表，名称已去掉命名空间前缀，值已解码实体。
+    // 视图只在 startElement 回调期间有效
+    class XmlAttributes {
+    public:
+        [[nodiscard]] std::string_view get(std::string_view name, std::string_view fallback = {}) const {
+            for (const auto &[key, value]: items_) {
+                if (key == name) {
+                    return value;
+                }
+            }
+            return fallback;
+        }
+
+        [[nodiscard]] bool has(std::string_view name) const {
+            for (const auto &item: items_) {
+                if (item.first == name) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        [[nodiscard]] const std::vector<std::pair<std::string_view, std::string_view> > &items() const {
+            return items_;
+        }
+
+    private:
+        template<typename Handler>
+        friend class XmlSaxParser;
+
+        std::vector<std::pair<std::string_view, std::string_view> > items_;
+    };
+
+    // 推送式（SAX）XML 解析器，只覆盖 OOXML 用到的子集：元素、属性、文本、CDATA、
+    // 预定义实体和字符引用；处理指令、注释和 DOCTYPE 会被跳过，不做 DTD 校验。
+    // 数据可以按任意边界分块 feed()，跨块的不完整标记会暂存到下一次调用，内存只和最长的单个标记有关。
+    //
+    // Handler 需要提供：
+    //   void startElement(std::string_view name, const XmlAttributes &attributes);
+    //   void endElement(std::string_view name);
+    //   void characters(std::string_view text);   // 同一段文本可能分多次回调
+    template<typename Handler>
+    class XmlSaxParser {
+    public:
+        explicit XmlSaxParser(Handler &handler) : handler_(handler) {}
+
+        void feed(const char *data, size_t size) {
+            if (buffer_.empty()) {
+                // 没有暂存数据时直接解析输入，只复制末尾不完整的标记
+                const size_t used = parse(std::string_view(data, size), false);
+                buffer_.assign(data + used, size - used);
+            } else {
+                buffer_.append(data, size);
+                buffer_.erase(0, parse(buffer_, false));
+            }
+        }
+
+        // 输入结束，残留未闭合的标记视为格式错误
+        void finish() {
+            buffer_.erase(0, parse(buffer_, true));
+            if (!buffer_.empty()) {
+                throw std::runtime_error("Unexpected end of XML document");
+            }
+        }
+
+        [[nodiscard]] std::uint64_t bytesParsed() const { return consumed_; }
+
+    private:
+        static std::string_view localName(std::string_view name) {
+            const auto colon = name.rfind(':');
+            return colon == std::string_view::npos ? name : name.substr(colon + 1);
+        }
+
+        static bool isSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        static void appendUtf8(std::string &out, std::uint32_t cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x110000) {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+
+        // 解码实体后追加到 out，无法识别的实体按原样保留
+        static void decode(std::string_view text, std::string &out) {
+            size_t pos = 0;
+            while (pos < text.size()) {
+                const auto amp = text.find('&', pos);
+                if (amp == std::string_view::npos) {
+                    out.append(text.substr(pos));
+                    return;
+                }
+                out.append(text.substr(pos, amp - pos));
+                const auto semi = text.find(';', amp);
+                if (semi == std::string_view::npos) {
+                    out.append(text.substr(amp));
+                    return;
+                }
+                const std::string_view entity = text.substr(amp + 1, semi - amp - 1);
+                if (entity == "amp") {
+                    out.push_back('&');
+                } else if (entity == "lt") {
+                    out.push_back('<');
+                } else if (entity == "gt") {
+                    out.push_back('>');
+                } else if (entity == "quot") {
+                    out.push_back('"');
+                } else if (entity == "apos") {
+                    out.push_back('\'');
+                } else if (entity.size() > 1 && entity[0] == '#') {
+                    const bool hex = entity[1] == 'x' || entity[1] == 'X';
+                    std::uint32_t cp = 0;
+                    bool valid = entity.size() > (hex ? 2u : 1u);
+                    for (size_t i = hex ? 2 : 1; i < entity.size() && valid; ++i) {
+                        const char c = entity[i];
+                        std::uint32_t digit;
+                        if (c >= '0' && c <= '9') {
+                            digit = static_cast<std::uint32_t>(c - '0');
+                        } else if (hex && c >= 'a' && c <= 'f') {
+                            digit = static_cast<std::uint32_t>(c - 'a' + 10);
+                        } else if (hex && c >= 'A' && c <= 'F') {
+                            digit = static_cast<std::uint32_t>(c - 'A' + 10);
+                        } else {
+                            valid = false;
+                            break;
+                        }
+                        cp = cp * (hex ? 16 : 10) + digit;
+                        valid = cp < 0x110000;
+                    }
+                    if (valid) {
+                        appendUtf8(out, cp);
+                    } else {
+                        out.append(text.substr(amp, semi - amp + 1));
+                    }
+                } else {
+                    out.append(text.substr(amp, semi - amp + 1));
+                }
+                pos = semi + 1;
+            }
+        }
+
+        void emitText(std::string_view raw) {
+            if (raw.empty()) {
+                return;
+            }
+            if (raw.find('&') == std::string_view::npos) {
+                handler_.characters(raw);
+                return;
+            }
+            text_.clear();
+            decode(raw, text_);
+            handler_.characters(text_);
+        }
+
+        // 在 '<' 处查找与之配对的 '>'，跳过引号中的内容
+        static size_t findTagEnd(std::string_view data, size_t from) {
+            char quote = 0;
+            for (size_t i = from; i < data.size(); ++i) {
+                const char c = data[i];
+                if (quote) {
+                    if (c == quote) {
+                        quote = 0;
+                    }
+                } else if (c == '"' || c == '\'') {
+                    quote = c;
+                } else if (c == '>') {
+                    return i;
+                }
+            }
+            return std::string_view::npos;
+        }
+
+        void startTag(std::string_view tag) {
+            // tag 不含 '<' 和 '>'
+            bool self_closing = false;
+            if (!tag.empty() && tag.back() == '/') {
+                self_closing = true;
+                tag.remove_suffix(1);
+            }
+            size_t pos = 0;
+            while (pos < tag.size() && !isSpace(tag[pos])) {
+                ++pos;
+            }
+            const std::string_view name = localName(tag.substr(0, pos));
+
+            // 先把所有属性值解码进同一个缓冲区，最后再生成视图，避免扩容导致视图失效
+            attribute_spans_.clear();
+            attribute_values_.clear();
+            while (pos < tag.size()) {
+                while (pos < tag.size() && isSpace(tag[pos])) {
+                    ++pos;
+                }
+                const size_t name_start = pos;
+                while (pos < tag.size() && tag[pos] != '=' && !isSpace(tag[pos])) {
+                    ++pos;
+                }
+                if (pos == name_start) {
+                    break;
+                }
+                const std::string_view attribute_name = localName(tag.substr(name_start, pos - name_start));
+                while (pos < tag.size() && (isSpace(tag[pos]) || tag[pos] == '=')) {
+                    ++pos;
+                }
+                if (pos >= tag.size() || (tag[pos] != '"' && tag[pos] != '\'')) {
+                    throw std::runtime_error("Malformed XML attribute in <" + std::string(name) + ">");
+                }
+                const char quote = tag[pos++];
+                const auto value_end = tag.find(quote, pos);
+                if (value_end == std::string_view::npos) {
+                    throw std::runtime_error("Malformed XML attribute in <" + std::string(name) + ">");
+                }
+                const size_t offset = attribute_values_.size();
+                decode(tag.substr(pos, value_end - pos), attribute_values_);
+                attribute_spans_.push_back({attribute_name, {offset, attribute_values_.size() - offset}});
+                pos = value_end + 1;
+            }
+
+            attributes_.items_.clear();
+            for (const auto &[attribute_name, span]: attribute_spans_) {
+                attributes_.items_.emplace_back(attribute_name,
+                                                std::string_view(attribute_values_).substr(span.first, span.second));
+            }
+            handler_.startElement(name, attributes_);
+            if (self_closing) {
+                handler_.endElement(name);
+            }
+        }
+
+        // 返回已消费的字节数，剩余部分是不完整的标记
+        size_t parse(std::string_view data, bool final) {
+            size_t pos = 0;
+            while (pos < data.size()) {
+                if (data[pos] != '<') {
+                    const auto lt = data.find('<', pos);
+                    if (lt == std::string_view::npos) {
+                        // 文本没有结束：最后一个未闭合的实体留到下一块
+                        size_t end = data.size();
+                        if (!final) {
+                            const auto amp = data.rfind('&');
+                            if (amp != std::string_view::npos && amp >= pos &&
+                                data.find(';', amp) == std::string_view::npos) {
+                                end = amp;
+                            }
+                        }
+                        emitText(data.substr(pos, end - pos));
+                        pos = end;
+                        break;
+                    }
+                    emitText(data.substr(pos, lt - pos));
+                    pos = lt;
+                    continue;
+                }
+
+                const std::string_view rest = data.substr(pos);
+                size_t end;
+                if (rest.size() < 2) {
+                    break;
+                }
+                if (rest[1] == '?') {
+                    end = rest.find("?>");
+                    if (end == std::string_view::npos) {
+                        break;
+                    }
+                    end += 2;
+                } else if (rest[1] == '!') {
+                    if (rest.size() < 9 && !final) {
+                        // 还不足以区分注释、CDATA 和 DOCTYPE
+                        break;
+                    }
+                    if (rest.compare(0, 4, "<!--") == 0) {
+                        end = rest.find("-->", 4);
+                        if (end == std::string_view::npos) {
+                            break;
+                        }
+                        end += 3;
+                    } else if (rest.compare(0, 9, "<![CDATA[") == 0) {
+                        end = rest.find("]]>", 9);
+                        if (end == std::string_view::npos) {
+                            break;
+                        }
+                        if (end > 9) {
+                            handler_.characters(rest.substr(9, end - 9));
+                        }
+                        end += 3;
+                    } else {
+                        // DOCTYPE，内部子集可能包含 '>'
+                        int depth = 0;
+                        end = std::string_view::npos;
+                        for (size_t i = 2; i < rest.size(); ++i) {
+                            if (rest[i] == '[') {
+                                ++depth;
+                            } else if (rest[i] == ']') {
+                                --depth;
+                            } else if (rest[i] == '>' && depth <= 0) {
+                                end = i + 1;
+                                break;
+                            }
+                        }
+                        if (end == std::string_view::npos) {
+                            break;
+                        }
+                    }
+                } else if (rest[1] == '/') {
+                    end = rest.find('>', 2);
+                    if (end == std::string_view::npos) {
+                        break;
+                    }
+                    std::string_view name = rest.substr(2, end - 2);
+                    while (!name.empty() && isSpace(name.back())) {
+                        name.remove_suffix(1);
+                    }
+                    handler_.endElement(localName(name));
+                    end += 1;
+                } else {
+                    end = findTagEnd(rest, 1);
+                    if (end == std::string_view::npos) {
+                        break;
+                    }
+                    startTag(rest.substr(1, end - 1));
+                    end += 1;
+                }
+                pos += end;
+            }
+
+            consumed_ += pos;
+            return pos;
+        }
+
+        Handler &handler_;
+        std::string buffer_;
+        std::string text_;
+        std::string attribute_values_;
+        std::vector<std::pair<std::string_view, std::pair<size_t, size_t> > > attribute_spans_;
+        XmlAttributes attributes_;
+        std::uint64_t consumed_ = 0;
+    };
+} // namespace TinaToolBox
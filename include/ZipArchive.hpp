@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace TinaToolBox {
+    class ZipEntryReader;
+
+    // 只读 ZIP 归档：解析中央目录（支持 ZIP64），按需流式解压单个条目。
+    // 不会把整个归档或条目读入内存，每个 ZipEntryReader 独立打开文件，可以在不同线程并发读取。
+    class ZipArchive {
+    public:
+        struct Entry {
+            std::string name;
+            std::uint64_t compressed_size = 0;
+            std::uint64_t uncompressed_size = 0;
+            std::uint64_t local_header_offset = 0;
+            std::uint32_t crc32 = 0;
+            // 0 = stored，8 = deflate
+            std::uint16_t method = 0;
+        };
+
+        // 文件无法打开或不是有效的 ZIP 时抛出 std::runtime_error
+        explicit ZipArchive(std::string path);
+
+        [[nodiscard]] const std::vector<Entry> &entries() const { return entries_; }
+
+        [[nodiscard]] const Entry *find(std::string_view name) const;
+
+        [[nodiscard]] std::unique_ptr<ZipEntryReader> open(const Entry &entry) const;
+
+        // 读取整个条目，只用于 workbook.xml 这类小文件；条目不存在时返回 false
+        bool readAll(std::string_view name, std::string &out) const;
+
+        [[nodiscard]] const std::string &path() const { return path_; }
+
+    private:
+        void readCentralDirectory(std::ifstream &file);
+
+        std::string path_;
+        std::vector<Entry> entries_;
+    };
+
+    // 单个条目的流式解压器，内部只保留固定大小的输入缓冲区。
+    // 读到末尾时校验 CRC32，不一致时抛出 std::runtime_error
+    class ZipEntryReader {
+    public:
+        ZipEntryReader(const std::string &path, const ZipArchive::Entry &entry);
+
+        ~ZipEntryReader();
+
+        ZipEntryReader(const ZipEntryReader &) = delete;
+
+        ZipEntryReader &operator=(const ZipEntryReader &) = delete;
+
+        // 读取最多 size 字节的解压数据，返回 0 表示条目已读完
+        size_t read(char *buffer, size_t size);
+
+        [[nodiscard]] std::uint64_t uncompressedBytesRead() const { return produced_; }
+
+        [[nodiscard]] std::uint64_t uncompressedSize() const { return entry_.uncompressed_size; }
+
+    private:
+        static constexpr size_t INPUT_BUFFER_SIZE = 256 * 1024;
+
+        size_t fillInput();
+
+        void finishEntry();
+
+        ZipArchive::Entry entry_;
+        std::ifstream file_;
+        std::vector<char> input_;
+        std::uint64_t compressed_remaining_ = 0;
+        std::uint64_t produced_ = 0;
+        std::uint32_t crc_ = 0;
+        bool finished_ = false;
+        // z_stream 的不透明指针，避免在头文件中引入 zlib.h
+        struct Inflater;
+        std::unique_ptr<Inflater> inflater_;
+    };
+} // namespace TinaToolBox
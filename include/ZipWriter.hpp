@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace TinaToolBox {
+    // 顺序写入的 ZIP 归档：每个条目边写边压缩（raw deflate），结束时回填本地文件头中的 CRC32 和大小。
+    // 内存只有固定大小的输出缓冲区。不支持 ZIP64，单个条目或整个归档超过 4 GiB 时抛出 std::runtime_error
+    class ZipWriter {
+    public:
+        // 文件无法创建时抛出 std::runtime_error
+        explicit ZipWriter(const std::string &path);
+
+        ~ZipWriter();
+
+        ZipWriter(const ZipWriter &) = delete;
+
+        ZipWriter &operator=(const ZipWriter &) = delete;
+
+        // level 为 zlib 压缩级别（0-9），-1 使用默认级别；上一个条目未结束时先结束它
+        void beginEntry(const std::string &name, int level = -1);
+
+        void write(const char *data, size_t size);
+
+        void write(std::string_view data) { write(data.data(), data.size()); }
+
+        void endEntry();
+
+        // 写入中央目录；析构时未调用则归档不完整
+        void close();
+
+    private:
+        struct Entry {
+            std::string name;
+            std::uint64_t local_header_offset = 0;
+            std::uint64_t compressed_size = 0;
+            std::uint64_t uncompressed_size = 0;
+            std::uint32_t crc32 = 0;
+        };
+
+        static constexpr size_t OUTPUT_BUFFER_SIZE = 256 * 1024;
+
+        void deflateInput(const char *data, size_t size, bool finish);
+
+        void writeRaw(const void *data, size_t size);
+
+        std::ofstream file_;
+        std::vector<Entry> entries_;
+        std::vector<char> output_;
+        std::uint64_t offset_ = 0;
+        std::uint16_t dos_time_ = 0;
+        std::uint16_t dos_date_ = 0;
+        bool in_entry_ = false;
+        bool closed_ = false;
+        // z_stream 的不透明指针，避免在头文件中引入 zlib.h
+        struct Deflater;
+        std::unique_ptr<Deflater> deflater_;
+    };
+} // namespace TinaToolBox
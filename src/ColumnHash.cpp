@@ -0,0 +1,32 @@
+#include "ColumnHash.hpp"
+
+#include <arrow/array/array_dict.h>
+#include <arrow/array/concatenate.h>
+
+namespace TinaToolBox {
+    namespace ColumnHash {
+        std::unique_ptr<HashColumn> makeHashColumn(const arrow::Array &array) {
+            if (array.type_id() == arrow::Type::DICTIONARY) {
+                return makeHashColumn(*static_cast<const arrow::DictionaryArray &>(array).indices());
+            }
+            std::unique_ptr<HashColumn> column;
+            visitArray(array, [&](const auto &typed) {
+                column = std::make_unique<TypedHashColumn<std::decay_t<decltype(typed)>>>(typed);
+            });
+            return column;
+        }
+
+        arrow::Result<std::shared_ptr<arrow::Array>> contiguous(std::shared_ptr<arrow::ChunkedArray> column) {
+            if (column->type()->id() == arrow::Type::DICTIONARY && column->num_chunks() > 1) {
+                ARROW_ASSIGN_OR_RAISE(column, arrow::DictionaryUnifier::UnifyChunkedArray(column));
+            }
+            if (column->num_chunks() == 0) {
+                return arrow::MakeEmptyArray(column->type());
+            }
+            if (column->num_chunks() == 1) {
+                return column->chunk(0);
+            }
+            return arrow::Concatenate(column->chunks());
+        }
+    }
+} // namespace TinaToolBox
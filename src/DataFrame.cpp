@@ -1,23 +1,37 @@
 #include "DataFrame.hpp"
+#include "DataFrameCache.hpp"
+#include "DataFrameSpill.hpp"
+#include "XlsxStreamReader.hpp"
+#include "XlsxStreamWriter.hpp"
 #include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
 #include <arrow/csv/api.h>
 #include <arrow/table.h>
 #include <arrow/type.h>
 #include <arrow/compute/api_scalar.h>
 #include <arrow/compute/exec.h>
 #include <arrow/builder.h>
+#include <arrow/util/byte_size.h>
+#include <arrow/util/compression.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+#include <parquet/statistics.h>
 #include <memory>
-#include <xlnt/xlnt.hpp>
 #include <spdlog/spdlog.h>
 #include <algorithm>
-#include <future>
 #include <filesystem>
 #include <ctime>
 #include <chrono>
 #include <unordered_map>
 #include <fstream>
 #include <cmath>
-#include <mutex>
+#include <cstdio>
+#include <array>
+#include <limits>
+#include <deque>
+#include <future>
+#include <optional>
 #include <time.h>
 
 #ifdef _WIN32
@@ -26,44 +40,165 @@
 
 namespace
 {
-    // 辅助函数：将xlnt datetime转换为时间戳
-    int64_t datetime_to_timestamp(const xlnt::datetime& dt) {
+    // 按本地时间格式化微秒时间戳，例如 2024-01-02 03:04:05
+    std::string formatLocalTimestamp(int64_t micros) {
+        const time_t seconds = static_cast<time_t>(micros / 1000000 - (micros % 1000000 < 0 ? 1 : 0));
         std::tm tm = {};
-        tm.tm_year = dt.year - 1900;
-        tm.tm_mon = dt.month - 1;
-        tm.tm_mday = dt.day;
-        tm.tm_hour = dt.hour;
-        tm.tm_min = dt.minute;
-        tm.tm_sec = dt.second;
-        time_t t = ::mktime(&tm);
-        if (t == -1) {
-            throw std::runtime_error("Failed to convert datetime to timestamp");
-        }
-        return static_cast<int64_t>(t) * 1000000LL;
-    }
-
-    // 辅助函数：将时间戳转换为xlnt datetime
-    xlnt::datetime timestamp_to_datetime(int64_t timestamp) {
-        time_t unix_time = timestamp / 1000000;
-        std::tm* tm = ::localtime(&unix_time);
-        if (!tm) {
+#ifdef _WIN32
+        const bool converted = ::localtime_s(&tm, &seconds) == 0;
+#else
+        const bool converted = ::localtime_r(&seconds, &tm) != nullptr;
+#endif
+        if (!converted) {
             throw std::runtime_error("Failed to convert timestamp to datetime");
         }
-
-        return xlnt::datetime(
-            tm->tm_year + 1900,
-            tm->tm_mon + 1,
-            tm->tm_mday,
-            tm->tm_hour,
-            tm->tm_min,
-            tm->tm_sec
-        );
+        char buffer[32];
+        const size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+        return std::string(buffer, length);
     }
+
+    // 辅助类：将 Excel 序列日期转换为本地时间的微秒时间戳（与 ExcelSerialConverter 互逆）。
+    // mktime 开销较大，按天缓存当天零点的时间戳；当天没有夏令时切换时直接加上秒数
+    class ExcelDateConverter {
+    public:
+        explicit ExcelDateConverter(bool date1904) : date1904_(date1904) {}
+
+        int64_t toTimestamp(double serial) {
+            const auto total_seconds = static_cast<int64_t>(std::llround(serial * 86400.0));
+            const int64_t day = floorDiv(total_seconds, 86400);
+            const int64_t seconds = total_seconds - day * 86400;
+
+            // 1900 日期系统沿用了 Lotus 的错误，把 1900 年当作闰年：序列号 60 是不存在的 1900-02-29，
+            // 因此 60 之前的日期以 1899-12-31 为第 0 天，之后以 1899-12-30 为第 0 天
+            const int64_t epoch = date1904_ ? DAYS_TO_1904_01_01 : (day < 60 ? DAYS_TO_1899_12_31 : DAYS_TO_1899_12_30);
+            const int64_t unix_day = epoch + day;
+
+            auto cached = day_cache_.find(unix_day);
+            if (cached == day_cache_.end()) {
+                const time_t midnight = localTime(unix_day, 0);
+                const time_t next_midnight = localTime(unix_day + 1, 0);
+                cached = day_cache_.emplace(unix_day, std::make_pair(midnight, next_midnight - midnight == 86400)).first;
+            }
+            const auto [midnight, uniform] = cached->second;
+            const time_t t = uniform || seconds == 0 ? midnight + seconds : localTime(unix_day, seconds);
+            return static_cast<int64_t>(t) * 1000000LL;
+        }
+
+    private:
+        static constexpr int64_t DAYS_TO_1899_12_30 = -25569;
+        static constexpr int64_t DAYS_TO_1899_12_31 = -25568;
+        static constexpr int64_t DAYS_TO_1904_01_01 = -24107;
+
+        static int64_t floorDiv(int64_t a, int64_t b) {
+            return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+        }
+
+        // 1970-01-01 起的天数 + 当天秒数，按本地时区转换
+        static time_t localTime(int64_t unix_day, int64_t seconds) {
+            // civil_from_days（Howard Hinnant 的公历算法）
+            const int64_t z = unix_day + 719468;
+            const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+            const int64_t doe = z - era * 146097;
+            const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const int64_t mp = (5 * doy + 2) / 153;
+            const int64_t month = mp < 10 ? mp + 3 : mp - 9;
+            const int64_t year = yoe + era * 400 + (month <= 2);
+
+            std::tm tm = {};
+            tm.tm_year = static_cast<int>(year - 1900);
+            tm.tm_mon = static_cast<int>(month - 1);
+            tm.tm_mday = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+            tm.tm_hour = static_cast<int>(seconds / 3600);
+            tm.tm_min = static_cast<int>(seconds / 60 % 60);
+            tm.tm_sec = static_cast<int>(seconds % 60);
+            tm.tm_isdst = -1;
+            const time_t t = ::mktime(&tm);
+            if (t == -1) {
+                throw std::runtime_error("Failed to convert datetime to timestamp");
+            }
+            return t;
+        }
+
+        bool date1904_;
+        std::unordered_map<int64_t, std::pair<time_t, bool>> day_cache_;
+    };
+
+    // 辅助类：将微秒时间戳按本地时间转换为 1900 日期系统的 Excel 序列日期。
+    // localtime 开销较大，按小时缓存本地时间与 UTC 的差值；该小时内有时区切换时逐个转换
+    class ExcelSerialConverter {
+    public:
+        // 早于 1900-01-01 的时间 Excel 无法表示，返回 std::nullopt
+        std::optional<double> toSerial(int64_t micros) {
+            const int64_t seconds = floorDiv(micros, 1000000);
+            const int64_t hour = floorDiv(seconds, 3600);
+            auto cached = hour_cache_.find(hour);
+            if (cached == hour_cache_.end()) {
+                if (hour_cache_.size() >= MAX_CACHED_HOURS) {
+                    hour_cache_.clear();
+                }
+                const int64_t start = utcOffset(hour * 3600);
+                const int64_t end = utcOffset(hour * 3600 + 3599);
+                cached = hour_cache_.emplace(hour, start == end ? std::optional<int64_t>(start) : std::nullopt).first;
+            }
+            const int64_t offset = cached->second ? *cached->second : utcOffset(seconds);
+            const double local_seconds = static_cast<double>(seconds + offset) +
+                                         static_cast<double>(micros - seconds * 1000000) / 1e6;
+
+            double serial = local_seconds / 86400.0 + DAYS_FROM_1899_12_30;
+            if (serial < 1.0) {
+                return std::nullopt;
+            }
+            // 1900-03-01 之前的序列号比实际天数少 1（Excel 虚构的 1900-02-29 是 60）
+            if (serial < 61.0) {
+                serial -= 1.0;
+            }
+            return serial;
+        }
+
+    private:
+        static constexpr double DAYS_FROM_1899_12_30 = 25569.0;
+        static constexpr size_t MAX_CACHED_HOURS = 1 << 16;
+
+        static int64_t floorDiv(int64_t a, int64_t b) {
+            return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+        }
+
+        // days_from_civil（Howard Hinnant 的公历算法）
+        static int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+            year -= month <= 2;
+            const int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const int64_t yoe = year - era * 400;
+            const int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + doe - 719468;
+        }
+
+        // seconds 时刻本地时间比 UTC 快的秒数
+        static int64_t utcOffset(int64_t seconds) {
+            const auto t = static_cast<time_t>(seconds);
+            std::tm tm = {};
+#ifdef _WIN32
+            const bool converted = ::localtime_s(&tm, &t) == 0;
+#else
+            const bool converted = ::localtime_r(&t, &tm) != nullptr;
+#endif
+            if (!converted) {
+                throw std::runtime_error("Failed to convert timestamp to datetime");
+            }
+            const int64_t local = daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * 86400 +
+                                  tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+            return local - seconds;
+        }
+
+        std::unordered_map<int64_t, std::optional<int64_t>> hour_cache_;
+    };
 }
 
 namespace TinaToolBox {
     
-    DataFrame::DataFrame(std::shared_ptr<arrow::Table> table) : table_(table) {}
+    DataFrame::DataFrame(std::shared_ptr<arrow::Table> table)
+        : table_(std::move(table)) {}
 
     // 辅助函数：创建一个新的ArrayBuilder
     static std::shared_ptr<arrow::ArrayBuilder> createBuilder(const std::shared_ptr<arrow::DataType>& type) {
@@ -81,6 +216,9 @@ namespace TinaToolBox {
             case arrow::Type::INT64: {
                 return std::make_shared<arrow::Int64Builder>(pool);
             }
+            case arrow::Type::INT32: {
+                return std::make_shared<arrow::Int32Builder>(pool);
+            }
             case arrow::Type::DOUBLE: {
                 return std::make_shared<arrow::DoubleBuilder>(pool);
             }
@@ -93,258 +231,860 @@ namespace TinaToolBox {
         }
     }
 
-    DataFrame DataFrame::fromExcel(const std::string &filePath) {
-        auto& pool = getThreadPool();
-        xlnt::workbook wb;
-        
-        try {
-            wb.load(filePath);
-        } catch (const xlnt::exception& e) {
-            spdlog::error("Failed to load Excel file: {}", e.what());
-            throw std::runtime_error("Failed to load Excel file: " + std::string(e.what()));
+    static void checkStatus(const arrow::Status& status, const char* what) {
+        if (!status.ok()) {
+            throw std::runtime_error(std::string(what) + ": " + status.ToString());
         }
+    }
 
-        xlnt::worksheet ws = wb.active_sheet();
-        const auto max_row = ws.highest_row();
-        const auto max_column = ws.highest_column().index;
+    // 辅助类：把工作表的行流式追加到 Arrow 列中，只扫描一遍。
+    // 每列在出现第一个值时取最窄的类型，之后遇到放不下的值就原地放宽（INT64 -> DOUBLE，
+    // 其余不兼容的组合 -> 字符串），已封装的分块和当前分块一起转换，不需要重新读取工作表。
+    // 每满 chunk_size 行封装成一个分块，工作内存只有当前分块。Arrow 默认内存池的占用超过内存预算后，
+    // 已封装的和之后封装的分块都写入溢出文件，merge() 时再逐个读回。
+    // 并行解析时每个片段一个构建器，各自收敛类型，最后由 merge() 统一类型并按片段顺序拼接成表
+    class SheetTableBuilder {
+    public:
+        using Cell = XlsxStreamReader::Cell;
 
-        if (max_row < 1 || max_column < 1) {
-            throw std::runtime_error("Excel file is empty");
+        // first_range 为 true 时第 1 行是表头，数据从第 2 行开始；
+        // 否则行号从片段中的第一行开始，前面缺失的行由 merge() 补齐
+        SheetTableBuilder(const XlsxStreamReader& reader, size_t column_hint, size_t chunk_size,
+                          const CancellationToken& token, bool first_range)
+            : reader_(reader), dates_(reader.date1904()), column_hint_(column_hint), chunk_size_(chunk_size),
+              token_(token), first_range_(first_range), next_row_(first_range ? 2 : 0) {}
+
+        void onRow(uint64_t row, const std::vector<Cell>& cells) {
+            if (row == 1 && first_range_) {
+                for (const auto& cell : cells) {
+                    if (header_.size() <= cell.column) {
+                        header_.resize(cell.column + 1);
+                    }
+                    header_[cell.column] = cellText(cell);
+                }
+                return;
+            }
+            appendRow(row, cells);
         }
 
-        spdlog::info("Reading Excel file with {} rows and {} columns", max_row, max_column);
-        
-        // 优化采样策略
-        const size_t SAMPLE_SIZE = std::min<size_t>(std::max<size_t>(20, max_row / 100), 100);
-        const size_t SAMPLE_INTERVAL = std::max<size_t>(1, (max_row - 1) / SAMPLE_SIZE);
-        
-        std::vector<std::shared_ptr<arrow::DataType>> column_types(max_column);
-        std::vector<std::string> column_names(max_column);
-        
-        // 优化chunk大小，根据数据量动态调整
-        const size_t estimated_rows = max_row - 1;
-        const size_t optimal_chunk_size = std::min<size_t>(
-            std::max<size_t>(1000, estimated_rows / (std::thread::hardware_concurrency() * 2)),
-            10000
-        );
-        const size_t num_chunks = (estimated_rows + optimal_chunk_size - 1) / optimal_chunk_size;
+        // 按片段顺序拼接，ranges[0] 是包含表头的片段。
+        // 各片段中同一列的类型按与构建时相同的规则放宽后统一，片段之间缺失的行补为空行。
+        // 字典列的分块在这里才封装为 DictionaryArray：每列的字典只包含该列用到的文本，
+        // 各片段中的共享字符串索引和扩展文本编码统一换成字典中的编码。
+        // 空行段和各分块依次作为记录批次交给 SpillableTableBuilder，已追加的分块不再保留；
+        // 有片段溢出过或拼接时超过内存预算，结果从溢出文件映射读回，spilled 为 true
+        static std::shared_ptr<arrow::Table> merge(const std::vector<std::unique_ptr<SheetTableBuilder>>& ranges,
+                                                   std::vector<DataFrame::ColumnLoadReport>& report, bool& spilled) {
+            if (ranges.empty()) {
+                throw std::runtime_error("Excel file is empty");
+            }
+            const SheetTableBuilder& head = *ranges.front();
+            size_t column_count = std::max(head.column_hint_, head.header_.size());
+            for (const auto& range : ranges) {
+                range->finishChunks();
+                column_count = std::max(column_count, range->columns_.size());
+            }
+            if (column_count == 0) {
+                throw std::runtime_error("Excel file is empty");
+            }
 
-        // 使用内存池来减少内存分配
-        arrow::MemoryPool* memory_pool = arrow::default_memory_pool();
-        
-        // 预缓存所有列名
-        for (int col = 1; col <= max_column; ++col) {
-            column_names[col - 1] = ws.cell(col, 1).to_string();
-            if(column_names[col - 1].empty()) {
-                column_names[col - 1] = "Column" + std::to_string(col);
+            std::vector<std::shared_ptr<arrow::Field>> fields;
+            fields.reserve(column_count);
+            report.assign(column_count, {});
+            for (size_t col = 0; col < column_count; ++col) {
+                std::shared_ptr<arrow::DataType> type;
+                ValueCounts counts{};
+                for (const auto& range : ranges) {
+                    if (col < range->columns_.size() && range->columns_[col].type) {
+                        const Column& column = range->columns_[col];
+                        type = type ? widenedType(type, column.type) : column.type;
+                        for (size_t kind = 0; kind < KIND_COUNT; ++kind) {
+                            counts[kind] += column.counts[kind];
+                        }
+                    }
+                }
+                if (!type) {
+                    // 整列都是空值
+                    type = arrow::utf8();
+                }
+
+                std::string name = col < head.header_.size() ? head.header_[col] : std::string();
+                if (name.empty()) {
+                    name = "Column" + std::to_string(col + 1);
+                }
+                auto& entry = report[col];
+                entry.column = name;
+                entry.type = type;
+                for (const int64_t count : counts) {
+                    entry.values += count;
+                }
+                entry.coerced = entry.values - counts[nativeKind(type->id())];
+                fields.push_back(std::make_shared<arrow::Field>(std::move(name), type));
             }
-        }
 
-        // 使用互斥锁保护worksheet访问
-        std::mutex ws_mutex;
-        
-        // 并行类型检测，使用更智能的任务分配
-        const size_t type_detection_batch_size = std::max<size_t>(1, max_column / std::thread::hardware_concurrency());
-        std::vector<std::future<void>> type_futures;
-        type_futures.reserve((max_column + type_detection_batch_size - 1) / type_detection_batch_size);
-        
-        for (size_t col_start = 1; col_start <= max_column; col_start += type_detection_batch_size) {
-            size_t col_end = std::min<size_t>(col_start + type_detection_batch_size, max_column + 1);
-            type_futures.push_back(pool.submit([col_start, col_end, ws, max_row, SAMPLE_SIZE, SAMPLE_INTERVAL, &column_types]() {
-                for (size_t col = col_start; col < col_end; ++col) {
-                    std::unordered_map<arrow::Type::type, int> type_counts;
-                    bool has_date = false;
-                    
-                    // 批量读取样本数据
-                    std::vector<xlnt::cell> sample_cells;
-                    sample_cells.reserve(SAMPLE_SIZE);
-                    
-                    for (size_t sample_idx = 0; sample_idx < SAMPLE_SIZE; ++sample_idx) {
-                        size_t row = 2 + sample_idx * SAMPLE_INTERVAL;
-                        if (row > max_row) break;
-                        sample_cells.push_back(ws.cell(col, row));
+            const XlsxStreamReader& reader = head.reader_;
+            const auto shared_count = static_cast<int32_t>(reader.sharedStringCount());
+
+            // 字典列：各片段扩展文本的原始编码起点、原始编码（共享字符串索引，或按片段顺序排在其后的扩展文本）
+            // 到整列字典中编码的映射，以及只含本列用到的文本的字典。按批次拼接时各列同时需要，每列一份
+            std::vector<std::vector<int32_t>> extra_offsets(column_count);
+            std::vector<std::vector<int32_t>> local_codes(column_count);
+            std::vector<std::shared_ptr<arrow::Array>> dictionaries(column_count);
+            for (size_t col = 0; col < column_count; ++col) {
+                if (fields[col]->type()->id() != arrow::Type::DICTIONARY) {
+                    continue;
+                }
+                extra_offsets[col].assign(ranges.size(), 0);
+                int32_t offset = shared_count;
+                for (size_t i = 0; i < ranges.size(); ++i) {
+                    if (col < ranges[i]->columns_.size()) {
+                        extra_offsets[col][i] = offset;
+                        offset += static_cast<int32_t>(ranges[i]->columns_[col].extras.size());
+                    }
+                }
+                local_codes[col].assign(static_cast<size_t>(offset), -1);
+                dictionaries[col] = compactDictionary(reader, ranges, col, extra_offsets[col], local_codes[col]);
+            }
+
+            const auto schema = std::make_shared<arrow::Schema>(fields);
+            SpillableTableBuilder table_builder;
+            const bool ranges_spilled = std::any_of(ranges.begin(), ranges.end(), [](const auto& range) {
+                return !range->chunk_spills_.empty();
+            });
+            if (ranges_spilled) {
+                checkStatus(table_builder.spill(), "Failed to create spill file");
+            }
+            auto null_column = [&](size_t col, int64_t length) -> std::shared_ptr<arrow::Array> {
+                const auto& type = fields[col]->type();
+                if (dictionaries[col]) {
+                    auto codes = arrow::MakeArrayOfNull(arrow::int32(), length);
+                    checkStatus(codes.status(), "Failed to create null array");
+                    return std::make_shared<arrow::DictionaryArray>(type, std::move(codes).ValueOrDie(), dictionaries[col]);
+                }
+                auto nulls = arrow::MakeArrayOfNull(type, length);
+                checkStatus(nulls.status(), "Failed to create null array");
+                return std::move(nulls).ValueOrDie();
+            };
+            auto append_batch = [&](int64_t length, arrow::ArrayVector arrays) {
+                checkStatus(table_builder.append(arrow::RecordBatch::Make(schema, length, std::move(arrays))),
+                            "Failed to append batch");
+            };
+
+            uint64_t next_row = 2;
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                SheetTableBuilder& range = *ranges[i];
+                if (range.chunk_lengths_.empty()) {
+                    continue;
+                }
+                if (range.first_row_ > next_row) {
+                    const auto length = static_cast<int64_t>(range.first_row_ - next_row);
+                    arrow::ArrayVector arrays;
+                    for (size_t col = 0; col < column_count; ++col) {
+                        arrays.push_back(null_column(col, length));
                     }
-                    
-                    // 处理样本数据
-                    size_t non_empty_count = 0;
-                    for (const auto& cell : sample_cells) {
-                        if (non_empty_count >= 10) break;
-                        
-                        if (cell.has_value()) {
-                            non_empty_count++;
-                            if (cell.is_date()) {
-                                has_date = true;
-                                break;
-                            }
-                            switch (cell.data_type()) {
-                                case xlnt::cell_type::number: {
-                                    double value = cell.value<double>();
-                                    double intpart;
-                                    if (std::modf(value, &intpart) == 0.0) {
-                                        type_counts[arrow::Type::INT64]++;
-                                    } else {
-                                        type_counts[arrow::Type::DOUBLE]++;
-                                    }
-                                    break;
-                                }
-                                case xlnt::cell_type::boolean:
-                                    type_counts[arrow::Type::BOOL]++;
-                                    break;
-                                default:
-                                    type_counts[arrow::Type::STRING]++;
-                                    break;
-                            }
+                    append_batch(length, std::move(arrays));
+                }
+                next_row = range.next_row_;
+
+                for (size_t k = 0; k < range.chunk_lengths_.size(); ++k) {
+                    const int64_t length = range.chunk_lengths_[k];
+                    arrow::ArrayVector arrays;
+                    for (size_t col = 0; col < column_count; ++col) {
+                        if (col >= range.columns_.size() || !range.columns_[col].type) {
+                            arrays.push_back(null_column(col, length));
+                            continue;
+                        }
+                        const auto& type = fields[col]->type();
+                        const auto chunk = range.storedChunk(col, k);
+                        if (dictionaries[col]) {
+                            arrays.push_back(std::make_shared<arrow::DictionaryArray>(
+                                type, remapCodes(*chunk, shared_count, extra_offsets[col][i], local_codes[col]),
+                                dictionaries[col]));
+                        } else if (chunk->type()->Equals(*type)) {
+                            arrays.push_back(chunk);
+                        } else {
+                            arrays.push_back(range.convertChunk(*chunk, range.columns_[col], type));
                         }
+                        range.columns_[col].chunks[k].reset();
                     }
-                    
-                    if (has_date) {
-                        column_types[col - 1] = std::make_shared<arrow::TimestampType>(arrow::TimeUnit::MICRO);
-                    } else if (!type_counts.empty()) {
-                        auto max_type = std::max_element(
-                            type_counts.begin(), type_counts.end(),
-                            [](const auto& p1, const auto& p2) { return p1.second < p2.second; }
-                        );
-                        
-                        switch (max_type->first) {
-                            case arrow::Type::INT64:
-                                column_types[col - 1] = std::make_shared<arrow::Int64Type>();
-                                break;
-                            case arrow::Type::DOUBLE:
-                                column_types[col - 1] = std::make_shared<arrow::DoubleType>();
-                                break;
-                            case arrow::Type::BOOL:
-                                column_types[col - 1] = std::make_shared<arrow::BooleanType>();
-                                break;
-                            default:
-                                column_types[col - 1] = std::make_shared<arrow::StringType>();
-                                break;
+                    append_batch(length, std::move(arrays));
+                }
+            }
+
+            auto table = table_builder.finish(schema);
+            checkStatus(table.status(), "Failed to build table");
+            spilled = table_builder.spilled();
+            return std::move(table).ValueOrDie();
+        }
+
+    private:
+        static constexpr size_t CANCEL_CHECK_ROWS = 1024;
+
+        // 单元格值的原始类别，用于统计有多少值没有按原始类型保存
+        enum ValueKind : size_t { KIND_INT, KIND_DOUBLE, KIND_BOOL, KIND_DATE, KIND_TEXT, KIND_COUNT };
+        using ValueCounts = std::array<int64_t, KIND_COUNT>;
+
+        struct Column {
+            // 出现第一个值之前为空，此时不占用构建器，空值在确定类型时补齐
+            std::shared_ptr<arrow::DataType> type;
+            std::shared_ptr<arrow::ArrayBuilder> builder;
+            // 字典列在 merge() 之前保存 int32 编码；已溢出的分块为空指针
+            std::vector<std::shared_ptr<arrow::Array>> chunks;
+            // 字典列中不在共享字符串表里的文本，编码从共享字符串数开始依次分配
+            std::unordered_map<std::string, int32_t> extra_codes;
+            std::vector<std::string> extras;
+            ValueCounts counts{};
+            // 曾放宽为 DOUBLE。此前溢出的 INT64 分块转换为字符串时按小数格式输出，
+            // 与内存中先转为 DOUBLE 再转为字符串的分块一致
+            bool was_double = false;
+        };
+
+        static std::shared_ptr<arrow::DataType> sharedStringType() {
+            return arrow::dictionary(arrow::int32(), arrow::utf8());
+        }
+
+        // 构建期间各列分块的实际类型：字典列只有编码
+        static std::shared_ptr<arrow::DataType> storageType(const std::shared_ptr<arrow::DataType>& type) {
+            return type->id() == arrow::Type::DICTIONARY ? arrow::int32() : type;
+        }
+
+        // 按第一次出现的顺序收集 col 列用到的文本作为整列的字典，local_codes 记录原始编码在字典中的位置。
+        // 每列只保存自己用到的文本，缓存、溢出文件和导出的 Parquet/Feather 不会为每列重复整个共享字符串表
+        static std::shared_ptr<arrow::Array> compactDictionary(const XlsxStreamReader& reader,
+                                                               const std::vector<std::unique_ptr<SheetTableBuilder>>& ranges,
+                                                               size_t col, const std::vector<int32_t>& extra_offsets,
+                                                               std::vector<int32_t>& local_codes) {
+            const auto shared_count = static_cast<int32_t>(reader.sharedStringCount());
+            arrow::StringBuilder builder;
+            int32_t next_code = 0;
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                if (col >= ranges[i]->columns_.size()) {
+                    continue;
+                }
+                const Column& column = ranges[i]->columns_[col];
+                if (!column.type || column.type->id() != arrow::Type::DICTIONARY) {
+                    continue;
+                }
+                for (size_t k = 0; k < column.chunks.size(); ++k) {
+                    const auto chunk = ranges[i]->storedChunk(col, k);
+                    const auto& codes = static_cast<const arrow::Int32Array&>(*chunk);
+                    for (int64_t row = 0; row < codes.length(); ++row) {
+                        if (codes.IsNull(row)) {
+                            continue;
                         }
-                    } else {
-                        column_types[col - 1] = std::make_shared<arrow::StringType>();
+                        const int32_t code = codes.Value(row);
+                        const int32_t raw = code < shared_count ? code : extra_offsets[i] + (code - shared_count);
+                        if (local_codes[raw] >= 0) {
+                            continue;
+                        }
+                        local_codes[raw] = next_code++;
+                        const std::string_view text = code < shared_count
+                                                          ? reader.sharedString(static_cast<uint32_t>(code))
+                                                          : std::string_view(column.extras[code - shared_count]);
+                        checkStatus(builder.Append(text.data(), static_cast<int32_t>(text.size())),
+                                    "Failed to append value");
                     }
                 }
-            }));
+            }
+            std::shared_ptr<arrow::Array> dictionary;
+            checkStatus(builder.Finish(&dictionary), "Failed to finalize array");
+            return dictionary;
         }
 
-        // 等待所有类型检测完成
-        for (auto& fut : type_futures) {
-            fut.wait();
+        // 把片段中的原始编码换成整列字典中的编码；extra_offset 是该片段扩展文本的原始编码起点
+        static std::shared_ptr<arrow::Array> remapCodes(const arrow::Array& chunk, int32_t shared_count,
+                                                        int32_t extra_offset, const std::vector<int32_t>& local_codes) {
+            const auto& codes = static_cast<const arrow::Int32Array&>(chunk);
+            arrow::Int32Builder builder;
+            checkStatus(builder.Reserve(codes.length()), "Failed to reserve builder");
+            for (int64_t i = 0; i < codes.length(); ++i) {
+                if (codes.IsNull(i)) {
+                    builder.UnsafeAppendNull();
+                } else {
+                    const int32_t code = codes.Value(i);
+                    builder.UnsafeAppend(local_codes[code < shared_count ? code : extra_offset + (code - shared_count)]);
+                }
+            }
+            std::shared_ptr<arrow::Array> remapped;
+            checkStatus(builder.Finish(&remapped), "Failed to finalize array");
+            return remapped;
         }
 
-        // 创建schema
-        std::vector<std::shared_ptr<arrow::Field>> fields;
-        fields.reserve(max_column);
-        for (size_t i = 0; i < max_column; ++i) {
-            fields.push_back(std::make_shared<arrow::Field>(column_names[i], column_types[i]));
+        static ValueKind cellKind(const Cell& cell) {
+            switch (cell.type) {
+                case Cell::Type::Number: {
+                    if (cell.is_date) {
+                        return KIND_DATE;
+                    }
+                    double intpart;
+                    if (std::modf(cell.number, &intpart) == 0.0 && std::fabs(cell.number) < 9.2e18) {
+                        return KIND_INT;
+                    }
+                    return KIND_DOUBLE;
+                }
+                case Cell::Type::Boolean:
+                    return KIND_BOOL;
+                default:
+                    return KIND_TEXT;
+            }
         }
-        auto schema = std::make_shared<arrow::Schema>(fields);
 
-        // 优化并行处理策略
-        std::vector<std::shared_ptr<arrow::ChunkedArray>> columns(max_column);
-        const size_t column_batch_size = std::max<size_t>(1, max_column / std::thread::hardware_concurrency());
-        std::vector<std::future<void>> column_futures;
-        column_futures.reserve((max_column + column_batch_size - 1) / column_batch_size);
-        
-        for (size_t col_start = 1; col_start <= max_column; col_start += column_batch_size) {
-            size_t col_end = std::min<size_t>(col_start + column_batch_size, max_column + 1);
-            column_futures.push_back(pool.submit([col_start, col_end, ws, max_row, optimal_chunk_size, num_chunks, &column_types, &columns, memory_pool]() {
-                for (size_t col = col_start; col < col_end; ++col) {
-                    std::vector<std::shared_ptr<arrow::Array>> chunks;
-                    chunks.reserve(num_chunks);
-                    auto builder = createBuilder(column_types[col-1]);
-                    
-                    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
-                        size_t start_row = 2 + chunk * optimal_chunk_size;
-                        size_t end_row = std::min<size_t>(start_row + optimal_chunk_size, max_row + 1);
-                        
-                        builder->Reserve(end_row - start_row);
-                        
-                        // 批量读取数据
-                        std::vector<xlnt::cell> chunk_cells;
-                        chunk_cells.reserve(end_row - start_row);
-                        for (size_t row = start_row; row < end_row; ++row) {
-                            chunk_cells.push_back(ws.cell(col, row));
+        // 列的第一个值决定初始类型，取能容纳它的最窄类型
+        static std::shared_ptr<arrow::DataType> initialType(ValueKind kind, const Cell& cell) {
+            switch (kind) {
+                case KIND_INT:
+                    return arrow::int64();
+                case KIND_DOUBLE:
+                    return arrow::float64();
+                case KIND_BOOL:
+                    return arrow::boolean();
+                case KIND_DATE:
+                    return arrow::timestamp(arrow::TimeUnit::MICRO);
+                default:
+                    // 文本来自共享字符串表时按字典编码，每个单元格只占 4 字节
+                    return cell.type == Cell::Type::SharedString ? sharedStringType() : arrow::utf8();
+            }
+        }
+
+        static ValueKind nativeKind(arrow::Type::type id) {
+            switch (id) {
+                case arrow::Type::INT64:
+                    return KIND_INT;
+                case arrow::Type::DOUBLE:
+                    return KIND_DOUBLE;
+                case arrow::Type::BOOL:
+                    return KIND_BOOL;
+                case arrow::Type::TIMESTAMP:
+                    return KIND_DATE;
+                default:
+                    return KIND_TEXT;
+            }
+        }
+
+        // 字符串列（包括字典列）可以容纳任何值，DOUBLE 列可以容纳整数
+        static bool fits(arrow::Type::type id, ValueKind kind) {
+            switch (id) {
+                case arrow::Type::DICTIONARY:
+                case arrow::Type::STRING:
+                    return true;
+                case arrow::Type::DOUBLE:
+                    return kind == KIND_INT || kind == KIND_DOUBLE;
+                default:
+                    return kind == nativeKind(id);
+            }
+        }
+
+        // 两种列类型的最小公共类型：整数和小数取 DOUBLE，其余不一致时取字符串
+        static std::shared_ptr<arrow::DataType> widenedType(const std::shared_ptr<arrow::DataType>& a,
+                                                            const std::shared_ptr<arrow::DataType>& b) {
+            if (a->Equals(*b)) {
+                return a;
+            }
+            const auto numeric = [](const arrow::DataType& type) {
+                return type.id() == arrow::Type::INT64 || type.id() == arrow::Type::DOUBLE;
+            };
+            if (numeric(*a) && numeric(*b)) {
+                return arrow::float64();
+            }
+            return arrow::utf8();
+        }
+
+        static std::string formatNumber(double value) {
+            char buffer[32];
+            const int length = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+            return std::string(buffer, static_cast<size_t>(length));
+        }
+
+        // 与 toSaveExcel 一样按本地时间解释时间戳
+        // 单元格的文本形式，和放宽为字符串列时已有值的转换结果一致
+        std::string cellText(const Cell& cell) {
+            switch (cell.type) {
+                case Cell::Type::SharedString:
+                    return std::string(reader_.sharedString(cell.shared_index));
+                case Cell::Type::Boolean:
+                    return cell.number != 0.0 ? "TRUE" : "FALSE";
+                case Cell::Type::Number:
+                    return cell.is_date ? formatLocalTimestamp(dates_.toTimestamp(cell.number)) : formatNumber(cell.number);
+                default:
+                    return std::string(cell.text);
+            }
+        }
+
+        // 把 source 转换后追加到 target。source 是构建期间的存储类型（字典列为 int32 编码），
+        // 溢出的分块保留写入时的类型，可能比 column.type 窄。目标只会是 DOUBLE（来自 INT64）或字符串
+        void appendConverted(arrow::ArrayBuilder& target, const arrow::Array& source, const Column& column,
+                             arrow::Type::type to) const {
+            checkStatus(target.Reserve(source.length()), "Failed to reserve builder");
+            if (to == arrow::Type::DOUBLE) {
+                auto& builder = static_cast<arrow::DoubleBuilder&>(target);
+                const auto& values = static_cast<const arrow::Int64Array&>(source);
+                for (int64_t i = 0; i < values.length(); ++i) {
+                    if (values.IsNull(i)) {
+                        builder.UnsafeAppendNull();
+                    } else {
+                        builder.UnsafeAppend(static_cast<double>(values.Value(i)));
+                    }
+                }
+                return;
+            }
+
+            auto& builder = static_cast<arrow::StringBuilder&>(target);
+            for (int64_t i = 0; i < source.length(); ++i) {
+                arrow::Status status;
+                if (source.IsNull(i)) {
+                    status = builder.AppendNull();
+                } else {
+                    switch (source.type_id()) {
+                        case arrow::Type::INT64: {
+                            const int64_t value = static_cast<const arrow::Int64Array&>(source).Value(i);
+                            status = builder.Append(column.was_double ? formatNumber(static_cast<double>(value))
+                                                                      : std::to_string(value));
+                            break;
                         }
-                        
-                        // 处理chunk数据
-                        for (const auto& cell : chunk_cells) {
-                            arrow::Status status;
-
-                            if (!cell.has_value()) {
-                                status = builder->AppendNull();
-                            } else {
-                                switch (column_types[col-1]->id()) {
-                                    case arrow::Type::TIMESTAMP: {
-                                        auto timestampBuilder = static_cast<arrow::TimestampBuilder*>(builder.get());
-                                        if (cell.is_date()) {
-                                            auto dt = cell.value<xlnt::datetime>();
-                                            status = timestampBuilder->Append(datetime_to_timestamp(dt));
-                                        } else {
-                                            status = builder->AppendNull();
-                                        }
-                                        break;
-                                    }
-                                    case arrow::Type::INT64: {
-                                        auto intBuilder = static_cast<arrow::Int64Builder*>(builder.get());
-                                        if (cell.data_type() == xlnt::cell_type::number) {
-                                            status = intBuilder->Append(static_cast<int64_t>(cell.value<double>()));
-                                        } else {
-                                            status = builder->AppendNull();
-                                        }
-                                        break;
-                                    }
-                                    case arrow::Type::DOUBLE: {
-                                        auto doubleBuilder = static_cast<arrow::DoubleBuilder*>(builder.get());
-                                        if (cell.data_type() == xlnt::cell_type::number) {
-                                            status = doubleBuilder->Append(cell.value<double>());
-                                        } else {
-                                            status = builder->AppendNull();
-                                        }
-                                        break;
-                                    }
-                                    case arrow::Type::BOOL: {
-                                        auto boolBuilder = static_cast<arrow::BooleanBuilder*>(builder.get());
-                                        if (cell.data_type() == xlnt::cell_type::boolean) {
-                                            status = boolBuilder->Append(cell.value<bool>());
-                                        } else {
-                                            status = builder->AppendNull();
-                                        }
-                                        break;
-                                    }
-                                    default: {
-                                        auto stringBuilder = static_cast<arrow::StringBuilder*>(builder.get());
-                                        status = stringBuilder->Append(cell.to_string());
-                                        break;
-                                    }
-                                }
-                            }
-
-                            if (!status.ok()) {
-                                throw std::runtime_error("Failed to append value: " + status.ToString());
-                            }
+                        case arrow::Type::DOUBLE:
+                            status = builder.Append(formatNumber(static_cast<const arrow::DoubleArray&>(source).Value(i)));
+                            break;
+                        case arrow::Type::BOOL:
+                            status = builder.Append(static_cast<const arrow::BooleanArray&>(source).Value(i) ? "TRUE" : "FALSE");
+                            break;
+                        case arrow::Type::TIMESTAMP:
+                            status = builder.Append(
+                                formatLocalTimestamp(static_cast<const arrow::TimestampArray&>(source).Value(i)));
+                            break;
+                        case arrow::Type::INT32: {
+                            const auto code = static_cast<size_t>(static_cast<const arrow::Int32Array&>(source).Value(i));
+                            const std::string_view text = code < reader_.sharedStringCount()
+                                                              ? reader_.sharedString(static_cast<uint32_t>(code))
+                                                              : std::string_view(column.extras[code - reader_.sharedStringCount()]);
+                            status = builder.Append(text.data(), static_cast<int32_t>(text.size()));
+                            break;
                         }
+                        default:
+                            status = builder.Append(static_cast<const arrow::StringArray&>(source).GetView(i));
+                            break;
+                    }
+                }
+                checkStatus(status, "Failed to append value");
+            }
+        }
+
+        std::shared_ptr<arrow::Array> convertChunk(const arrow::Array& chunk, const Column& column,
+                                                   const std::shared_ptr<arrow::DataType>& type) const {
+            auto builder = createBuilder(type);
+            appendConverted(*builder, chunk, column, type->id());
+            std::shared_ptr<arrow::Array> converted;
+            checkStatus(builder->Finish(&converted), "Failed to finalize array");
+            return converted;
+        }
+
+        // 确定列的类型；已封装的分块和当前分块中已有的行补为空值（已溢出的分块读回时补）
+        void startColumn(Column& column, std::shared_ptr<arrow::DataType> type) {
+            column.type = std::move(type);
+            column.builder = createBuilder(storageType(column.type));
+            column.chunks.resize(chunk_spills_.size());
+            for (size_t k = chunk_spills_.size(); k < chunk_lengths_.size(); ++k) {
+                auto nulls = arrow::MakeArrayOfNull(storageType(column.type), chunk_lengths_[k]);
+                checkStatus(nulls.status(), "Failed to create null array");
+                column.chunks.push_back(std::move(nulls).ValueOrDie());
+            }
+            checkStatus(column.builder->Reserve(static_cast<int64_t>(chunk_size_)), "Failed to reserve builder");
+            checkStatus(column.builder->AppendNulls(static_cast<int64_t>(rows_in_chunk_)), "Failed to append value");
+        }
+
+        // 放宽列类型：转换内存中已封装的分块（已溢出的分块在 merge() 读回时转换），
+        // 当前分块已有的行转换后写入新的构建器
+        void widenColumn(Column& column, const std::shared_ptr<arrow::DataType>& type) {
+            std::shared_ptr<arrow::Array> partial;
+            checkStatus(column.builder->Finish(&partial), "Failed to finalize array");
+            for (auto& chunk : column.chunks) {
+                if (chunk) {
+                    chunk = convertChunk(*chunk, column, type);
+                }
+            }
+            auto builder = createBuilder(type);
+            checkStatus(builder->Reserve(static_cast<int64_t>(chunk_size_)), "Failed to reserve builder");
+            appendConverted(*builder, *partial, column, type->id());
+            column.was_double = column.was_double || type->id() == arrow::Type::DOUBLE;
+            column.type = type;
+            column.builder = std::move(builder);
+        }
+
+        static void appendNull(Column& column) {
+            if (column.builder) {
+                checkStatus(column.builder->AppendNull(), "Failed to append value");
+            }
+        }
+
+        void appendNullRows(uint64_t count) {
+            while (count > 0) {
+                const auto n = static_cast<int64_t>(std::min<uint64_t>(count, chunk_size_ - rows_in_chunk_));
+                for (auto& column : columns_) {
+                    if (column.builder) {
+                        checkStatus(column.builder->AppendNulls(n), "Failed to append value");
+                    }
+                }
+                count -= static_cast<uint64_t>(n);
+                rows_in_chunk_ += static_cast<size_t>(n);
+                if (rows_in_chunk_ == chunk_size_) {
+                    flushChunk();
+                }
+            }
+        }
+
+        void finishChunks() {
+            if (rows_in_chunk_ > 0) {
+                flushChunk();
+            }
+            if (!spill_files_.empty()) {
+                checkStatus(spill_files_.back()->close(), "Failed to close spill file");
+            }
+        }
+
+        void appendRow(uint64_t row, const std::vector<Cell>& cells) {
+            if (next_row_ == 0) {
+                // 片段构建器：第一行之前的空行由 merge() 补齐
+                first_row_ = row;
+                next_row_ = row;
+            }
+            // 数据从第 2 行开始，中间缺失的行补为空行
+            if (row > next_row_) {
+                appendNullRows(row - next_row_);
+            }
+
+            if (!cells.empty() && columns_.size() <= cells.back().column) {
+                columns_.resize(cells.back().column + 1);
+            }
+            size_t next_column = 0;
+            for (const auto& cell : cells) {
+                if (cell.column < next_column) {
+                    continue;
+                }
+                for (; next_column < cell.column; ++next_column) {
+                    appendNull(columns_[next_column]);
+                }
+                appendValue(columns_[cell.column], cell);
+                next_column = cell.column + 1;
+            }
+            for (; next_column < columns_.size(); ++next_column) {
+                appendNull(columns_[next_column]);
+            }
+
+            next_row_ = row + 1;
+            if (++rows_in_chunk_ == chunk_size_) {
+                flushChunk();
+            } else if (rows_in_chunk_ % CANCEL_CHECK_ROWS == 0) {
+                token_.throwIfCancelled();
+            }
+        }
+
+        void appendValue(Column& column, const Cell& cell) {
+            const ValueKind kind = cellKind(cell);
+            column.counts[kind]++;
+            if (!column.type) {
+                startColumn(column, initialType(kind, cell));
+            } else if (!fits(column.type->id(), kind)) {
+                widenColumn(column, widenedType(column.type, initialType(kind, cell)));
+            }
 
-                        std::shared_ptr<arrow::Array> chunk_array;
-                        auto status = builder->Finish(&chunk_array);
-                        if (!status.ok()) {
-                            throw std::runtime_error("Failed to finalize array: " + status.ToString());
+            arrow::Status status;
+            switch (column.type->id()) {
+                case arrow::Type::TIMESTAMP:
+                    status = static_cast<arrow::TimestampBuilder*>(column.builder.get())->Append(
+                        dates_.toTimestamp(cell.number));
+                    break;
+                case arrow::Type::INT64:
+                    status = static_cast<arrow::Int64Builder*>(column.builder.get())->Append(
+                        static_cast<int64_t>(cell.number));
+                    break;
+                case arrow::Type::DOUBLE:
+                    status = static_cast<arrow::DoubleBuilder*>(column.builder.get())->Append(cell.number);
+                    break;
+                case arrow::Type::BOOL:
+                    status = static_cast<arrow::BooleanBuilder*>(column.builder.get())->Append(cell.number != 0.0);
+                    break;
+                case arrow::Type::DICTIONARY: {
+                    auto codeBuilder = static_cast<arrow::Int32Builder*>(column.builder.get());
+                    if (cell.type == Cell::Type::SharedString && cell.shared_index < reader_.sharedStringCount()) {
+                        status = codeBuilder->Append(static_cast<int32_t>(cell.shared_index));
+                    } else {
+                        // 内联字符串、数字等不在共享字符串表中的值
+                        const int32_t next_code = static_cast<int32_t>(reader_.sharedStringCount() + column.extras.size());
+                        const auto [it, inserted] = column.extra_codes.try_emplace(cellText(cell), next_code);
+                        if (inserted) {
+                            column.extras.push_back(it->first);
                         }
-                        chunks.push_back(chunk_array);
-                        
-                        builder = createBuilder(column_types[col-1]);
+                        status = codeBuilder->Append(it->second);
                     }
-                    
-                    columns[col-1] = std::make_shared<arrow::ChunkedArray>(chunks);
+                    break;
+                }
+                default: {
+                    auto stringBuilder = static_cast<arrow::StringBuilder*>(column.builder.get());
+                    if (cell.type == Cell::Type::SharedString) {
+                        const std::string_view text = reader_.sharedString(cell.shared_index);
+                        status = stringBuilder->Append(text.data(), static_cast<int32_t>(text.size()));
+                    } else if (cell.type == Cell::Type::String || cell.type == Cell::Type::Error) {
+                        status = stringBuilder->Append(cell.text.data(), static_cast<int32_t>(cell.text.size()));
+                    } else {
+                        status = stringBuilder->Append(cellText(cell));
+                    }
+                    break;
+                }
+            }
+            checkStatus(status, "Failed to append value");
+        }
+
+        void flushChunk() {
+            for (auto& column : columns_) {
+                if (!column.builder) {
+                    continue;
+                }
+                std::shared_ptr<arrow::Array> chunk_array;
+                checkStatus(column.builder->Finish(&chunk_array), "Failed to finalize array");
+                column.chunks.push_back(std::move(chunk_array));
+                checkStatus(column.builder->Reserve(static_cast<int64_t>(chunk_size_)), "Failed to reserve builder");
+            }
+            chunk_lengths_.push_back(static_cast<int64_t>(rows_in_chunk_));
+            rows_in_chunk_ = 0;
+            if (!chunk_spills_.empty() || SpillableTableBuilder::overBudget()) {
+                while (chunk_spills_.size() < chunk_lengths_.size()) {
+                    spillChunk(chunk_spills_.size());
+                }
+            }
+            token_.throwIfCancelled();
+        }
+
+        static std::string spillColumnName(size_t col) {
+            return "c" + std::to_string(col);
+        }
+
+        // 把第 k 个分块中已确定类型的列作为一个记录批次写入溢出文件，并释放内存中的分块。
+        // 列的集合或类型与当前文件不同时换一个新文件
+        void spillChunk(size_t k) {
+            arrow::FieldVector fields;
+            arrow::ArrayVector arrays;
+            for (size_t col = 0; col < columns_.size(); ++col) {
+                if (!columns_[col].type) {
+                    continue;
+                }
+                auto& chunk = columns_[col].chunks[k];
+                fields.push_back(arrow::field(spillColumnName(col), chunk->type()));
+                arrays.push_back(std::move(chunk));
+            }
+            auto schema = arrow::schema(std::move(fields));
+            if (spill_files_.empty() || !spill_schema_->Equals(*schema)) {
+                if (!spill_files_.empty()) {
+                    checkStatus(spill_files_.back()->close(), "Failed to close spill file");
+                }
+                spill_files_.push_back(std::make_unique<SpillFile>());
+                spill_schema_ = schema;
+                spill_batches_ = 0;
+            }
+            const auto batch = arrow::RecordBatch::Make(std::move(schema), chunk_lengths_[k], std::move(arrays));
+            checkStatus(spill_files_.back()->write(*batch), "Failed to spill chunk");
+            chunk_spills_.emplace_back(spill_files_.size() - 1, spill_batches_++);
+        }
+
+        // col 列第 k 个分块的存储类型数组。已溢出的分块从文件中读回，保留写入时的类型；
+        // 写入时该列还没有确定类型的补为空值
+        std::shared_ptr<arrow::Array> storedChunk(size_t col, size_t k) {
+            const Column& column = columns_[col];
+            if (column.chunks[k]) {
+                return column.chunks[k];
+            }
+            const auto [file, index] = chunk_spills_[k];
+            spill_readers_.resize(spill_files_.size());
+            if (!spill_readers_[file]) {
+                auto opened = spill_files_[file]->reader();
+                checkStatus(opened.status(), "Failed to open spill file");
+                spill_readers_[file] = std::move(opened).ValueOrDie();
+            }
+            auto batch = spill_readers_[file]->ReadRecordBatch(index);
+            checkStatus(batch.status(), "Failed to read spill file");
+            if (auto array = batch.ValueOrDie()->GetColumnByName(spillColumnName(col))) {
+                return array;
+            }
+            auto nulls = arrow::MakeArrayOfNull(storageType(column.type), chunk_lengths_[k]);
+            checkStatus(nulls.status(), "Failed to create null array");
+            return std::move(nulls).ValueOrDie();
+        }
+
+        const XlsxStreamReader& reader_;
+        ExcelDateConverter dates_;
+        const size_t column_hint_;
+        const size_t chunk_size_;
+        const CancellationToken& token_;
+        const bool first_range_;
+
+        std::vector<std::string> header_;
+        std::vector<Column> columns_;
+        std::vector<int64_t> chunk_lengths_;
+        // 已溢出分块所在的文件和批次下标。溢出从第一个分块开始，之后的分块都写入文件，
+        // 前 chunk_spills_.size() 个分块已溢出
+        std::vector<std::pair<size_t, int>> chunk_spills_;
+        std::vector<std::unique_ptr<SpillFile>> spill_files_;
+        std::shared_ptr<arrow::Schema> spill_schema_;
+        int spill_batches_ = 0;
+        std::vector<std::shared_ptr<arrow::ipc::RecordBatchFileReader>> spill_readers_;
+        size_t rows_in_chunk_ = 0;
+        uint64_t first_row_ = 2;
+        // 下一行的行号，片段构建器在收到第一行之前为 0
+        uint64_t next_row_;
+    };
+
+    // 并行解析时每个工作表片段的目标大小（解压后的 XML 字节数）
+    static constexpr size_t SHEET_RANGE_BYTES = 1 << 20;
+
+    // xlsx 的内容哈希：中央目录中各条目的名称、CRC32 和大小，只需要读取文件末尾，不解压任何条目
+    static uint64_t excelContentHash(const std::string& filePath) {
+        const ZipArchive archive(filePath);
+        uint64_t hash = DataFrameCache::HASH_SEED;
+        for (const auto& entry : archive.entries()) {
+            hash = DataFrameCache::hash(entry.name.data(), entry.name.size(), hash);
+            hash = DataFrameCache::hash(&entry.crc32, sizeof(entry.crc32), hash);
+            hash = DataFrameCache::hash(&entry.uncompressed_size, sizeof(entry.uncompressed_size), hash);
+        }
+        return hash;
+    }
+
+    DataFrame DataFrame::fromExcel(const std::string &filePath, CancellationToken token, ProgressCallback progress) {
+        DataFrameCache& cache = DataFrameCache::getInstance();
+        std::optional<DataFrameCache::Key> cache_key;
+        if (cache.enabled()) {
+            try {
+                cache_key = DataFrameCache::makeKey(filePath, excelContentHash(filePath));
+            } catch (const std::exception&) {
+                // 不是有效的 ZIP，由下面的读取流程报告错误
+            }
+            if (cache_key) {
+                if (auto cached = cache.lookup(*cache_key)) {
+                    spdlog::info("Loaded {} from DataFrame cache", filePath);
+                    return std::move(*cached);
+                }
+            }
+        }
+
+        std::unique_ptr<XlsxStreamReader> reader;
+        XlsxStreamReader::Dimension dimension;
+        try {
+            reader = std::make_unique<XlsxStreamReader>(filePath);
+            dimension = reader->dimension(reader->activeSheet());
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to load Excel file: {}", e.what());
+            throw std::runtime_error("Failed to load Excel file: " + std::string(e.what()));
+        }
+
+        token.throwIfCancelled();
+
+        const size_t sheet = reader->activeSheet();
+        const uint64_t sheet_bytes = reader->sheetSize(sheet);
+        spdlog::info("Reading Excel file with {} rows and {} columns", dimension.rows, dimension.columns);
+
+        // 优化chunk大小，根据数据量动态调整；缺少 <dimension> 时使用上限
+        const size_t estimated_rows = dimension.rows > 1 ? dimension.rows - 1 : 0;
+        const size_t optimal_chunk_size = estimated_rows == 0 ? 10000 : std::min<size_t>(
+            std::max<size_t>(1000, estimated_rows / (std::max(1u, std::thread::hardware_concurrency()) * 2)),
+            10000
+        );
+
+        // 工作表 XML 只能顺序解压，解压和切分在当前线程进行，切出的片段交给线程池并行解析。
+        // 各片段独立收敛列类型，不需要等待第一个片段；同时在途的片段数有上限，
+        // 解压后的 XML 不会整体驻留内存
+        static const bool per_node = ThreadPlatform::numaNodes().size() > 1;
+        const size_t workers = per_node
+                                   ? getNodePools().nodeCount() * getNodePools().pool(0).threadCount()
+                                   : getThreadPool().threadCount();
+        const size_t max_in_flight = workers * 2;
+
+        std::vector<std::unique_ptr<SheetTableBuilder>> ranges;
+
+        std::deque<std::pair<std::future<void>, size_t>> in_flight;
+        std::exception_ptr first_error;
+        uint64_t parsed_bytes = 0;
+        auto report = [&](size_t bytes) {
+            parsed_bytes += bytes;
+            if (progress) {
+                progress(parsed_bytes, sheet_bytes);
+            }
+        };
+        // 按提交顺序回收，保证进度回调单调且只在当前线程上发生
+        auto collect = [&] {
+            auto [future, bytes] = std::move(in_flight.front());
+            in_flight.pop_front();
+            try {
+                future.get();
+                report(bytes);
+            } catch (...) {
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+            }
+        };
+
+        try {
+            reader->splitSheet(sheet, SHEET_RANGE_BYTES, [&](std::string&& xml) {
+                const size_t bytes = xml.size();
+                if (ranges.empty() || workers > 1) {
+                    const bool first_range = ranges.empty();
+                    ranges.push_back(std::make_unique<SheetTableBuilder>(
+                        *reader, first_range ? dimension.columns : 0, optimal_chunk_size, token, first_range));
+                }
+                SheetTableBuilder* range = ranges.back().get();
+                if (workers <= 1) {
+                    // 单线程时所有片段追加到同一个构建器
+                    reader->parseRange(xml, [range](uint64_t row, const std::vector<XlsxStreamReader::Cell>& cells) {
+                        range->onRow(row, cells);
+                    });
+                    report(bytes);
+                    return;
+                }
+
+                ThreadPool& pool = per_node ? getNodePools().poolFor(ranges.size()) : getThreadPool();
+                in_flight.emplace_back(pool.submit([&reader, range, xml = std::move(xml)] {
+                    reader->parseRange(xml, [range](uint64_t row, const std::vector<XlsxStreamReader::Cell>& cells) {
+                        range->onRow(row, cells);
+                    });
+                }, token), bytes);
+
+                while (in_flight.size() > max_in_flight) {
+                    collect();
                 }
-            }));
+                if (first_error) {
+                    std::rethrow_exception(first_error);
+                }
+            });
+        } catch (...) {
+            if (!first_error) {
+                first_error = std::current_exception();
+            }
         }
 
-        // 等待所有列处理完成
-        for (auto& fut : column_futures) {
-            fut.wait();
+        // 片段任务引用了 reader 和构建器，必须全部结束后才能返回或抛出
+        while (!in_flight.empty()) {
+            collect();
+        }
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+
+        std::vector<ColumnLoadReport> load_report;
+        bool spilled = false;
+        DataFrame frame(SheetTableBuilder::merge(ranges, load_report, spilled));
+        frame.spilled_ = spilled;
+        for (const auto& column : load_report) {
+            if (column.coerced > 0) {
+                spdlog::warn("Column '{}' loaded as {}: {} of {} values coerced",
+                             column.column, column.type->ToString(), column.coerced, column.values);
+            }
         }
+        frame.load_report_ = std::move(load_report);
 
-        return DataFrame(arrow::Table::Make(schema, columns));
+        if (cache_key) {
+            // 表不可变，写缓存不阻塞本次读取
+            getThreadPool().post([key = std::move(*cache_key), frame] {
+                DataFrameCache::getInstance().store(key, frame);
+            }, ThreadPool::TaskOptions{ThreadPool::TaskPriority::Low});
+        }
+        return frame;
     }
 
     std::vector<std::string> DataFrame::getColumnNames() const {
@@ -379,192 +1119,1169 @@ namespace TinaToolBox {
         return batch;
     }
 
-    arrow::Result<DataFrame> DataFrame::filter(
-        const std::string& column,
-        const std::shared_ptr<arrow::Scalar>& value,
-        const std::string& comparison_operator
-    ) const {
-        if (!table_) {
-            return arrow::Status::Invalid("DataFrame is empty");
+    // 字典列的排序键：每个字典项的名次（相同的值名次相同），按编码取出后即可代替字符串排序。
+    // 只有所有分块共用同一个字典时名次才可比较，否则返回 nullptr
+    static arrow::Result<std::shared_ptr<arrow::ChunkedArray>> dictionaryRanks(const arrow::ChunkedArray& column) {
+        std::shared_ptr<arrow::Array> dictionary;
+        for (const auto& chunk : column.chunks()) {
+            const auto& chunk_dictionary = static_cast<const arrow::DictionaryArray&>(*chunk).dictionary();
+            if (!dictionary) {
+                dictionary = chunk_dictionary;
+            } else if (chunk_dictionary != dictionary && !chunk_dictionary->Equals(*dictionary)) {
+                return nullptr;
+            }
+        }
+        if (!dictionary) {
+            return nullptr;
         }
 
-        auto col = getColumn(column);
-        if (!col) {
-            return arrow::Status::Invalid("Column not found");
+        arrow::compute::RankOptions options(arrow::compute::SortOrder::Ascending,
+                                            arrow::compute::NullPlacement::AtEnd,
+                                            arrow::compute::RankOptions::Min);
+        ARROW_ASSIGN_OR_RAISE(auto ranks, arrow::compute::CallFunction("rank", {dictionary}, &options));
+        const auto rank_array = ranks.make_array();
+
+        std::vector<std::shared_ptr<arrow::Array>> keys;
+        keys.reserve(column.num_chunks());
+        for (const auto& chunk : column.chunks()) {
+            const auto& indices = *static_cast<const arrow::DictionaryArray&>(*chunk).indices();
+            ARROW_ASSIGN_OR_RAISE(auto key, arrow::compute::Take(*rank_array, indices));
+            keys.push_back(std::move(key));
         }
+        return std::make_shared<arrow::ChunkedArray>(std::move(keys), rank_array->type());
+    }
 
-        // Create comparison kernel
-        std::string kernel_name;
-        if (comparison_operator == "equal") {
-            kernel_name = "equal";
-        } else if (comparison_operator == "not_equal") {
-            kernel_name = "not_equal";
-        } else if (comparison_operator == "greater") {
-            kernel_name = "greater";
-        } else if (comparison_operator == "greater_equal") {
-            kernel_name = "greater_equal";
-        } else if (comparison_operator == "less") {
-            kernel_name = "less";
-        } else if (comparison_operator == "less_equal") {
-            kernel_name = "less_equal";
-        } else {
-            return arrow::Status::Invalid("Invalid comparison operator");
+    namespace Predicate {
+        Expression column(const std::string &name) {
+            return arrow::compute::field_ref(name);
         }
 
-        // Perform comparison
-        arrow::Datum col_datum(col);
-        arrow::Datum value_datum(value);
-        ARROW_ASSIGN_OR_RAISE(auto mask_datum, 
-            arrow::compute::CallFunction(kernel_name, {col_datum, value_datum}));
+        Expression compare(const std::string &column, const std::string &comparison,
+                           std::shared_ptr<arrow::Scalar> value) {
+            return arrow::compute::call(comparison, {arrow::compute::field_ref(column),
+                                                     arrow::compute::literal(std::move(value))});
+        }
 
-        // Perform filtering
-        arrow::Datum table_datum(table_);
-        ARROW_ASSIGN_OR_RAISE(auto filtered_datum,
-            arrow::compute::CallFunction("filter", {table_datum, mask_datum}));
+        Expression isIn(const std::string &column, std::shared_ptr<arrow::Array> values) {
+            return arrow::compute::call("is_in", {arrow::compute::field_ref(column)},
+                                        arrow::compute::SetLookupOptions(std::move(values),
+                                            arrow::compute::SetLookupOptions::MATCH));
+        }
 
-        return DataFrame(filtered_datum.table());
-    }
+        Expression between(const std::string &column, std::shared_ptr<arrow::Scalar> lower,
+                           std::shared_ptr<arrow::Scalar> upper) {
+            return arrow::compute::and_(
+                arrow::compute::greater_equal(arrow::compute::field_ref(column),
+                                              arrow::compute::literal(std::move(lower))),
+                arrow::compute::less_equal(arrow::compute::field_ref(column),
+                                           arrow::compute::literal(std::move(upper))));
+        }
 
-    arrow::Result<DataFrame> DataFrame::sort(
-        const std::string& column, 
-        bool ascending
-    ) const {
+        Expression contains(const std::string &column, const std::string &pattern, bool ignore_case) {
+            return arrow::compute::call("match_substring", {arrow::compute::field_ref(column)},
+                                        arrow::compute::MatchSubstringOptions(pattern, ignore_case));
+        }
+
+        Expression matches(const std::string &column, const std::string &regex, bool ignore_case) {
+            return arrow::compute::call("match_substring_regex", {arrow::compute::field_ref(column)},
+                                        arrow::compute::MatchSubstringOptions(regex, ignore_case));
+        }
+
+        Expression isNull(const std::string &column) {
+            return arrow::compute::is_null(arrow::compute::field_ref(column));
+        }
+
+        Expression isValid(const std::string &column) {
+            return arrow::compute::is_valid(arrow::compute::field_ref(column));
+        }
+    }
+
+    // filter(Expression) 的求值器。只引用同一个字典列的布尔子表达式在字典上求值：字典末尾补一个空值，
+    // 空编码映射到它，按编码取出的结果与逐行求值完全一致（包括 is_null 和 Kleene 逻辑）；
+    // 共用同一字典的批次共用这份结果。其余部分在每个批次上求值一次，仍引用的字典列才解码
+    class PredicateEvaluator {
+    public:
+        static arrow::Result<PredicateEvaluator> make(const arrow::compute::Expression& predicate,
+                                                      const std::shared_ptr<arrow::Schema>& schema) {
+            PredicateEvaluator evaluator;
+            evaluator.schema_ = schema;
+            ARROW_ASSIGN_OR_RAISE(auto residual, evaluator.extractDictionaryPredicates(predicate));
+
+            // 剩余表达式仍引用的字典列解码为值类型，字典子条件的结果作为额外的布尔列追加在后面
+            arrow::FieldVector fields = schema->fields();
+            for (const auto& ref : arrow::compute::FieldsInExpression(residual)) {
+                ARROW_ASSIGN_OR_RAISE(auto path, ref.FindOneOrNone(*schema));
+                if (path.indices().size() == 1 && fields[path[0]]->type()->id() == arrow::Type::DICTIONARY) {
+                    const int index = path[0];
+                    if (std::find(evaluator.decoded_columns_.begin(), evaluator.decoded_columns_.end(), index) ==
+                        evaluator.decoded_columns_.end()) {
+                        evaluator.decoded_columns_.push_back(index);
+                        fields[index] = fields[index]->WithType(
+                            static_cast<const arrow::DictionaryType&>(*fields[index]->type()).value_type());
+                    }
+                }
+            }
+            for (size_t i = 0; i < evaluator.dictionary_predicates_.size(); ++i) {
+                fields.push_back(arrow::field("__ttb_dictionary_predicate_" + std::to_string(i), arrow::boolean()));
+            }
+            evaluator.residual_schema_ = arrow::schema(std::move(fields));
+            ARROW_ASSIGN_OR_RAISE(evaluator.residual_, residual.Bind(*evaluator.residual_schema_));
+            if (evaluator.residual_.type()->id() != arrow::Type::BOOL) {
+                return arrow::Status::TypeError("Filter predicate must be boolean, got ",
+                                                evaluator.residual_.type()->ToString());
+            }
+            return evaluator;
+        }
+
+        // 返回与 batch 等长的布尔掩码
+        arrow::Result<std::shared_ptr<arrow::Array>> evaluate(const arrow::RecordBatch& batch) {
+            std::vector<std::shared_ptr<arrow::Array>> columns = batch.columns();
+            for (const int index : decoded_columns_) {
+                ARROW_ASSIGN_OR_RAISE(auto decoded, arrow::compute::Cast(*columns[index],
+                                                        residual_schema_->field(index)->type()));
+                columns[index] = std::move(decoded);
+            }
+            for (auto& dictionary_predicate : dictionary_predicates_) {
+                ARROW_ASSIGN_OR_RAISE(auto mask, evaluate(dictionary_predicate, *batch.column(dictionary_predicate.column)));
+                columns.push_back(std::move(mask));
+            }
+            const auto input = arrow::RecordBatch::Make(residual_schema_, batch.num_rows(), std::move(columns));
+            ARROW_ASSIGN_OR_RAISE(auto result, arrow::compute::ExecuteScalarExpression(residual_, *residual_schema_,
+                                                                                       arrow::Datum(input)));
+            return toArray(result, batch.num_rows());
+        }
+
+    private:
+        struct DictionaryPredicate {
+            int column = 0;
+            // 绑定到只有该列（值类型）的 schema
+            arrow::compute::Expression expression;
+            std::shared_ptr<arrow::Schema> schema;
+            // 最近一次求值的字典和结果（长度为字典长度 + 1，最后一项对应空编码）
+            std::shared_ptr<arrow::Array> dictionary;
+            std::shared_ptr<arrow::Array> mask;
+        };
+
+        PredicateEvaluator() = default;
+
+        static arrow::Result<std::shared_ptr<arrow::Array>> toArray(const arrow::Datum& datum, int64_t length) {
+            if (datum.is_scalar()) {
+                return arrow::MakeArrayFromScalar(*datum.scalar(), length);
+            }
+            return datum.make_array();
+        }
+
+        // 把只引用一个字典列的最大布尔子表达式替换为对追加布尔列的引用
+        arrow::Result<arrow::compute::Expression> extractDictionaryPredicates(
+            const arrow::compute::Expression& expression) {
+            const auto* call = expression.call();
+            if (!call) {
+                return expression;
+            }
+
+            int column = -1;
+            bool single_dictionary = true;
+            for (const auto& ref : arrow::compute::FieldsInExpression(expression)) {
+                ARROW_ASSIGN_OR_RAISE(auto path, ref.FindOneOrNone(*schema_));
+                if (path.indices().size() != 1 || (column >= 0 && path[0] != column) ||
+                    schema_->field(path[0])->type()->id() != arrow::Type::DICTIONARY) {
+                    single_dictionary = false;
+                    break;
+                }
+                column = path[0];
+            }
+            if (single_dictionary && column >= 0) {
+                const auto& field = schema_->field(column);
+                auto schema = arrow::schema({field->WithType(
+                    static_cast<const arrow::DictionaryType&>(*field->type()).value_type())});
+                auto bound = expression.Bind(*schema);
+                if (bound.ok() && bound->type()->id() == arrow::Type::BOOL) {
+                    const auto index = schema_->num_fields() + static_cast<int>(dictionary_predicates_.size());
+                    DictionaryPredicate dictionary_predicate;
+                    dictionary_predicate.column = column;
+                    dictionary_predicate.expression = std::move(bound).ValueOrDie();
+                    dictionary_predicate.schema = std::move(schema);
+                    dictionary_predicates_.push_back(std::move(dictionary_predicate));
+                    return arrow::compute::field_ref(arrow::FieldRef(arrow::FieldPath({index})));
+                }
+            }
+
+            std::vector<arrow::compute::Expression> arguments;
+            arguments.reserve(call->arguments.size());
+            for (const auto& argument : call->arguments) {
+                ARROW_ASSIGN_OR_RAISE(auto rewritten, extractDictionaryPredicates(argument));
+                arguments.push_back(std::move(rewritten));
+            }
+            return arrow::compute::call(call->function_name, std::move(arguments), call->options);
+        }
+
+        static arrow::Result<std::shared_ptr<arrow::Array>> evaluate(DictionaryPredicate& predicate,
+                                                                     const arrow::Array& column) {
+            const auto& dictionary_array = static_cast<const arrow::DictionaryArray&>(column);
+            const auto& dictionary = dictionary_array.dictionary();
+            if (dictionary != predicate.dictionary) {
+                ARROW_ASSIGN_OR_RAISE(auto null_value, arrow::MakeArrayOfNull(dictionary->type(), 1));
+                ARROW_ASSIGN_OR_RAISE(auto values, arrow::Concatenate({dictionary, null_value}));
+                const auto input = arrow::RecordBatch::Make(predicate.schema, values->length(), {values});
+                ARROW_ASSIGN_OR_RAISE(auto result, arrow::compute::ExecuteScalarExpression(
+                                          predicate.expression, *predicate.schema, arrow::Datum(input)));
+                ARROW_ASSIGN_OR_RAISE(predicate.mask, toArray(result, values->length()));
+                predicate.dictionary = dictionary;
+            }
+
+            std::shared_ptr<arrow::Array> indices = dictionary_array.indices();
+            if (indices->null_count() > 0) {
+                ARROW_ASSIGN_OR_RAISE(auto widened, arrow::compute::Cast(*indices, arrow::int32()));
+                ARROW_ASSIGN_OR_RAISE(auto filled, arrow::compute::CallFunction(
+                                          "coalesce", {widened, arrow::Datum(static_cast<int32_t>(dictionary->length()))}));
+                indices = filled.make_array();
+            }
+            ARROW_ASSIGN_OR_RAISE(auto mask, arrow::compute::Take(*predicate.mask, *indices));
+            return mask;
+        }
+
+        std::shared_ptr<arrow::Schema> schema_;
+        std::vector<DictionaryPredicate> dictionary_predicates_;
+        std::vector<int> decoded_columns_;
+        std::shared_ptr<arrow::Schema> residual_schema_;
+        arrow::compute::Expression residual_;
+    };
+
+    static arrow::Result<arrow::compute::Expression> comparisonPredicate(const std::string& column,
+                                                                        const std::shared_ptr<arrow::Scalar>& value,
+                                                                        const std::string& comparison_operator) {
+        static const std::array<const char*, 6> OPERATORS = {
+            "equal", "not_equal", "greater", "greater_equal", "less", "less_equal"
+        };
+        if (std::find(OPERATORS.begin(), OPERATORS.end(), comparison_operator) == OPERATORS.end()) {
+            return arrow::Status::Invalid("Invalid comparison operator");
+        }
+        return Predicate::compare(column, comparison_operator, value);
+    }
+
+    arrow::Result<DataFrame> DataFrame::filter(
+        const std::string& column,
+        const std::shared_ptr<arrow::Scalar>& value,
+        const std::string& comparison_operator
+    ) const {
         if (!table_) {
             return arrow::Status::Invalid("DataFrame is empty");
         }
+        if (!getColumn(column)) {
+            return arrow::Status::Invalid("Column not found");
+        }
+        ARROW_ASSIGN_OR_RAISE(auto predicate, comparisonPredicate(column, value, comparison_operator));
+        return filter(predicate);
+    }
 
-        auto col = getColumn(column);
-        if (!col) {
+    arrow::Result<std::shared_ptr<arrow::ChunkedArray>> DataFrame::filterMask(
+        const arrow::compute::Expression& predicate) const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        ARROW_ASSIGN_OR_RAISE(auto evaluator, PredicateEvaluator::make(predicate, table_->schema()));
+
+        // 批次边界是各列分块边界的并集，批次内各列都是连续数组，不需要拷贝
+        std::vector<std::shared_ptr<arrow::Array>> masks;
+        arrow::TableBatchReader reader(*table_);
+        std::shared_ptr<arrow::RecordBatch> batch;
+        while (true) {
+            ARROW_RETURN_NOT_OK(reader.ReadNext(&batch));
+            if (!batch) {
+                break;
+            }
+            ARROW_ASSIGN_OR_RAISE(auto mask, evaluator.evaluate(*batch));
+            masks.push_back(std::move(mask));
+        }
+        return std::make_shared<arrow::ChunkedArray>(std::move(masks), arrow::boolean());
+    }
+
+    arrow::Result<DataFrame> DataFrame::filter(const arrow::compute::Expression& predicate) const {
+        ARROW_ASSIGN_OR_RAISE(auto selection, filterMask(predicate));
+        ARROW_ASSIGN_OR_RAISE(auto filtered, arrow::compute::CallFunction("filter", {table_, selection}));
+        return DataFrame(filtered.table());
+    }
+
+    // 排序键在两行上的比较，规则与 arrow 的 SortIndices 一致：空值和 NaN 按 nulls_first 放在两端（空值在最外侧），
+    // 与升降序无关；字符串按字节比较。用于并行排序的归并和 top-k 筛选
+    class SortKeyComparator {
+    public:
+        // 有不支持的键类型时返回 nullptr，调用方退回到 arrow 的整表排序
+        static std::unique_ptr<SortKeyComparator> make(const std::vector<std::shared_ptr<arrow::Array>>& columns,
+                                                       const std::vector<DataFrame::SortKey>& keys) {
+            auto comparator = std::unique_ptr<SortKeyComparator>(new SortKeyComparator());
+            for (size_t i = 0; i < columns.size(); ++i) {
+                auto column = makeColumn(*columns[i], keys[i]);
+                if (!column) {
+                    return nullptr;
+                }
+                comparator->columns_.push_back(std::move(column));
+            }
+            return comparator;
+        }
+
+        // 键都相同时按行号比较，保证稳定
+        bool less(int64_t a, int64_t b) const {
+            for (const auto& column : columns_) {
+                const int result = column->compare(a, b);
+                if (result != 0) {
+                    return result < 0;
+                }
+            }
+            return a < b;
+        }
+
+    private:
+        class Column {
+        public:
+            virtual ~Column() = default;
+            virtual int compare(int64_t a, int64_t b) const = 0;
+        };
+
+        template<typename ArrayType>
+        class TypedColumn final : public Column {
+        public:
+            TypedColumn(const arrow::Array& array, const DataFrame::SortKey& key)
+                : array_(static_cast<const ArrayType&>(array)), ascending_(key.ascending),
+                  nulls_first_(key.nulls_first) {}
+
+            int compare(int64_t a, int64_t b) const override {
+                const bool null_a = array_.IsNull(a);
+                const bool null_b = array_.IsNull(b);
+                if (null_a || null_b) {
+                    return edge(null_a, null_b);
+                }
+                const auto value_a = array_.GetView(a);
+                const auto value_b = array_.GetView(b);
+                if constexpr (std::is_floating_point_v<decltype(value_a)>) {
+                    const bool nan_a = std::isnan(value_a);
+                    const bool nan_b = std::isnan(value_b);
+                    if (nan_a || nan_b) {
+                        return edge(nan_a, nan_b);
+                    }
+                }
+                const int result = value_a < value_b ? -1 : (value_b < value_a ? 1 : 0);
+                return ascending_ ? result : -result;
+            }
+
+        private:
+            // 至少一个是空值（或 NaN）时的比较结果
+            int edge(bool a, bool b) const {
+                if (a == b) {
+                    return 0;
+                }
+                return a == nulls_first_ ? -1 : 1;
+            }
+
+            const ArrayType& array_;
+            bool ascending_;
+            bool nulls_first_;
+        };
+
+        SortKeyComparator() = default;
+
+        static std::unique_ptr<Column> makeColumn(const arrow::Array& array, const DataFrame::SortKey& key) {
+            switch (array.type_id()) {
+                case arrow::Type::BOOL: return std::make_unique<TypedColumn<arrow::BooleanArray>>(array, key);
+                case arrow::Type::INT8: return std::make_unique<TypedColumn<arrow::Int8Array>>(array, key);
+                case arrow::Type::INT16: return std::make_unique<TypedColumn<arrow::Int16Array>>(array, key);
+                case arrow::Type::INT32: return std::make_unique<TypedColumn<arrow::Int32Array>>(array, key);
+                case arrow::Type::INT64: return std::make_unique<TypedColumn<arrow::Int64Array>>(array, key);
+                case arrow::Type::UINT8: return std::make_unique<TypedColumn<arrow::UInt8Array>>(array, key);
+                case arrow::Type::UINT16: return std::make_unique<TypedColumn<arrow::UInt16Array>>(array, key);
+                case arrow::Type::UINT32: return std::make_unique<TypedColumn<arrow::UInt32Array>>(array, key);
+                case arrow::Type::UINT64: return std::make_unique<TypedColumn<arrow::UInt64Array>>(array, key);
+                case arrow::Type::FLOAT: return std::make_unique<TypedColumn<arrow::FloatArray>>(array, key);
+                case arrow::Type::DOUBLE: return std::make_unique<TypedColumn<arrow::DoubleArray>>(array, key);
+                case arrow::Type::STRING: return std::make_unique<TypedColumn<arrow::StringArray>>(array, key);
+                case arrow::Type::LARGE_STRING: return std::make_unique<TypedColumn<arrow::LargeStringArray>>(array, key);
+                case arrow::Type::DATE32: return std::make_unique<TypedColumn<arrow::Date32Array>>(array, key);
+                case arrow::Type::DATE64: return std::make_unique<TypedColumn<arrow::Date64Array>>(array, key);
+                case arrow::Type::TIMESTAMP: return std::make_unique<TypedColumn<arrow::TimestampArray>>(array, key);
+                case arrow::Type::DURATION: return std::make_unique<TypedColumn<arrow::DurationArray>>(array, key);
+                default: return nullptr;
+            }
+        }
+
+        std::vector<std::unique_ptr<Column>> columns_;
+    };
+
+    // 排序用的键列：字典列换成字典项名次（各分块字典不一致时解码），列名依次为 0、1、2……
+    static arrow::Result<std::shared_ptr<arrow::Table>> sortKeyTable(const arrow::Table& table,
+                                                                     const std::vector<DataFrame::SortKey>& keys) {
+        arrow::FieldVector fields;
+        std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+        for (const auto& key : keys) {
+            auto column = table.GetColumnByName(key.column);
+            if (!column) {
+                return arrow::Status::Invalid("Column not found: ", key.column);
+            }
+            if (column->type()->id() == arrow::Type::DICTIONARY) {
+                ARROW_ASSIGN_OR_RAISE(auto ranks, dictionaryRanks(*column));
+                if (!ranks) {
+                    const auto& value_type = static_cast<const arrow::DictionaryType&>(*column->type()).value_type();
+                    ARROW_ASSIGN_OR_RAISE(auto decoded, arrow::compute::Cast(arrow::Datum(column), value_type));
+                    ranks = decoded.chunked_array();
+                }
+                column = std::move(ranks);
+            }
+            fields.push_back(arrow::field(std::to_string(fields.size()), column->type()));
+            columns.push_back(std::move(column));
+        }
+        return arrow::Table::Make(arrow::schema(std::move(fields)), std::move(columns), table.num_rows());
+    }
+
+    static arrow::compute::SortOptions sortOptions(const std::vector<DataFrame::SortKey>& keys) {
+        std::vector<arrow::compute::SortKey> sort_keys;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            sort_keys.emplace_back(std::to_string(i),
+                                   keys[i].ascending ? arrow::compute::SortOrder::Ascending
+                                                     : arrow::compute::SortOrder::Descending,
+                                   keys[i].nulls_first ? arrow::compute::NullPlacement::AtStart
+                                                       : arrow::compute::NullPlacement::AtEnd);
+        }
+        return arrow::compute::SortOptions(std::move(sort_keys));
+    }
+
+    // 把各段已排好序的行号归并为一个序列，最多取 limit 个。各段是按原顺序切分的连续区间，
+    // 比较器在键相同时按行号比较，因此结果是稳定的
+    static std::vector<int64_t> mergeSortedRuns(const std::vector<std::vector<int64_t>>& runs,
+                                                const SortKeyComparator& comparator, size_t limit) {
+        size_t total = 0;
+        for (const auto& run : runs) {
+            total += run.size();
+        }
+        std::vector<int64_t> merged;
+        merged.reserve(std::min(total, limit));
+
+        // 小顶堆中保存 (段号, 段内位置)
+        using Cursor = std::pair<size_t, size_t>;
+        auto greater = [&](const Cursor& a, const Cursor& b) {
+            return comparator.less(runs[b.first][b.second], runs[a.first][a.second]);
+        };
+        std::vector<Cursor> heap;
+        for (size_t r = 0; r < runs.size(); ++r) {
+            if (!runs[r].empty()) {
+                heap.emplace_back(r, 0);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), greater);
+        while (!heap.empty() && merged.size() < limit) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            auto& cursor = heap.back();
+            merged.push_back(runs[cursor.first][cursor.second]);
+            if (++cursor.second < runs[cursor.first].size()) {
+                std::push_heap(heap.begin(), heap.end(), greater);
+            } else {
+                heap.pop_back();
+            }
+        }
+        return merged;
+    }
+
+    // 排序后的行号；limit < 0 时全部排序，否则只求前 limit 个。
+    // 全排序且不超过 PARALLEL_SORT_ROWS 行时直接使用 arrow 的稳定排序；
+    // 否则按线程数切分为连续的段，各段并行排序（或用大小为 limit 的堆筛选），再 k 路归并
+    static arrow::Result<std::shared_ptr<arrow::Array>> sortIndices(const arrow::Table& key_table,
+                                                                    const std::vector<DataFrame::SortKey>& keys,
+                                                                    int64_t limit, ThreadPool& pool) {
+        const int64_t num_rows = key_table.num_rows();
+        const auto options = sortOptions(keys);
+        const bool partial = limit >= 0 && limit < num_rows;
+        if (!partial && num_rows <= DataFrame::PARALLEL_SORT_ROWS) {
+            return arrow::compute::SortIndices(arrow::Datum(key_table), options);
+        }
+
+        std::vector<std::shared_ptr<arrow::Array>> key_columns;
+        for (const auto& column : key_table.columns()) {
+            if (column->num_chunks() == 1) {
+                key_columns.push_back(column->chunk(0));
+            } else {
+                ARROW_ASSIGN_OR_RAISE(auto combined, arrow::Concatenate(column->chunks()));
+                key_columns.push_back(std::move(combined));
+            }
+        }
+        const auto comparator = SortKeyComparator::make(key_columns, keys);
+        if (!comparator) {
+            ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(arrow::Datum(key_table), options));
+            return partial ? indices->Slice(0, limit) : indices;
+        }
+
+        const size_t run_count = num_rows > DataFrame::PARALLEL_SORT_ROWS
+                                     ? std::max<size_t>(1, pool.threadCount())
+                                     : 1;
+        const auto run_rows = static_cast<int64_t>((num_rows + run_count - 1) / run_count);
+        std::vector<std::vector<int64_t>> runs(run_count);
+        std::vector<arrow::Status> statuses(run_count);
+        pool.parallel_for(0, run_count, 1, [&](size_t r) {
+            const int64_t begin = std::min(num_rows, static_cast<int64_t>(r) * run_rows);
+            const int64_t end = std::min(num_rows, begin + run_rows);
+            auto& run = runs[r];
+            if (partial) {
+                // 大顶堆保留当前最小的 limit 行
+                auto less = [&](int64_t a, int64_t b) { return comparator->less(a, b); };
+                run.reserve(static_cast<size_t>(std::min(limit, end - begin)));
+                for (int64_t row = begin; row < end; ++row) {
+                    if (static_cast<int64_t>(run.size()) < limit) {
+                        run.push_back(row);
+                        std::push_heap(run.begin(), run.end(), less);
+                    } else if (limit > 0 && comparator->less(row, run.front())) {
+                        std::pop_heap(run.begin(), run.end(), less);
+                        run.back() = row;
+                        std::push_heap(run.begin(), run.end(), less);
+                    }
+                }
+                std::sort_heap(run.begin(), run.end(), less);
+                return;
+            }
+            auto indices = arrow::compute::SortIndices(arrow::Datum(key_table.Slice(begin, end - begin)), options);
+            if (!indices.ok()) {
+                statuses[r] = indices.status();
+                return;
+            }
+            const auto& values = static_cast<const arrow::UInt64Array&>(**indices);
+            run.resize(static_cast<size_t>(values.length()));
+            for (int64_t i = 0; i < values.length(); ++i) {
+                run[i] = begin + static_cast<int64_t>(values.Value(i));
+            }
+        });
+        for (const auto& status : statuses) {
+            ARROW_RETURN_NOT_OK(status);
+        }
+
+        auto merged = mergeSortedRuns(runs, *comparator, partial ? static_cast<size_t>(limit) : SIZE_MAX);
+        const auto length = static_cast<int64_t>(merged.size());
+        return std::make_shared<arrow::Int64Array>(length, arrow::Buffer::FromVector(std::move(merged)));
+    }
+
+    arrow::Result<DataFrame> DataFrame::sort(
+        const std::string& column, 
+        bool ascending
+    ) const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        if (!getColumn(column)) {
             return arrow::Status::Invalid("Column not found");
         }
-        arrow::compute::SortOptions options({arrow::compute::SortKey(column, ascending ? arrow::compute::SortOrder::Ascending : arrow::compute::SortOrder::Descending)});
+        return sort(std::vector<SortKey>{SortKey{column, ascending}});
+    }
 
-        ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(table_, options));
+    arrow::Result<std::shared_ptr<arrow::Array>> DataFrame::sortedRowIndices(const std::vector<SortKey>& keys,
+                                                                             int64_t limit) const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        if (keys.empty()) {
+            return arrow::Status::Invalid("No sort keys");
+        }
+        // 字典列按字典项名次排序，不解码字符串
+        ARROW_ASSIGN_OR_RAISE(auto key_table, sortKeyTable(*table_, keys));
+        return sortIndices(*key_table, keys, limit, getThreadPool());
+    }
+
+    arrow::Result<DataFrame> DataFrame::sort(const std::vector<SortKey>& keys) const {
+        if (table_ && exceedsMemoryBudget(arrow::util::TotalBufferSize(*table_))) {
+            return externalSort(keys);
+        }
+        ARROW_ASSIGN_OR_RAISE(auto indices, sortedRowIndices(keys, -1));
         ARROW_ASSIGN_OR_RAISE(auto sorted_table, arrow::compute::Take(table_, indices));
+        return DataFrame(sorted_table.table());
+    }
 
+    arrow::Result<DataFrame> DataFrame::topK(const std::vector<SortKey>& keys, int64_t k) const {
+        if (k < 0) {
+            return arrow::Status::Invalid("k must not be negative");
+        }
+        ARROW_ASSIGN_OR_RAISE(auto indices, sortedRowIndices(keys, k));
+        ARROW_ASSIGN_OR_RAISE(auto sorted_table, arrow::compute::Take(table_, indices));
         return DataFrame(sorted_table.table());
     }
 
+    std::shared_ptr<const std::vector<int64_t>> DataFrame::chunkOffsets(int column) const {
+        const auto build = [&] {
+            const auto &chunked = *table_->column(column);
+            auto starts = std::make_shared<std::vector<int64_t>>();
+            starts->reserve(chunked.num_chunks() + 1);
+            int64_t start = 0;
+            for (const auto &chunk : chunked.chunks()) {
+                starts->push_back(start);
+                start += chunk->length();
+            }
+            starts->push_back(start);
+            return starts;
+        };
+        // 被移动过的对象没有缓存，每次重新计算
+        if (!chunk_offsets_) {
+            return build();
+        }
+        std::lock_guard<std::mutex> lock(chunk_offsets_->mutex);
+        auto &offsets = chunk_offsets_->offsets;
+        if (offsets.empty()) {
+            offsets.resize(table_->num_columns());
+        }
+        if (!offsets[column]) {
+            offsets[column] = build();
+        }
+        return offsets[column];
+    }
+
     template<typename T>
-    arrow::Result<T> DataFrame::getValue(int64_t row, const std::string &column) const {
+    arrow::Result<ColumnAccessor<T>> DataFrame::columnAccessor(const std::string &column) const {
         if (!table_) {
             return arrow::Status::Invalid("DataFrame is empty");
         }
-        if (row < 0 || row >= table_->num_rows()) {
-            return arrow::Status::Invalid("Row index out of bounds");
-        }
-        auto col = getColumn(column);
-        if (!col) {
+        const int index = table_->schema()->GetFieldIndex(column);
+        if (index < 0) {
             return arrow::Status::Invalid("Column not found");
         }
-        if (col->num_chunks() == 0) {
-            return arrow::Status::Invalid("Column has no data");
-        }
-        
-        if constexpr (std::is_same_v<T, std::string>) {
-            if (col->type()->id() != arrow::Type::STRING && col->type()->id() != arrow::Type::LARGE_STRING) {
+        const auto &type = *table_->schema()->field(index)->type();
+        if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+            if (type.id() == arrow::Type::DICTIONARY) {
+                if (static_cast<const arrow::DictionaryType &>(type).value_type()->id() != arrow::Type::STRING) {
+                    return arrow::Status::TypeError("Column type is not string");
+                }
+            } else if (type.id() != arrow::Type::STRING && type.id() != arrow::Type::LARGE_STRING) {
                 return arrow::Status::TypeError("Column type is not string");
             }
-            auto array = std::static_pointer_cast<arrow::StringArray>(col->chunk(0));
-            return array->GetString(row);
         } else if constexpr (std::is_same_v<T, int64_t>) {
-            if (col->type()->id() != arrow::Type::INT64) {
+            if (type.id() != arrow::Type::INT64) {
                 return arrow::Status::TypeError("Column type is not int64");
             }
-            auto array = std::static_pointer_cast<arrow::Int64Array>(col->chunk(0));
-            return array->Value(row);
         } else if constexpr (std::is_same_v<T, double>) {
-            if (col->type()->id() != arrow::Type::DOUBLE) {
+            if (type.id() != arrow::Type::DOUBLE) {
                 return arrow::Status::TypeError("Column type is not double");
             }
-            auto array = std::static_pointer_cast<arrow::DoubleArray>(col->chunk(0));
-            return array->Value(row);
         } else if constexpr (std::is_same_v<T, bool>) {
-            if (col->type()->id() != arrow::Type::BOOL) {
+            if (type.id() != arrow::Type::BOOL) {
                 return arrow::Status::TypeError("Column type is not bool");
             }
-            auto array = std::static_pointer_cast<arrow::BooleanArray>(col->chunk(0));
-            return array->Value(row);
         } else {
             return arrow::Status::NotImplemented("Type not supported");
         }
+        return ColumnAccessor<T>(table_->column(index), chunkOffsets(index));
     }
 
-    bool DataFrame::toSaveExcel(const std::string &filePath, bool forceOverwrite) const {
-        if (!forceOverwrite && std::filesystem::exists(filePath)) {
-            spdlog::error("File already exists: {}", filePath);
-            return false;
-        }
-
+    template<typename T>
+    arrow::Result<T> DataFrame::getValue(int64_t row, const std::string &column) const {
         if (!table_) {
-            spdlog::error("DataFrame is empty, nothing to save.");
-            return false;
+            return arrow::Status::Invalid("DataFrame is empty");
         }
+        if (row < 0 || row >= table_->num_rows()) {
+            return arrow::Status::Invalid("Row index out of bounds");
+        }
+        ARROW_ASSIGN_OR_RAISE(const auto accessor, columnAccessor<T>(column));
+        if (accessor.isNull(row)) {
+            return arrow::Status::Invalid("Value is null");
+        }
+        return accessor.value(row);
+    }
 
-        xlnt::workbook wb;
-        xlnt::worksheet ws = wb.active_sheet();
+    // toSaveExcel 每批处理的行数：一批内按列遍历，单元格总数约为 EXCEL_BATCH_ROWS × 列数
+    static constexpr int64_t EXCEL_BATCH_ROWS = 4096;
 
-        // Write header
-        int col_index = 1;
-        for (const auto& field : table_->schema()->fields()) {
-            ws.cell(col_index, 1).value(field->name());
-            col_index++;
+    // 导出 xlsx 时一列的读取位置，每批从上次停下的 chunk 和偏移继续，整列只遍历一次
+    struct ExcelColumnCursor {
+        const arrow::ChunkedArray* column = nullptr;
+        int chunk = 0;
+        int64_t offset = 0;
+        // 字典值到共享字符串索引的映射，字典变化时重建
+        static constexpr uint32_t UNMAPPED = XlsxStreamWriter::NO_SHARED_STRING - 1;
+        const arrow::Array* mapped_dictionary = nullptr;
+        std::vector<uint32_t> shared_indices;
+        bool warned = false;
+    };
+
+    template<typename ArrayType>
+    static void appendNumberCells(const arrow::Array& array, int64_t offset, int64_t count, uint32_t column,
+                                  std::vector<XlsxStreamWriter::Cell>* rows) {
+        const auto& values = static_cast<const ArrayType&>(array);
+        for (int64_t i = 0; i < count; ++i) {
+            if (values.IsNull(offset + i)) {
+                continue;
+            }
+            XlsxStreamWriter::Cell cell;
+            cell.column = column;
+            cell.number = static_cast<double>(values.Value(offset + i));
+            rows[i].push_back(cell);
         }
+    }
 
-        // Write data
-        for (int64_t row_index = 0; row_index < table_->num_rows(); ++row_index) {
-            for (int col_index = 0; col_index < table_->num_columns(); ++col_index) {
-                auto cell = ws.cell(col_index + 1, row_index + 2);
-                auto column = table_->column(col_index);
+    // 把 cursor 所在列接下来的 count 个值追加到 rows[0, count) 中。
+    // 早于 1900 年的时间戳以文本写出，文本保存在 texts 中直到这一批写完
+    static void appendExcelColumn(ExcelColumnCursor& cursor, uint32_t column, int64_t count,
+                                  std::vector<XlsxStreamWriter::Cell>* rows, XlsxStreamWriter& writer,
+                                  ExcelSerialConverter& dates, std::deque<std::string>& texts) {
+        using Cell = XlsxStreamWriter::Cell;
+        const arrow::DataType& type = *cursor.column->type();
+        while (count > 0) {
+            const arrow::Array& array = *cursor.column->chunk(cursor.chunk);
+            const int64_t n = std::min(count, array.length() - cursor.offset);
+            if (n <= 0) {
+                ++cursor.chunk;
+                cursor.offset = 0;
+                continue;
+            }
+            const int64_t offset = cursor.offset;
 
-                if (column->chunk(0)->IsNull(row_index)) {
-                    continue; // Skip null values
+            switch (type.id()) {
+                case arrow::Type::BOOL: {
+                    const auto& values = static_cast<const arrow::BooleanArray&>(array);
+                    for (int64_t i = 0; i < n; ++i) {
+                        if (!values.IsNull(offset + i)) {
+                            Cell cell;
+                            cell.column = column;
+                            cell.type = Cell::Type::Boolean;
+                            cell.number = values.Value(offset + i) ? 1.0 : 0.0;
+                            rows[i].push_back(cell);
+                        }
+                    }
+                    break;
                 }
-
-                switch (column->type()->id()) {
-                    case arrow::Type::INT64: {
-                        auto int_array = std::static_pointer_cast<arrow::Int64Array>(column->chunk(0));
-                        cell.value(static_cast<int64_t>(int_array->Value(row_index)));
-                        break;
+                case arrow::Type::INT8: appendNumberCells<arrow::Int8Array>(array, offset, n, column, rows); break;
+                case arrow::Type::INT16: appendNumberCells<arrow::Int16Array>(array, offset, n, column, rows); break;
+                case arrow::Type::INT32: appendNumberCells<arrow::Int32Array>(array, offset, n, column, rows); break;
+                case arrow::Type::INT64: appendNumberCells<arrow::Int64Array>(array, offset, n, column, rows); break;
+                case arrow::Type::UINT8: appendNumberCells<arrow::UInt8Array>(array, offset, n, column, rows); break;
+                case arrow::Type::UINT16: appendNumberCells<arrow::UInt16Array>(array, offset, n, column, rows); break;
+                case arrow::Type::UINT32: appendNumberCells<arrow::UInt32Array>(array, offset, n, column, rows); break;
+                case arrow::Type::UINT64: appendNumberCells<arrow::UInt64Array>(array, offset, n, column, rows); break;
+                case arrow::Type::FLOAT: appendNumberCells<arrow::FloatArray>(array, offset, n, column, rows); break;
+                case arrow::Type::DOUBLE: appendNumberCells<arrow::DoubleArray>(array, offset, n, column, rows); break;
+                case arrow::Type::STRING:
+                case arrow::Type::LARGE_STRING: {
+                    for (int64_t i = 0; i < n; ++i) {
+                        if (array.IsNull(offset + i)) {
+                            continue;
+                        }
+                        Cell cell;
+                        cell.column = column;
+                        cell.type = Cell::Type::String;
+                        cell.text = type.id() == arrow::Type::STRING
+                                        ? static_cast<const arrow::StringArray&>(array).GetView(offset + i)
+                                        : static_cast<const arrow::LargeStringArray&>(array).GetView(offset + i);
+                        rows[i].push_back(cell);
                     }
-                    case arrow::Type::DOUBLE: {
-                        auto double_array = std::static_pointer_cast<arrow::DoubleArray>(column->chunk(0));
-                        cell.value(double_array->Value(row_index));
+                    break;
+                }
+                case arrow::Type::DICTIONARY: {
+                    const auto& values = static_cast<const arrow::DictionaryArray&>(array);
+                    if (values.dictionary()->type_id() != arrow::Type::STRING) {
+                        if (!cursor.warned) {
+                            spdlog::warn("Unsupported column type for Excel export: {}", type.ToString());
+                            cursor.warned = true;
+                        }
                         break;
                     }
-                    case arrow::Type::STRING: {
-                        auto string_array = std::static_pointer_cast<arrow::StringArray>(column->chunk(0));
-                        cell.value(string_array->GetString(row_index));
-                        break;
+                    const auto& dictionary = static_cast<const arrow::StringArray&>(*values.dictionary());
+                    // 每个字典值在第一次用到时查一次共享字符串表，没有用到的字典值不写入
+                    if (cursor.mapped_dictionary != &dictionary) {
+                        cursor.mapped_dictionary = &dictionary;
+                        cursor.shared_indices.assign(dictionary.length(), ExcelColumnCursor::UNMAPPED);
                     }
-                    case arrow::Type::BOOL: {
-                        auto bool_array = std::static_pointer_cast<arrow::BooleanArray>(column->chunk(0));
-                        cell.value(bool_array->Value(row_index));
-                        break;
+                    for (int64_t i = 0; i < n; ++i) {
+                        if (values.IsNull(offset + i)) {
+                            continue;
+                        }
+                        const int64_t index = values.GetValueIndex(offset + i);
+                        if (dictionary.IsNull(index)) {
+                            continue;
+                        }
+                        auto& shared_index = cursor.shared_indices[index];
+                        if (shared_index == ExcelColumnCursor::UNMAPPED) {
+                            shared_index = writer.sharedString(dictionary.GetView(index));
+                        }
+                        Cell cell;
+                        cell.column = column;
+                        cell.shared_index = shared_index;
+                        if (cell.shared_index == XlsxStreamWriter::NO_SHARED_STRING) {
+                            cell.type = Cell::Type::String;
+                            cell.text = dictionary.GetView(index);
+                        } else {
+                            cell.type = Cell::Type::SharedString;
+                        }
+                        rows[i].push_back(cell);
                     }
-                    case arrow::Type::TIMESTAMP: {
-                        auto timestamp_array = std::static_pointer_cast<arrow::TimestampArray>(column->chunk(0));
-                        auto timestamp = timestamp_array->Value(row_index);
-                        xlnt::datetime dt = timestamp_to_datetime(timestamp);
-                        cell.value(dt);
-                        cell.number_format(xlnt::number_format("yyyy-mm-dd"));
-                        break;
+                    break;
+                }
+                case arrow::Type::TIMESTAMP: {
+                    const auto& values = static_cast<const arrow::TimestampArray&>(array);
+                    int64_t multiplier = 1;
+                    int64_t divisor = 1;
+                    switch (static_cast<const arrow::TimestampType&>(type).unit()) {
+                        case arrow::TimeUnit::SECOND: multiplier = 1000000; break;
+                        case arrow::TimeUnit::MILLI: multiplier = 1000; break;
+                        case arrow::TimeUnit::MICRO: break;
+                        case arrow::TimeUnit::NANO: divisor = 1000; break;
                     }
-                    default:
-                        spdlog::warn("Unsupported column type for Excel export: {}", column->type()->ToString());
-                        break;
+                    // 换算为微秒会溢出 int64（秒约为 ±29 万年）的值写为 #NUM!
+                    const int64_t limit = std::numeric_limits<int64_t>::max() / multiplier;
+                    for (int64_t i = 0; i < n; ++i) {
+                        if (values.IsNull(offset + i)) {
+                            continue;
+                        }
+                        const int64_t value = values.Value(offset + i);
+                        Cell cell;
+                        cell.column = column;
+                        if (value > limit || value < -limit) {
+                            cell.type = Cell::Type::String;
+                            cell.text = "#NUM!";
+                            rows[i].push_back(cell);
+                            continue;
+                        }
+                        const int64_t micros = value * multiplier / divisor;
+                        if (const auto serial = dates.toSerial(micros)) {
+                            cell.type = Cell::Type::Date;
+                            cell.number = *serial;
+                        } else {
+                            cell.type = Cell::Type::String;
+                            cell.text = texts.emplace_back(formatLocalTimestamp(micros));
+                        }
+                        rows[i].push_back(cell);
+                    }
+                    break;
                 }
+                default:
+                    if (!cursor.warned) {
+                        spdlog::warn("Unsupported column type for Excel export: {}", type.ToString());
+                        cursor.warned = true;
+                    }
+                    break;
             }
+
+            cursor.offset += n;
+            rows += n;
+            count -= n;
+        }
+    }
+
+    bool DataFrame::toSaveExcel(const std::string &filePath, bool forceOverwrite) const {
+        // 路径为 UTF-8，MSVC 按 ANSI 代码页解释窄字符串路径
+        const std::filesystem::path path = std::filesystem::u8path(filePath);
+        if (!forceOverwrite && std::filesystem::exists(path)) {
+            spdlog::error("File already exists: {}", filePath);
+            return false;
+        }
+
+        if (!table_) {
+            spdlog::error("DataFrame is empty, nothing to save.");
+            return false;
+        }
+
+        const int64_t num_rows = table_->num_rows();
+        const int num_columns = table_->num_columns();
+        // 第一行是表头
+        if (num_rows + 1 > XlsxStreamWriter::MAX_ROWS || num_columns > static_cast<int>(XlsxStreamWriter::MAX_COLUMNS)) {
+            spdlog::error("DataFrame ({} rows, {} columns) exceeds the Excel sheet limit", num_rows, num_columns);
+            return false;
         }
 
         try {
-            wb.save(filePath);
-            spdlog::info("DataFrame successfully saved to: {}", filePath);
-            return true;
-        } catch (const xlnt::exception& e) {
+            XlsxStreamWriter writer(filePath, {static_cast<uint32_t>(num_rows + 1), static_cast<uint32_t>(num_columns)});
+
+            std::vector<XlsxStreamWriter::Cell> header;
+            for (int col = 0; col < num_columns; ++col) {
+                XlsxStreamWriter::Cell cell;
+                cell.column = static_cast<uint32_t>(col);
+                cell.type = XlsxStreamWriter::Cell::Type::String;
+                cell.text = table_->schema()->field(col)->name();
+                header.push_back(cell);
+            }
+            writer.writeRow(1, header);
+
+            std::vector<ExcelColumnCursor> cursors(num_columns);
+            for (int col = 0; col < num_columns; ++col) {
+                cursors[col].column = table_->column(col).get();
+            }
+            ExcelSerialConverter dates;
+            std::deque<std::string> texts;
+            std::vector<std::vector<XlsxStreamWriter::Cell>> rows(std::min(num_rows, EXCEL_BATCH_ROWS));
+            for (int64_t start = 0; start < num_rows; start += EXCEL_BATCH_ROWS) {
+                const int64_t count = std::min(EXCEL_BATCH_ROWS, num_rows - start);
+                for (int64_t i = 0; i < count; ++i) {
+                    rows[i].clear();
+                }
+                texts.clear();
+                for (int col = 0; col < num_columns; ++col) {
+                    appendExcelColumn(cursors[col], static_cast<uint32_t>(col), count, rows.data(), writer, dates,
+                                      texts);
+                }
+                for (int64_t i = 0; i < count; ++i) {
+                    writer.writeRow(static_cast<uint64_t>(start + i + 2), rows[i]);
+                }
+            }
+            writer.finish();
+        } catch (const std::exception& e) {
             spdlog::error("Failed to save Excel file: {}", e.what());
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
             return false;
         }
+
+        spdlog::info("DataFrame successfully saved to: {}", filePath);
+        return true;
+    }
+
+    static arrow::Result<arrow::Compression::type> arrowCompression(DataFrame::Compression compression, bool feather) {
+        arrow::Compression::type type;
+        switch (compression) {
+            case DataFrame::Compression::None:
+                return arrow::Compression::UNCOMPRESSED;
+            case DataFrame::Compression::Snappy:
+                if (feather) {
+                    return arrow::Status::Invalid("Feather only supports LZ4 and ZSTD compression");
+                }
+                type = arrow::Compression::SNAPPY;
+                break;
+            case DataFrame::Compression::LZ4:
+                type = feather ? arrow::Compression::LZ4_FRAME : arrow::Compression::LZ4;
+                break;
+            default:
+                type = arrow::Compression::ZSTD;
+                break;
+        }
+        if (!arrow::util::Codec::IsAvailable(type)) {
+            return arrow::Status::NotImplemented("Compression codec not available: ",
+                                                 arrow::util::Codec::GetCodecAsString(type));
+        }
+        return type;
+    }
+
+    // 需要从文件中读取的列：投影列加上只出现在过滤条件中的列
+    static arrow::Result<std::vector<int>> readColumnIndices(const arrow::Schema& schema,
+                                                             const DataFrame::ReadOptions& options) {
+        std::vector<int> indices;
+        if (options.columns.empty()) {
+            for (int i = 0; i < schema.num_fields(); ++i) {
+                indices.push_back(i);
+            }
+            return indices;
+        }
+        auto add = [&](const std::string& name) -> arrow::Status {
+            const int index = schema.GetFieldIndex(name);
+            if (index < 0) {
+                return arrow::Status::Invalid("Column not found: ", name);
+            }
+            if (std::find(indices.begin(), indices.end(), index) == indices.end()) {
+                indices.push_back(index);
+            }
+            return arrow::Status::OK();
+        };
+        for (const auto& name : options.columns) {
+            ARROW_RETURN_NOT_OK(add(name));
+        }
+        for (const auto& filter : options.filters) {
+            ARROW_RETURN_NOT_OK(add(filter.column));
+        }
+        return indices;
+    }
+
+    // 按条件过滤后去掉只用于过滤的列，并按 options.columns 的顺序排列
+    static arrow::Result<DataFrame> finishRead(std::shared_ptr<arrow::Table> table,
+                                               const DataFrame::ReadOptions& options) {
+        DataFrame frame(std::move(table));
+        if (!options.filters.empty()) {
+            // 所有条件合并为一个表达式，只过滤一次
+            std::vector<arrow::compute::Expression> predicates;
+            for (const auto& filter : options.filters) {
+                ARROW_ASSIGN_OR_RAISE(auto predicate,
+                                      comparisonPredicate(filter.column, filter.value, filter.comparison_operator));
+                predicates.push_back(std::move(predicate));
+            }
+            ARROW_ASSIGN_OR_RAISE(frame, frame.filter(arrow::compute::and_(predicates)));
+        }
+        if (options.columns.empty()) {
+            return frame;
+        }
+        std::vector<int> indices;
+        for (const auto& name : options.columns) {
+            indices.push_back(frame.schema()->GetFieldIndex(name));
+        }
+        ARROW_ASSIGN_OR_RAISE(auto projected, frame.table()->SelectColumns(indices));
+        return DataFrame(std::move(projected));
+    }
+
+    // 行组的 min/max 统计能否排除满足条件的行；没有统计信息或无法比较时保守地认为可能满足
+    static bool rowGroupMayMatch(const parquet::RowGroupMetaData& row_group, const parquet::SchemaDescriptor& schema,
+                                 const std::vector<ColumnFilter>& filters) {
+        for (const auto& filter : filters) {
+            if (!filter.value || !filter.value->is_valid) {
+                continue;
+            }
+            const int leaf = schema.ColumnIndex(filter.column);
+            if (leaf < 0) {
+                continue;
+            }
+            const auto chunk = row_group.ColumnChunk(leaf);
+            const auto statistics = chunk->is_stats_set() ? chunk->statistics() : nullptr;
+            if (!statistics || !statistics->HasMinMax()) {
+                continue;
+            }
+            std::shared_ptr<arrow::Scalar> min;
+            std::shared_ptr<arrow::Scalar> max;
+            if (!parquet::arrow::StatisticsAsScalars(*statistics, &min, &max).ok()) {
+                continue;
+            }
+            std::shared_ptr<arrow::Scalar> value = filter.value;
+            if (!value->type->Equals(*min->type)) {
+                auto cast = value->CastTo(min->type);
+                if (!cast.ok()) {
+                    continue;
+                }
+                value = std::move(cast).ValueOrDie();
+            }
+
+            // 比较失败时返回 true，不排除行组
+            auto holds = [](const char* function, const std::shared_ptr<arrow::Scalar>& lhs,
+                            const std::shared_ptr<arrow::Scalar>& rhs) {
+                auto result = arrow::compute::CallFunction(function, {lhs, rhs});
+                if (!result.ok()) {
+                    return true;
+                }
+                const auto& scalar = static_cast<const arrow::BooleanScalar&>(*result->scalar());
+                return !scalar.is_valid || scalar.value;
+            };
+
+            const std::string& op = filter.comparison_operator;
+            bool may_match = true;
+            if (op == "equal") {
+                may_match = holds("less_equal", min, value) && holds("greater_equal", max, value);
+            } else if (op == "not_equal") {
+                may_match = !(min->Equals(*max) && min->Equals(*value));
+            } else if (op == "less") {
+                may_match = holds("less", min, value);
+            } else if (op == "less_equal") {
+                may_match = holds("less_equal", min, value);
+            } else if (op == "greater") {
+                may_match = holds("greater", max, value);
+            } else if (op == "greater_equal") {
+                may_match = holds("greater_equal", max, value);
+            }
+            if (!may_match) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    arrow::Status DataFrame::toParquet(const std::string &filePath, const WriteOptions &options) const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        ARROW_ASSIGN_OR_RAISE(auto codec, arrowCompression(options.compression, false));
+        parquet::WriterProperties::Builder properties;
+        properties.compression(codec);
+        if (options.compression_level != 0) {
+            properties.compression_level(options.compression_level);
+        }
+        // 在元数据中保存 Arrow schema，读回时恢复时间戳单位和字典类型
+        auto arrow_properties = parquet::ArrowWriterProperties::Builder().store_schema()->build();
+
+        ARROW_ASSIGN_OR_RAISE(auto output, arrow::io::FileOutputStream::Open(filePath));
+        ARROW_RETURN_NOT_OK(parquet::arrow::WriteTable(*table_, arrow::default_memory_pool(), output,
+                                                       options.row_group_size, properties.build(), arrow_properties));
+        ARROW_RETURN_NOT_OK(output->Close());
+        spdlog::info("DataFrame successfully saved to: {}", filePath);
+        return arrow::Status::OK();
+    }
+
+    arrow::Result<DataFrame> DataFrame::fromParquet(const std::string &filePath, const ReadOptions &options) {
+        parquet::ArrowReaderProperties properties;
+        properties.set_use_threads(true);
+        parquet::arrow::FileReaderBuilder builder;
+        ARROW_RETURN_NOT_OK(builder.OpenFile(filePath, true));
+        builder.properties(properties);
+        std::unique_ptr<parquet::arrow::FileReader> reader;
+        ARROW_RETURN_NOT_OK(builder.Build(&reader));
+
+        std::shared_ptr<arrow::Schema> schema;
+        ARROW_RETURN_NOT_OK(reader->GetSchema(&schema));
+        ARROW_ASSIGN_OR_RAISE(auto columns, readColumnIndices(*schema, options));
+
+        const auto metadata = reader->parquet_reader()->metadata();
+        std::vector<int> row_groups;
+        for (int i = 0; i < metadata->num_row_groups(); ++i) {
+            if (rowGroupMayMatch(*metadata->RowGroup(i), *metadata->schema(), options.filters)) {
+                row_groups.push_back(i);
+            }
+        }
+        if (static_cast<int>(row_groups.size()) < metadata->num_row_groups()) {
+            spdlog::debug("Skipped {} of {} row groups in {}", metadata->num_row_groups() - row_groups.size(),
+                          metadata->num_row_groups(), filePath);
+        }
+
+        // 逐批解码、过滤和投影，超过内存预算后的批次直接写入溢出文件
+        ARROW_ASSIGN_OR_RAISE(auto batches, reader->GetRecordBatchReader(row_groups, columns));
+        SpillableTableBuilder table_builder;
+        std::shared_ptr<arrow::Schema> result_schema;
+        while (true) {
+            ARROW_ASSIGN_OR_RAISE(auto batch, batches->Next());
+            if (!batch) {
+                break;
+            }
+            ARROW_ASSIGN_OR_RAISE(auto table, arrow::Table::FromRecordBatches({std::move(batch)}));
+            ARROW_ASSIGN_OR_RAISE(auto part, finishRead(std::move(table), options));
+            result_schema = part.schema();
+            arrow::TableBatchReader part_reader(*part.table());
+            ARROW_ASSIGN_OR_RAISE(auto part_batches, part_reader.ToRecordBatches());
+            for (const auto& part_batch : part_batches) {
+                ARROW_RETURN_NOT_OK(table_builder.append(part_batch));
+            }
+        }
+        if (!result_schema) {
+            // 没有任何批次时由空表得到投影后的 schema
+            ARROW_ASSIGN_OR_RAISE(auto empty, arrow::Table::MakeEmpty(batches->schema()));
+            ARROW_ASSIGN_OR_RAISE(auto part, finishRead(std::move(empty), options));
+            result_schema = part.schema();
+        }
+        ARROW_ASSIGN_OR_RAISE(auto table, table_builder.finish(result_schema));
+        DataFrame frame(std::move(table));
+        frame.spilled_ = table_builder.spilled();
+        return frame;
+    }
+
+    arrow::Status DataFrame::toFeather(const std::string &filePath, const WriteOptions &options) const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        auto ipc_options = arrow::ipc::IpcWriteOptions::Defaults();
+        // IPC 文件格式要求每列只有一个字典，不同分块的字典在写入时合并
+        ipc_options.unify_dictionaries = true;
+        ARROW_ASSIGN_OR_RAISE(auto codec, arrowCompression(options.compression, true));
+        if (codec != arrow::Compression::UNCOMPRESSED) {
+            ARROW_ASSIGN_OR_RAISE(ipc_options.codec, arrow::util::Codec::Create(
+                codec, options.compression_level != 0 ? options.compression_level
+                                                      : arrow::util::kUseDefaultCompressionLevel));
+        }
+
+        ARROW_ASSIGN_OR_RAISE(auto output, arrow::io::FileOutputStream::Open(filePath));
+        ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(output, table_->schema(), ipc_options));
+        ARROW_RETURN_NOT_OK(writer->WriteTable(*table_, options.row_group_size));
+        ARROW_RETURN_NOT_OK(writer->Close());
+        ARROW_RETURN_NOT_OK(output->Close());
+        spdlog::info("DataFrame successfully saved to: {}", filePath);
+        return arrow::Status::OK();
+    }
+
+    arrow::Result<DataFrame> DataFrame::fromFeather(const std::string &filePath, const ReadOptions &options) {
+        ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::MemoryMappedFile::Open(filePath, arrow::io::FileMode::READ));
+        auto ipc_options = arrow::ipc::IpcReadOptions::Defaults();
+        ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(file, ipc_options));
+        if (!options.columns.empty()) {
+            // 投影需要列下标，先读出 schema 再按投影重新打开（只读取文件尾部的元数据）
+            ARROW_ASSIGN_OR_RAISE(ipc_options.included_fields, readColumnIndices(*reader->schema(), options));
+            std::sort(ipc_options.included_fields.begin(), ipc_options.included_fields.end());
+            ARROW_ASSIGN_OR_RAISE(reader, arrow::ipc::RecordBatchFileReader::Open(file, ipc_options));
+        }
+
+        std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+        batches.reserve(static_cast<size_t>(reader->num_record_batches()));
+        for (int i = 0; i < reader->num_record_batches(); ++i) {
+            ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+            batches.push_back(std::move(batch));
+        }
+        ARROW_ASSIGN_OR_RAISE(auto table, arrow::Table::FromRecordBatches(reader->schema(), batches));
+        return finishRead(std::move(table), options);
     }
 
     void DataFrame::appendBatch(std::shared_ptr<arrow::ArrayBuilder>& builder,
@@ -577,4 +2294,9 @@ namespace TinaToolBox {
     template arrow::Result<int64_t> DataFrame::getValue<int64_t>(int64_t row, const std::string &column) const;
     template arrow::Result<double> DataFrame::getValue<double>(int64_t row, const std::string &column) const;
     template arrow::Result<bool> DataFrame::getValue<bool>(int64_t row, const std::string &column) const;
+    template arrow::Result<ColumnAccessor<std::string>> DataFrame::columnAccessor<std::string>(const std::string &column) const;
+    template arrow::Result<ColumnAccessor<std::string_view>> DataFrame::columnAccessor<std::string_view>(const std::string &column) const;
+    template arrow::Result<ColumnAccessor<int64_t>> DataFrame::columnAccessor<int64_t>(const std::string &column) const;
+    template arrow::Result<ColumnAccessor<double>> DataFrame::columnAccessor<double>(const std::string &column) const;
+    template arrow::Result<ColumnAccessor<bool>> DataFrame::columnAccessor<bool>(const std::string &column) const;
 }
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include "DataFrameCache.hpp"
+
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/key_value_metadata.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+namespace TinaToolBox {
+    namespace {
+        // 缓存格式或 fromExcel 的类型规则变化时递增，旧缓存随之失效
+        constexpr const char *CACHE_VERSION = "1";
+        constexpr const char *KEY_METADATA = "ttb.cache.key";
+        constexpr const char *REPORT_METADATA = "ttb.cache.report";
+        constexpr const char *ENTRY_EXTENSION = ".arrow";
+        constexpr std::int64_t ENTRY_BATCH_ROWS = 64 * 1024;
+
+        constexpr std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+        // Arrow 的文件接口按 UTF-8 解释路径
+        std::string utf8Path(const std::filesystem::path &path) {
+#if defined(__cpp_lib_char8_t)
+            const auto text = path.u8string();
+            return std::string(text.begin(), text.end());
+#else
+            return path.u8string();
+#endif
+        }
+
+        // 各列的 values:coerced，以逗号分隔
+        std::string encodeReport(const std::vector<DataFrame::ColumnLoadReport> &report) {
+            std::ostringstream out;
+            for (size_t i = 0; i < report.size(); ++i) {
+                out << (i ? "," : "") << report[i].values << ':' << report[i].coerced;
+            }
+            return out.str();
+        }
+
+        std::vector<DataFrame::ColumnLoadReport> decodeReport(const std::string &text, const arrow::Schema &schema) {
+            std::vector<DataFrame::ColumnLoadReport> report;
+            std::istringstream in(text);
+            std::string item;
+            while (std::getline(in, item, ',')) {
+                const auto index = static_cast<int>(report.size());
+                if (index >= schema.num_fields()) {
+                    return {};
+                }
+                DataFrame::ColumnLoadReport column;
+                column.column = schema.field(index)->name();
+                column.type = schema.field(index)->type();
+                long long values = 0;
+                long long coerced = 0;
+                if (std::sscanf(item.c_str(), "%lld:%lld", &values, &coerced) != 2) {
+                    return {};
+                }
+                column.values = values;
+                column.coerced = coerced;
+                report.push_back(std::move(column));
+            }
+            return static_cast<int>(report.size()) == schema.num_fields() ? report : std::vector<DataFrame::ColumnLoadReport>{};
+        }
+    }
+
+    void DataFrameCache::setDirectory(const std::filesystem::path &directory) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        directory_.clear();
+        if (directory.empty()) {
+            return;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            spdlog::warn("Failed to create DataFrame cache directory {}: {}", utf8Path(directory), ec.message());
+            return;
+        }
+        directory_ = directory;
+    }
+
+    std::filesystem::path DataFrameCache::directory() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return directory_;
+    }
+
+    bool DataFrameCache::enabled() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !directory_.empty();
+    }
+
+    void DataFrameCache::setCapacity(std::uint64_t bytes) {
+        capacity_.store(bytes, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!directory_.empty()) {
+            evict({});
+        }
+    }
+
+    std::optional<DataFrameCache::Key> DataFrameCache::makeKey(const std::string &path, std::uint64_t content_hash) {
+        std::error_code ec;
+        // path 为 UTF-8，MSVC 按 ANSI 代码页解释窄字符串路径
+        const std::filesystem::path absolute =
+            std::filesystem::absolute(std::filesystem::u8path(path), ec).lexically_normal();
+        if (ec) {
+            return std::nullopt;
+        }
+        const auto size = std::filesystem::file_size(absolute, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        const auto mtime = std::filesystem::last_write_time(absolute, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        Key key;
+        key.path = utf8Path(absolute);
+        key.size = size;
+        key.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+        key.content_hash = content_hash;
+        return key;
+    }
+
+    std::string DataFrameCache::keyString(const Key &key) {
+        return std::string(CACHE_VERSION) + '|' + key.path + '|' + std::to_string(key.size) + '|' +
+               std::to_string(key.mtime) + '|' + std::to_string(key.content_hash);
+    }
+
+    std::filesystem::path DataFrameCache::entryPath(const Key &key) const {
+        const std::string text = keyString(key);
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash(text.data(), text.size())));
+        return directory_ / (std::string(name) + ENTRY_EXTENSION);
+    }
+
+    std::optional<DataFrame> DataFrameCache::lookup(const Key &key) {
+        std::filesystem::path path;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (directory_.empty()) {
+                return std::nullopt;
+            }
+            path = entryPath(key);
+        }
+
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) {
+            ++misses_;
+            return std::nullopt;
+        }
+
+        auto loaded = [&]() -> arrow::Result<DataFrame> {
+            ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::MemoryMappedFile::Open(utf8Path(path),
+                                                                               arrow::io::FileMode::READ));
+            ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(file));
+            const auto &metadata = reader->schema()->metadata();
+            // 文件名只是键的哈希，键本身保存在元数据中用来排除碰撞
+            if (!metadata || metadata->Get(KEY_METADATA).ValueOr("") != keyString(key)) {
+                return arrow::Status::Invalid("Cache key mismatch");
+            }
+
+            std::vector<std::shared_ptr<arrow::RecordBatch> > batches;
+            batches.reserve(static_cast<size_t>(reader->num_record_batches()));
+            for (int i = 0; i < reader->num_record_batches(); ++i) {
+                ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+                batches.push_back(std::move(batch));
+            }
+            const auto schema = reader->schema()->WithMetadata(nullptr);
+            ARROW_ASSIGN_OR_RAISE(auto table, arrow::Table::FromRecordBatches(schema, batches));
+            DataFrame frame(std::move(table));
+            frame.load_report_ = decodeReport(metadata->Get(REPORT_METADATA).ValueOr(""), *schema);
+            return frame;
+        }();
+
+        if (!loaded.ok()) {
+            ++misses_;
+            spdlog::warn("Discarding DataFrame cache entry {}: {}", utf8Path(path), loaded.status().ToString());
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::filesystem::remove(path, ec);
+            return std::nullopt;
+        }
+
+        // 刷新修改时间作为最近使用时间
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+        ++hits_;
+        return std::move(loaded).ValueOrDie();
+    }
+
+    void DataFrameCache::store(const Key &key, const DataFrame &frame) {
+        const auto table = frame.table();
+        if (!table) {
+            return;
+        }
+        std::filesystem::path target;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (directory_.empty()) {
+                return;
+            }
+            target = entryPath(key);
+        }
+        // 先写临时文件再改名，读取方不会看到写了一半的缓存
+        std::filesystem::path temp = target;
+        temp += ".tmp" + std::to_string(temp_counter_.fetch_add(1));
+
+        const auto status = [&]() -> arrow::Status {
+            auto metadata = std::make_shared<arrow::KeyValueMetadata>();
+            metadata->Append(KEY_METADATA, keyString(key));
+            if (static_cast<int>(frame.loadReport().size()) == table->num_columns()) {
+                metadata->Append(REPORT_METADATA, encodeReport(frame.loadReport()));
+            }
+            const auto tagged = table->ReplaceSchemaMetadata(metadata);
+
+            // 不压缩，命中时才能零拷贝映射
+            auto options = arrow::ipc::IpcWriteOptions::Defaults();
+            options.unify_dictionaries = true;
+            ARROW_ASSIGN_OR_RAISE(auto output, arrow::io::FileOutputStream::Open(utf8Path(temp)));
+            ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(output, tagged->schema(), options));
+            ARROW_RETURN_NOT_OK(writer->WriteTable(*tagged, ENTRY_BATCH_ROWS));
+            ARROW_RETURN_NOT_OK(writer->Close());
+            return output->Close();
+        }();
+
+        std::error_code ec;
+        if (!status.ok()) {
+            spdlog::warn("Failed to write DataFrame cache entry {}: {}", utf8Path(target), status.ToString());
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::filesystem::rename(temp, target, ec);
+        if (ec) {
+            spdlog::warn("Failed to write DataFrame cache entry {}: {}", utf8Path(target), ec.message());
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+        ++stores_;
+        evict(target);
+    }
+
+    void DataFrameCache::evict(const std::filesystem::path &keep) {
+        struct Entry {
+            std::filesystem::file_time_type used;
+            std::uint64_t size;
+            std::filesystem::path path;
+        };
+        std::vector<Entry> entries;
+        std::uint64_t total = 0;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() != ENTRY_EXTENSION) {
+                continue;
+            }
+            std::error_code entry_ec;
+            const auto size = it->file_size(entry_ec);
+            const auto used = it->last_write_time(entry_ec);
+            if (entry_ec) {
+                continue;
+            }
+            total += size;
+            entries.push_back({used, size, it->path()});
+        }
+
+        const std::uint64_t capacity = capacity_.load(std::memory_order_relaxed);
+        if (total <= capacity) {
+            return;
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used < b.used; });
+        for (const auto &entry: entries) {
+            if (total <= capacity) {
+                break;
+            }
+            if (entry.path == keep) {
+                continue;
+            }
+            // Windows 上仍被映射的文件无法删除，跳过
+            if (std::filesystem::remove(entry.path, ec)) {
+                total -= entry.size;
+                ++evictions_;
+            }
+        }
+    }
+
+    void DataFrameCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (directory_.empty()) {
+            return;
+        }
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() == ENTRY_EXTENSION) {
+                std::error_code remove_ec;
+                std::filesystem::remove(it->path(), remove_ec);
+            }
+        }
+    }
+
+    DataFrameCache::Stats DataFrameCache::stats() const {
+        Stats stats;
+        stats.hits = hits_.load();
+        stats.misses = misses_.load();
+        stats.stores = stores_.load();
+        stats.evictions = evictions_.load();
+        return stats;
+    }
+
+    std::uint64_t DataFrameCache::hash(const void *data, size_t size, std::uint64_t seed) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        std::uint64_t value = seed;
+        for (size_t i = 0; i < size; ++i) {
+            value = (value ^ bytes[i]) * FNV_PRIME;
+        }
+        return value;
+    }
+} // namespace TinaToolBox
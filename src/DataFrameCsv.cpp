@@ -0,0 +1,191 @@
+#include "DataFrame.hpp"
+#include "DataFrameSpill.hpp"
+#include "EncodingDetector.hpp"
+#include <arrow/csv/api.h>
+#include <arrow/io/file.h>
+#include <arrow/io/transform.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/util/value_parsing.h>
+#include <QByteArray>
+#include <QString>
+#include <QTextCodec>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace TinaToolBox {
+    namespace {
+        // 检测编码时读取的文件开头字节数
+        constexpr int64_t ENCODING_SAMPLE_BYTES = 64 * 1024;
+        // 转码输出时每次转换的最大字节数（QTextCodec 的长度参数为 int）
+        constexpr int64_t TRANSCODE_CHUNK_BYTES = 16 << 20;
+
+        bool isUtf8(const std::string &encoding) {
+            const QString name = QString::fromStdString(encoding);
+            return name.isEmpty() || name.compare("UTF-8", Qt::CaseInsensitive) == 0 ||
+                   name.compare("UTF8", Qt::CaseInsensitive) == 0 || name.compare("ASCII", Qt::CaseInsensitive) == 0;
+        }
+
+        arrow::Result<QTextCodec *> codecFor(const std::string &encoding) {
+            QTextCodec *codec = QTextCodec::codecForName(QByteArray::fromStdString(encoding));
+            if (!codec) {
+                return arrow::Status::Invalid("Unsupported CSV encoding: ", encoding);
+            }
+            return codec;
+        }
+
+        arrow::Result<std::string> detectEncoding(arrow::io::RandomAccessFile &file) {
+            ARROW_ASSIGN_OR_RAISE(const int64_t size, file.GetSize());
+            ARROW_ASSIGN_OR_RAISE(auto sample, file.ReadAt(0, std::min(size, ENCODING_SAMPLE_BYTES)));
+            const std::string_view bytes(reinterpret_cast<const char *>(sample->data()),
+                                         static_cast<size_t>(sample->size()));
+            // 样本截断在最后一个换行处，避免末尾半个多字节字符使 UTF-8 检查失败
+            size_t length = bytes.size();
+            if (sample->size() < size) {
+                const size_t newline = bytes.rfind('\n');
+                if (newline != std::string_view::npos && newline > 0) {
+                    length = newline + 1;
+                }
+            }
+            return EncodingDetector::detect(QByteArray(bytes.data(), static_cast<int>(length))).toStdString();
+        }
+
+        // 把 codec 编码的块转为 UTF-8；ConverterState 保留块末尾不完整的多字节字符，接到下一块开头
+        arrow::io::TransformInputStream::TransformFunc utf8Transcoder(QTextCodec *codec) {
+            auto state = std::make_shared<QTextCodec::ConverterState>();
+            return [codec, state](const std::shared_ptr<arrow::Buffer> &buffer)
+                -> arrow::Result<std::shared_ptr<arrow::Buffer>> {
+                const QString text = codec->toUnicode(reinterpret_cast<const char *>(buffer->data()),
+                                                      static_cast<int>(buffer->size()), state.get());
+                const QByteArray utf8 = text.toUtf8();
+                ARROW_ASSIGN_OR_RAISE(auto output, arrow::AllocateBuffer(utf8.size()));
+                std::memcpy(output->mutable_data(), utf8.constData(), static_cast<size_t>(utf8.size()));
+                return std::shared_ptr<arrow::Buffer>(std::move(output));
+            };
+        }
+
+        // 把写入的 UTF-8 字节流转为 codec 编码后写入 wrapped；两个 ConverterState 分别保留跨次写入的半个字符
+        class TranscodingOutputStream : public arrow::io::OutputStream {
+        public:
+            TranscodingOutputStream(std::shared_ptr<arrow::io::OutputStream> wrapped, QTextCodec *codec)
+                : wrapped_(std::move(wrapped)), codec_(codec), utf8_(QTextCodec::codecForName("UTF-8")) {}
+
+            using arrow::io::OutputStream::Write;
+
+            arrow::Status Write(const void *data, int64_t nbytes) override {
+                const auto *bytes = static_cast<const char *>(data);
+                for (int64_t offset = 0; offset < nbytes; offset += TRANSCODE_CHUNK_BYTES) {
+                    const auto length = static_cast<int>(std::min(TRANSCODE_CHUNK_BYTES, nbytes - offset));
+                    const QString text = utf8_->toUnicode(bytes + offset, length, &decode_state_);
+                    const QByteArray encoded = codec_->fromUnicode(text.constData(), static_cast<int>(text.size()),
+                                                                   &encode_state_);
+                    ARROW_RETURN_NOT_OK(wrapped_->Write(encoded.constData(), encoded.size()));
+                }
+                position_ += nbytes;
+                return arrow::Status::OK();
+            }
+
+            arrow::Status Flush() override { return wrapped_->Flush(); }
+
+            arrow::Status Close() override {
+                closed_ = true;
+                return wrapped_->Close();
+            }
+
+            [[nodiscard]] bool closed() const override { return closed_; }
+
+            [[nodiscard]] arrow::Result<int64_t> Tell() const override { return position_; }
+
+        private:
+            std::shared_ptr<arrow::io::OutputStream> wrapped_;
+            QTextCodec *codec_;
+            QTextCodec *utf8_;
+            QTextCodec::ConverterState decode_state_;
+            QTextCodec::ConverterState encode_state_;
+            int64_t position_ = 0;
+            bool closed_ = false;
+        };
+    }
+
+    arrow::Result<DataFrame> DataFrame::fromCsv(const std::string &filePath, const CsvReadOptions &options) {
+        ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::ReadableFile::Open(filePath));
+        std::string encoding = options.encoding;
+        if (encoding.empty()) {
+            ARROW_ASSIGN_OR_RAISE(encoding, detectEncoding(*file));
+            spdlog::debug("Detected encoding {} for {}", encoding, filePath);
+            // ReadAt 之后需要重新定位，才能按顺序读取
+            ARROW_RETURN_NOT_OK(file->Seek(0));
+        }
+        std::shared_ptr<arrow::io::InputStream> input = file;
+        if (!isUtf8(encoding)) {
+            ARROW_ASSIGN_OR_RAISE(auto codec, codecFor(encoding));
+            input = std::make_shared<arrow::io::TransformInputStream>(std::move(input), utf8Transcoder(codec));
+        }
+
+        // 各块由 Arrow 的 CPU 线程池并行解析和转换类型；允许引号内换行（Excel 导出的多行单元格）
+        auto read_options = arrow::csv::ReadOptions::Defaults();
+        read_options.use_threads = true;
+        read_options.block_size = options.block_size;
+        read_options.autogenerate_column_names = !options.has_header;
+        auto parse_options = arrow::csv::ParseOptions::Defaults();
+        parse_options.delimiter = options.delimiter;
+        parse_options.newlines_in_values = true;
+        auto convert_options = arrow::csv::ConvertOptions::Defaults();
+        convert_options.column_types.insert(options.column_types.begin(), options.column_types.end());
+        convert_options.include_columns = options.columns;
+        convert_options.strings_can_be_null = true;
+        convert_options.timestamp_parsers = {
+            arrow::TimestampParser::MakeISO8601(),
+            arrow::TimestampParser::MakeStrptime("%Y/%m/%d %H:%M:%S"),
+            arrow::TimestampParser::MakeStrptime("%Y/%m/%d"),
+        };
+
+        // 逐批读取（列类型按第一块推断，与整表读取相同），超过内存预算后的批次直接写入溢出文件
+        ARROW_ASSIGN_OR_RAISE(auto reader, arrow::csv::StreamingReader::Make(arrow::io::default_io_context(), input,
+                                                                             read_options, parse_options,
+                                                                             convert_options));
+        SpillableTableBuilder builder;
+        while (true) {
+            ARROW_ASSIGN_OR_RAISE(auto batch, reader->Next());
+            if (!batch) {
+                break;
+            }
+            ARROW_RETURN_NOT_OK(builder.append(batch));
+        }
+        ARROW_ASSIGN_OR_RAISE(auto table, builder.finish(reader->schema()));
+        spdlog::info("Loaded {} rows from {} ({})", table->num_rows(), filePath, encoding);
+        DataFrame frame(std::move(table));
+        frame.spilled_ = builder.spilled();
+        return frame;
+    }
+
+    arrow::Status DataFrame::toCsv(const std::string &filePath, const CsvWriteOptions &options) const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        QTextCodec *codec = nullptr;
+        if (!isUtf8(options.encoding)) {
+            ARROW_ASSIGN_OR_RAISE(codec, codecFor(options.encoding));
+        }
+
+        ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::OutputStream> output,
+                              arrow::io::FileOutputStream::Open(filePath));
+        if (codec) {
+            output = std::make_shared<TranscodingOutputStream>(std::move(output), codec);
+        } else if (options.utf8_bom) {
+            ARROW_RETURN_NOT_OK(output->Write("\xEF\xBB\xBF", 3));
+        }
+
+        auto write_options = arrow::csv::WriteOptions::Defaults();
+        write_options.include_header = options.include_header;
+        write_options.delimiter = options.delimiter;
+        write_options.batch_size = options.batch_rows;
+        ARROW_ASSIGN_OR_RAISE(auto writer, arrow::csv::MakeCSVWriter(output, table_->schema(), write_options));
+        ARROW_RETURN_NOT_OK(writer->WriteTable(*table_, options.batch_rows));
+        ARROW_RETURN_NOT_OK(writer->Close());
+        ARROW_RETURN_NOT_OK(output->Close());
+        spdlog::info("DataFrame successfully saved to: {}", filePath);
+        return arrow::Status::OK();
+    }
+} // namespace TinaToolBox
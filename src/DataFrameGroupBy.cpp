@@ -0,0 +1,587 @@
+#include "DataFrameGroupBy.hpp"
+#include "ColumnHash.hpp"
+#include "DataFrameSpill.hpp"
+
+#include <arrow/util/byte_size.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+
+namespace TinaToolBox {
+    namespace {
+        using namespace ColumnHash;
+
+        // 计算哈希时每个任务处理的行数
+        constexpr size_t HASH_BLOCK_ROWS = 64 * 1024;
+        constexpr size_t MAX_PARTITIONS = 256;
+        // 落盘分区用哈希再混合一次后的高位，与分区内聚合使用的高位和槽位低位无关
+        constexpr std::uint64_t SPILL_PARTITION_SALT = 0xD6E8FEB86659FD93ULL;
+
+        struct AggregatePlan {
+            AggregateFunction function = AggregateFunction::Count;
+            std::string name;
+            // Count 统计行数时为空
+            std::shared_ptr<arrow::Array> values;
+            // CountDistinct 的值比较
+            std::unique_ptr<HashColumn> distinct;
+            // Sum 是否按浮点累加
+            bool floating = false;
+        };
+
+        // 一个分区中一个聚合的中间结果，下标为分区内的组号
+        struct AggregateState {
+            // Count / CountDistinct 的个数、整数 Sum 的和、Min / Max 所在的行号（-1 表示没有）
+            std::vector<int64_t> values;
+            // 浮点 Sum 和 Mean 的和
+            std::vector<double> sums;
+            // Sum / Mean 的非空值个数
+            std::vector<int64_t> counts;
+        };
+
+        struct Partition {
+            std::vector<int64_t> first_rows;
+            std::vector<AggregateState> states;
+        };
+
+        template<typename T>
+        constexpr bool isNumber = std::is_arithmetic_v<T>;
+
+        void updateSum(const AggregatePlan &plan, const int64_t *rows, const std::uint32_t *groups, size_t count,
+                       AggregateState &state) {
+            visitArray(*plan.values, [&](const auto &array) {
+                using Value = ValueType<std::decay_t<decltype(array)>>;
+                if constexpr (isNumber<Value>) {
+                    const bool floating = plan.floating || plan.function == AggregateFunction::Mean;
+                    for (size_t i = 0; i < count; ++i) {
+                        if (array.IsNull(rows[i])) {
+                            continue;
+                        }
+                        const auto value = array.GetView(rows[i]);
+                        if (floating) {
+                            state.sums[groups[i]] += static_cast<double>(value);
+                        } else {
+                            // 按无符号数相加，溢出时回绕而不是未定义行为
+                            state.values[groups[i]] = static_cast<int64_t>(
+                                static_cast<std::uint64_t>(state.values[groups[i]]) + static_cast<std::uint64_t>(value));
+                        }
+                        ++state.counts[groups[i]];
+                    }
+                }
+            });
+        }
+
+        // 比较 row 与当前极值所在的行，less 为 true 时保留更小的值
+        template<typename GetValue>
+        void updateExtreme(bool minimum, const int64_t *rows, const std::uint32_t *groups, size_t count,
+                           const arrow::Array &array, GetValue &&get, AggregateState &state) {
+            for (size_t i = 0; i < count; ++i) {
+                const int64_t row = rows[i];
+                if (array.IsNull(row)) {
+                    continue;
+                }
+                const auto value = get(row);
+                if constexpr (std::is_floating_point_v<decltype(value)>) {
+                    if (std::isnan(value)) {
+                        continue;
+                    }
+                }
+                int64_t &best = state.values[groups[i]];
+                if (best < 0 || (minimum ? value < get(best) : get(best) < value)) {
+                    best = row;
+                }
+            }
+        }
+
+        void updateMinMax(const AggregatePlan &plan, const int64_t *rows, const std::uint32_t *groups, size_t count,
+                          AggregateState &state) {
+            const bool minimum = plan.function == AggregateFunction::Min;
+            if (plan.values->type_id() == arrow::Type::DICTIONARY) {
+                const auto &array = static_cast<const arrow::DictionaryArray &>(*plan.values);
+                const auto &dictionary = static_cast<const arrow::StringArray &>(*array.dictionary());
+                updateExtreme(minimum, rows, groups, count, array,
+                              [&](int64_t row) { return dictionary.GetView(array.GetValueIndex(row)); }, state);
+                return;
+            }
+            visitArray(*plan.values, [&](const auto &array) {
+                updateExtreme(minimum, rows, groups, count, array, [&](int64_t row) { return array.GetView(row); },
+                              state);
+            });
+        }
+
+        // 分区内按 (组号, 值) 去重；分组键已经决定了分区，同一组的值都在同一个分区中
+        void updateCountDistinct(const AggregatePlan &plan, const int64_t *rows, const std::uint32_t *groups,
+                                 size_t count, AggregateState &state) {
+            HashTable seen(std::min<size_t>(count, 1024));
+            std::vector<std::pair<std::uint32_t, int64_t>> entries;
+            for (size_t i = 0; i < count; ++i) {
+                const int64_t row = rows[i];
+                if (plan.distinct->isNull(row)) {
+                    continue;
+                }
+                const std::uint32_t group = groups[i];
+                const std::uint64_t hash = combine(mix(group), plan.distinct->hash(row));
+                const auto [id, inserted] = seen.findOrInsert(hash, [&](std::uint32_t existing) {
+                    return entries[existing].first == group && plan.distinct->equal(entries[existing].second, row);
+                });
+                if (inserted) {
+                    entries.emplace_back(group, row);
+                    ++state.values[group];
+                }
+            }
+        }
+
+        void aggregatePartition(const std::vector<std::unique_ptr<HashColumn>> &keys, const std::uint64_t *hashes,
+                                const int64_t *rows, size_t count, const std::vector<AggregatePlan> &plans,
+                                Partition &partition) {
+            HashTable table(std::min<size_t>(count, 4096));
+            std::vector<std::uint32_t> groups(count);
+            for (size_t i = 0; i < count; ++i) {
+                const int64_t row = rows[i];
+                const auto [group, inserted] = table.findOrInsert(hashes[row], [&](std::uint32_t existing) {
+                    const int64_t first = partition.first_rows[existing];
+                    return std::all_of(keys.begin(), keys.end(),
+                                       [&](const auto &key) { return key->equal(first, row); });
+                });
+                if (inserted) {
+                    partition.first_rows.push_back(row);
+                }
+                groups[i] = group;
+            }
+
+            const size_t group_count = table.size();
+            partition.states.resize(plans.size());
+            for (size_t p = 0; p < plans.size(); ++p) {
+                const auto &plan = plans[p];
+                auto &state = partition.states[p];
+                switch (plan.function) {
+                    case AggregateFunction::Count:
+                        state.values.assign(group_count, 0);
+                        for (size_t i = 0; i < count; ++i) {
+                            if (!plan.values || !plan.values->IsNull(rows[i])) {
+                                ++state.values[groups[i]];
+                            }
+                        }
+                        break;
+                    case AggregateFunction::Sum:
+                    case AggregateFunction::Mean:
+                        state.values.assign(group_count, 0);
+                        state.sums.assign(group_count, 0.0);
+                        state.counts.assign(group_count, 0);
+                        updateSum(plan, rows, groups.data(), count, state);
+                        break;
+                    case AggregateFunction::Min:
+                    case AggregateFunction::Max:
+                        state.values.assign(group_count, -1);
+                        updateMinMax(plan, rows, groups.data(), count, state);
+                        break;
+                    case AggregateFunction::CountDistinct:
+                        state.values.assign(group_count, 0);
+                        updateCountDistinct(plan, rows, groups.data(), count, state);
+                        break;
+                }
+            }
+        }
+
+        std::string functionName(AggregateFunction function) {
+            switch (function) {
+                case AggregateFunction::Sum: return "sum";
+                case AggregateFunction::Mean: return "mean";
+                case AggregateFunction::Count: return "count";
+                case AggregateFunction::Min: return "min";
+                case AggregateFunction::Max: return "max";
+                case AggregateFunction::CountDistinct: return "count_distinct";
+            }
+            return "unknown";
+        }
+
+        arrow::Result<AggregatePlan> makePlan(const arrow::Table &table, const Aggregation &aggregation) {
+            AggregatePlan plan;
+            plan.function = aggregation.function;
+            plan.name = aggregation.name.empty()
+                            ? functionName(aggregation.function) + "(" +
+                              (aggregation.column.empty() ? "*" : aggregation.column) + ")"
+                            : aggregation.name;
+            if (aggregation.column.empty()) {
+                if (aggregation.function != AggregateFunction::Count) {
+                    return arrow::Status::Invalid(plan.name, " requires a column");
+                }
+                return plan;
+            }
+            auto column = table.GetColumnByName(aggregation.column);
+            if (!column) {
+                return arrow::Status::Invalid("Column not found: ", aggregation.column);
+            }
+            ARROW_ASSIGN_OR_RAISE(plan.values, contiguous(column));
+
+            const auto &type = *plan.values->type();
+            const auto unsupported = [&] {
+                return arrow::Status::TypeError(plan.name, " does not support ", type.ToString());
+            };
+            switch (aggregation.function) {
+                case AggregateFunction::Count:
+                    break;
+                case AggregateFunction::Sum:
+                case AggregateFunction::Mean:
+                    if (!arrow::is_integer(type.id()) && !arrow::is_floating(type.id()) &&
+                        type.id() != arrow::Type::BOOL) {
+                        return unsupported();
+                    }
+                    plan.floating = arrow::is_floating(type.id());
+                    break;
+                case AggregateFunction::Min:
+                case AggregateFunction::Max:
+                    if (type.id() == arrow::Type::DICTIONARY) {
+                        if (static_cast<const arrow::DictionaryType &>(type).value_type()->id() != arrow::Type::STRING) {
+                            return unsupported();
+                        }
+                    } else if (!visitArray(*plan.values, [](const auto &) {})) {
+                        return unsupported();
+                    }
+                    break;
+                case AggregateFunction::CountDistinct:
+                    plan.distinct = makeHashColumn(*plan.values);
+                    if (!plan.distinct) {
+                        return unsupported();
+                    }
+                    break;
+            }
+            return plan;
+        }
+
+        std::shared_ptr<arrow::Array> int64Array(std::vector<int64_t> values) {
+            const auto length = static_cast<int64_t>(values.size());
+            return std::make_shared<arrow::Int64Array>(length, arrow::Buffer::FromVector(std::move(values)));
+        }
+
+        // 结果中的字典列复制到内存，不让结果为了字典一直占用整个分区临时文件
+        arrow::Result<std::shared_ptr<arrow::Table>> detachDictionaries(std::shared_ptr<arrow::Table> table) {
+            for (int i = 0; i < table->num_columns(); ++i) {
+                const auto &column = table->column(i);
+                if (column->type()->id() != arrow::Type::DICTIONARY) {
+                    continue;
+                }
+                arrow::ArrayVector chunks;
+                for (const auto &chunk : column->chunks()) {
+                    const auto &encoded = static_cast<const arrow::DictionaryArray &>(*chunk);
+                    ARROW_ASSIGN_OR_RAISE(auto dictionary,
+                                          encoded.dictionary()->CopyTo(arrow::default_cpu_memory_manager()));
+                    ARROW_ASSIGN_OR_RAISE(auto copied, arrow::DictionaryArray::FromArrays(
+                                              column->type(), encoded.indices(), std::move(dictionary)));
+                    chunks.push_back(std::move(copied));
+                }
+                ARROW_ASSIGN_OR_RAISE(table, table->SetColumn(i, table->field(i),
+                                                              std::make_shared<arrow::ChunkedArray>(
+                                                                  std::move(chunks), column->type())));
+            }
+            return table;
+        }
+    }
+
+    GroupBy::GroupBy(DataFrame frame, std::vector<std::string> keys)
+        : frame_(std::move(frame)), keys_(std::move(keys)) {}
+
+    GroupBy DataFrame::groupBy(std::vector<std::string> keys) const {
+        return GroupBy(*this, std::move(keys));
+    }
+
+    arrow::Result<DataFrame> GroupBy::agg(const std::vector<Aggregation> &aggregations) const {
+        const auto table = frame_.table();
+        if (!table) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        if (keys_.empty() || DataFrame::memoryBudget() == 0) {
+            return aggregate(aggregations);
+        }
+        std::vector<std::string> names = keys_;
+        for (const auto &aggregation : aggregations) {
+            if (!aggregation.column.empty() &&
+                std::find(names.begin(), names.end(), aggregation.column) == names.end()) {
+                names.push_back(aggregation.column);
+            }
+        }
+        std::vector<int> indices;
+        for (const auto &name : names) {
+            const int index = table->schema()->GetFieldIndex(name);
+            if (index < 0) {
+                return arrow::Status::Invalid("Column not found: ", name);
+            }
+            indices.push_back(index);
+        }
+        ARROW_ASSIGN_OR_RAISE(auto columns, table->SelectColumns(indices));
+        if (DataFrame::exceedsMemoryBudget(arrow::util::TotalBufferSize(*columns))) {
+            return aggregatePartitioned(aggregations, std::move(columns));
+        }
+        return aggregate(aggregations);
+    }
+
+    arrow::Result<DataFrame> GroupBy::aggregate(const std::vector<Aggregation> &aggregations) const {
+        const auto table = frame_.table();
+
+        std::vector<std::shared_ptr<arrow::Array>> key_arrays;
+        std::vector<std::unique_ptr<HashColumn>> keys;
+        for (const auto &name : keys_) {
+            auto column = table->GetColumnByName(name);
+            if (!column) {
+                return arrow::Status::Invalid("Column not found: ", name);
+            }
+            ARROW_ASSIGN_OR_RAISE(auto array, contiguous(column));
+            auto key = makeHashColumn(*array);
+            if (!key) {
+                return arrow::Status::TypeError("Cannot group by ", name, " of type ", array->type()->ToString());
+            }
+            key_arrays.push_back(std::move(array));
+            keys.push_back(std::move(key));
+        }
+        std::vector<AggregatePlan> plans;
+        for (const auto &aggregation : aggregations) {
+            ARROW_ASSIGN_OR_RAISE(auto plan, makePlan(*table, aggregation));
+            plans.push_back(std::move(plan));
+        }
+
+        ThreadPool &pool = DataFrame::getThreadPool();
+        const auto num_rows = static_cast<size_t>(table->num_rows());
+
+        std::vector<std::uint64_t> hashes(num_rows, SEED);
+        pool.parallel_for(0, num_rows, HASH_BLOCK_ROWS, [&](size_t begin, size_t end) {
+            for (const auto &key : keys) {
+                key->hash(static_cast<int64_t>(begin), static_cast<int64_t>(end), hashes.data() + begin);
+            }
+        });
+
+        // 按哈希的高位分区，分区内保持原有行序，各组在分区内按第一次出现的顺序编号
+        size_t partition_count = 1;
+        if (static_cast<int64_t>(num_rows) > PARALLEL_ROWS && pool.threadCount() > 1) {
+            while (partition_count < std::min<size_t>(pool.threadCount() * 4, MAX_PARTITIONS)) {
+                partition_count <<= 1;
+            }
+        }
+        int partition_bits = 0;
+        while ((size_t{1} << partition_bits) < partition_count) {
+            ++partition_bits;
+        }
+        const auto partitionOf = [&](size_t row) -> size_t {
+            return partition_bits == 0 ? 0 : static_cast<size_t>(hashes[row] >> (64 - partition_bits));
+        };
+
+        std::vector<int64_t> rows(num_rows);
+        std::vector<size_t> partition_offsets(partition_count + 1, 0);
+        if (partition_count == 1) {
+            for (size_t row = 0; row < num_rows; ++row) {
+                rows[row] = static_cast<int64_t>(row);
+            }
+            partition_offsets[1] = num_rows;
+        } else {
+            // 各块先统计每个分区的行数，再按块号和分区前缀和并行写入，结果与顺序写入相同
+            const size_t block_count = pool.threadCount() * 4;
+            const size_t block_rows = (num_rows + block_count - 1) / block_count;
+            std::vector<std::vector<size_t>> histograms(block_count, std::vector<size_t>(partition_count, 0));
+            pool.parallel_for(0, block_count, 1, [&](size_t block) {
+                const size_t end = std::min(num_rows, (block + 1) * block_rows);
+                for (size_t row = block * block_rows; row < end; ++row) {
+                    ++histograms[block][partitionOf(row)];
+                }
+            });
+            std::vector<std::vector<size_t>> cursors(block_count, std::vector<size_t>(partition_count, 0));
+            size_t offset = 0;
+            for (size_t partition = 0; partition < partition_count; ++partition) {
+                partition_offsets[partition] = offset;
+                for (size_t block = 0; block < block_count; ++block) {
+                    cursors[block][partition] = offset;
+                    offset += histograms[block][partition];
+                }
+            }
+            partition_offsets[partition_count] = offset;
+            pool.parallel_for(0, block_count, 1, [&](size_t block) {
+                auto &cursor = cursors[block];
+                const size_t end = std::min(num_rows, (block + 1) * block_rows);
+                for (size_t row = block * block_rows; row < end; ++row) {
+                    rows[cursor[partitionOf(row)]++] = static_cast<int64_t>(row);
+                }
+            });
+        }
+
+        std::vector<Partition> partitions(partition_count);
+        pool.parallel_for(0, partition_count, 1, [&](size_t partition) {
+            const size_t begin = partition_offsets[partition];
+            aggregatePartition(keys, hashes.data(), rows.data() + begin, partition_offsets[partition + 1] - begin,
+                               plans, partitions[partition]);
+        });
+
+        // 所有分区的组按第一次出现的行排序
+        std::vector<std::tuple<int64_t, std::uint32_t, std::uint32_t>> order;
+        for (size_t partition = 0; partition < partition_count; ++partition) {
+            const auto &first_rows = partitions[partition].first_rows;
+            for (size_t group = 0; group < first_rows.size(); ++group) {
+                order.emplace_back(first_rows[group], static_cast<std::uint32_t>(partition),
+                                   static_cast<std::uint32_t>(group));
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        arrow::FieldVector fields;
+        std::vector<std::shared_ptr<arrow::Array>> columns;
+        std::vector<int64_t> first_rows;
+        first_rows.reserve(order.size());
+        for (const auto &[row, partition, group] : order) {
+            first_rows.push_back(row);
+        }
+        const auto first_row_array = int64Array(std::move(first_rows));
+        for (size_t k = 0; k < keys_.size(); ++k) {
+            ARROW_ASSIGN_OR_RAISE(auto key_column, arrow::compute::Take(*key_arrays[k], *first_row_array));
+            fields.push_back(arrow::field(keys_[k], key_column->type()));
+            columns.push_back(std::move(key_column));
+        }
+
+        for (size_t p = 0; p < plans.size(); ++p) {
+            const auto &plan = plans[p];
+            std::shared_ptr<arrow::Array> column;
+            switch (plan.function) {
+                case AggregateFunction::Count:
+                case AggregateFunction::CountDistinct: {
+                    std::vector<int64_t> values;
+                    values.reserve(order.size());
+                    for (const auto &[row, partition, group] : order) {
+                        values.push_back(partitions[partition].states[p].values[group]);
+                    }
+                    column = int64Array(std::move(values));
+                    break;
+                }
+                case AggregateFunction::Sum:
+                case AggregateFunction::Mean: {
+                    const bool floating = plan.floating || plan.function == AggregateFunction::Mean;
+                    arrow::DoubleBuilder doubles;
+                    arrow::Int64Builder integers;
+                    ARROW_RETURN_NOT_OK(floating ? doubles.Reserve(order.size()) : integers.Reserve(order.size()));
+                    for (const auto &[row, partition, group] : order) {
+                        const auto &state = partitions[partition].states[p];
+                        const int64_t count = state.counts[group];
+                        if (count == 0) {
+                            floating ? doubles.UnsafeAppendNull() : integers.UnsafeAppendNull();
+                        } else if (plan.function == AggregateFunction::Mean) {
+                            doubles.UnsafeAppend(state.sums[group] / static_cast<double>(count));
+                        } else if (floating) {
+                            doubles.UnsafeAppend(state.sums[group]);
+                        } else {
+                            integers.UnsafeAppend(state.values[group]);
+                        }
+                    }
+                    ARROW_ASSIGN_OR_RAISE(column, floating ? doubles.Finish() : integers.Finish());
+                    break;
+                }
+                case AggregateFunction::Min:
+                case AggregateFunction::Max: {
+                    // 取出极值所在的行，结果类型与输入列完全相同
+                    arrow::Int64Builder indices;
+                    ARROW_RETURN_NOT_OK(indices.Reserve(order.size()));
+                    for (const auto &[row, partition, group] : order) {
+                        const int64_t best = partitions[partition].states[p].values[group];
+                        best < 0 ? indices.UnsafeAppendNull() : indices.UnsafeAppend(best);
+                    }
+                    ARROW_ASSIGN_OR_RAISE(auto index_array, indices.Finish());
+                    ARROW_ASSIGN_OR_RAISE(column, arrow::compute::Take(*plan.values, *index_array));
+                    break;
+                }
+            }
+            fields.push_back(arrow::field(plan.name, column->type()));
+            columns.push_back(std::move(column));
+        }
+
+        return DataFrame(arrow::Table::Make(arrow::schema(std::move(fields)), std::move(columns),
+                                            static_cast<int64_t>(order.size())));
+    }
+
+    arrow::Result<DataFrame> GroupBy::aggregatePartitioned(const std::vector<Aggregation> &aggregations,
+                                                           std::shared_ptr<arrow::Table> columns) const {
+        // 分区文件分批写入，各批次的字典必须相同；统一后字典列的编码也可以直接哈希
+        ARROW_ASSIGN_OR_RAISE(columns, SpillFile::unifyDictionaries(std::move(columns)));
+        const int64_t bytes = arrow::util::TotalBufferSize(*columns);
+        const int64_t partition_bytes = std::max<int64_t>(1, DataFrame::memoryBudget() / 2);
+        int partition_bits = 1;
+        while ((size_t{1} << partition_bits) < MAX_PARTITIONS &&
+               (int64_t{1} << partition_bits) * partition_bytes < bytes) {
+            ++partition_bits;
+        }
+        const size_t partition_count = size_t{1} << partition_bits;
+
+        // 逐批计算键的哈希，每行连同原来的行号写入所在分区的临时文件
+        std::vector<std::unique_ptr<SpillFile>> files;
+        for (size_t partition = 0; partition < partition_count; ++partition) {
+            files.push_back(std::make_unique<SpillFile>());
+        }
+        const int row_column = columns->num_columns();
+        const auto row_field = arrow::field(SpillFile::ROW_COLUMN, arrow::int64());
+        arrow::TableBatchReader batches(*columns);
+        batches.set_chunksize(DataFrame::SPILL_BATCH_ROWS);
+        std::vector<std::uint64_t> hashes;
+        std::vector<std::vector<int64_t>> selections(partition_count);
+        int64_t offset = 0;
+        for (;;) {
+            std::shared_ptr<arrow::RecordBatch> batch;
+            ARROW_RETURN_NOT_OK(batches.ReadNext(&batch));
+            if (!batch) {
+                break;
+            }
+            const int64_t length = batch->num_rows();
+            hashes.assign(static_cast<size_t>(length), SEED);
+            for (const auto &name : keys_) {
+                const auto &array = batch->GetColumnByName(name);
+                const auto key = makeHashColumn(*array);
+                if (!key) {
+                    return arrow::Status::TypeError("Cannot group by ", name, " of type ", array->type()->ToString());
+                }
+                key->hash(0, length, hashes.data());
+            }
+            for (auto &selection : selections) {
+                selection.clear();
+            }
+            for (int64_t row = 0; row < length; ++row) {
+                selections[mix(hashes[row] ^ SPILL_PARTITION_SALT) >> (64 - partition_bits)].push_back(row);
+            }
+
+            std::vector<int64_t> rows(static_cast<size_t>(length));
+            std::iota(rows.begin(), rows.end(), offset);
+            ARROW_ASSIGN_OR_RAISE(auto numbered, batch->AddColumn(row_column, row_field, int64Array(std::move(rows))));
+            for (size_t partition = 0; partition < partition_count; ++partition) {
+                if (selections[partition].empty()) {
+                    continue;
+                }
+                ARROW_ASSIGN_OR_RAISE(auto taken, arrow::compute::Take(numbered, int64Array(selections[partition])));
+                ARROW_RETURN_NOT_OK(files[partition]->write(*taken.record_batch()));
+            }
+            offset += length;
+        }
+
+        // 同一组的行都在同一个分区，各分区独立聚合；各组第一次出现的行号用来恢复整体顺序
+        auto numbered_aggregations = aggregations;
+        numbered_aggregations.push_back(Aggregation{AggregateFunction::Min, SpillFile::ROW_COLUMN,
+                                                    SpillFile::ROW_COLUMN});
+        std::vector<std::shared_ptr<arrow::Table>> results;
+        for (auto &file : files) {
+            ARROW_RETURN_NOT_OK(file->close());
+            ARROW_ASSIGN_OR_RAISE(auto partition, file->read());
+            if (!partition) {
+                continue;
+            }
+            ARROW_ASSIGN_OR_RAISE(auto result,
+                                  GroupBy(DataFrame(std::move(partition)), keys_).aggregate(numbered_aggregations));
+            results.push_back(result.table());
+        }
+        spdlog::debug("Partitioned group-by of {} rows into {} spill files", columns->num_rows(), partition_count);
+        if (results.empty()) {
+            return aggregate(aggregations);
+        }
+
+        ARROW_ASSIGN_OR_RAISE(auto combined, arrow::ConcatenateTables(results));
+        const DataFrame merged(combined);
+        ARROW_ASSIGN_OR_RAISE(auto order, merged.sortedRowIndices({DataFrame::SortKey{SpillFile::ROW_COLUMN}}, -1));
+        ARROW_ASSIGN_OR_RAISE(auto ordered, arrow::compute::Take(combined, order));
+        ARROW_ASSIGN_OR_RAISE(auto output, ordered.table()->RemoveColumn(ordered.table()->num_columns() - 1));
+        ARROW_ASSIGN_OR_RAISE(output, detachDictionaries(std::move(output)));
+        return DataFrame(std::move(output));
+    }
+} // namespace TinaToolBox
@@ -0,0 +1,351 @@
+#include "DataFrame.hpp"
+#include "ColumnHash.hpp"
+
+#include <arrow/array/array_dict.h>
+#include <algorithm>
+#include <unordered_set>
+
+namespace TinaToolBox {
+    namespace {
+        using namespace ColumnHash;
+
+        // 一侧的连接键：连续数组、对应的哈希列和每行的哈希
+        struct JoinKeys {
+            std::vector<std::shared_ptr<arrow::Array>> arrays;
+            std::vector<std::unique_ptr<HashColumn>> columns;
+            std::vector<std::uint64_t> hashes;
+            int64_t rows = 0;
+
+            // 含空值的键不与任何行匹配
+            [[nodiscard]] bool hasNull(int64_t row) const {
+                return std::any_of(columns.begin(), columns.end(), [&](const auto &column) { return column->isNull(row); });
+            }
+
+            [[nodiscard]] bool equal(int64_t row, const JoinKeys &other, int64_t other_row) const {
+                for (size_t k = 0; k < columns.size(); ++k) {
+                    if (!columns[k]->equal(row, *other.columns[k], other_row)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        };
+
+        arrow::Status decodeDictionary(std::shared_ptr<arrow::ChunkedArray> &column) {
+            const auto &type = static_cast<const arrow::DictionaryType &>(*column->type());
+            ARROW_ASSIGN_OR_RAISE(auto decoded, arrow::compute::Cast(arrow::Datum(column), type.value_type()));
+            column = decoded.chunked_array();
+            return arrow::Status::OK();
+        }
+
+        // 让两边的键列类型一致：两边都是同类型的字典列时统一字典，使编码可以直接比较；
+        // 只有一边是字典列时先解码；其余类型不同的情况把右表的键转换为左表的类型
+        arrow::Status alignKeys(std::shared_ptr<arrow::ChunkedArray> &left, std::shared_ptr<arrow::ChunkedArray> &right) {
+            const bool left_dictionary = left->type()->id() == arrow::Type::DICTIONARY;
+            const bool right_dictionary = right->type()->id() == arrow::Type::DICTIONARY;
+            if (left_dictionary && right_dictionary && left->type()->Equals(right->type())) {
+                arrow::ArrayVector chunks = left->chunks();
+                chunks.insert(chunks.end(), right->chunks().begin(), right->chunks().end());
+                ARROW_ASSIGN_OR_RAISE(auto combined, arrow::ChunkedArray::Make(std::move(chunks), left->type()));
+                ARROW_ASSIGN_OR_RAISE(auto unified, arrow::DictionaryUnifier::UnifyChunkedArray(combined));
+                const auto split = unified->chunks().begin() + left->num_chunks();
+                ARROW_ASSIGN_OR_RAISE(left, arrow::ChunkedArray::Make(arrow::ArrayVector(unified->chunks().begin(), split),
+                                                                      unified->type()));
+                ARROW_ASSIGN_OR_RAISE(right, arrow::ChunkedArray::Make(arrow::ArrayVector(split, unified->chunks().end()),
+                                                                       unified->type()));
+                return arrow::Status::OK();
+            }
+            if (left_dictionary) {
+                ARROW_RETURN_NOT_OK(decodeDictionary(left));
+            }
+            if (right_dictionary) {
+                ARROW_RETURN_NOT_OK(decodeDictionary(right));
+            }
+            if (!right->type()->Equals(left->type())) {
+                auto cast = arrow::compute::Cast(arrow::Datum(right), left->type());
+                if (!cast.ok()) {
+                    return arrow::Status::TypeError("Cannot join ", right->type()->ToString(), " key with ",
+                                                    left->type()->ToString(), ": ", cast.status().message());
+                }
+                right = cast->chunked_array();
+            }
+            return arrow::Status::OK();
+        }
+
+        arrow::Status makeKeys(const std::vector<std::shared_ptr<arrow::ChunkedArray>> &columns, JoinKeys &keys) {
+            for (const auto &column : columns) {
+                ARROW_ASSIGN_OR_RAISE(auto array, contiguous(column));
+                auto hash_column = makeHashColumn(*array);
+                if (!hash_column) {
+                    return arrow::Status::TypeError("Cannot join on key of type ", array->type()->ToString());
+                }
+                keys.rows = array->length();
+                keys.arrays.push_back(std::move(array));
+                keys.columns.push_back(std::move(hash_column));
+            }
+            return arrow::Status::OK();
+        }
+
+        void hashKeys(ThreadPool &pool, JoinKeys &keys) {
+            keys.hashes.assign(static_cast<size_t>(keys.rows), SEED);
+            pool.parallel_for(0, static_cast<size_t>(keys.rows), static_cast<size_t>(DataFrame::JOIN_PROBE_BLOCK_ROWS),
+                              [&](size_t begin, size_t end) {
+                                  for (const auto &column : keys.columns) {
+                                      column->hash(static_cast<int64_t>(begin), static_cast<int64_t>(end),
+                                                   keys.hashes.data() + begin);
+                                  }
+                              });
+        }
+
+        // 建表一侧：相同键的行归为一组，各组的行按行序连续存放
+        struct BuildIndex {
+            HashTable table{0};
+            // 每组的第一行，用于与探测行比较键
+            std::vector<int64_t> first_rows;
+            // 每行所在的组，含空值键的行为 -1
+            std::vector<int64_t> group_of;
+            // 组 g 的行为 rows[offsets[g], offsets[g + 1])
+            std::vector<int64_t> offsets;
+            std::vector<int64_t> rows;
+        };
+
+        BuildIndex buildIndex(const JoinKeys &keys) {
+            BuildIndex index;
+            index.table = HashTable(static_cast<size_t>(keys.rows));
+            index.group_of.assign(static_cast<size_t>(keys.rows), -1);
+            for (int64_t row = 0; row < keys.rows; ++row) {
+                if (keys.hasNull(row)) {
+                    continue;
+                }
+                const auto [group, inserted] = index.table.findOrInsert(keys.hashes[row], [&](std::uint32_t existing) {
+                    return keys.equal(index.first_rows[existing], keys, row);
+                });
+                if (inserted) {
+                    index.first_rows.push_back(row);
+                }
+                index.group_of[row] = group;
+            }
+            index.offsets.assign(index.first_rows.size() + 1, 0);
+            for (const int64_t group : index.group_of) {
+                if (group >= 0) {
+                    ++index.offsets[group + 1];
+                }
+            }
+            for (size_t group = 0; group < index.first_rows.size(); ++group) {
+                index.offsets[group + 1] += index.offsets[group];
+            }
+            index.rows.resize(static_cast<size_t>(index.offsets.back()));
+            std::vector<int64_t> cursor(index.offsets.begin(), index.offsets.end() - 1);
+            for (int64_t row = 0; row < keys.rows; ++row) {
+                if (index.group_of[row] >= 0) {
+                    index.rows[cursor[index.group_of[row]]++] = row;
+                }
+            }
+            return index;
+        }
+
+        // 一个探测块的输出：左表行号和右表行号（-1 表示没有匹配）
+        struct JoinBlock {
+            std::vector<int64_t> left;
+            std::vector<int64_t> right;
+        };
+
+        // 左表第 left_row 行与 right_rows 中各行匹配时写入结果
+        void emitRow(JoinType type, int64_t left_row, const int64_t *right_rows, size_t count, JoinBlock &out) {
+            switch (type) {
+                case JoinType::Inner:
+                case JoinType::Left:
+                    for (size_t i = 0; i < count; ++i) {
+                        out.left.push_back(left_row);
+                        out.right.push_back(right_rows[i]);
+                    }
+                    if (count == 0 && type == JoinType::Left) {
+                        out.left.push_back(left_row);
+                        out.right.push_back(-1);
+                    }
+                    break;
+                case JoinType::Semi:
+                    if (count > 0) {
+                        out.left.push_back(left_row);
+                    }
+                    break;
+                case JoinType::Anti:
+                    if (count == 0) {
+                        out.left.push_back(left_row);
+                    }
+                    break;
+            }
+        }
+
+        arrow::Result<std::shared_ptr<arrow::Array>> indexArray(const std::vector<JoinBlock> &blocks, size_t rows,
+                                                                bool right) {
+            arrow::Int64Builder builder;
+            ARROW_RETURN_NOT_OK(builder.Reserve(static_cast<int64_t>(rows)));
+            for (const auto &block : blocks) {
+                const auto &values = right ? block.right : block.left;
+                for (const int64_t value : values) {
+                    value < 0 ? builder.UnsafeAppendNull() : builder.UnsafeAppend(value);
+                }
+            }
+            return builder.Finish();
+        }
+
+        size_t totalRows(const std::vector<JoinBlock> &blocks) {
+            size_t total = 0;
+            for (const auto &block : blocks) {
+                total += block.left.size();
+            }
+            return total;
+        }
+    }
+
+    arrow::Result<DataFrame> DataFrame::join(const DataFrame &right, const std::vector<std::string> &keys,
+                                             JoinType type, const std::string &right_suffix) const {
+        return join(right, keys, keys, type, right_suffix);
+    }
+
+    arrow::Result<DataFrame> DataFrame::join(const DataFrame &right, const std::vector<std::string> &left_keys,
+                                             const std::vector<std::string> &right_keys, JoinType type,
+                                             const std::string &right_suffix) const {
+        if (!table_ || !right.table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        if (left_keys.empty() || left_keys.size() != right_keys.size()) {
+            return arrow::Status::Invalid("Join requires the same non-zero number of keys on both sides");
+        }
+
+        std::vector<std::shared_ptr<arrow::ChunkedArray>> left_columns;
+        std::vector<std::shared_ptr<arrow::ChunkedArray>> right_columns;
+        for (size_t k = 0; k < left_keys.size(); ++k) {
+            auto left_column = table_->GetColumnByName(left_keys[k]);
+            if (!left_column) {
+                return arrow::Status::Invalid("Column not found: ", left_keys[k]);
+            }
+            auto right_column = right.table_->GetColumnByName(right_keys[k]);
+            if (!right_column) {
+                return arrow::Status::Invalid("Column not found: ", right_keys[k]);
+            }
+            ARROW_RETURN_NOT_OK(alignKeys(left_column, right_column));
+            left_columns.push_back(std::move(left_column));
+            right_columns.push_back(std::move(right_column));
+        }
+        JoinKeys left_side;
+        JoinKeys right_side;
+        ARROW_RETURN_NOT_OK(makeKeys(left_columns, left_side));
+        ARROW_RETURN_NOT_OK(makeKeys(right_columns, right_side));
+
+        ThreadPool &pool = getThreadPool();
+        hashKeys(pool, left_side);
+        hashKeys(pool, right_side);
+
+        // 在较小的一侧建表，另一侧分块并行探测；各块的结果按块号拼接，保持左表行序
+        const auto block_rows = static_cast<size_t>(JOIN_PROBE_BLOCK_ROWS);
+        const auto left_rows = static_cast<size_t>(left_side.rows);
+        const size_t left_blocks = (left_rows + block_rows - 1) / block_rows;
+        std::vector<JoinBlock> blocks(left_blocks);
+        if (right_side.rows <= left_side.rows) {
+            const BuildIndex index = buildIndex(right_side);
+            pool.parallel_for(0, left_blocks, 1, [&](size_t block) {
+                const size_t end = std::min(left_rows, (block + 1) * block_rows);
+                for (size_t row = block * block_rows; row < end; ++row) {
+                    const auto left_row = static_cast<int64_t>(row);
+                    int64_t group = -1;
+                    if (!left_side.hasNull(left_row)) {
+                        group = index.table.find(left_side.hashes[row], [&](std::uint32_t existing) {
+                            return right_side.equal(index.first_rows[existing], left_side, left_row);
+                        });
+                    }
+                    if (group < 0) {
+                        emitRow(type, left_row, nullptr, 0, blocks[block]);
+                    } else {
+                        emitRow(type, left_row, index.rows.data() + index.offsets[group],
+                                static_cast<size_t>(index.offsets[group + 1] - index.offsets[group]), blocks[block]);
+                    }
+                }
+            });
+        } else {
+            // 左表较小：先用右表探测，把匹配的右表行按左表的组归类，再按左表行序输出
+            const BuildIndex index = buildIndex(left_side);
+            const auto right_rows = static_cast<size_t>(right_side.rows);
+            const size_t right_blocks = (right_rows + block_rows - 1) / block_rows;
+            std::vector<std::vector<std::pair<int64_t, std::uint32_t>>> matches(right_blocks);
+            pool.parallel_for(0, right_blocks, 1, [&](size_t block) {
+                const size_t end = std::min(right_rows, (block + 1) * block_rows);
+                for (size_t row = block * block_rows; row < end; ++row) {
+                    const auto right_row = static_cast<int64_t>(row);
+                    if (right_side.hasNull(right_row)) {
+                        continue;
+                    }
+                    const int64_t group = index.table.find(right_side.hashes[row], [&](std::uint32_t existing) {
+                        return left_side.equal(index.first_rows[existing], right_side, right_row);
+                    });
+                    if (group >= 0) {
+                        matches[block].emplace_back(right_row, static_cast<std::uint32_t>(group));
+                    }
+                }
+            });
+
+            std::vector<int64_t> offsets(index.first_rows.size() + 1, 0);
+            for (const auto &block : matches) {
+                for (const auto &[row, group] : block) {
+                    ++offsets[group + 1];
+                }
+            }
+            for (size_t group = 0; group < index.first_rows.size(); ++group) {
+                offsets[group + 1] += offsets[group];
+            }
+            std::vector<int64_t> matched_rows(static_cast<size_t>(offsets.back()));
+            std::vector<int64_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (const auto &block : matches) {
+                for (const auto &[row, group] : block) {
+                    matched_rows[cursor[group]++] = row;
+                }
+            }
+            matches.clear();
+
+            pool.parallel_for(0, left_blocks, 1, [&](size_t block) {
+                const size_t end = std::min(left_rows, (block + 1) * block_rows);
+                for (size_t row = block * block_rows; row < end; ++row) {
+                    const int64_t group = index.group_of[row];
+                    if (group < 0) {
+                        emitRow(type, static_cast<int64_t>(row), nullptr, 0, blocks[block]);
+                    } else {
+                        emitRow(type, static_cast<int64_t>(row), matched_rows.data() + offsets[group],
+                                static_cast<size_t>(offsets[group + 1] - offsets[group]), blocks[block]);
+                    }
+                }
+            });
+        }
+
+        const size_t result_rows = totalRows(blocks);
+        ARROW_ASSIGN_OR_RAISE(const auto left_indices, indexArray(blocks, result_rows, false));
+        ARROW_ASSIGN_OR_RAISE(auto left_result, arrow::compute::Take(arrow::Datum(table_), arrow::Datum(left_indices)));
+        if (type == JoinType::Semi || type == JoinType::Anti) {
+            return DataFrame(left_result.table());
+        }
+
+        // 右表只保留非键列，与左表重名的列加后缀
+        const std::unordered_set<std::string> key_names(right_keys.begin(), right_keys.end());
+        std::vector<int> right_indices_to_keep;
+        arrow::FieldVector fields = table_->schema()->fields();
+        for (int i = 0; i < right.table_->num_columns(); ++i) {
+            const auto &field = right.table_->schema()->field(i);
+            if (key_names.count(field->name()) > 0) {
+                continue;
+            }
+            right_indices_to_keep.push_back(i);
+            fields.push_back(table_->schema()->GetFieldIndex(field->name()) >= 0
+                                 ? field->WithName(field->name() + right_suffix)
+                                 : field);
+        }
+        ARROW_ASSIGN_OR_RAISE(auto right_table, right.table_->SelectColumns(right_indices_to_keep));
+        ARROW_ASSIGN_OR_RAISE(const auto right_indices, indexArray(blocks, result_rows, true));
+        ARROW_ASSIGN_OR_RAISE(auto right_result, arrow::compute::Take(arrow::Datum(right_table), arrow::Datum(right_indices)));
+
+        auto columns = left_result.table()->columns();
+        const auto right_columns_taken = right_result.table()->columns();
+        columns.insert(columns.end(), right_columns_taken.begin(), right_columns_taken.end());
+        return DataFrame(arrow::Table::Make(arrow::schema(std::move(fields)), std::move(columns),
+                                            static_cast<int64_t>(result_rows)));
+    }
+} // namespace TinaToolBox
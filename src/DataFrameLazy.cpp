@@ -0,0 +1,424 @@
+#include "DataFrameLazy.hpp"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <sstream>
+
+namespace TinaToolBox {
+    struct LazyFrame::Plan {
+        enum class Kind { Filter, Sort, TopK, Limit };
+
+        struct Step {
+            Kind kind = Kind::Filter;
+            Operation operation;
+        };
+
+        // 扫描：读取的列（为空表示全部）和下推到文件读取的比较
+        ColumnarReadOptions read;
+        std::vector<Step> steps;
+        // 输出列，为空表示扫描得到的全部列
+        std::optional<std::vector<std::string>> output;
+    };
+
+    namespace {
+        arrow::Result<arrow::compute::Expression> comparisonExpression(const ColumnFilter &filter) {
+            static const std::array<const char *, 6> OPERATORS = {
+                "equal", "not_equal", "greater", "greater_equal", "less", "less_equal"
+            };
+            if (std::find(OPERATORS.begin(), OPERATORS.end(), filter.comparison_operator) == OPERATORS.end()) {
+                return arrow::Status::Invalid("Invalid comparison operator");
+            }
+            return Predicate::compare(filter.column, filter.comparison_operator, filter.value);
+        }
+
+        // 表达式引用的列名；引用了不是列名的字段（如按序号）时返回 std::nullopt
+        std::optional<std::vector<std::string>> referencedColumns(const arrow::compute::Expression &expression) {
+            std::vector<std::string> names;
+            for (const auto &ref : arrow::compute::FieldsInExpression(expression)) {
+                const auto *name = ref.name();
+                if (!name) {
+                    return std::nullopt;
+                }
+                names.push_back(*name);
+            }
+            return names;
+        }
+
+        void appendUnique(std::vector<std::string> &names, const std::string &name) {
+            if (std::find(names.begin(), names.end(), name) == names.end()) {
+                names.push_back(name);
+            }
+        }
+
+        arrow::Result<std::shared_ptr<arrow::Table>> selectColumns(const std::shared_ptr<arrow::Table> &table,
+                                                                   const std::vector<std::string> &names) {
+            std::vector<int> indices;
+            for (const auto &name : names) {
+                const int index = table->schema()->GetFieldIndex(name);
+                if (index < 0) {
+                    return arrow::Status::Invalid("Column not found: ", name);
+                }
+                indices.push_back(index);
+            }
+            return table->SelectColumns(indices);
+        }
+
+        // 掩码中为 true 的行号（空值不选）
+        arrow::Result<std::shared_ptr<arrow::Array>> selectedRows(const arrow::ChunkedArray &mask) {
+            arrow::Int64Builder builder;
+            int64_t row = 0;
+            for (const auto &chunk : mask.chunks()) {
+                const auto &booleans = static_cast<const arrow::BooleanArray &>(*chunk);
+                ARROW_RETURN_NOT_OK(builder.Reserve(booleans.true_count()));
+                for (int64_t i = 0; i < booleans.length(); ++i) {
+                    if (booleans.IsValid(i) && booleans.Value(i)) {
+                        builder.UnsafeAppend(row + i);
+                    }
+                }
+                row += booleans.length();
+            }
+            return builder.Finish();
+        }
+
+        std::string describeKeys(const std::vector<DataFrame::SortKey> &keys) {
+            std::string text;
+            for (const auto &key : keys) {
+                text += (text.empty() ? "" : ", ") + key.column + (key.ascending ? " asc" : " desc") +
+                        (key.nulls_first ? " nulls first" : "");
+            }
+            return text;
+        }
+
+        std::string describeColumns(const std::vector<std::string> &columns) {
+            std::string text;
+            for (const auto &column : columns) {
+                text += (text.empty() ? "" : ", ") + column;
+            }
+            return "[" + text + "]";
+        }
+
+        std::string describeComparison(const ColumnFilter &filter) {
+            return filter.column + " " + filter.comparison_operator + " " +
+                   (filter.value ? filter.value->ToString() : "null");
+        }
+    }
+
+    LazyFrame::LazyFrame(DataFrame source) : format_(SourceFormat::Frame), frame_(std::move(source)) {}
+
+    LazyFrame::LazyFrame(SourceFormat format, std::string path) : format_(format), path_(std::move(path)) {}
+
+    LazyFrame LazyFrame::scanParquet(std::string filePath) {
+        return LazyFrame(SourceFormat::Parquet, std::move(filePath));
+    }
+
+    LazyFrame LazyFrame::scanFeather(std::string filePath) {
+        return LazyFrame(SourceFormat::Feather, std::move(filePath));
+    }
+
+    LazyFrame DataFrame::lazy() const {
+        return LazyFrame(*this);
+    }
+
+    LazyFrame LazyFrame::with(Operation operation) const {
+        LazyFrame result = *this;
+        result.operations_.push_back(std::move(operation));
+        return result;
+    }
+
+    LazyFrame LazyFrame::filter(arrow::compute::Expression predicate) const {
+        Operation operation;
+        operation.step = Step::Filter;
+        operation.predicates.push_back(std::move(predicate));
+        return with(std::move(operation));
+    }
+
+    LazyFrame LazyFrame::filter(const std::string &column, std::shared_ptr<arrow::Scalar> value,
+                                const std::string &comparison_operator) const {
+        Operation operation;
+        operation.step = Step::Filter;
+        operation.comparisons.push_back(ColumnFilter{column, std::move(value), comparison_operator});
+        return with(std::move(operation));
+    }
+
+    LazyFrame LazyFrame::select(std::vector<std::string> columns) const {
+        Operation operation;
+        operation.step = Step::Select;
+        operation.columns = std::move(columns);
+        return with(std::move(operation));
+    }
+
+    LazyFrame LazyFrame::sort(std::vector<DataFrame::SortKey> keys) const {
+        Operation operation;
+        operation.step = Step::Sort;
+        operation.keys = std::move(keys);
+        return with(std::move(operation));
+    }
+
+    LazyFrame LazyFrame::limit(int64_t rows) const {
+        Operation operation;
+        operation.step = Step::Limit;
+        operation.rows = rows;
+        return with(std::move(operation));
+    }
+
+    arrow::Result<LazyFrame::Plan> LazyFrame::optimize() const {
+        Plan plan;
+
+        // 检查各操作引用的列在当时可见，随后去掉投影，只在最后选择输出列（投影与过滤、排序、截取都可交换）
+        std::optional<std::vector<std::string>> visible;
+        const auto require = [&](const std::string &column) -> arrow::Status {
+            if (visible && std::find(visible->begin(), visible->end(), column) == visible->end()) {
+                return arrow::Status::Invalid("Column not found: ", column);
+            }
+            return arrow::Status::OK();
+        };
+        std::vector<Plan::Step> steps;
+        for (const auto &operation : operations_) {
+            switch (operation.step) {
+                case Step::Filter:
+                    for (const auto &comparison : operation.comparisons) {
+                        ARROW_RETURN_NOT_OK(comparisonExpression(comparison).status());
+                        ARROW_RETURN_NOT_OK(require(comparison.column));
+                    }
+                    for (const auto &predicate : operation.predicates) {
+                        for (const auto &column : referencedColumns(predicate).value_or(std::vector<std::string>{})) {
+                            ARROW_RETURN_NOT_OK(require(column));
+                        }
+                    }
+                    steps.push_back({Plan::Kind::Filter, operation});
+                    break;
+                case Step::Select:
+                    for (const auto &column : operation.columns) {
+                        ARROW_RETURN_NOT_OK(require(column));
+                    }
+                    visible = operation.columns;
+                    break;
+                case Step::Sort:
+                    if (operation.keys.empty()) {
+                        return arrow::Status::Invalid("No sort keys");
+                    }
+                    for (const auto &key : operation.keys) {
+                        ARROW_RETURN_NOT_OK(require(key.column));
+                    }
+                    steps.push_back({Plan::Kind::Sort, operation});
+                    break;
+                case Step::Limit:
+                    if (operation.rows < 0) {
+                        return arrow::Status::Invalid("limit must not be negative");
+                    }
+                    steps.push_back({Plan::Kind::Limit, operation});
+                    break;
+            }
+        }
+        plan.output = std::move(visible);
+
+        // 谓词下推：过滤越过它前面的排序（不越过截取）
+        for (size_t i = 1; i < steps.size(); ++i) {
+            for (size_t j = i; j > 0 && steps[j].kind == Plan::Kind::Filter && steps[j - 1].kind == Plan::Kind::Sort; --j) {
+                std::swap(steps[j - 1], steps[j]);
+            }
+        }
+
+        // 合并相邻的同类步骤，排序后的截取折叠为 topK
+        for (auto &step : steps) {
+            if (!plan.steps.empty()) {
+                auto &previous = plan.steps.back();
+                if (step.kind == Plan::Kind::Filter && previous.kind == Plan::Kind::Filter) {
+                    auto &target = previous.operation;
+                    target.predicates.insert(target.predicates.end(), step.operation.predicates.begin(),
+                                             step.operation.predicates.end());
+                    target.comparisons.insert(target.comparisons.end(), step.operation.comparisons.begin(),
+                                              step.operation.comparisons.end());
+                    continue;
+                }
+                if (step.kind == Plan::Kind::Sort && previous.kind == Plan::Kind::Sort) {
+                    // 排序是稳定的，后一次排序的键优先，前一次的键决定相同键的先后
+                    auto keys = step.operation.keys;
+                    keys.insert(keys.end(), previous.operation.keys.begin(), previous.operation.keys.end());
+                    previous.operation.keys = std::move(keys);
+                    continue;
+                }
+                if (step.kind == Plan::Kind::Limit &&
+                    (previous.kind == Plan::Kind::Limit || previous.kind == Plan::Kind::TopK)) {
+                    previous.operation.rows = std::min(previous.operation.rows, step.operation.rows);
+                    continue;
+                }
+                if (step.kind == Plan::Kind::Limit && previous.kind == Plan::Kind::Sort) {
+                    previous.kind = Plan::Kind::TopK;
+                    previous.operation.rows = step.operation.rows;
+                    continue;
+                }
+            }
+            plan.steps.push_back(std::move(step));
+        }
+
+        // 文件源：第一个过滤中的简单比较下推到读取
+        if (format_ != SourceFormat::Frame && !plan.steps.empty() && plan.steps.front().kind == Plan::Kind::Filter) {
+            auto &first = plan.steps.front().operation;
+            plan.read.filters = std::move(first.comparisons);
+            first.comparisons.clear();
+            if (first.predicates.empty()) {
+                plan.steps.erase(plan.steps.begin());
+            }
+        }
+
+        // 投影裁剪：只读取输出列和后续步骤用到的列；下推到读取的比较列不必读出
+        if (plan.output) {
+            std::vector<std::string> columns = *plan.output;
+            bool prunable = true;
+            for (const auto &step : plan.steps) {
+                for (const auto &comparison : step.operation.comparisons) {
+                    appendUnique(columns, comparison.column);
+                }
+                for (const auto &predicate : step.operation.predicates) {
+                    const auto referenced = referencedColumns(predicate);
+                    if (!referenced) {
+                        prunable = false;
+                        break;
+                    }
+                    for (const auto &column : *referenced) {
+                        appendUnique(columns, column);
+                    }
+                }
+                for (const auto &key : step.operation.keys) {
+                    appendUnique(columns, key.column);
+                }
+            }
+            if (prunable) {
+                plan.read.columns = std::move(columns);
+            }
+        }
+        return plan;
+    }
+
+    std::string LazyFrame::explain() const {
+        auto plan = optimize();
+        if (!plan.ok()) {
+            return "Invalid plan: " + plan.status().ToString();
+        }
+        std::ostringstream text;
+        switch (format_) {
+            case SourceFormat::Frame: text << "Scan frame"; break;
+            case SourceFormat::Parquet: text << "Scan parquet " << path_; break;
+            case SourceFormat::Feather: text << "Scan feather " << path_; break;
+        }
+        text << " columns=" << (plan->read.columns.empty() ? "*" : describeColumns(plan->read.columns));
+        for (const auto &filter : plan->read.filters) {
+            text << " filter=(" << describeComparison(filter) << ")";
+        }
+        text << "\n";
+        for (const auto &step : plan->steps) {
+            const auto &operation = step.operation;
+            switch (step.kind) {
+                case Plan::Kind::Filter: {
+                    text << "Filter";
+                    for (const auto &comparison : operation.comparisons) {
+                        text << " (" << describeComparison(comparison) << ")";
+                    }
+                    for (const auto &predicate : operation.predicates) {
+                        text << " " << predicate.ToString();
+                    }
+                    break;
+                }
+                case Plan::Kind::Sort: text << "Sort " << describeKeys(operation.keys); break;
+                case Plan::Kind::TopK: text << "TopK " << operation.rows << " by " << describeKeys(operation.keys); break;
+                case Plan::Kind::Limit: text << "Limit " << operation.rows; break;
+            }
+            text << "\n";
+        }
+        if (plan->output) {
+            text << "Project " << describeColumns(*plan->output) << "\n";
+        }
+        return text.str();
+    }
+
+    arrow::Result<DataFrame> LazyFrame::collect() const {
+        ARROW_ASSIGN_OR_RAISE(const auto plan, optimize());
+
+        std::shared_ptr<arrow::Table> table;
+        switch (format_) {
+            case SourceFormat::Frame:
+                table = frame_.table();
+                if (!table) {
+                    return arrow::Status::Invalid("DataFrame is empty");
+                }
+                if (!plan.read.columns.empty()) {
+                    ARROW_ASSIGN_OR_RAISE(table, selectColumns(table, plan.read.columns));
+                }
+                break;
+            case SourceFormat::Parquet: {
+                ARROW_ASSIGN_OR_RAISE(auto frame, DataFrame::fromParquet(path_, plan.read));
+                table = frame.table();
+                break;
+            }
+            case SourceFormat::Feather: {
+                ARROW_ASSIGN_OR_RAISE(auto frame, DataFrame::fromFeather(path_, plan.read));
+                table = frame.table();
+                break;
+            }
+        }
+
+        // 过滤和排序只更新 selection（table 中被选中的行号，按输出顺序），为空表示全部行按原顺序
+        std::shared_ptr<arrow::Array> selection;
+        for (const auto &step : plan.steps) {
+            const auto &operation = step.operation;
+            switch (step.kind) {
+                case Plan::Kind::Filter: {
+                    if (selection) {
+                        // 截取之后的过滤：先取出已选中的行（此时行数已经很少）
+                        ARROW_ASSIGN_OR_RAISE(auto taken, arrow::compute::Take(table, selection));
+                        table = taken.table();
+                        selection = nullptr;
+                    }
+                    std::vector<arrow::compute::Expression> conjuncts = operation.predicates;
+                    for (const auto &comparison : operation.comparisons) {
+                        ARROW_ASSIGN_OR_RAISE(auto expression, comparisonExpression(comparison));
+                        conjuncts.push_back(std::move(expression));
+                    }
+                    ARROW_ASSIGN_OR_RAISE(auto mask, DataFrame(table).filterMask(arrow::compute::and_(conjuncts)));
+                    ARROW_ASSIGN_OR_RAISE(selection, selectedRows(*mask));
+                    break;
+                }
+                case Plan::Kind::Sort:
+                case Plan::Kind::TopK: {
+                    // 只取出键列参与排序
+                    std::vector<std::string> key_columns;
+                    for (const auto &key : operation.keys) {
+                        appendUnique(key_columns, key.column);
+                    }
+                    ARROW_ASSIGN_OR_RAISE(auto key_table, selectColumns(table, key_columns));
+                    if (selection) {
+                        ARROW_ASSIGN_OR_RAISE(auto taken, arrow::compute::Take(key_table, selection));
+                        key_table = taken.table();
+                    }
+                    const int64_t limit = step.kind == Plan::Kind::TopK ? operation.rows : -1;
+                    ARROW_ASSIGN_OR_RAISE(auto order, DataFrame(key_table).sortedRowIndices(operation.keys, limit));
+                    if (selection) {
+                        ARROW_ASSIGN_OR_RAISE(auto composed, arrow::compute::Take(*selection, *order));
+                        selection = std::move(composed);
+                    } else {
+                        selection = std::move(order);
+                    }
+                    break;
+                }
+                case Plan::Kind::Limit:
+                    if (selection) {
+                        selection = selection->Slice(0, std::min(operation.rows, selection->length()));
+                    } else {
+                        table = table->Slice(0, operation.rows);
+                    }
+                    break;
+            }
+        }
+
+        if (plan.output) {
+            ARROW_ASSIGN_OR_RAISE(table, selectColumns(table, *plan.output));
+        }
+        if (selection) {
+            ARROW_ASSIGN_OR_RAISE(auto taken, arrow::compute::Take(table, selection));
+            table = taken.table();
+        }
+        return DataFrame(std::move(table));
+    }
+} // namespace TinaToolBox
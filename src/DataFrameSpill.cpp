@@ -0,0 +1,416 @@
+#include "DataFrameSpill.hpp"
+#include "DataFrame.hpp"
+
+#include <arrow/array/array_dict.h>
+#include <arrow/util/byte_size.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace TinaToolBox {
+    namespace {
+        std::atomic<int64_t> memory_budget{0};
+        // 同一进程内的临时文件名前缀各不相同
+        std::atomic<std::uint64_t> spill_counter{0};
+
+        // 外部排序归并窗口中每段的最少行数
+        constexpr int64_t MIN_MERGE_ROWS = 1024;
+
+        // Arrow 的文件接口按 UTF-8 解释路径
+        std::string utf8Path(const std::filesystem::path &path) {
+#if defined(__cpp_lib_char8_t)
+            const auto text = path.u8string();
+            return std::string(text.begin(), text.end());
+#else
+            return path.u8string();
+#endif
+        }
+
+        std::shared_ptr<arrow::Array> rowNumbers(int64_t offset, int64_t length) {
+            std::vector<int64_t> rows(static_cast<size_t>(length));
+            std::iota(rows.begin(), rows.end(), offset);
+            return std::make_shared<arrow::Int64Array>(length, arrow::Buffer::FromVector(std::move(rows)));
+        }
+
+        // 一次映射。声明顺序使析构时先解除映射，再释放对临时文件的引用
+        struct MappedSpill {
+            std::shared_ptr<TTBTemporaryFile> file;
+            std::shared_ptr<arrow::io::MemoryMappedFile> mapped;
+        };
+
+        // 映射中的一段数据，持有映射和临时文件；Arrow 从它切出的缓冲区都以它为父缓冲区
+        class SpillBuffer final : public arrow::Buffer {
+        public:
+            SpillBuffer(std::shared_ptr<const MappedSpill> owner, std::shared_ptr<arrow::Buffer> mapped)
+                : arrow::Buffer(mapped->data(), mapped->size()), owner_(std::move(owner)), mapped_(std::move(mapped)) {}
+
+        private:
+            // 声明在 mapped_ 之前，析构时先释放映射的缓冲区
+            std::shared_ptr<const MappedSpill> owner_;
+            std::shared_ptr<arrow::Buffer> mapped_;
+        };
+
+        // 转发到 MemoryMappedFile，返回的缓冲区包装为 SpillBuffer
+        class SpillInputFile final : public arrow::io::RandomAccessFile {
+        public:
+            explicit SpillInputFile(std::shared_ptr<const MappedSpill> owner) : owner_(std::move(owner)) {}
+
+            arrow::Status Close() override {
+                closed_ = true;
+                return arrow::Status::OK();
+            }
+
+            [[nodiscard]] bool closed() const override { return closed_; }
+
+            [[nodiscard]] arrow::Result<int64_t> Tell() const override { return owner_->mapped->Tell(); }
+
+            arrow::Status Seek(int64_t position) override { return owner_->mapped->Seek(position); }
+
+            arrow::Result<int64_t> GetSize() override { return owner_->mapped->GetSize(); }
+
+            [[nodiscard]] bool supports_zero_copy() const override { return true; }
+
+            arrow::Result<int64_t> Read(int64_t nbytes, void *out) override {
+                return owner_->mapped->Read(nbytes, out);
+            }
+
+            arrow::Result<std::shared_ptr<arrow::Buffer>> Read(int64_t nbytes) override {
+                ARROW_ASSIGN_OR_RAISE(auto buffer, owner_->mapped->Read(nbytes));
+                return wrap(std::move(buffer));
+            }
+
+            arrow::Result<int64_t> ReadAt(int64_t position, int64_t nbytes, void *out) override {
+                return owner_->mapped->ReadAt(position, nbytes, out);
+            }
+
+            arrow::Result<std::shared_ptr<arrow::Buffer>> ReadAt(int64_t position, int64_t nbytes) override {
+                ARROW_ASSIGN_OR_RAISE(auto buffer, owner_->mapped->ReadAt(position, nbytes));
+                return wrap(std::move(buffer));
+            }
+
+        private:
+            std::shared_ptr<arrow::Buffer> wrap(std::shared_ptr<arrow::Buffer> buffer) const {
+                return std::make_shared<SpillBuffer>(owner_, std::move(buffer));
+            }
+
+            std::shared_ptr<const MappedSpill> owner_;
+            bool closed_ = false;
+        };
+
+        // SortIndices 返回 UINT64，分段归并返回 INT64
+        int64_t indexAt(const arrow::Array &indices, int64_t i) {
+            return indices.type_id() == arrow::Type::UINT64
+                       ? static_cast<int64_t>(static_cast<const arrow::UInt64Array &>(indices).Value(i))
+                       : static_cast<const arrow::Int64Array &>(indices).Value(i);
+        }
+    }
+
+    SpillFile::SpillFile()
+        : file_(std::make_shared<TTBTemporaryFile>("ttb_spill_" + std::to_string(spill_counter.fetch_add(1)) + "_")) {}
+
+    arrow::Status SpillFile::open(const std::shared_ptr<arrow::Schema> &schema) {
+        if (writer_) {
+            return arrow::Status::OK();
+        }
+        if (closed_) {
+            return arrow::Status::Invalid("Spill file is closed");
+        }
+        // 不压缩，读回时才能零拷贝映射
+        auto options = arrow::ipc::IpcWriteOptions::Defaults();
+        options.unify_dictionaries = true;
+        options.emit_dictionary_deltas = true;
+        ARROW_ASSIGN_OR_RAISE(output_, arrow::io::FileOutputStream::Open(utf8Path(path())));
+        ARROW_ASSIGN_OR_RAISE(writer_, arrow::ipc::MakeFileWriter(output_, schema, options));
+        return arrow::Status::OK();
+    }
+
+    arrow::Status SpillFile::write(const arrow::RecordBatch &batch) {
+        ARROW_RETURN_NOT_OK(open(batch.schema()));
+        ARROW_ASSIGN_OR_RAISE(auto extended, extendDictionaries(batch));
+        ARROW_RETURN_NOT_OK(writer_->WriteRecordBatch(*extended));
+        rows_ += batch.num_rows();
+        return arrow::Status::OK();
+    }
+
+    arrow::Result<std::shared_ptr<arrow::RecordBatch>> SpillFile::extendDictionaries(const arrow::RecordBatch &batch) {
+        dictionaries_.resize(static_cast<size_t>(batch.num_columns()));
+        auto columns = batch.columns();
+        for (int i = 0; i < batch.num_columns(); ++i) {
+            if (columns[i]->type_id() != arrow::Type::DICTIONARY) {
+                continue;
+            }
+            const auto &array = static_cast<const arrow::DictionaryArray &>(*columns[i]);
+            auto &written = dictionaries_[static_cast<size_t>(i)];
+            if (!written) {
+                written = array.dictionary();
+                continue;
+            }
+            if (array.dictionary() == written) {
+                continue;
+            }
+            // 先放入已写入的字典，合并结果以它为前缀，写出器可以只写增量
+            const auto &type = static_cast<const arrow::DictionaryType &>(*array.type());
+            ARROW_ASSIGN_OR_RAISE(auto unifier, arrow::DictionaryUnifier::Make(type.value_type()));
+            ARROW_RETURN_NOT_OK(unifier->Unify(*written));
+            std::shared_ptr<arrow::Buffer> transpose;
+            ARROW_RETURN_NOT_OK(unifier->Unify(*array.dictionary(), &transpose));
+            ARROW_RETURN_NOT_OK(unifier->GetResultWithIndexType(type.index_type(), &written));
+            ARROW_ASSIGN_OR_RAISE(columns[i], array.Transpose(array.type(), written,
+                                                              transpose->data_as<int32_t>()));
+        }
+        return arrow::RecordBatch::Make(batch.schema(), batch.num_rows(), std::move(columns));
+    }
+
+    arrow::Status SpillFile::write(const arrow::Table &table, int64_t batch_rows) {
+        ARROW_RETURN_NOT_OK(open(table.schema()));
+        ARROW_RETURN_NOT_OK(writer_->WriteTable(table, batch_rows));
+        rows_ += table.num_rows();
+        return arrow::Status::OK();
+    }
+
+    arrow::Status SpillFile::close() {
+        if (!writer_) {
+            closed_ = true;
+            return arrow::Status::OK();
+        }
+        ARROW_RETURN_NOT_OK(writer_->Close());
+        ARROW_RETURN_NOT_OK(output_->Close());
+        writer_.reset();
+        output_.reset();
+        closed_ = true;
+        written_ = true;
+        return arrow::Status::OK();
+    }
+
+    arrow::Result<std::shared_ptr<arrow::ipc::RecordBatchFileReader>> SpillFile::reader() const {
+        if (!written_) {
+            return arrow::Status::Invalid("Spill file has not been written");
+        }
+        auto owner = std::make_shared<MappedSpill>();
+        owner->file = file_;
+        ARROW_ASSIGN_OR_RAISE(owner->mapped, arrow::io::MemoryMappedFile::Open(utf8Path(path()),
+                                                                               arrow::io::FileMode::READ));
+        return arrow::ipc::RecordBatchFileReader::Open(std::make_shared<SpillInputFile>(std::move(owner)));
+    }
+
+    arrow::Result<std::shared_ptr<arrow::Table>> SpillFile::read() const {
+        if (!written_) {
+            return nullptr;
+        }
+        ARROW_ASSIGN_OR_RAISE(auto reader, this->reader());
+        std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+        batches.reserve(static_cast<size_t>(reader->num_record_batches()));
+        for (int i = 0; i < reader->num_record_batches(); ++i) {
+            ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+            batches.push_back(std::move(batch));
+        }
+        return arrow::Table::FromRecordBatches(reader->schema(), batches);
+    }
+
+    arrow::Result<std::shared_ptr<arrow::Table>> SpillFile::unifyDictionaries(std::shared_ptr<arrow::Table> table) {
+        for (int i = 0; i < table->num_columns(); ++i) {
+            auto column = table->column(i);
+            if (column->type()->id() != arrow::Type::DICTIONARY || column->num_chunks() < 2) {
+                continue;
+            }
+            ARROW_ASSIGN_OR_RAISE(column, arrow::DictionaryUnifier::UnifyChunkedArray(column));
+            ARROW_ASSIGN_OR_RAISE(table, table->SetColumn(i, table->field(i), std::move(column)));
+        }
+        return table;
+    }
+
+    bool SpillableTableBuilder::overBudget() {
+        return DataFrame::exceedsMemoryBudget(arrow::default_memory_pool()->bytes_allocated());
+    }
+
+    arrow::Status SpillableTableBuilder::append(const std::shared_ptr<arrow::RecordBatch> &batch) {
+        if (!file_ && overBudget()) {
+            spdlog::info("Memory pool holds {} bytes (budget {}), spilling loaded batches to a temporary file",
+                         arrow::default_memory_pool()->bytes_allocated(), DataFrame::memoryBudget());
+            ARROW_RETURN_NOT_OK(spill());
+        }
+        if (file_) {
+            return file_->write(*batch);
+        }
+        batches_.push_back(batch);
+        return arrow::Status::OK();
+    }
+
+    arrow::Status SpillableTableBuilder::spill() {
+        if (file_) {
+            return arrow::Status::OK();
+        }
+        file_ = std::make_unique<SpillFile>();
+        for (auto &batch : batches_) {
+            ARROW_RETURN_NOT_OK(file_->write(*batch));
+            batch.reset();
+        }
+        batches_.clear();
+        return arrow::Status::OK();
+    }
+
+    arrow::Result<std::shared_ptr<arrow::Table>> SpillableTableBuilder::finish(
+        const std::shared_ptr<arrow::Schema> &schema) {
+        std::shared_ptr<arrow::Table> table;
+        if (file_) {
+            ARROW_RETURN_NOT_OK(file_->close());
+            ARROW_ASSIGN_OR_RAISE(table, file_->read());
+        } else if (!batches_.empty()) {
+            ARROW_ASSIGN_OR_RAISE(table, arrow::Table::FromRecordBatches(schema, batches_));
+            batches_.clear();
+        }
+        if (!table) {
+            ARROW_ASSIGN_OR_RAISE(table, arrow::Table::MakeEmpty(schema));
+        }
+        return table;
+    }
+
+    void DataFrame::setMemoryBudget(int64_t bytes) {
+        memory_budget.store(std::max<int64_t>(0, bytes), std::memory_order_relaxed);
+    }
+
+    int64_t DataFrame::memoryBudget() {
+        return memory_budget.load(std::memory_order_relaxed);
+    }
+
+    bool DataFrame::exceedsMemoryBudget(int64_t bytes) {
+        const int64_t budget = memoryBudget();
+        return budget > 0 && bytes > budget;
+    }
+
+    arrow::Result<DataFrame> DataFrame::spill() const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        if (spilled_) {
+            return *this;
+        }
+        SpillFile file;
+        ARROW_RETURN_NOT_OK(file.write(*table_, SPILL_BATCH_ROWS));
+        ARROW_RETURN_NOT_OK(file.close());
+        ARROW_ASSIGN_OR_RAISE(auto table, file.read());
+        DataFrame frame(std::move(table));
+        frame.spilled_ = true;
+        frame.load_report_ = load_report_;
+        return frame;
+    }
+
+    arrow::Result<DataFrame> DataFrame::externalSort(const std::vector<SortKey> &keys) const {
+        if (!table_) {
+            return arrow::Status::Invalid("DataFrame is empty");
+        }
+        if (keys.empty()) {
+            return arrow::Status::Invalid("No sort keys");
+        }
+        // 各段和输出分批写入同一格式的文件，每列只能有一个字典
+        ARROW_ASSIGN_OR_RAISE(auto table, SpillFile::unifyDictionaries(table_));
+        const int64_t num_rows = table->num_rows();
+        if (num_rows == 0) {
+            return *this;
+        }
+        const int64_t row_bytes = std::max<int64_t>(1, arrow::util::TotalBufferSize(*table) / num_rows);
+        const int64_t run_rows = std::max(SPILL_BATCH_ROWS, memoryBudget() / 2 / row_bytes);
+        const int64_t run_count = (num_rows + run_rows - 1) / run_rows;
+        // 归并窗口同时容纳每段的一批，总量与一段相当
+        const int64_t merge_rows = std::clamp(run_rows / run_count, MIN_MERGE_ROWS, SPILL_BATCH_ROWS);
+
+        // 每段带上原来的行号，归并时作为最后一个键，使结果与内存中的稳定排序相同
+        const int row_column = table->num_columns();
+        const auto row_field = arrow::field(SpillFile::ROW_COLUMN, arrow::int64());
+        std::vector<SortKey> merge_keys = keys;
+        merge_keys.push_back(SortKey{SpillFile::ROW_COLUMN, true, false});
+
+        std::vector<std::unique_ptr<SpillFile>> runs;
+        for (int64_t begin = 0; begin < num_rows; begin += run_rows) {
+            const int64_t length = std::min(run_rows, num_rows - begin);
+            ARROW_ASSIGN_OR_RAISE(auto slice, table->Slice(begin, length)->AddColumn(
+                                      row_column, row_field,
+                                      std::make_shared<arrow::ChunkedArray>(rowNumbers(begin, length))));
+            DataFrame run(std::move(slice));
+            ARROW_ASSIGN_OR_RAISE(auto indices, run.sortedRowIndices(keys, -1));
+            ARROW_ASSIGN_OR_RAISE(auto sorted, arrow::compute::Take(run.table_, indices));
+            auto file = std::make_unique<SpillFile>();
+            ARROW_RETURN_NOT_OK(file->write(*sorted.table(), merge_rows));
+            ARROW_RETURN_NOT_OK(file->close());
+            runs.push_back(std::move(file));
+        }
+        spdlog::debug("External sort of {} rows: {} runs of up to {} rows", num_rows, runs.size(), run_rows);
+
+        struct RunCursor {
+            std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader;
+            int next_batch = 0;
+            // 已读入、还没有输出的行（有序）
+            std::shared_ptr<arrow::Table> pending;
+
+            [[nodiscard]] bool exhausted() const { return next_batch >= reader->num_record_batches(); }
+        };
+        std::vector<RunCursor> cursors(runs.size());
+        for (size_t r = 0; r < runs.size(); ++r) {
+            ARROW_ASSIGN_OR_RAISE(cursors[r].reader, runs[r]->reader());
+        }
+
+        // 每轮把各段读入的行合并排序。还有未读批次的段，其后续的行都不小于它当前的最后一行，
+        // 所以只输出不超过这些最后一行中最小者的部分，其余留到下一轮；该段的行全部输出，下一轮读入新批次
+        SpillFile output;
+        std::vector<int64_t> positions;
+        for (;;) {
+            std::vector<std::shared_ptr<arrow::Table>> window;
+            std::vector<RunCursor *> members;
+            for (auto &cursor : cursors) {
+                while ((!cursor.pending || cursor.pending->num_rows() == 0) && !cursor.exhausted()) {
+                    ARROW_ASSIGN_OR_RAISE(auto batch, cursor.reader->ReadRecordBatch(cursor.next_batch++));
+                    ARROW_ASSIGN_OR_RAISE(cursor.pending, arrow::Table::FromRecordBatches({std::move(batch)}));
+                }
+                if (cursor.pending && cursor.pending->num_rows() > 0) {
+                    window.push_back(cursor.pending);
+                    members.push_back(&cursor);
+                }
+            }
+            if (window.empty()) {
+                break;
+            }
+
+            ARROW_ASSIGN_OR_RAISE(auto combined, arrow::ConcatenateTables(window));
+            const DataFrame merged(combined);
+            ARROW_ASSIGN_OR_RAISE(auto indices, merged.sortedRowIndices(merge_keys, -1));
+            positions.resize(static_cast<size_t>(combined->num_rows()));
+            for (int64_t i = 0; i < indices->length(); ++i) {
+                positions[indexAt(*indices, i)] = i;
+            }
+            int64_t emit = combined->num_rows();
+            int64_t offset = 0;
+            for (size_t m = 0; m < members.size(); ++m) {
+                const int64_t length = window[m]->num_rows();
+                if (!members[m]->exhausted()) {
+                    emit = std::min(emit, positions[offset + length - 1] + 1);
+                }
+                offset += length;
+            }
+
+            ARROW_ASSIGN_OR_RAISE(auto emitted, arrow::compute::Take(combined, indices->Slice(0, emit)));
+            ARROW_ASSIGN_OR_RAISE(auto rows, emitted.table()->RemoveColumn(row_column));
+            ARROW_RETURN_NOT_OK(output.write(*rows, merge_rows));
+
+            offset = 0;
+            for (size_t m = 0; m < members.size(); ++m) {
+                const int64_t length = window[m]->num_rows();
+                const auto consumed = std::count_if(positions.begin() + offset, positions.begin() + offset + length,
+                                                    [emit](int64_t position) { return position < emit; });
+                members[m]->pending = members[m]->pending->Slice(consumed);
+                offset += length;
+            }
+        }
+        // 各段的映射和临时文件不再需要
+        cursors.clear();
+        runs.clear();
+
+        ARROW_RETURN_NOT_OK(output.close());
+        ARROW_ASSIGN_OR_RAISE(auto sorted, output.read());
+        DataFrame frame(std::move(sorted));
+        frame.spilled_ = true;
+        return frame;
+    }
+} // namespace TinaToolBox
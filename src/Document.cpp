@@ -21,6 +21,15 @@ namespace TinaToolBox {
     }
 
     Document::~Document() {
+        cancellationSource_.cancel();
+    }
+
+    CancellationToken Document::cancellationToken() const {
+        return cancellationSource_.token();
+    }
+
+    void Document::cancelBackgroundWork() {
+        cancellationSource_.cancel();
     }
 
     Document::State Document::getState() const {
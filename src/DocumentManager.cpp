@@ -43,6 +43,8 @@ namespace TinaToolBox {
         QString filePath = document->filePath();
         spdlog::debug("Starting to close document: {}", filePath.toStdString());
 
+        // 取消持有该文档令牌、仍在排队或运行中的后台任务
+        document->cancelBackgroundWork();
         // 发出信号前先移除文档引用
         documents_.remove(filePath);
         // 发出信号
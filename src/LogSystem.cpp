@@ -87,9 +87,10 @@ namespace TinaToolBox {
     }
 
     void LogSystem::cacheLog(const LogEntry &entry) {
-        cachedLogs_.push(entry);
-        while (cachedLogs_.size()>MAX_CACHED_LOGS) {
-            cachedLogs_.pop();
+        // 缓存已满时丢弃最旧的日志
+        while (!cachedLogs_.try_push(entry)) {
+            LogEntry oldest;
+            cachedLogs_.try_pop(oldest);
         }
     }
 
@@ -152,7 +153,6 @@ namespace TinaToolBox {
     }
 
     void LogSystem::log(const QString &message, spdlog::level::level_enum level) {
-        std::lock_guard lock(mutex_);
         LogEntry entry{
             message,
             level,
@@ -170,11 +170,21 @@ namespace TinaToolBox {
 
     QVector<LogEntry> LogSystem::getCachedLogs() {
         std::lock_guard<std::mutex> lock(mutex_);
+        // 环形队列中的日志只取出一次并追加到历史末尾，不再放回，不会与并发写入的日志交错。
+        // 两次读取之间环形队列写满时丢弃的是其中最旧的日志，此时截断后的历史恰好是环形队列的全部内容
+        std::vector<LogEntry> entries;
+        cachedLogs_.try_pop_batch(entries, MAX_CACHED_LOGS);
+        for (auto &entry: entries) {
+            logHistory_.push_back(std::move(entry));
+        }
+        while (logHistory_.size() > MAX_CACHED_LOGS) {
+            logHistory_.pop_front();
+        }
+
         QVector<LogEntry> logs;
-        auto tempQueue = cachedLogs_;  // 创建副本
-        while (!tempQueue.empty()) {
-            logs.append(tempQueue.front());
-            tempQueue.pop();
+        logs.reserve(static_cast<int>(logHistory_.size()));
+        for (const auto &entry: logHistory_) {
+            logs.append(entry);
         }
         return logs;
     }
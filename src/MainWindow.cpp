@@ -25,6 +25,7 @@
 #include "TextDocumentView.hpp"
 #include "ConfigManager.hpp"
 #include "DataFrame.hpp"
+#include "DataFrameCache.hpp"
 #include "ThemeManager.hpp"
 #include "UIConfig.hpp"
 #include <QElapsedTimer>
@@ -61,6 +62,11 @@ namespace TinaToolBox
         mainLayout->setSpacing(0);
 
         setUpUI();
+
+        // 大表格解码结果缓存到应用数据目录，再次打开时直接映射
+        DataFrameCache::getInstance().setDirectory(
+            std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdWString()) /
+            "DataFrameCache");
     }
 
     MainWindow::~MainWindow()
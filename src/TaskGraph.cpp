@@ -0,0 +1,155 @@
+#include "TaskGraph.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace TinaToolBox {
+    // 单次运行的状态，由所有在途任务共享
+    struct TaskGraph::RunState {
+        RunState(TaskGraph &graph, ThreadPool &pool, CancellationToken token)
+            : graph(graph), pool(pool), token(std::move(token)),
+              remaining_predecessors(std::make_unique<std::atomic_size_t[]>(graph.nodes_.size())),
+              remaining_nodes(graph.nodes_.size()) {
+            for (size_t i = 0; i < graph.nodes_.size(); ++i) {
+                remaining_predecessors[i] = graph.nodes_[i].predecessor_count;
+            }
+        }
+
+        TaskGraph &graph;
+        ThreadPool &pool;
+        CancellationToken token;
+        std::unique_ptr<std::atomic_size_t[]> remaining_predecessors;
+        std::atomic_size_t remaining_nodes;
+        std::atomic_bool failed{false};
+        std::mutex exception_mutex;
+        std::exception_ptr exception;
+        std::promise<void> done;
+    };
+
+    TaskGraph::Node &TaskGraph::Node::precede(Node other) {
+        graph_->addEdge(index_, other.index_);
+        return *this;
+    }
+
+    TaskGraph::Node &TaskGraph::Node::succeed(Node other) {
+        graph_->addEdge(other.index_, index_);
+        return *this;
+    }
+
+    void TaskGraph::addEdge(size_t from, size_t to) {
+        if (from >= nodes_.size() || to >= nodes_.size()) {
+            throw std::out_of_range("TaskGraph node does not belong to this graph");
+        }
+        nodes_[from].successors.push_back(to);
+        ++nodes_[to].predecessor_count;
+    }
+
+    void TaskGraph::checkAcyclic() const {
+        // Kahn 拓扑排序：能被依次移除的节点数少于总数说明存在环
+        std::vector<size_t> in_degree(nodes_.size());
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            in_degree[i] = nodes_[i].predecessor_count;
+            if (in_degree[i] == 0) {
+                ready.push_back(i);
+            }
+        }
+
+        size_t visited = 0;
+        while (!ready.empty()) {
+            size_t index = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (size_t successor: nodes_[index].successors) {
+                if (--in_degree[successor] == 0) {
+                    ready.push_back(successor);
+                }
+            }
+        }
+
+        if (visited != nodes_.size()) {
+            throw std::logic_error("TaskGraph contains a cycle");
+        }
+    }
+
+    std::future<void> TaskGraph::run(ThreadPool &pool) {
+        return run(pool, CancellationToken());
+    }
+
+    std::future<void> TaskGraph::run(ThreadPool &pool, CancellationToken token) {
+        checkAcyclic();
+
+        auto state = std::make_shared<RunState>(*this, pool, std::move(token));
+        auto future = state->done.get_future();
+        if (nodes_.empty()) {
+            state->done.set_value();
+            return future;
+        }
+
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            if (nodes_[i].predecessor_count == 0) {
+                schedule(state, i);
+            }
+        }
+        return future;
+    }
+
+    void TaskGraph::schedule(const std::shared_ptr<RunState> &state, size_t index) {
+        state->pool.post([state, index] {
+            execute(state, index);
+        }, state->graph.nodes_[index].priority);
+    }
+
+    void TaskGraph::execute(const std::shared_ptr<RunState> &state, size_t index) {
+        // 第一个就绪的后继直接在当前线程继续执行，保持数据局部性，其余后继投递到线程池
+        while (true) {
+            const auto &node = state->graph.nodes_[index];
+            if (!state->failed && state->token.isCancelled()) {
+                std::lock_guard<std::mutex> lock(state->exception_mutex);
+                if (!state->exception) {
+                    state->exception = std::make_exception_ptr(TaskCancelledException());
+                }
+                state->failed = true;
+            }
+            if (!state->failed) {
+                try {
+                    node.work();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state->exception_mutex);
+                    if (!state->exception) {
+                        state->exception = std::current_exception();
+                    }
+                    state->failed = true;
+                }
+            }
+
+            bool has_next = false;
+            size_t next = 0;
+            for (size_t successor: node.successors) {
+                if (--state->remaining_predecessors[successor] == 0) {
+                    if (!has_next) {
+                        next = successor;
+                        has_next = true;
+                    } else {
+                        schedule(state, successor);
+                    }
+                }
+            }
+
+            if (--state->remaining_nodes == 0) {
+                if (state->exception) {
+                    state->done.set_exception(state->exception);
+                } else {
+                    state->done.set_value();
+                }
+            }
+
+            if (!has_next) {
+                return;
+            }
+            index = next;
+        }
+    }
+} // namespace TinaToolBox
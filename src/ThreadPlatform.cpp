@@ -0,0 +1,235 @@
+#include "ThreadPlatform.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <cctype>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <dirent.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#endif
+
+namespace TinaToolBox {
+    namespace {
+        std::vector<int> allCpus() {
+            std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+            for (size_t i = 0; i < cpus.size(); ++i) {
+                cpus[i] = static_cast<int>(i);
+            }
+            return cpus;
+        }
+
+#ifdef __linux__
+        // 解析 sysfs 的 cpulist 格式，例如 "0-3,8-11"
+        std::vector<int> parseCpuList(const std::string &text) {
+            std::vector<int> cpus;
+            std::stringstream stream(text);
+            std::string range;
+            while (std::getline(stream, range, ',')) {
+                if (range.empty() || range == "\n") {
+                    continue;
+                }
+                const auto dash = range.find('-');
+                try {
+                    const int first = std::stoi(range.substr(0, dash));
+                    const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                    for (int cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(cpu);
+                    }
+                } catch (const std::exception &) {
+                    return {};
+                }
+            }
+            return cpus;
+        }
+#endif
+
+#ifdef _WIN32
+        unsigned __stdcall threadEntry(void *arg) {
+#else
+        void *threadEntry(void *arg) {
+#endif
+            std::unique_ptr<std::function<void()> > body(static_cast<std::function<void()> *>(arg));
+            (*body)();
+#ifdef _WIN32
+            return 0;
+#else
+            return nullptr;
+#endif
+        }
+    }
+
+    std::vector<NumaNode> ThreadPlatform::numaNodes() {
+        std::vector<NumaNode> nodes;
+#ifdef _WIN32
+        ULONG highest = 0;
+        if (GetNumaHighestNodeNumber(&highest)) {
+            for (USHORT node = 0; node <= highest; ++node) {
+                GROUP_AFFINITY affinity{};
+                if (!GetNumaNodeProcessorMaskEx(node, &affinity) || affinity.Mask == 0) {
+                    continue;
+                }
+                NumaNode numa_node;
+                numa_node.id = node;
+                for (int bit = 0; bit < 64; ++bit) {
+                    if (affinity.Mask & (KAFFINITY(1) << bit)) {
+                        numa_node.cpus.push_back(affinity.Group * 64 + bit);
+                    }
+                }
+                nodes.push_back(std::move(numa_node));
+            }
+        }
+#elif defined(__linux__)
+        if (DIR *dir = opendir("/sys/devices/system/node")) {
+            while (dirent *entry = readdir(dir)) {
+                const std::string name = entry->d_name;
+                if (name.rfind("node", 0) != 0 || name.size() <= 4 ||
+                    !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+                    continue;
+                }
+                std::ifstream cpulist("/sys/devices/system/node/" + name + "/cpulist");
+                std::string text;
+                std::getline(cpulist, text);
+                NumaNode numa_node;
+                numa_node.id = std::stoi(name.substr(4));
+                numa_node.cpus = parseCpuList(text);
+                if (!numa_node.cpus.empty()) {
+                    nodes.push_back(std::move(numa_node));
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(nodes.begin(), nodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+#endif
+        if (nodes.empty()) {
+            nodes.push_back(NumaNode{0, allCpus()});
+        }
+        return nodes;
+    }
+
+    bool ThreadPlatform::setCurrentThreadAffinity(const std::vector<int> &cpus) {
+        if (cpus.empty()) {
+            return false;
+        }
+#ifdef _WIN32
+        // Windows 的线程亲和性只能落在一个处理器组内，取第一个 CPU 所在的组
+        GROUP_AFFINITY affinity{};
+        affinity.Group = static_cast<WORD>(cpus.front() / 64);
+        for (int cpu: cpus) {
+            if (cpu / 64 == affinity.Group) {
+                affinity.Mask |= KAFFINITY(1) << (cpu % 64);
+            }
+        }
+        return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu: cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool ThreadPlatform::setCurrentThreadName(const std::string &name) {
+#ifdef _WIN32
+        const int length = MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, nullptr, 0);
+        std::wstring wide(static_cast<size_t>(std::max(length, 1)), L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, wide.data(), length);
+        return SUCCEEDED(SetThreadDescription(GetCurrentThread(), wide.c_str()));
+#elif defined(__APPLE__)
+        return pthread_setname_np(name.substr(0, 63).c_str()) == 0;
+#elif defined(__linux__)
+        return pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()) == 0;
+#else
+        return false;
+#endif
+    }
+
+    NativeThread::NativeThread(std::function<void()> body, size_t stack_size) {
+        auto arg = std::make_unique<std::function<void()> >(std::move(body));
+#ifdef _WIN32
+        const auto handle = _beginthreadex(nullptr, static_cast<unsigned>(stack_size), &threadEntry, arg.get(),
+                                           stack_size ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0, nullptr);
+        if (handle == 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to create thread");
+        }
+        handle_ = reinterpret_cast<void *>(handle);
+#else
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (stack_size > 0) {
+            // 栈大小不能小于系统下限，并按页对齐
+            const long page = sysconf(_SC_PAGESIZE) > 0 ? sysconf(_SC_PAGESIZE) : 4096;
+            stack_size = std::max<size_t>(stack_size, PTHREAD_STACK_MIN);
+            stack_size = (stack_size + page - 1) / page * page;
+            pthread_attr_setstacksize(&attr, stack_size);
+        }
+        const int error = pthread_create(&thread_, &attr, &threadEntry, arg.get());
+        pthread_attr_destroy(&attr);
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(), "Failed to create thread");
+        }
+#endif
+        arg.release();
+        joinable_ = true;
+    }
+
+    NativeThread::NativeThread(NativeThread &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    NativeThread &NativeThread::operator=(NativeThread &&other) noexcept {
+        if (this != &other) {
+            if (joinable_) {
+                std::terminate();
+            }
+#ifdef _WIN32
+            handle_ = other.handle_;
+            other.handle_ = nullptr;
+#else
+            thread_ = other.thread_;
+#endif
+            joinable_ = other.joinable_;
+            other.joinable_ = false;
+        }
+        return *this;
+    }
+
+    NativeThread::~NativeThread() {
+        // 与 std::thread 相同：销毁仍可 join 的线程是编程错误
+        if (joinable_) {
+            std::terminate();
+        }
+    }
+
+    void NativeThread::join() {
+        if (!joinable_) {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "Thread is not joinable");
+        }
+#ifdef _WIN32
+        WaitForSingleObject(handle_, INFINITE);
+        CloseHandle(handle_);
+        handle_ = nullptr;
+#else
+        pthread_join(thread_, nullptr);
+#endif
+        joinable_ = false;
+    }
+} // namespace TinaToolBox
@@ -1,42 +1,425 @@
 #include "ThreadPool.hpp"
 
 namespace TinaToolBox {
-    void ThreadPool::workerThread() {
-        while (is_active_) {
-            Task task;
-            bool got_task = false;
-            
-            {
-                std::unique_lock<std::mutex> lock(all_tasks_done_mutex_);
-                if (!task_queue_.empty()) {
-                    got_task = task_queue_.try_pop(task);
-                    if (got_task) {
-                        ++active_tasks_;
-                    }
-                } else if (is_active_) {
-                    cv_all_tasks_done_.wait_for(lock, std::chrono::microseconds(100));
-                    continue;
+    namespace {
+        // 记录当前线程所属的线程池及工作线程序号，用于把工作线程内部提交的任务放入本地队列
+        thread_local const ThreadPool *current_pool = nullptr;
+        thread_local size_t current_worker = 0;
+
+        // 标记一次进行中的提交。先登记再检查 is_active_，shutdown 先清除 is_active_ 再等待登记数归零，
+        // 两者都是顺序一致的原子操作，因此提交要么看到池已关闭而放弃，要么在 shutdown 清空队列之前完成入队
+        class SubmitGuard {
+        public:
+            explicit SubmitGuard(std::atomic_size_t &submitting) : submitting_(submitting) { ++submitting_; }
+            ~SubmitGuard() { --submitting_; }
+
+            SubmitGuard(const SubmitGuard &) = delete;
+            SubmitGuard &operator=(const SubmitGuard &) = delete;
+
+        private:
+            std::atomic_size_t &submitting_;
+        };
+
+        ThreadPool::Config legacyConfig(size_t threads, ThreadPool::SchedulingMode mode) {
+            ThreadPool::Config config;
+            config.thread_count = threads == 0 ? 1 : threads;
+            config.mode = mode;
+            return config;
+        }
+    }
+
+    ThreadPool::ThreadPool(size_t threads, SchedulingMode mode)
+        : ThreadPool(legacyConfig(threads, mode)) {
+    }
+
+    ThreadPool::ThreadPool(const Config &config) : mode_(config.mode), telemetry_enabled_(config.telemetry) {
+        size_t threads = config.thread_count;
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (mode_ == SchedulingMode::WorkStealing) {
+            local_queues_.reserve(threads);
+            for (size_t i = 0; i < threads; ++i) {
+                local_queues_.push_back(std::make_unique<WorkerQueue>());
+            }
+        }
+        worker_count_ = threads;
+        planWorkerPlacement(config);
+        telemetry_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            telemetry_.push_back(std::make_unique<WorkerTelemetry>());
+        }
+
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i] { workerThread(i); }, config.stack_size);
+        }
+    }
+
+    void ThreadPool::planWorkerPlacement(const Config &config) {
+        worker_cpus_.assign(worker_count_, {});
+        worker_names_.assign(worker_count_, {});
+
+        if (!config.affinity.empty()) {
+            for (size_t i = 0; i < worker_count_; ++i) {
+                worker_cpus_[i] = config.affinity[i % config.affinity.size()];
+            }
+        } else if (config.numa_aware) {
+            // 按各节点的 CPU 数成比例分配线程，同一节点的线程序号连续
+            const auto nodes = ThreadPlatform::numaNodes();
+            size_t total_cpus = 0;
+            for (const auto &node: nodes) {
+                total_cpus += node.cpus.size();
+            }
+            size_t worker = 0;
+            size_t cpus_before = 0;
+            for (const auto &node: nodes) {
+                cpus_before += node.cpus.size();
+                const size_t node_end = worker_count_ * cpus_before / total_cpus;
+                for (; worker < node_end; ++worker) {
+                    worker_cpus_[worker] = node.cpus;
+                }
+            }
+        }
+
+        if (!config.thread_name_prefix.empty()) {
+            for (size_t i = 0; i < worker_count_; ++i) {
+                worker_names_[i] = config.thread_name_prefix + "-" + std::to_string(i);
+            }
+        }
+    }
+
+    void ThreadPool::enqueue(Task &&task) {
+        SubmitGuard guard(submitting_);
+        if (!is_active_) {
+            return;
+        }
+
+        if (!task.func.isInline()) {
+            ++stats_.task_heap_allocations;
+        }
+        if (telemetry_enabled_) {
+            task.enqueue_ticks = CycleClock::now();
+        }
+
+        ++pending_tasks_;
+        if (mode_ == SchedulingMode::SharedQueue) {
+            task_queue_.push(std::move(task));
+            idle_workers_.notifyOne();
+            return;
+        }
+
+        // 工作线程内部提交的任务进入自己的本地队列，外部提交的任务轮询分发
+        const size_t index = current_pool == this
+                                 ? current_worker
+                                 : next_queue_.fetch_add(1, std::memory_order_relaxed) % local_queues_.size();
+        const auto lane = static_cast<size_t>(task.priority);
+        auto &queue = *local_queues_[index];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.lanes[lane].push_back(std::move(task));
+            queue.lane_sizes[lane].fetch_add(1, std::memory_order_release);
+        }
+        idle_workers_.notifyOne();
+    }
+
+    void ThreadPool::enqueueBatch(std::vector<Task> &tasks) {
+        SubmitGuard guard(submitting_);
+        if (!is_active_ || tasks.empty()) {
+            return;
+        }
+
+        const auto now = telemetry_enabled_ ? CycleClock::now() : 0;
+        for (auto &task: tasks) {
+            if (!task.func.isInline()) {
+                ++stats_.task_heap_allocations;
+            }
+            task.enqueue_ticks = now;
+        }
+
+        const size_t count = tasks.size();
+        pending_tasks_ += count;
+        if (mode_ == SchedulingMode::SharedQueue) {
+            task_queue_.push_batch(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+        } else if (current_pool == this) {
+            // 工作线程内部提交的整批任务进入自己的本地队列，其他线程再按需窃取
+            auto &queue = *local_queues_[current_worker];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            for (auto &task: tasks) {
+                const auto lane = static_cast<size_t>(task.priority);
+                queue.lanes[lane].push_back(std::move(task));
+                queue.lane_sizes[lane].fetch_add(1, std::memory_order_release);
+            }
+        } else {
+            // 外部提交时把整批切成连续的若干段分给各个工作线程，每个队列只加一次锁
+            const size_t queue_count = local_queues_.size();
+            const size_t first_queue = next_queue_.fetch_add(1, std::memory_order_relaxed);
+            const size_t slice = (tasks.size() + queue_count - 1) / queue_count;
+            for (size_t offset = 0, q = 0; offset < tasks.size(); offset += slice, ++q) {
+                auto &queue = *local_queues_[(first_queue + q) % queue_count];
+                const size_t slice_end = std::min(tasks.size(), offset + slice);
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                for (size_t i = offset; i < slice_end; ++i) {
+                    const auto lane = static_cast<size_t>(tasks[i].priority);
+                    queue.lanes[lane].push_back(std::move(tasks[i]));
+                    queue.lane_sizes[lane].fetch_add(1, std::memory_order_release);
                 }
             }
+        }
+        tasks.clear();
+
+        if (count > 1) {
+            idle_workers_.notifyAll();
+        } else {
+            idle_workers_.notifyOne();
+        }
+    }
+
+    bool ThreadPool::popBatch(size_t worker_index, std::vector<Task> &batch) {
+        if (mode_ == SchedulingMode::SharedQueue) {
+            // 每次最多取走队列中属于自己的那一份，避免一个线程囤积任务而其他线程空闲；
+            // 批内任务按优先级顺序取出，新到的高优先级任务最多等待当前这一小批。份额在队列内同一次加锁中计算
+            return task_queue_.try_pop_batch(batch, BATCH_SIZE, worker_count_) > 0;
+        }
+
+        // 工作窃取模式下任务保留在可被窃取的本地队列里，批量体现在窃取一侧
+        batch.emplace_back();
+        if (popTask(worker_index, batch.back())) {
+            return true;
+        }
+        batch.clear();
+        return false;
+    }
+
+    bool ThreadPool::popTask(size_t worker_index, Task &task) {
+        if (mode_ == SchedulingMode::SharedQueue) {
+            return task_queue_.try_pop(task);
+        }
 
-            if (got_task) {
-                auto start = std::chrono::steady_clock::now();
-                try {
-                    task.func();
-                } catch (...) {
-                    task.exception = std::current_exception();
+        // 按优先级从高到低：先取本地通道（后进先出，缓存友好），再从其他线程的同级通道窃取
+        auto &own = *local_queues_[worker_index];
+        for (size_t lane = PRIORITY_LEVELS; lane-- > 0;) {
+            if (own.lane_sizes[lane].load(std::memory_order_acquire) > 0) {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                auto &deque = own.lanes[lane];
+                if (!deque.empty()) {
+                    deque.pop_back(task);
+                    own.lane_sizes[lane].fetch_sub(1, std::memory_order_release);
+                    return true;
                 }
-                auto end = std::chrono::steady_clock::now();
-                stats_.total_task_time += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-                
+            }
+            if (stealTask(worker_index, lane, task)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ThreadPool::stealTask(size_t thief_index, size_t lane, Task &task) {
+        const size_t count = local_queues_.size();
+        auto &own = *local_queues_[thief_index];
+        auto &stolen = own.steal_buffer;
+        for (size_t offset = 1; offset < count; ++offset) {
+            auto &victim = *local_queues_[(thief_index + offset) % count];
+            if (victim.lane_sizes[lane].load(std::memory_order_acquire) == 0) {
+                continue;
+            }
+            {
+                // 窃取方从队首（最早提交的一端）取任务，与所有者错开；
+                // 一次拿走约一半（不超过 BATCH_SIZE），减少后续窃取次数
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                auto &deque = victim.lanes[lane];
+                const size_t available = victim.lane_sizes[lane].load(std::memory_order_relaxed);
+                const size_t take = std::min(BATCH_SIZE, (available + 1) / 2);
+                for (size_t i = 0; i < take && !deque.empty(); ++i) {
+                    stolen.emplace_back();
+                    deque.pop_front(stolen.back());
+                }
+                victim.lane_sizes[lane].fetch_sub(stolen.size(), std::memory_order_release);
+            }
+            if (stolen.empty()) {
+                continue;
+            }
+
+            task = std::move(stolen.front());
+            if (stolen.size() > 1) {
+                // 其余任务放入自己的本地队列，其他空闲线程仍可以再从这里窃取
                 {
-                    std::unique_lock<std::mutex> lock(all_tasks_done_mutex_);
-                    --active_tasks_;
-                    if (waiting_for_all_ && active_tasks_ == 0 && task_queue_.empty()) {
-                        cv_all_tasks_done_.notify_all();
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    for (size_t i = stolen.size(); i-- > 1;) {
+                        own.lanes[lane].push_back(std::move(stolen[i]));
                     }
+                    own.lane_sizes[lane].fetch_add(stolen.size() - 1, std::memory_order_release);
                 }
+                idle_workers_.notifyOne();
+            }
+            stolen.clear();
+            return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::runTask(Task &task, WorkerTelemetry &telemetry) {
+        // 取消与超时在出队时检查：丢弃任务只需销毁可调用对象，future 端会收到 TaskCancelledException
+        if (task.isAbandoned()) {
+            task.func.reset();
+            ++stats_.tasks_cancelled;
+            finishTask();
+            return;
+        }
+
+        const auto start = CycleClock::now();
+        try {
+            task.func();
+        } catch (...) {
+            task.exception = std::current_exception();
+        }
+        const auto end = CycleClock::now();
+        task.func.reset();
+
+        // 遥测只写本线程独占的数据，开销为几次 relaxed 读写，加上入队时的一次 CycleClock::now()
+        const auto run_ns = static_cast<std::uint64_t>(static_cast<double>(end - start) * ns_per_tick_);
+        if (telemetry_enabled_) {
+            // 入队和执行可能在不同核心上打点，TSC 存在微小偏差时截断为 0
+            const auto wait_ns = start > task.enqueue_ticks
+                                     ? static_cast<std::uint64_t>(static_cast<double>(start - task.enqueue_ticks) * ns_per_tick_)
+                                     : 0;
+            const auto lane = static_cast<size_t>(task.priority);
+            telemetry.queue_wait[lane].record(wait_ns);
+            telemetry.run_time[lane].record(run_ns);
+            telemetry.tasks_run.store(telemetry.tasks_run.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            telemetry.busy_ns.store(telemetry.busy_ns.load(std::memory_order_relaxed) + run_ns, std::memory_order_relaxed);
+            if (--telemetry.depth_sample_countdown == 0) {
+                telemetry.depth_sample_countdown = DEPTH_SAMPLE_INTERVAL;
+                telemetry.queue_depth.record(pending_tasks_.load(std::memory_order_relaxed));
+            }
+        }
+        stats_.total_task_time += run_ns;
+
+        finishTask();
+    }
+
+    void ThreadPool::finishTask() {
+        if (--pending_tasks_ == 0 && waiters_ > 0) {
+            std::lock_guard<std::mutex> lock(all_tasks_done_mutex_);
+            cv_all_tasks_done_.notify_all();
+        }
+    }
+
+    void ThreadPool::workerThread(size_t worker_index) {
+        current_pool = this;
+        current_worker = worker_index;
+        if (!worker_cpus_[worker_index].empty()) {
+            ThreadPlatform::setCurrentThreadAffinity(worker_cpus_[worker_index]);
+        }
+        if (!worker_names_[worker_index].empty()) {
+            ThreadPlatform::setCurrentThreadName(worker_names_[worker_index]);
+        }
+
+        auto &telemetry = *telemetry_[worker_index];
+        std::vector<Task> batch;
+        batch.reserve(mode_ == SchedulingMode::SharedQueue ? BATCH_SIZE : 1);
+        auto run_batch = [this, &batch, &telemetry] {
+            for (auto &task: batch) {
+                if (!is_active_) {
+                    break;
+                }
+                runTask(task, telemetry);
+            }
+            // 关闭时尚未执行的任务随 batch 一起销毁，其 future 收到 TaskCancelledException
+            batch.clear();
+        };
+
+        int idle_rounds = 0;
+        while (is_active_) {
+            if (popBatch(worker_index, batch)) {
+                run_batch();
+                idle_rounds = 0;
+                continue;
+            }
+
+            if (idle_rounds < IDLE_SPIN_ROUNDS) {
+                ++idle_rounds;
+                std::this_thread::yield();
+                continue;
+            }
+
+            // 先登记为等待者再检查一次队列，之后提交的任务一定会唤醒本线程
+            auto key = idle_workers_.prepareWait();
+            if (!is_active_) {
+                idle_workers_.cancelWait();
+                break;
+            }
+            if (popBatch(worker_index, batch)) {
+                idle_workers_.cancelWait();
+                run_batch();
+                idle_rounds = 0;
+                continue;
+            }
+            idle_workers_.commitWait(key);
+        }
+
+        current_pool = nullptr;
+    }
+
+    ThreadPool::TelemetrySnapshot ThreadPool::telemetry() const {
+        TelemetrySnapshot snapshot;
+        snapshot.uptime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time_);
+        snapshot.shared_queue_locks = task_queue_.lockCount();
+        snapshot.workers.reserve(telemetry_.size());
+        for (const auto &worker: telemetry_) {
+            for (size_t lane = 0; lane < PRIORITY_LEVELS; ++lane) {
+                snapshot.queue_wait[lane] += worker->queue_wait[lane].snapshot();
+                snapshot.run_time[lane] += worker->run_time[lane].snapshot();
+            }
+            snapshot.queue_depth += worker->queue_depth.snapshot();
+
+            TelemetrySnapshot::Worker info;
+            info.tasks_run = worker->tasks_run.load(std::memory_order_relaxed);
+            info.busy_time = std::chrono::nanoseconds(worker->busy_ns.load(std::memory_order_relaxed));
+            info.utilization = snapshot.uptime.count() > 0
+                                   ? static_cast<double>(info.busy_time.count()) / snapshot.uptime.count()
+                                   : 0.0;
+            snapshot.workers.push_back(info);
+        }
+        return snapshot;
+    }
+
+    void ThreadPool::waitForAll() {
+        std::unique_lock<std::mutex> lock(all_tasks_done_mutex_);
+        ++waiters_;
+        while (pending_tasks_ > 0 && is_active_) {
+            cv_all_tasks_done_.wait(lock);
+        }
+        --waiters_;
+    }
+
+    void ThreadPool::shutdown() {
+        is_active_ = false;
+        // 等待已经通过 is_active_ 检查的提交完成入队，之后不会再有任务进入队列，
+        // 清空队列和最后重置 pending_tasks_ 都不会与入队交错
+        while (submitting_ > 0) {
+            std::this_thread::yield();
+        }
+        task_queue_.clear();
+        for (auto &queue: local_queues_) {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            for (size_t lane = 0; lane < PRIORITY_LEVELS; ++lane) {
+                queue->lanes[lane].clear();
+                queue->lane_sizes[lane] = 0;
+            }
+        }
+        idle_workers_.notifyAll();
+        {
+            std::lock_guard<std::mutex> lock(all_tasks_done_mutex_);
+            cv_all_tasks_done_.notify_all();
+        }
+
+        for (auto &worker: workers_) {
+            if (worker.joinable()) {
+                worker.join();
             }
         }
+        pending_tasks_ = 0;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,39 @@
+#include "ThreadPoolGroup.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace TinaToolBox {
+    ThreadPoolGroup::ThreadPoolGroup(const ThreadPool::Config &base) : nodes_(ThreadPlatform::numaNodes()) {
+        size_t total_cpus = 0;
+        for (const auto &node: nodes_) {
+            total_cpus += node.cpus.size();
+        }
+
+        pools_.reserve(nodes_.size());
+        for (const auto &node: nodes_) {
+            ThreadPool::Config config = base;
+            config.affinity = {node.cpus};
+            config.numa_aware = false;
+            config.thread_count = base.thread_count == 0
+                                      ? node.cpus.size()
+                                      : std::max<size_t>(1, base.thread_count * node.cpus.size() / total_cpus);
+            if (!base.thread_name_prefix.empty()) {
+                config.thread_name_prefix = base.thread_name_prefix + "-n" + std::to_string(node.id);
+            }
+            pools_.push_back(std::make_unique<ThreadPool>(config));
+        }
+    }
+
+    void ThreadPoolGroup::waitForAll() {
+        for (auto &pool: pools_) {
+            pool->waitForAll();
+        }
+    }
+
+    void ThreadPoolGroup::shutdown() {
+        for (auto &pool: pools_) {
+            pool->shutdown();
+        }
+    }
+} // namespace TinaToolBox
@@ -0,0 +1,676 @@
+#include "XlsxStreamReader.hpp"
+#include "XmlSaxParser.hpp"
+
+#include <charconv>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace TinaToolBox {
+    namespace {
+        std::string_view trim(std::string_view text) {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r' ||
+                                     text.front() == '\n')) {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r' ||
+                                     text.back() == '\n')) {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        template<typename T>
+        bool parseNumber(std::string_view text, T &value) {
+            text = trim(text);
+            if (!text.empty() && text.front() == '+') {
+                text.remove_prefix(1);
+            }
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc() && end == text.data() + text.size() && !text.empty();
+        }
+
+        bool parseBool(std::string_view text) {
+            text = trim(text);
+            return text == "1" || text == "true";
+        }
+
+        // 还原 Excel 在文本中用 _xHHHH_ 表示的字符（XML 不允许的控制字符，以及转义为 _x005F_ 的下划线），
+        // 只处理 data 从 start 开始的部分
+        void decodeEscapes(std::string &data, size_t start) {
+            size_t read = data.find("_x", start);
+            if (read == std::string::npos) {
+                return;
+            }
+            size_t write = read;
+            while (read < data.size()) {
+                std::uint32_t code = 0;
+                if (data[read] == '_' && read + 6 < data.size() && data[read + 1] == 'x' && data[read + 6] == '_') {
+                    const char *begin = data.data() + read + 2;
+                    const auto [end, error] = std::from_chars(begin, begin + 4, code, 16);
+                    if (error == std::errc() && end == begin + 4) {
+                        // 按 UTF-8 写回，结果不会比 7 个字节的转义序列长
+                        if (code < 0x80) {
+                            data[write++] = static_cast<char>(code);
+                        } else if (code < 0x800) {
+                            data[write++] = static_cast<char>(0xC0 | (code >> 6));
+                            data[write++] = static_cast<char>(0x80 | (code & 0x3F));
+                        } else {
+                            data[write++] = static_cast<char>(0xE0 | (code >> 12));
+                            data[write++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                            data[write++] = static_cast<char>(0x80 | (code & 0x3F));
+                        }
+                        read += 7;
+                        continue;
+                    }
+                }
+                data[write++] = data[read++];
+            }
+            data.resize(write);
+        }
+
+        // 按块解压并解析压缩包中的一个 XML 条目
+        template<typename Handler, typename Progress>
+        void parseEntry(const ZipArchive &archive, const ZipArchive::Entry &entry, Handler &handler,
+                        const Progress &on_progress) {
+            auto reader = archive.open(entry);
+            XmlSaxParser<Handler> parser(handler);
+            std::vector<char> block(64 * 1024);
+            while (const size_t n = reader->read(block.data(), block.size())) {
+                parser.feed(block.data(), n);
+                on_progress(reader->uncompressedBytesRead());
+                if (handler.done) {
+                    return;
+                }
+            }
+            parser.finish();
+        }
+
+        template<typename Handler>
+        void parseEntry(const ZipArchive &archive, const std::string &path, Handler &handler) {
+            const ZipArchive::Entry *entry = archive.find(path);
+            if (!entry) {
+                throw std::runtime_error("Missing part in xlsx package: " + path);
+            }
+            parseEntry(archive, *entry, handler, [](std::uint64_t) {});
+        }
+
+        // 把关系文件中的相对 Target 解析为压缩包内的绝对路径
+        std::string resolvePath(const std::string &base_dir, std::string_view target) {
+            std::string joined = !target.empty() && target.front() == '/'
+                                     ? std::string(target.substr(1))
+                                     : base_dir + std::string(target);
+            std::vector<std::string> parts;
+            size_t pos = 0;
+            while (pos <= joined.size()) {
+                auto slash = joined.find('/', pos);
+                if (slash == std::string::npos) {
+                    slash = joined.size();
+                }
+                const std::string part = joined.substr(pos, slash - pos);
+                if (part == "..") {
+                    if (!parts.empty()) {
+                        parts.pop_back();
+                    }
+                } else if (!part.empty() && part != ".") {
+                    parts.push_back(part);
+                }
+                pos = slash + 1;
+            }
+            std::string result;
+            for (const auto &part: parts) {
+                if (!result.empty()) {
+                    result += '/';
+                }
+                result += part;
+            }
+            return result;
+        }
+
+        bool endsWith(std::string_view text, std::string_view suffix) {
+            return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+        }
+
+        struct RelationshipsHandler {
+            struct Relationship {
+                std::string id;
+                std::string type;
+                std::string target;
+            };
+
+            std::vector<Relationship> relationships;
+            bool done = false;
+
+            void startElement(std::string_view name, const XmlAttributes &attributes) {
+                if (name == "Relationship") {
+                    relationships.push_back({std::string(attributes.get("Id")), std::string(attributes.get("Type")),
+                                             std::string(attributes.get("Target"))});
+                }
+            }
+
+            void endElement(std::string_view) {}
+
+            void characters(std::string_view) {}
+
+            [[nodiscard]] const Relationship *findType(std::string_view suffix) const {
+                for (const auto &relationship: relationships) {
+                    if (endsWith(relationship.type, suffix)) {
+                        return &relationship;
+                    }
+                }
+                return nullptr;
+            }
+        };
+
+        struct WorkbookHandler {
+            // 工作表名称和关系 Id
+            std::vector<std::pair<std::string, std::string> > sheets;
+            size_t active_tab = 0;
+            bool has_view = false;
+            bool date1904 = false;
+            bool done = false;
+
+            void startElement(std::string_view name, const XmlAttributes &attributes) {
+                if (name == "sheet") {
+                    sheets.emplace_back(std::string(attributes.get("name")), std::string(attributes.get("id")));
+                } else if (name == "workbookPr") {
+                    date1904 = parseBool(attributes.get("date1904"));
+                } else if (name == "workbookView" && !has_view) {
+                    has_view = true;
+                    parseNumber(attributes.get("activeTab"), active_tab);
+                }
+            }
+
+            void endElement(std::string_view) {}
+
+            void characters(std::string_view) {}
+        };
+
+        struct SharedStringsHandler {
+            std::string &data;
+            std::vector<std::pair<size_t, std::uint32_t> > &offsets;
+            size_t item_start = 0;
+            int phonetic_depth = 0;
+            bool in_item = false;
+            bool in_text = false;
+            bool done = false;
+
+            void startElement(std::string_view name, const XmlAttributes &attributes) {
+                if (name == "si") {
+                    in_item = true;
+                    item_start = data.size();
+                } else if (name == "t" && in_item && phonetic_depth == 0) {
+                    in_text = true;
+                } else if (name == "rPh") {
+                    // 注音文字不属于单元格的显示文本
+                    ++phonetic_depth;
+                } else if (name == "sst") {
+                    size_t count = 0;
+                    if (parseNumber(attributes.get("uniqueCount"), count)) {
+                        offsets.reserve(count);
+                    }
+                }
+            }
+
+            void endElement(std::string_view name) {
+                if (name == "t") {
+                    in_text = false;
+                } else if (name == "rPh") {
+                    --phonetic_depth;
+                } else if (name == "si") {
+                    in_item = false;
+                    decodeEscapes(data, item_start);
+                    offsets.emplace_back(item_start, static_cast<std::uint32_t>(data.size() - item_start));
+                }
+            }
+
+            void characters(std::string_view text) {
+                if (in_text) {
+                    data.append(text);
+                }
+            }
+        };
+
+        struct StylesHandler {
+            std::unordered_map<std::uint32_t, std::string> custom_formats;
+            std::vector<std::uint32_t> cell_formats;
+            bool in_cell_xfs = false;
+            bool done = false;
+
+            void startElement(std::string_view name, const XmlAttributes &attributes) {
+                if (name == "numFmt") {
+                    std::uint32_t id = 0;
+                    if (parseNumber(attributes.get("numFmtId"), id)) {
+                        custom_formats[id] = std::string(attributes.get("formatCode"));
+                    }
+                } else if (name == "cellXfs") {
+                    in_cell_xfs = true;
+                } else if (name == "xf" && in_cell_xfs) {
+                    std::uint32_t id = 0;
+                    parseNumber(attributes.get("numFmtId"), id);
+                    cell_formats.push_back(id);
+                }
+            }
+
+            void endElement(std::string_view name) {
+                if (name == "cellXfs") {
+                    in_cell_xfs = false;
+                }
+            }
+
+            void characters(std::string_view) {}
+        };
+
+        struct DimensionHandler {
+            XlsxStreamReader::Dimension dimension;
+            bool done = false;
+
+            void startElement(std::string_view name, const XmlAttributes &attributes) {
+                if (name == "dimension") {
+                    std::string_view ref = attributes.get("ref");
+                    const auto colon = ref.find(':');
+                    if (colon != std::string_view::npos) {
+                        ref = ref.substr(colon + 1);
+                    }
+                    const std::int64_t column = XlsxStreamReader::columnFromReference(ref);
+                    size_t digits = 0;
+                    while (digits < ref.size() && !(ref[digits] >= '0' && ref[digits] <= '9')) {
+                        ++digits;
+                    }
+                    std::uint32_t row = 0;
+                    if (column >= 0 && parseNumber(ref.substr(digits), row)) {
+                        dimension.columns = static_cast<std::uint32_t>(column + 1);
+                        dimension.rows = row;
+                    }
+                } else if (name == "sheetData") {
+                    done = true;
+                }
+            }
+
+            void endElement(std::string_view) {}
+
+            void characters(std::string_view) {}
+        };
+
+        struct SheetHandler {
+            using Cell = XlsxStreamReader::Cell;
+
+            SheetHandler(const XlsxStreamReader::RowCallback &on_row, const std::vector<bool> &date_styles)
+                : on_row(on_row), date_styles(date_styles) {}
+
+            const XlsxStreamReader::RowCallback &on_row;
+            const std::vector<bool> &date_styles;
+
+            std::vector<Cell> cells;
+            // 本行 String/Error 单元格的文本，行结束时才生成视图
+            std::string row_text;
+            std::vector<std::pair<size_t, size_t> > text_spans;
+            std::string value;
+
+            std::uint64_t row = 0;
+            std::uint32_t next_column = 0;
+            std::uint32_t column = 0;
+            std::string cell_type;
+            std::uint32_t style = 0;
+            int phonetic_depth = 0;
+            bool in_row = false;
+            bool in_cell = false;
+            bool in_value = false;
+            bool in_inline = false;
+            bool has_value = false;
+            bool done = false;
+
+            void startElement(std::string_view name, const XmlAttributes &attributes) {
+                if (name == "c" && in_row) {
+                    const std::int64_t referenced = XlsxStreamReader::columnFromReference(attributes.get("r"));
+                    column = referenced >= 0 ? static_cast<std::uint32_t>(referenced) : next_column;
+                    cell_type.assign(attributes.get("t"));
+                    style = 0;
+                    parseNumber(attributes.get("s"), style);
+                    value.clear();
+                    in_cell = true;
+                    has_value = false;
+                } else if (name == "v" && in_cell) {
+                    in_value = true;
+                    has_value = true;
+                } else if (name == "is" && in_cell) {
+                    in_inline = true;
+                } else if (name == "t" && in_inline && phonetic_depth == 0) {
+                    in_value = true;
+                    has_value = true;
+                } else if (name == "rPh") {
+                    ++phonetic_depth;
+                } else if (name == "row") {
+                    std::uint64_t number = 0;
+                    row = parseNumber(attributes.get("r"), number) ? number : row + 1;
+                    cells.clear();
+                    text_spans.clear();
+                    row_text.clear();
+                    next_column = 0;
+                    in_row = true;
+                }
+            }
+
+            void endElement(std::string_view name) {
+                if (name == "v" || name == "t") {
+                    in_value = false;
+                } else if (name == "rPh") {
+                    --phonetic_depth;
+                } else if (name == "is") {
+                    in_inline = false;
+                } else if (name == "c" && in_cell) {
+                    in_cell = false;
+                    next_column = column + 1;
+                    if (has_value) {
+                        appendCell();
+                    }
+                } else if (name == "row" && in_row) {
+                    in_row = false;
+                    for (size_t i = 0; i < cells.size(); ++i) {
+                        if (text_spans[i].second > 0) {
+                            cells[i].text = std::string_view(row_text).substr(text_spans[i].first,
+                                                                              text_spans[i].second);
+                        }
+                    }
+                    on_row(row, cells);
+                }
+            }
+
+            void characters(std::string_view text) {
+                if (in_value) {
+                    value.append(text);
+                }
+            }
+
+            void appendText(Cell &cell) {
+                const size_t start = row_text.size();
+                row_text.append(value);
+                decodeEscapes(row_text, start);
+                text_spans.emplace_back(start, row_text.size() - start);
+                cell.text = {};
+            }
+
+            void appendCell() {
+                Cell cell;
+                cell.column = column;
+                if (cell_type == "s") {
+                    cell.type = Cell::Type::SharedString;
+                    if (!parseNumber(std::string_view(value), cell.shared_index)) {
+                        return;
+                    }
+                } else if (cell_type == "b") {
+                    cell.type = Cell::Type::Boolean;
+                    cell.number = parseBool(value) ? 1.0 : 0.0;
+                } else if (cell_type == "e") {
+                    cell.type = Cell::Type::Error;
+                    appendText(cell);
+                    cells.push_back(cell);
+                    return;
+                } else if (cell_type == "str" || cell_type == "inlineStr" || cell_type == "d") {
+                    // t="d" 是 ISO 8601 文本，按字符串处理
+                    cell.type = Cell::Type::String;
+                    appendText(cell);
+                    cells.push_back(cell);
+                    return;
+                } else {
+                    cell.type = Cell::Type::Number;
+                    if (!parseNumber(std::string_view(value), cell.number)) {
+                        cell.type = Cell::Type::String;
+                        appendText(cell);
+                        cells.push_back(cell);
+                        return;
+                    }
+                    cell.is_date = style < date_styles.size() && date_styles[style];
+                }
+                text_spans.emplace_back(0, 0);
+                cells.push_back(cell);
+            }
+        };
+    }
+
+    XlsxStreamReader::XlsxStreamReader(const std::string &path) : archive_(path) {
+        loadWorkbook();
+    }
+
+    void XlsxStreamReader::loadWorkbook() {
+        std::string workbook_path = "xl/workbook.xml";
+        if (archive_.find("_rels/.rels")) {
+            RelationshipsHandler package;
+            parseEntry(archive_, "_rels/.rels", package);
+            if (const auto *document = package.findType("/officeDocument")) {
+                workbook_path = resolvePath("", document->target);
+            }
+        }
+
+        const auto slash = workbook_path.rfind('/');
+        const std::string base_dir = slash == std::string::npos ? "" : workbook_path.substr(0, slash + 1);
+        const std::string file_name = slash == std::string::npos ? workbook_path : workbook_path.substr(slash + 1);
+
+        WorkbookHandler workbook;
+        parseEntry(archive_, workbook_path, workbook);
+        RelationshipsHandler relationships;
+        parseEntry(archive_, base_dir + "_rels/" + file_name + ".rels", relationships);
+
+        date1904_ = workbook.date1904;
+        for (const auto &[name, id]: workbook.sheets) {
+            for (const auto &relationship: relationships.relationships) {
+                if (relationship.id == id) {
+                    sheets_.push_back({name, resolvePath(base_dir, relationship.target)});
+                    break;
+                }
+            }
+        }
+        if (sheets_.empty()) {
+            throw std::runtime_error("Workbook contains no worksheets");
+        }
+        active_sheet_ = workbook.active_tab < sheets_.size() ? workbook.active_tab : 0;
+
+        if (const auto *styles = relationships.findType("/styles")) {
+            loadStyles(resolvePath(base_dir, styles->target));
+        }
+        if (const auto *shared_strings = relationships.findType("/sharedStrings")) {
+            loadSharedStrings(resolvePath(base_dir, shared_strings->target));
+        }
+    }
+
+    void XlsxStreamReader::loadSharedStrings(const std::string &path) {
+        SharedStringsHandler handler{shared_string_data_, shared_string_offsets_};
+        parseEntry(archive_, path, handler);
+    }
+
+    void XlsxStreamReader::loadStyles(const std::string &path) {
+        StylesHandler handler;
+        parseEntry(archive_, path, handler);
+        date_styles_.reserve(handler.cell_formats.size());
+        for (const std::uint32_t id: handler.cell_formats) {
+            const auto custom = handler.custom_formats.find(id);
+            date_styles_.push_back(isDateFormat(id, custom == handler.custom_formats.end()
+                                                        ? std::string_view()
+                                                        : std::string_view(custom->second)));
+        }
+    }
+
+    std::string_view XlsxStreamReader::sharedString(std::uint32_t index) const {
+        if (index >= shared_string_offsets_.size()) {
+            return {};
+        }
+        const auto &[offset, length] = shared_string_offsets_[index];
+        return std::string_view(shared_string_data_).substr(offset, length);
+    }
+
+    const ZipArchive::Entry &XlsxStreamReader::sheetEntry(size_t sheet) const {
+        if (sheet >= sheets_.size()) {
+            throw std::out_of_range("Worksheet index out of range");
+        }
+        const ZipArchive::Entry *entry = archive_.find(sheets_[sheet].path);
+        if (!entry) {
+            throw std::runtime_error("Missing part in xlsx package: " + sheets_[sheet].path);
+        }
+        return *entry;
+    }
+
+    XlsxStreamReader::Dimension XlsxStreamReader::dimension(size_t sheet) const {
+        DimensionHandler handler;
+        parseEntry(archive_, sheetEntry(sheet), handler, [](std::uint64_t) {});
+        return handler.dimension;
+    }
+
+    void XlsxStreamReader::readSheet(size_t sheet, const RowCallback &on_row,
+                                     const ProgressCallback &on_progress) const {
+        const ZipArchive::Entry &entry = sheetEntry(sheet);
+        SheetHandler handler(on_row, date_styles_);
+        parseEntry(archive_, entry, handler, [&](std::uint64_t bytes) {
+            if (on_progress) {
+                on_progress(bytes, entry.uncompressed_size);
+            }
+        });
+    }
+
+    void XlsxStreamReader::splitSheet(size_t sheet, size_t range_bytes, const RangeCallback &on_range,
+                                      const ProgressCallback &on_progress) const {
+        const ZipArchive::Entry &entry = sheetEntry(sheet);
+        auto reader = archive_.open(entry);
+        std::vector<char> block(READ_BLOCK_SIZE);
+        std::string buffer;
+        buffer.reserve(range_bytes + READ_BLOCK_SIZE);
+        // 已确认没有切分点的前缀长度，避免没有行号时反复扫描整个缓冲区
+        size_t scanned = 0;
+        while (const size_t n = reader->read(block.data(), block.size())) {
+            buffer.append(block.data(), n);
+            if (buffer.size() >= range_bytes) {
+                // 回退一点以覆盖跨块的 <row 标签
+                const size_t cut = findRowBoundary(buffer, scanned > 256 ? scanned - 256 : 0);
+                if (cut != std::string::npos && cut > 0) {
+                    std::string rest = buffer.substr(cut);
+                    buffer.resize(cut);
+                    on_range(std::move(buffer));
+                    buffer = std::move(rest);
+                    buffer.reserve(range_bytes + READ_BLOCK_SIZE);
+                    scanned = 0;
+                } else {
+                    scanned = buffer.size();
+                }
+            }
+            if (on_progress) {
+                on_progress(reader->uncompressedBytesRead(), entry.uncompressed_size);
+            }
+        }
+        if (!buffer.empty()) {
+            on_range(std::move(buffer));
+        }
+    }
+
+    void XlsxStreamReader::parseRange(std::string_view xml, const RowCallback &on_row) const {
+        SheetHandler handler(on_row, date_styles_);
+        XmlSaxParser<SheetHandler> parser(handler);
+        parser.feed(xml.data(), xml.size());
+        parser.finish();
+    }
+
+    size_t XlsxStreamReader::findRowBoundary(std::string_view xml, size_t from) {
+        auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+        size_t pos = xml.size();
+        while (pos > from) {
+            const size_t found = xml.rfind("row", pos - 1);
+            if (found == std::string_view::npos || found < from || found == 0) {
+                break;
+            }
+            pos = found;
+            // 标签名后必须是空白，排除 <rowBreaks> 和 </row>
+            const size_t name_end = found + 3;
+            if (name_end >= xml.size() || !is_space(xml[name_end])) {
+                continue;
+            }
+            // 允许命名空间前缀，例如 <x:row
+            size_t start = found;
+            if (xml[start - 1] == ':') {
+                --start;
+                while (start > 0 && xml[start - 1] != '<' && xml[start - 1] != '/' && !is_space(xml[start - 1]) &&
+                       xml[start - 1] != '>') {
+                    --start;
+                }
+            }
+            if (start == 0 || xml[start - 1] != '<') {
+                continue;
+            }
+            const size_t tag_end = xml.find('>', name_end);
+            if (tag_end == std::string_view::npos) {
+                continue;
+            }
+            const std::string_view attributes = xml.substr(name_end, tag_end - name_end);
+            for (size_t i = 0; i + 1 < attributes.size(); ++i) {
+                if (is_space(attributes[i]) && attributes[i + 1] == 'r') {
+                    size_t j = i + 2;
+                    while (j < attributes.size() && is_space(attributes[j])) {
+                        ++j;
+                    }
+                    if (j < attributes.size() && attributes[j] == '=') {
+                        return start - 1;
+                    }
+                }
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    std::int64_t XlsxStreamReader::columnFromReference(std::string_view reference) {
+        std::int64_t column = 0;
+        size_t letters = 0;
+        for (const char c: reference) {
+            if (c >= 'A' && c <= 'Z') {
+                column = column * 26 + (c - 'A' + 1);
+            } else if (c >= 'a' && c <= 'z') {
+                column = column * 26 + (c - 'a' + 1);
+            } else {
+                break;
+            }
+            ++letters;
+        }
+        return letters == 0 ? -1 : column - 1;
+    }
+
+    bool XlsxStreamReader::isDateFormat(std::uint32_t num_fmt_id, std::string_view format_code) {
+        if (format_code.empty()) {
+            // 内置格式：14-22 为通用日期时间，27-36、50-58 为东亚区域日期格式，45-47 为时间
+            return (num_fmt_id >= 14 && num_fmt_id <= 22) || (num_fmt_id >= 27 && num_fmt_id <= 36) ||
+                   (num_fmt_id >= 45 && num_fmt_id <= 47) || (num_fmt_id >= 50 && num_fmt_id <= 58);
+        }
+        // 自定义格式：跳过引号中的字面文本、转义字符和 [Red]/[$-409] 这类方括号段，
+        // 剩余部分出现 y/m/d/h/s 即为日期格式；[h]、[mm]、[ss] 这种经过时间也算
+        for (size_t i = 0; i < format_code.size(); ++i) {
+            const char c = format_code[i];
+            switch (c) {
+                case '"': {
+                    const auto close = format_code.find('"', i + 1);
+                    if (close == std::string_view::npos) {
+                        return false;
+                    }
+                    i = close;
+                    break;
+                }
+                case '\\':
+                case '_':
+                case '*':
+                    ++i;
+                    break;
+                case '[': {
+                    const auto close = format_code.find(']', i + 1);
+                    if (close == std::string_view::npos) {
+                        return false;
+                    }
+                    const std::string_view section = format_code.substr(i + 1, close - i - 1);
+                    if (!section.empty() && section.find_first_not_of("hHmMsS") == std::string_view::npos) {
+                        return true;
+                    }
+                    i = close;
+                    break;
+                }
+                case 'y': case 'Y': case 'm': case 'M': case 'd': case 'D':
+                case 'h': case 'H': case 's': case 'S':
+                    return true;
+                default:
+                    break;
+            }
+        }
+        return false;
+    }
+} // namespace TinaToolBox
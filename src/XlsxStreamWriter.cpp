@@ -0,0 +1,296 @@
+#include "XlsxStreamWriter.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace TinaToolBox {
+    namespace {
+        constexpr const char *XML_DECLARATION = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+        constexpr const char *MAIN_NAMESPACE = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+        constexpr const char *RELATIONSHIP_NAMESPACE =
+                "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+        // 工作表数据量大，优先压缩速度；其余部件很小，使用默认级别
+        constexpr int SHEET_COMPRESSION_LEVEL = 1;
+        // cellXfs 中日期时间格式的下标，见 writeWorkbookParts()
+        constexpr const char *DATE_STYLE = "1";
+
+        bool isHex(char c) {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        }
+
+        // 首尾有空白时需要 xml:space="preserve"，否则 Excel 会去掉
+        bool needsPreserve(std::string_view text) {
+            const auto space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+            return !text.empty() && (space(text.front()) || space(text.back()));
+        }
+
+        void appendNumber(std::string &out, double value) {
+            char buffer[32];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
+        void appendInteger(std::string &out, std::uint64_t value) {
+            char buffer[24];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+    }
+
+    XlsxStreamWriter::XlsxStreamWriter(const std::string &path, Dimension dimension, std::string sheet_name)
+        : zip_(path), sheet_name_(std::move(sheet_name)) {
+        buffer_.reserve(FLUSH_BYTES + 64 * 1024);
+        zip_.beginEntry("xl/worksheets/sheet1.xml", SHEET_COMPRESSION_LEVEL);
+        buffer_ += XML_DECLARATION;
+        buffer_ += "<worksheet xmlns=\"";
+        buffer_ += MAIN_NAMESPACE;
+        buffer_ += "\" xmlns:r=\"";
+        buffer_ += RELATIONSHIP_NAMESPACE;
+        buffer_ += "\">";
+        if (dimension.rows > 0 && dimension.columns > 0) {
+            buffer_ += "<dimension ref=\"A1:";
+            appendCellReference(dimension.columns - 1, dimension.rows);
+            buffer_ += "\"/>";
+        }
+        buffer_ += "<sheetData>";
+    }
+
+    std::uint32_t XlsxStreamWriter::sharedString(std::string_view text) {
+        const auto it = shared_string_index_.find(text);
+        if (it != shared_string_index_.end()) {
+            return it->second;
+        }
+        if (shared_string_bytes_ + text.size() > SHARED_STRING_LIMIT) {
+            return NO_SHARED_STRING;
+        }
+        const auto index = static_cast<std::uint32_t>(shared_strings_.size());
+        shared_string_index_.emplace(shared_strings_.emplace_back(text), index);
+        shared_string_bytes_ += text.size();
+        return index;
+    }
+
+    void XlsxStreamWriter::writeRow(std::uint64_t row, const std::vector<Cell> &cells) {
+        if (finished_) {
+            throw std::runtime_error("XLSX writer already finished");
+        }
+        if (row <= last_row_ || row > MAX_ROWS) {
+            throw std::runtime_error("Invalid XLSX row number " + std::to_string(row));
+        }
+        last_row_ = row;
+        if (cells.empty()) {
+            return;
+        }
+
+        buffer_ += "<row r=\"";
+        appendInteger(buffer_, row);
+        buffer_ += "\">";
+        for (const auto &cell: cells) {
+            if (cell.column >= MAX_COLUMNS) {
+                throw std::runtime_error("Too many columns for XLSX");
+            }
+            buffer_ += "<c r=\"";
+            appendCellReference(cell.column, row);
+            buffer_ += '"';
+            switch (cell.type) {
+                case Cell::Type::Number:
+                case Cell::Type::Date:
+                    if (!std::isfinite(cell.number)) {
+                        // Excel 没有 NaN 和无穷大
+                        buffer_ += " t=\"e\"><v>#NUM!</v></c>";
+                        break;
+                    }
+                    if (cell.type == Cell::Type::Date) {
+                        buffer_ += " s=\"";
+                        buffer_ += DATE_STYLE;
+                        buffer_ += '"';
+                    }
+                    buffer_ += "><v>";
+                    appendNumber(buffer_, cell.number);
+                    buffer_ += "</v></c>";
+                    break;
+                case Cell::Type::Boolean:
+                    buffer_ += cell.number != 0.0 ? " t=\"b\"><v>1</v></c>" : " t=\"b\"><v>0</v></c>";
+                    break;
+                case Cell::Type::SharedString:
+                case Cell::Type::String: {
+                    const std::uint32_t index = cell.type == Cell::Type::SharedString
+                                                    ? cell.shared_index
+                                                    : sharedString(cell.text);
+                    if (index == NO_SHARED_STRING) {
+                        buffer_ += " t=\"inlineStr\"><is><t";
+                        buffer_ += needsPreserve(cell.text) ? " xml:space=\"preserve\">" : ">";
+                        appendText(cell.text);
+                        buffer_ += "</t></is></c>";
+                    } else {
+                        buffer_ += " t=\"s\"><v>";
+                        appendInteger(buffer_, index);
+                        buffer_ += "</v></c>";
+                        ++shared_string_count_;
+                    }
+                    break;
+                }
+            }
+        }
+        buffer_ += "</row>";
+        if (buffer_.size() >= FLUSH_BYTES) {
+            flush();
+        }
+    }
+
+    void XlsxStreamWriter::finish() {
+        if (finished_) {
+            return;
+        }
+        buffer_ += "</sheetData></worksheet>";
+        flush();
+        zip_.endEntry();
+        writeSharedStrings();
+        writeWorkbookParts();
+        zip_.close();
+        finished_ = true;
+    }
+
+    void XlsxStreamWriter::appendCellReference(std::uint32_t column, std::uint64_t row) {
+        char letters[4];
+        size_t count = 0;
+        for (std::uint32_t n = column + 1; n > 0; n = (n - 1) / 26) {
+            letters[count++] = static_cast<char>('A' + (n - 1) % 26);
+        }
+        while (count > 0) {
+            buffer_.push_back(letters[--count]);
+        }
+        appendInteger(buffer_, row);
+    }
+
+    // 转义 XML 特殊字符；XML 1.0 不允许的控制字符和形如 _xHHHH_ 的原文按 Excel 的约定写成 _xHHHH_
+    void XlsxStreamWriter::appendText(std::string_view text) {
+        for (size_t i = 0; i < text.size(); ++i) {
+            const char c = text[i];
+            switch (c) {
+                case '&':
+                    buffer_ += "&amp;";
+                    break;
+                case '<':
+                    buffer_ += "&lt;";
+                    break;
+                case '>':
+                    buffer_ += "&gt;";
+                    break;
+                case '"':
+                    buffer_ += "&quot;";
+                    break;
+                case '_':
+                    if (i + 6 < text.size() && text[i + 1] == 'x' && isHex(text[i + 2]) && isHex(text[i + 3]) &&
+                        isHex(text[i + 4]) && isHex(text[i + 5]) && text[i + 6] == '_') {
+                        buffer_ += "_x005F_";
+                    } else {
+                        buffer_ += '_';
+                    }
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20 && c != '\t' && c != '\n' && c != '\r') {
+                        static constexpr char HEX[] = "0123456789ABCDEF";
+                        buffer_ += "_x00";
+                        buffer_ += HEX[(c >> 4) & 0xF];
+                        buffer_ += HEX[c & 0xF];
+                        buffer_ += '_';
+                    } else {
+                        buffer_ += c;
+                    }
+                    break;
+            }
+        }
+    }
+
+    void XlsxStreamWriter::flush() {
+        zip_.write(buffer_);
+        buffer_.clear();
+    }
+
+    void XlsxStreamWriter::writeSharedStrings() {
+        zip_.beginEntry("xl/sharedStrings.xml");
+        buffer_ += XML_DECLARATION;
+        buffer_ += "<sst xmlns=\"";
+        buffer_ += MAIN_NAMESPACE;
+        buffer_ += "\" count=\"";
+        appendInteger(buffer_, shared_string_count_);
+        buffer_ += "\" uniqueCount=\"";
+        appendInteger(buffer_, shared_strings_.size());
+        buffer_ += "\">";
+        for (const std::string &text: shared_strings_) {
+            buffer_ += needsPreserve(text) ? "<si><t xml:space=\"preserve\">" : "<si><t>";
+            appendText(text);
+            buffer_ += "</t></si>";
+            if (buffer_.size() >= FLUSH_BYTES) {
+                flush();
+            }
+        }
+        buffer_ += "</sst>";
+        flush();
+        zip_.endEntry();
+
+        shared_string_index_.clear();
+        shared_strings_.clear();
+    }
+
+    void XlsxStreamWriter::writeWorkbookParts() {
+        zip_.beginEntry("xl/styles.xml");
+        buffer_ += XML_DECLARATION;
+        buffer_ += "<styleSheet xmlns=\"";
+        buffer_ += MAIN_NAMESPACE;
+        buffer_ += "\">"
+                "<numFmts count=\"1\"><numFmt numFmtId=\"164\" formatCode=\"yyyy-mm-dd hh:mm:ss\"/></numFmts>"
+                "<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/><family val=\"2\"/></font></fonts>"
+                "<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill>"
+                "<fill><patternFill patternType=\"gray125\"/></fill></fills>"
+                "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+                "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+                "<cellXfs count=\"2\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>"
+                "<xf numFmtId=\"164\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+                "</cellXfs>"
+                "<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+                "</styleSheet>";
+        flush();
+
+        zip_.beginEntry("xl/workbook.xml");
+        buffer_ += XML_DECLARATION;
+        buffer_ += "<workbook xmlns=\"";
+        buffer_ += MAIN_NAMESPACE;
+        buffer_ += "\" xmlns:r=\"";
+        buffer_ += RELATIONSHIP_NAMESPACE;
+        buffer_ += "\"><sheets><sheet name=\"";
+        appendText(sheet_name_);
+        buffer_ += "\" sheetId=\"1\" r:id=\"rId1\"/></sheets></workbook>";
+        flush();
+
+        zip_.beginEntry("xl/_rels/workbook.xml.rels");
+        buffer_ += XML_DECLARATION;
+        buffer_ += "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+                "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
+                "<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>"
+                "</Relationships>";
+        flush();
+
+        zip_.beginEntry("_rels/.rels");
+        buffer_ += XML_DECLARATION;
+        buffer_ += "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+                "</Relationships>";
+        flush();
+
+        zip_.beginEntry("[Content_Types].xml");
+        buffer_ += XML_DECLARATION;
+        buffer_ += "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+                "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+                "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+                "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+                "<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+                "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+                "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>"
+                "</Types>";
+        flush();
+        zip_.endEntry();
+    }
+} // namespace TinaToolBox
@@ -0,0 +1,322 @@
+#include "ZipArchive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace TinaToolBox {
+    namespace {
+        constexpr std::uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+        constexpr std::uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+        constexpr std::uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+        constexpr std::uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06064b50;
+        constexpr std::uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+        constexpr std::uint16_t ZIP64_EXTRA_FIELD_ID = 0x0001;
+        constexpr size_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+        constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+        // readAll 按中央目录中的大小预留空间的上限，超出部分随读到的数据增长
+        constexpr std::uint64_t MAX_RESERVE_SIZE = 64 * 1024 * 1024;
+        constexpr size_t READ_CHUNK_SIZE = 1024 * 1024;
+
+        // ZIP 中的整数均为小端序
+        std::uint16_t readLE16(const unsigned char *p) {
+            return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        std::uint32_t readLE32(const unsigned char *p) {
+            return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+                   (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+        }
+
+        std::uint64_t readLE64(const unsigned char *p) {
+            return static_cast<std::uint64_t>(readLE32(p)) | (static_cast<std::uint64_t>(readLE32(p + 4)) << 32);
+        }
+
+        void readAt(std::ifstream &file, std::uint64_t offset, void *buffer, size_t size) {
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            file.read(static_cast<char *>(buffer), static_cast<std::streamsize>(size));
+            if (static_cast<size_t>(file.gcount()) != size) {
+                throw std::runtime_error("Unexpected end of ZIP file");
+            }
+        }
+    }
+
+    ZipArchive::ZipArchive(std::string path) : path_(std::move(path)) {
+        // 路径为 UTF-8，MSVC 按 ANSI 代码页解释窄字符串路径
+        std::ifstream file(std::filesystem::u8path(path_), std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open ZIP file: " + path_);
+        }
+        readCentralDirectory(file);
+    }
+
+    void ZipArchive::readCentralDirectory(std::ifstream &file) {
+        file.seekg(0, std::ios::end);
+        const auto file_size = static_cast<std::uint64_t>(file.tellg());
+        if (file_size < END_OF_CENTRAL_DIRECTORY_SIZE) {
+            throw std::runtime_error("Not a ZIP file: " + path_);
+        }
+
+        // 目录尾记录位于文件末尾，之后最多跟一个 64KB 的注释，从后往前找签名
+        const std::uint64_t tail_size = std::min<std::uint64_t>(file_size, END_OF_CENTRAL_DIRECTORY_SIZE + MAX_COMMENT_SIZE);
+        std::vector<unsigned char> tail(static_cast<size_t>(tail_size));
+        readAt(file, file_size - tail_size, tail.data(), tail.size());
+
+        size_t eocd = tail.size();
+        for (size_t i = tail.size() - END_OF_CENTRAL_DIRECTORY_SIZE + 1; i-- > 0;) {
+            if (readLE32(&tail[i]) == END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+                eocd = i;
+                break;
+            }
+        }
+        if (eocd == tail.size()) {
+            throw std::runtime_error("ZIP end of central directory not found: " + path_);
+        }
+
+        std::uint64_t entry_count = readLE16(&tail[eocd + 10]);
+        std::uint64_t directory_size = readLE32(&tail[eocd + 12]);
+        std::uint64_t directory_offset = readLE32(&tail[eocd + 16]);
+
+        // ZIP64：目录尾之前紧挨着 20 字节的定位记录
+        const std::uint64_t eocd_offset = file_size - tail_size + eocd;
+        if (eocd_offset >= 20) {
+            unsigned char locator[20];
+            readAt(file, eocd_offset - 20, locator, sizeof(locator));
+            if (readLE32(locator) == ZIP64_LOCATOR_SIGNATURE) {
+                unsigned char record[56];
+                readAt(file, readLE64(locator + 8), record, sizeof(record));
+                if (readLE32(record) != ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+                    throw std::runtime_error("Invalid ZIP64 end of central directory: " + path_);
+                }
+                entry_count = readLE64(record + 32);
+                directory_size = readLE64(record + 40);
+                directory_offset = readLE64(record + 48);
+            }
+        }
+
+        if (directory_offset + directory_size > file_size) {
+            throw std::runtime_error("Corrupted ZIP central directory: " + path_);
+        }
+        std::vector<unsigned char> directory(static_cast<size_t>(directory_size));
+        readAt(file, directory_offset, directory.data(), directory.size());
+
+        entries_.reserve(static_cast<size_t>(entry_count));
+        size_t pos = 0;
+        for (std::uint64_t i = 0; i < entry_count; ++i) {
+            if (pos + 46 > directory.size() || readLE32(&directory[pos]) != CENTRAL_HEADER_SIGNATURE) {
+                throw std::runtime_error("Corrupted ZIP central directory: " + path_);
+            }
+            const unsigned char *header = &directory[pos];
+            const std::uint16_t name_length = readLE16(header + 28);
+            const std::uint16_t extra_length = readLE16(header + 30);
+            const std::uint16_t comment_length = readLE16(header + 32);
+            if (pos + 46 + name_length + extra_length + comment_length > directory.size()) {
+                throw std::runtime_error("Corrupted ZIP central directory: " + path_);
+            }
+
+            Entry entry;
+            entry.method = readLE16(header + 10);
+            entry.crc32 = readLE32(header + 16);
+            entry.compressed_size = readLE32(header + 20);
+            entry.uncompressed_size = readLE32(header + 24);
+            entry.local_header_offset = readLE32(header + 42);
+            entry.name.assign(reinterpret_cast<const char *>(header + 46), name_length);
+
+            // ZIP64 扩展字段只包含值为 0xFFFFFFFF 的那些字段，顺序固定
+            const unsigned char *extra = header + 46 + name_length;
+            for (size_t offset = 0; offset + 4 <= extra_length;) {
+                const std::uint16_t id = readLE16(extra + offset);
+                const std::uint16_t size = readLE16(extra + offset + 2);
+                if (id == ZIP64_EXTRA_FIELD_ID) {
+                    const unsigned char *field = extra + offset + 4;
+                    const unsigned char *field_end = field + std::min<size_t>(size, extra_length - offset - 4);
+                    auto take = [&field, field_end](std::uint64_t &value) {
+                        if (value == 0xFFFFFFFF && field + 8 <= field_end) {
+                            value = readLE64(field);
+                            field += 8;
+                        }
+                    };
+                    take(entry.uncompressed_size);
+                    take(entry.compressed_size);
+                    take(entry.local_header_offset);
+                }
+                offset += 4 + size;
+            }
+
+            entries_.push_back(std::move(entry));
+            pos += 46 + name_length + extra_length + comment_length;
+        }
+    }
+
+    const ZipArchive::Entry *ZipArchive::find(std::string_view name) const {
+        for (const auto &entry: entries_) {
+            if (entry.name == name) {
+                return &entry;
+            }
+        }
+        // 个别生成器使用反斜杠作为路径分隔符
+        for (const auto &entry: entries_) {
+            if (entry.name.size() == name.size() &&
+                std::equal(entry.name.begin(), entry.name.end(), name.begin(), [](char a, char b) {
+                    return (a == '\\' ? '/' : a) == b;
+                })) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<ZipEntryReader> ZipArchive::open(const Entry &entry) const {
+        return std::make_unique<ZipEntryReader>(path_, entry);
+    }
+
+    bool ZipArchive::readAll(std::string_view name, std::string &out) const {
+        const Entry *entry = find(name);
+        if (!entry) {
+            return false;
+        }
+        auto reader = open(*entry);
+        out.clear();
+        // 中央目录中的大小不可信，损坏的文件不能让这里一次分配巨大的内存
+        out.reserve(static_cast<size_t>(std::min(entry->uncompressed_size, MAX_RESERVE_SIZE)));
+        size_t total = 0;
+        for (;;) {
+            if (total == out.size()) {
+                out.resize(std::max(out.capacity(), total + READ_CHUNK_SIZE));
+            }
+            const size_t n = reader->read(out.data() + total, out.size() - total);
+            if (n == 0) {
+                break;
+            }
+            total += n;
+        }
+        out.resize(total);
+        return true;
+    }
+
+    struct ZipEntryReader::Inflater {
+        z_stream stream{};
+    };
+
+    ZipEntryReader::ZipEntryReader(const std::string &path, const ZipArchive::Entry &entry)
+        : entry_(entry), file_(std::filesystem::u8path(path), std::ios::binary), input_(INPUT_BUFFER_SIZE) {
+        if (!file_) {
+            throw std::runtime_error("Failed to open ZIP file: " + path);
+        }
+        if (entry_.method != 0 && entry_.method != Z_DEFLATED) {
+            throw std::runtime_error("Unsupported ZIP compression method for " + entry_.name);
+        }
+
+        unsigned char header[30];
+        readAt(file_, entry_.local_header_offset, header, sizeof(header));
+        if (readLE32(header) != LOCAL_HEADER_SIGNATURE) {
+            throw std::runtime_error("Corrupted ZIP local header for " + entry_.name);
+        }
+        // 本地头中的文件名和扩展字段长度可能与中央目录不同
+        const std::uint64_t data_offset = entry_.local_header_offset + sizeof(header) +
+                                          readLE16(header + 26) + readLE16(header + 28);
+        file_.seekg(static_cast<std::streamoff>(data_offset));
+        compressed_remaining_ = entry_.compressed_size;
+
+        if (entry_.method == Z_DEFLATED) {
+            inflater_ = std::make_unique<Inflater>();
+            // 负的窗口位数表示原始 deflate 数据，没有 zlib/gzip 头
+            if (inflateInit2(&inflater_->stream, -MAX_WBITS) != Z_OK) {
+                throw std::runtime_error("Failed to initialize inflater for " + entry_.name);
+            }
+        }
+    }
+
+    ZipEntryReader::~ZipEntryReader() {
+        if (inflater_) {
+            inflateEnd(&inflater_->stream);
+        }
+    }
+
+    size_t ZipEntryReader::fillInput() {
+        const auto want = static_cast<size_t>(std::min<std::uint64_t>(input_.size(), compressed_remaining_));
+        if (want == 0) {
+            return 0;
+        }
+        file_.read(input_.data(), static_cast<std::streamsize>(want));
+        const auto got = static_cast<size_t>(file_.gcount());
+        if (got == 0) {
+            throw std::runtime_error("Unexpected end of ZIP data for " + entry_.name);
+        }
+        compressed_remaining_ -= got;
+        return got;
+    }
+
+    void ZipEntryReader::finishEntry() {
+        finished_ = true;
+        if (crc_ != entry_.crc32) {
+            throw std::runtime_error("CRC mismatch in ZIP entry " + entry_.name);
+        }
+    }
+
+    size_t ZipEntryReader::read(char *buffer, size_t size) {
+        if (finished_ || size == 0) {
+            return 0;
+        }
+
+        size_t produced = 0;
+        if (!inflater_) {
+            // stored：直接读取原始数据
+            // crc32 的长度参数同样是 32 位的
+            const auto want = static_cast<size_t>(
+                std::min<std::uint64_t>(std::min<size_t>(size, UINT32_MAX), compressed_remaining_));
+            if (want > 0) {
+                file_.read(buffer, static_cast<std::streamsize>(want));
+                produced = static_cast<size_t>(file_.gcount());
+                if (produced == 0) {
+                    throw std::runtime_error("Unexpected end of ZIP data for " + entry_.name);
+                }
+                compressed_remaining_ -= produced;
+            }
+            crc_ = static_cast<std::uint32_t>(::crc32(crc_, reinterpret_cast<const Bytef *>(buffer),
+                                                      static_cast<uInt>(produced)));
+            produced_ += produced;
+            if (compressed_remaining_ == 0) {
+                finishEntry();
+            }
+            return produced;
+        }
+
+        z_stream &stream = inflater_->stream;
+        stream.next_out = reinterpret_cast<Bytef *>(buffer);
+        // avail_out 是 32 位的，超过 4GB 的请求只填充前一部分
+        const size_t request = std::min<size_t>(size, UINT32_MAX);
+        stream.avail_out = static_cast<uInt>(request);
+        while (stream.avail_out > 0) {
+            if (stream.avail_in == 0) {
+                const size_t got = fillInput();
+                if (got == 0) {
+                    throw std::runtime_error("Truncated deflate stream in ZIP entry " + entry_.name);
+                }
+                stream.next_in = reinterpret_cast<Bytef *>(input_.data());
+                stream.avail_in = static_cast<uInt>(got);
+            }
+            const int status = inflate(&stream, Z_NO_FLUSH);
+            if (status == Z_STREAM_END) {
+                produced = request - stream.avail_out;
+                crc_ = static_cast<std::uint32_t>(::crc32(crc_, reinterpret_cast<const Bytef *>(buffer),
+                                                          static_cast<uInt>(produced)));
+                produced_ += produced;
+                finishEntry();
+                return produced;
+            }
+            if (status != Z_OK && status != Z_BUF_ERROR) {
+                throw std::runtime_error("Corrupted deflate stream in ZIP entry " + entry_.name);
+            }
+        }
+
+        produced = request - stream.avail_out;
+        crc_ = static_cast<std::uint32_t>(::crc32(crc_, reinterpret_cast<const Bytef *>(buffer),
+                                                  static_cast<uInt>(produced)));
+        produced_ += produced;
+        return produced;
+    }
+} // namespace TinaToolBox
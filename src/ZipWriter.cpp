@@ -0,0 +1,223 @@
+#include "ZipWriter.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace TinaToolBox {
+    namespace {
+        constexpr std::uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+        constexpr std::uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+        constexpr std::uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+        constexpr std::uint16_t VERSION_NEEDED = 20;
+        // 本地文件头中 CRC32 字段的偏移，之后依次是压缩后和压缩前的大小
+        constexpr std::uint64_t LOCAL_HEADER_CRC_OFFSET = 14;
+        constexpr std::uint64_t ZIP32_LIMIT = std::numeric_limits<std::uint32_t>::max();
+
+        // ZIP 中的整数均为小端序
+        void putLE16(std::string &out, std::uint16_t value) {
+            out.push_back(static_cast<char>(value & 0xFF));
+            out.push_back(static_cast<char>(value >> 8));
+        }
+
+        void putLE32(std::string &out, std::uint32_t value) {
+            putLE16(out, static_cast<std::uint16_t>(value & 0xFFFF));
+            putLE16(out, static_cast<std::uint16_t>(value >> 16));
+        }
+
+        std::uint32_t checkedSize(std::uint64_t value, const std::string &what) {
+            if (value > ZIP32_LIMIT) {
+                throw std::runtime_error(what + " exceeds 4 GiB, ZIP64 is not supported");
+            }
+            return static_cast<std::uint32_t>(value);
+        }
+    }
+
+    struct ZipWriter::Deflater {
+        z_stream stream{};
+        bool active = false;
+    };
+
+    ZipWriter::ZipWriter(const std::string &path)
+        : file_(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc), output_(OUTPUT_BUFFER_SIZE),
+          deflater_(std::make_unique<Deflater>()) {
+        if (!file_) {
+            throw std::runtime_error("Failed to create ZIP file: " + path);
+        }
+        // 所有条目使用同一个 DOS 格式的修改时间
+        const std::time_t now = std::time(nullptr);
+        std::tm tm = {};
+#ifdef _WIN32
+        localtime_s(&tm, &now);
+#else
+        localtime_r(&now, &tm);
+#endif
+        dos_time_ = static_cast<std::uint16_t>((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2));
+        dos_date_ = static_cast<std::uint16_t>(((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+    }
+
+    ZipWriter::~ZipWriter() {
+        if (deflater_->active) {
+            deflateEnd(&deflater_->stream);
+        }
+    }
+
+    void ZipWriter::beginEntry(const std::string &name, int level) {
+        if (in_entry_) {
+            endEntry();
+        }
+        if (closed_) {
+            throw std::runtime_error("ZIP archive already closed");
+        }
+
+        Entry entry;
+        entry.name = name;
+        entry.local_header_offset = offset_;
+
+        // CRC32 和大小先写 0，条目结束后回填
+        std::string header;
+        putLE32(header, LOCAL_HEADER_SIGNATURE);
+        putLE16(header, VERSION_NEEDED);
+        putLE16(header, 0);
+        putLE16(header, Z_DEFLATED);
+        putLE16(header, dos_time_);
+        putLE16(header, dos_date_);
+        putLE32(header, 0);
+        putLE32(header, 0);
+        putLE32(header, 0);
+        putLE16(header, static_cast<std::uint16_t>(name.size()));
+        putLE16(header, 0);
+        header += name;
+        writeRaw(header.data(), header.size());
+        entries_.push_back(std::move(entry));
+
+        deflater_->stream = z_stream{};
+        if (deflateInit2(&deflater_->stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("Failed to initialize deflate for " + name);
+        }
+        deflater_->active = true;
+        in_entry_ = true;
+    }
+
+    void ZipWriter::write(const char *data, size_t size) {
+        if (!in_entry_) {
+            throw std::runtime_error("ZIP write outside of an entry");
+        }
+        Entry &entry = entries_.back();
+        entry.uncompressed_size += size;
+        // crc32 的长度参数是 uInt，大块数据分段计算
+        for (size_t done = 0; done < size;) {
+            const auto n = static_cast<uInt>(std::min<size_t>(size - done, 1u << 30));
+            entry.crc32 = static_cast<std::uint32_t>(
+                crc32(entry.crc32, reinterpret_cast<const Bytef *>(data + done), n));
+            done += n;
+        }
+        deflateInput(data, size, false);
+    }
+
+    void ZipWriter::deflateInput(const char *data, size_t size, bool finish) {
+        z_stream &stream = deflater_->stream;
+        size_t remaining = size;
+        do {
+            const auto chunk = static_cast<uInt>(std::min<size_t>(remaining, 1u << 30));
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + (size - remaining)));
+            stream.avail_in = chunk;
+            remaining -= chunk;
+            const int flush = finish && remaining == 0 ? Z_FINISH : Z_NO_FLUSH;
+            int result;
+            do {
+                stream.next_out = reinterpret_cast<Bytef *>(output_.data());
+                stream.avail_out = static_cast<uInt>(output_.size());
+                result = deflate(&stream, flush);
+                if (result == Z_STREAM_ERROR) {
+                    throw std::runtime_error("Deflate failed for " + entries_.back().name);
+                }
+                const size_t produced = output_.size() - stream.avail_out;
+                writeRaw(output_.data(), produced);
+                entries_.back().compressed_size += produced;
+            } while (stream.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+        } while (remaining > 0);
+    }
+
+    void ZipWriter::endEntry() {
+        if (!in_entry_) {
+            return;
+        }
+        deflateInput(nullptr, 0, true);
+        deflateEnd(&deflater_->stream);
+        deflater_->active = false;
+        in_entry_ = false;
+
+        const Entry &entry = entries_.back();
+        std::string sizes;
+        putLE32(sizes, entry.crc32);
+        putLE32(sizes, checkedSize(entry.compressed_size, entry.name));
+        putLE32(sizes, checkedSize(entry.uncompressed_size, entry.name));
+        file_.seekp(static_cast<std::streamoff>(entry.local_header_offset + LOCAL_HEADER_CRC_OFFSET));
+        file_.write(sizes.data(), static_cast<std::streamsize>(sizes.size()));
+        file_.seekp(static_cast<std::streamoff>(offset_));
+        if (!file_) {
+            throw std::runtime_error("Failed to write ZIP entry " + entry.name);
+        }
+    }
+
+    void ZipWriter::close() {
+        if (closed_) {
+            return;
+        }
+        endEntry();
+
+        const std::uint64_t directory_offset = offset_;
+        std::string directory;
+        for (const auto &entry: entries_) {
+            putLE32(directory, CENTRAL_HEADER_SIGNATURE);
+            putLE16(directory, VERSION_NEEDED);
+            putLE16(directory, VERSION_NEEDED);
+            putLE16(directory, 0);
+            putLE16(directory, Z_DEFLATED);
+            putLE16(directory, dos_time_);
+            putLE16(directory, dos_date_);
+            putLE32(directory, entry.crc32);
+            putLE32(directory, static_cast<std::uint32_t>(entry.compressed_size));
+            putLE32(directory, static_cast<std::uint32_t>(entry.uncompressed_size));
+            putLE16(directory, static_cast<std::uint16_t>(entry.name.size()));
+            putLE16(directory, 0);
+            putLE16(directory, 0);
+            putLE16(directory, 0);
+            putLE16(directory, 0);
+            putLE32(directory, 0);
+            putLE32(directory, checkedSize(entry.local_header_offset, "ZIP archive"));
+            directory += entry.name;
+        }
+        if (entries_.size() > 0xFFFF) {
+            throw std::runtime_error("Too many ZIP entries, ZIP64 is not supported");
+        }
+        const auto directory_size = static_cast<std::uint32_t>(directory.size());
+        putLE32(directory, END_OF_CENTRAL_DIRECTORY_SIGNATURE);
+        putLE16(directory, 0);
+        putLE16(directory, 0);
+        putLE16(directory, static_cast<std::uint16_t>(entries_.size()));
+        putLE16(directory, static_cast<std::uint16_t>(entries_.size()));
+        putLE32(directory, directory_size);
+        putLE32(directory, checkedSize(directory_offset, "ZIP archive"));
+        putLE16(directory, 0);
+        writeRaw(directory.data(), directory.size());
+
+        file_.close();
+        if (file_.fail()) {
+            throw std::runtime_error("Failed to close ZIP file");
+        }
+        closed_ = true;
+    }
+
+    void ZipWriter::writeRaw(const void *data, size_t size) {
+        file_.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+        if (!file_) {
+            throw std::runtime_error("Failed to write ZIP file");
+        }
+        offset_ += size;
+    }
+} // namespace TinaToolBox
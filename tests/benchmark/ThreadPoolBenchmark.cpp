@@ -0,0 +1,329 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+#include "ThreadPool.hpp"
+#include "ThreadSafeQueue.hpp"
+
+using namespace TinaToolBox;
+
+namespace {
+    const char *modeName(ThreadPool::SchedulingMode mode) {
+        return mode == ThreadPool::SchedulingMode::WorkStealing ? "WorkStealing" : "SharedQueue";
+    }
+
+    // 外部线程逐个提交 num_tasks 个极小任务，返回从提交到全部完成的耗时
+    std::chrono::microseconds runFlatBenchmark(ThreadPool::SchedulingMode mode, int num_tasks) {
+        ThreadPool pool(std::thread::hardware_concurrency(), mode);
+        std::atomic<int> counter{0};
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_tasks; ++i) {
+            pool.post([&counter] {
+                counter.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        pool.waitForAll();
+        auto end = std::chrono::steady_clock::now();
+
+        EXPECT_EQ(counter.load(), num_tasks);
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    }
+
+    // 每个外部任务在工作线程内部再派生 fan_out 个极小任务
+    std::chrono::microseconds runNestedBenchmark(ThreadPool::SchedulingMode mode, int num_tasks) {
+        ThreadPool pool(std::thread::hardware_concurrency(), mode);
+        std::atomic<int> counter{0};
+        constexpr int fan_out = 100;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_tasks / fan_out; ++i) {
+            pool.post([&pool, &counter] {
+                for (int j = 0; j < fan_out; ++j) {
+                    pool.post([&counter] {
+                        counter.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+            });
+        }
+        pool.waitForAll();
+        auto end = std::chrono::steady_clock::now();
+
+        EXPECT_EQ(counter.load(), num_tasks / fan_out * fan_out);
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    }
+}
+
+class ThreadPoolBenchmark : public ::testing::TestWithParam<int> {
+};
+
+TEST_P(ThreadPoolBenchmark, FlatTinyTasks) {
+    const int num_tasks = GetParam();
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        auto elapsed = runFlatBenchmark(mode, num_tasks);
+        std::cout << "[flat]   " << modeName(mode) << ": " << num_tasks << " tasks in "
+                << elapsed.count() / 1000.0 << "ms" << std::endl;
+    }
+}
+
+TEST_P(ThreadPoolBenchmark, NestedTinyTasks) {
+    const int num_tasks = GetParam();
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        auto elapsed = runNestedBenchmark(mode, num_tasks);
+        std::cout << "[nested] " << modeName(mode) << ": " << num_tasks << " tasks in "
+                << elapsed.count() / 1000.0 << "ms" << std::endl;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(TinyTasks, ThreadPoolBenchmark, ::testing::Values(10000, 100000, 1000000));
+
+namespace {
+    // 当前进程累计消耗的 CPU 时间（所有线程的用户态 + 内核态）
+    std::chrono::microseconds processCpuTime() {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+        auto to_us = [](const FILETIME &ft) {
+            ULARGE_INTEGER value;
+            value.LowPart = ft.dwLowDateTime;
+            value.HighPart = ft.dwHighDateTime;
+            return static_cast<long long>(value.QuadPart / 10);
+        };
+        return std::chrono::microseconds(to_us(kernel) + to_us(user));
+#else
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return std::chrono::microseconds(static_cast<long long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000);
+#endif
+    }
+}
+
+TEST(ThreadPoolWakeupBenchmark, IdleCpuUsage) {
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        ThreadPool pool(std::thread::hardware_concurrency(), mode);
+        pool.post([] {
+        });
+        pool.waitForAll();
+
+        const auto idle_period = std::chrono::milliseconds(500);
+        auto cpu_before = processCpuTime();
+        std::this_thread::sleep_for(idle_period);
+        auto cpu_used = processCpuTime() - cpu_before;
+
+        const double ratio = static_cast<double>(cpu_used.count()) /
+                             std::chrono::duration_cast<std::chrono::microseconds>(idle_period).count();
+        // 只报告数值；空闲时不被唤醒由 ThreadPoolTest.IdleWorkersStayAsleep 检查
+        std::cout << "[idle]    " << modeName(mode) << ": " << pool.threadCount() << " idle workers used "
+                << cpu_used.count() / 1000.0 << "ms CPU in " << idle_period.count() << "ms ("
+                << ratio * 100.0 << "% of one core)" << std::endl;
+    }
+}
+
+TEST(ThreadPoolWakeupBenchmark, EnqueueToStartLatency) {
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        ThreadPool pool(std::thread::hardware_concurrency(), mode);
+        constexpr int samples = 200;
+        std::vector<long long> latencies(samples);
+
+        for (int i = 0; i < samples; ++i) {
+            // 间隔提交，保证每个任务提交时工作线程都已经进入休眠
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            auto enqueue_time = std::chrono::steady_clock::now();
+            pool.post([&latencies, i, enqueue_time] {
+                latencies[i] = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - enqueue_time).count();
+            });
+            pool.waitForAll();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "[latency] " << modeName(mode) << ": p50=" << latencies[samples / 2]
+                << "us p99=" << latencies[samples * 99 / 100] << "us max=" << latencies.back()
+                << "us" << std::endl;
+    }
+}
+
+TEST_P(ThreadPoolBenchmark, SubmitTinyTasks) {
+    const int num_tasks = GetParam();
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        ThreadPool pool(std::thread::hardware_concurrency(), mode);
+        std::vector<std::future<int> > futures;
+        futures.reserve(num_tasks);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_tasks; ++i) {
+            futures.push_back(pool.submit([i] {
+                return i;
+            }));
+        }
+        long long sum = 0;
+        for (auto &future: futures) {
+            sum += future.get();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        EXPECT_EQ(sum, static_cast<long long>(num_tasks - 1) * num_tasks / 2);
+        const auto &stats = pool.getStats();
+        std::cout << "[submit] " << modeName(mode) << ": " << num_tasks << " tasks in "
+                << elapsed.count() / 1000.0 << "ms, task heap allocations=" << stats.task_heap_allocations
+                << ", state arena/heap allocations=" << stats.state_arena_allocations << "/"
+                << stats.state_heap_allocations << std::endl;
+    }
+}
+
+namespace {
+    // producers 个线程各自推入 items_per_producer 个元素，consumers 个线程同时取出，返回总耗时
+    template<typename Queue>
+    std::chrono::microseconds runQueueContention(int producers, int consumers, int items_per_producer) {
+        Queue queue;
+        const long long total = static_cast<long long>(producers) * items_per_producer;
+        std::atomic<long long> consumed{0};
+        std::atomic<long long> checksum{0};
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, items_per_producer] {
+                for (int i = 0; i < items_per_producer; ++i) {
+                    queue.push(i);
+                }
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&queue, &consumed, &checksum, total] {
+                long long local_sum = 0;
+                int value = 0;
+                while (consumed.load(std::memory_order_relaxed) < total) {
+                    if (queue.try_pop(value)) {
+                        local_sum += value;
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                checksum.fetch_add(local_sum);
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        EXPECT_EQ(checksum.load(), static_cast<long long>(producers) * items_per_producer *
+                                   (items_per_producer - 1) / 2);
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    }
+}
+
+class ThreadSafeQueueContentionBenchmark : public ::testing::TestWithParam<int> {
+};
+
+TEST_P(ThreadSafeQueueContentionBenchmark, ProducersAndConsumers) {
+    const int threads = GetParam();
+    const int items_per_producer = 200000 / threads;
+    const double total = static_cast<double>(threads) * items_per_producer;
+
+    auto mutex_elapsed = runQueueContention<ThreadSafeQueue<int> >(threads, threads, items_per_producer);
+    auto ring_elapsed = runQueueContention<ThreadSafeQueue<int, LockFreeRingPolicy<4096> > >(
+        threads, threads, items_per_producer);
+
+    std::cout << "[queue]   " << threads << "P/" << threads << "C: mutex "
+            << total / std::max<long long>(1, mutex_elapsed.count()) << " Mops/s, lock-free ring "
+            << total / std::max<long long>(1, ring_elapsed.count()) << " Mops/s" << std::endl;
+}
+
+INSTANTIATE_TEST_SUITE_P(Contention, ThreadSafeQueueContentionBenchmark, ::testing::Values(1, 2, 4, 8, 16, 32));
+
+namespace {
+    struct StressResult {
+        std::chrono::microseconds elapsed{0};
+        // 共享队列的加锁次数，工作窃取模式下为 0
+        std::uint64_t queue_locks = 0;
+    };
+
+    // 与 StressTest 相同的负载：num_tasks 个 std::function 先构造好，再逐个或整批提交
+    StressResult runStressBenchmark(ThreadPool::SchedulingMode mode, int num_tasks, bool batched) {
+        ThreadPool pool(std::thread::hardware_concurrency(), mode);
+        std::atomic<int> counter{0};
+        std::vector<std::function<void()> > tasks(num_tasks, [&counter] {
+            counter.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        if (batched) {
+            pool.batch_post(tasks.begin(), tasks.end());
+        } else {
+            for (const auto &task: tasks) {
+                pool.post(task);
+            }
+        }
+        pool.waitForAll();
+        auto end = std::chrono::steady_clock::now();
+
+        EXPECT_EQ(counter.load(), num_tasks);
+        return {std::chrono::duration_cast<std::chrono::microseconds>(end - start), pool.telemetry().shared_queue_locks};
+    }
+}
+
+TEST_P(ThreadPoolBenchmark, StressBatchPost) {
+    const int num_tasks = GetParam();
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        auto single = runStressBenchmark(mode, num_tasks, false);
+        auto batched = runStressBenchmark(mode, num_tasks, true);
+        std::cout << "[stress]  " << modeName(mode) << ": " << num_tasks << " tasks, post "
+                << single.elapsed.count() / 1000.0 << "ms, batch_post " << batched.elapsed.count() / 1000.0 << "ms ("
+                << num_tasks / std::max(1.0, static_cast<double>(batched.elapsed.count())) << " Mtasks/s), queue locks per task "
+                << static_cast<double>(single.queue_locks) / num_tasks << " / "
+                << static_cast<double>(batched.queue_locks) / num_tasks << std::endl;
+    }
+}
+
+namespace {
+    // 整批提交 num_tasks 个空任务并等待完成，返回耗时
+    std::chrono::nanoseconds runEmptyTasks(ThreadPool::SchedulingMode mode, bool telemetry, int num_tasks) {
+        ThreadPool::Config config;
+        config.thread_count = std::thread::hardware_concurrency();
+        config.mode = mode;
+        config.telemetry = telemetry;
+        ThreadPool pool(config);
+        std::vector<std::function<void()> > tasks(num_tasks, [] {
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        pool.batch_post(tasks.begin(), tasks.end());
+        pool.waitForAll();
+        auto end = std::chrono::steady_clock::now();
+
+        EXPECT_EQ(pool.telemetry().run_time[static_cast<size_t>(ThreadPool::TaskPriority::Normal)].count,
+                  telemetry ? static_cast<std::uint64_t>(num_tasks) : 0u);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+}
+
+// 遥测在每个任务上的额外开销：同样的空任务分别在开启和关闭遥测的线程池中执行，各取多轮中最快的一次
+TEST(ThreadPoolTelemetryBenchmark, PerTaskOverhead) {
+    constexpr int num_tasks = 1000000;
+    constexpr int rounds = 5;
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        auto with_telemetry = std::chrono::nanoseconds::max();
+        auto without_telemetry = std::chrono::nanoseconds::max();
+        for (int round = 0; round < rounds; ++round) {
+            without_telemetry = std::min(without_telemetry, runEmptyTasks(mode, false, num_tasks));
+            with_telemetry = std::min(with_telemetry, runEmptyTasks(mode, true, num_tasks));
+        }
+        const double off_ns = static_cast<double>(without_telemetry.count()) / num_tasks;
+        const double on_ns = static_cast<double>(with_telemetry.count()) / num_tasks;
+        std::cout << "[telemetry] " << modeName(mode) << ": " << off_ns << "ns per task without telemetry, "
+                << on_ns << "ns with telemetry (+" << on_ns - off_ns << "ns)" << std::endl;
+    }
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "DataFrameFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    using DataFrameAccessorTest = ArrowTest;
+
+    constexpr int64_t ROWS = 40;
+
+    // 各列的原始值
+    struct Data {
+        Ints id;
+        Doubles score;
+        std::vector<std::optional<bool> > flag;
+        Texts name;
+        Texts dept;
+    };
+
+    Data sampleData() {
+        const std::vector<std::string> depts = {"HR", "IT", "Ops"};
+        Data data;
+        for (int64_t i = 0; i < ROWS; ++i) {
+            data.id.push_back(i % 6 == 5 ? std::nullopt : std::optional<int64_t>(i * 10));
+            data.score.push_back(i % 7 == 3 ? std::nullopt : std::optional<double>(i * 0.25));
+            data.flag.push_back(i % 5 == 4 ? std::nullopt : std::optional<bool>(i % 3 == 0));
+            data.name.push_back(i % 4 == 2 ? std::nullopt : std::optional<std::string>("name" + std::to_string(i)));
+            data.dept.push_back(i % 9 == 8 ? std::nullopt : std::optional<std::string>(depts[i % depts.size()]));
+        }
+        return data;
+    }
+
+    // 按 sizes 把 array 切成分块，允许长度为 0 的分块
+    std::shared_ptr<arrow::ChunkedArray> chunked(const std::shared_ptr<arrow::Array> &array,
+                                                 const std::vector<int64_t> &sizes) {
+        arrow::ArrayVector chunks;
+        int64_t offset = 0;
+        for (const int64_t size: sizes) {
+            chunks.push_back(array->Slice(offset, size));
+            offset += size;
+        }
+        EXPECT_EQ(offset, array->length());
+        return std::make_shared<arrow::ChunkedArray>(chunks, array->type());
+    }
+
+    // 每列的分块边界都不同，开头、中间和结尾都有空分块；dept 各分块的字典不同，name 为 large_string
+    DataFrame sampleFrame(const Data &data) {
+        const std::vector<std::vector<std::string> > dictionaries = {{"IT", "HR", "Ops"}, {"Ops", "unused", "IT", "HR"}};
+        const std::vector<std::pair<int64_t, int64_t> > dept_ranges = {{0, 0}, {0, 15}, {15, 15}, {15, 40}};
+        arrow::ArrayVector dept_chunks;
+        for (const auto &[begin, end]: dept_ranges) {
+            const auto &dictionary = dictionaries[dept_chunks.size() % 2];
+            Codes codes;
+            for (int64_t i = begin; i < end; ++i) {
+                if (data.dept[i]) {
+                    codes.emplace_back(static_cast<int32_t>(
+                        std::find(dictionary.begin(), dictionary.end(), *data.dept[i]) - dictionary.begin()));
+                } else {
+                    codes.emplace_back(std::nullopt);
+                }
+            }
+            dept_chunks.push_back(dictionaryArray(dictionary, codes));
+        }
+        const auto dept = std::make_shared<arrow::ChunkedArray>(dept_chunks);
+
+        const std::vector<std::shared_ptr<arrow::ChunkedArray> > columns = {
+            chunked(int64Array(data.id), {0, 7, 0, 0, 13, 1, 19, 0}),
+            chunked(doubleArray(data.score), {40}),
+            chunked(buildArray<arrow::BooleanBuilder>(data.flag), {20, 0, 20}),
+            chunked(buildArray<arrow::LargeStringBuilder>(data.name), {1, 1, 0, 38}),
+            dept,
+        };
+        const auto schema = arrow::schema({
+            arrow::field("id", arrow::int64()), arrow::field("score", arrow::float64()),
+            arrow::field("flag", arrow::boolean()), arrow::field("name", arrow::large_utf8()),
+            arrow::field("dept", dept->type()),
+        });
+        return DataFrame(arrow::Table::Make(schema, columns));
+    }
+
+    // 顺序、倒序和随机三种访问顺序
+    std::vector<std::vector<int64_t> > accessOrders() {
+        std::vector<int64_t> forward;
+        std::vector<int64_t> backward;
+        std::vector<int64_t> random;
+        uint32_t seed = 99;
+        for (int64_t i = 0; i < ROWS; ++i) {
+            forward.push_back(i);
+            backward.push_back(ROWS - 1 - i);
+        }
+        for (int i = 0; i < 500; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            random.push_back(static_cast<int64_t>((seed >> 16) % ROWS));
+        }
+        return {forward, backward, random};
+    }
+
+    template<typename T, typename V>
+    void expectReads(const ColumnAccessor<T> &accessor, const std::vector<std::optional<V> > &expected) {
+        ASSERT_EQ(accessor.length(), static_cast<int64_t>(expected.size()));
+        for (const auto &order: accessOrders()) {
+            for (const int64_t row: order) {
+                const auto actual = accessor.get(row);
+                ASSERT_EQ(accessor.isNull(row), !expected[row].has_value()) << "row " << row;
+                ASSERT_EQ(actual.has_value(), expected[row].has_value()) << "row " << row;
+                if (actual) {
+                    ASSERT_EQ(V(*actual), *expected[row]) << "row " << row;
+                    ASSERT_EQ(V(accessor.value(row)), *expected[row]) << "row " << row;
+                }
+            }
+        }
+        EXPECT_FALSE(accessor.get(-1).has_value());
+        EXPECT_FALSE(accessor.get(accessor.length()).has_value());
+    }
+}
+
+TEST_F(DataFrameAccessorTest, ReadsAcrossChunkBoundaries) {
+    const Data data = sampleData();
+    const DataFrame frame = sampleFrame(data);
+
+    TTB_ASSERT_OK_AND_ASSIGN(id, frame.columnAccessor<int64_t>("id"));
+    expectReads(id, data.id);
+    TTB_ASSERT_OK_AND_ASSIGN(score, frame.columnAccessor<double>("score"));
+    expectReads(score, data.score);
+    TTB_ASSERT_OK_AND_ASSIGN(flag, frame.columnAccessor<bool>("flag"));
+    expectReads(flag, data.flag);
+    TTB_ASSERT_OK_AND_ASSIGN(name, frame.columnAccessor<std::string>("name"));
+    expectReads(name, data.name);
+    TTB_ASSERT_OK_AND_ASSIGN(name_view, frame.columnAccessor<std::string_view>("name"));
+    expectReads(name_view, data.name);
+    TTB_ASSERT_OK_AND_ASSIGN(dept, frame.columnAccessor<std::string>("dept"));
+    expectReads(dept, data.dept);
+    TTB_ASSERT_OK_AND_ASSIGN(dept_view, frame.columnAccessor<std::string_view>("dept"));
+    expectReads(dept_view, data.dept);
+}
+
+TEST_F(DataFrameAccessorTest, ViewsOutliveTheFrame) {
+    const Data data = sampleData();
+    std::optional<ColumnAccessor<std::string_view> > dept;
+    {
+        const DataFrame frame = sampleFrame(data);
+        TTB_ASSERT_OK_AND_ASSIGN(accessor, frame.columnAccessor<std::string_view>("dept"));
+        dept.emplace(accessor);
+    }
+    // 访问器持有列数据，创建它的 DataFrame 销毁后仍可读取
+    expectReads(*dept, data.dept);
+}
+
+TEST_F(DataFrameAccessorTest, ConcurrentAccessorsShareChunkOffsets) {
+    const Data data = sampleData();
+    const DataFrame frame = sampleFrame(data);
+    // 每个线程使用自己的访问器，分块起始行号在第一次创建时计算并缓存
+    std::vector<std::thread> threads;
+    std::vector<int64_t> sums(4, 0);
+    for (size_t t = 0; t < sums.size(); ++t) {
+        threads.emplace_back([&frame, &sums, t] {
+            auto accessor = frame.columnAccessor<int64_t>("id");
+            if (!accessor.ok()) {
+                sums[t] = -1;
+                return;
+            }
+            for (int64_t row = ROWS - 1; row >= 0; --row) {
+                sums[t] += accessor->get(row).value_or(0);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    int64_t expected = 0;
+    for (const auto &value: data.id) {
+        expected += value.value_or(0);
+    }
+    for (const int64_t sum: sums) {
+        EXPECT_EQ(sum, expected);
+    }
+}
+
+TEST_F(DataFrameAccessorTest, EmptyColumnHasNoRows) {
+    const auto schema = arrow::schema({arrow::field("id", arrow::int64())});
+    const DataFrame frame(arrow::Table::Make(schema, {std::make_shared<arrow::ChunkedArray>(
+                                                 arrow::ArrayVector{}, arrow::int64())}));
+    TTB_ASSERT_OK_AND_ASSIGN(id, frame.columnAccessor<int64_t>("id"));
+    EXPECT_EQ(id.length(), 0);
+    EXPECT_FALSE(id.get(0).has_value());
+    EXPECT_FALSE(id.get(-1).has_value());
+}
+
+TEST_F(DataFrameAccessorTest, GetValueAndErrors) {
+    const Data data = sampleData();
+    const DataFrame frame = sampleFrame(data);
+
+    TTB_ASSERT_OK_AND_ASSIGN(id, frame.getValue<int64_t>(20, "id"));
+    EXPECT_EQ(id, 200);
+    TTB_ASSERT_OK_AND_ASSIGN(dept, frame.getValue<std::string>(16, "dept"));
+    EXPECT_EQ(dept, *data.dept[16]);
+    EXPECT_TRUE(frame.getValue<int64_t>(5, "id").status().IsInvalid());
+    EXPECT_TRUE(frame.getValue<int64_t>(ROWS, "id").status().IsInvalid());
+    EXPECT_TRUE(frame.getValue<int64_t>(-1, "id").status().IsInvalid());
+    EXPECT_TRUE(frame.getValue<double>(0, "id").status().IsTypeError());
+
+    EXPECT_TRUE(frame.columnAccessor<int64_t>("missing").status().IsInvalid());
+    EXPECT_TRUE(frame.columnAccessor<int64_t>("score").status().IsTypeError());
+    EXPECT_TRUE(frame.columnAccessor<bool>("id").status().IsTypeError());
+    EXPECT_TRUE(frame.columnAccessor<std::string>("id").status().IsTypeError());
+    EXPECT_TRUE(frame.columnAccessor<std::string_view>("flag").status().IsTypeError());
+
+    // 字典值不是字符串时不能按字符串读取
+    const auto numbers = arrow::DictionaryArray::FromArrays(arrow::dictionary(arrow::int32(), arrow::int64()),
+                                                            buildArray<arrow::Int32Builder>(
+                                                                Codes{0, 1}),
+                                                            int64Array({7, 8})).ValueOrDie();
+    EXPECT_TRUE(frameOf({{"code", numbers}}).columnAccessor<std::string>("code").status().IsTypeError());
+
+    const DataFrame empty;
+    EXPECT_TRUE(empty.columnAccessor<int64_t>("id").status().IsInvalid());
+    EXPECT_TRUE(empty.getValue<int64_t>(0, "id").status().IsInvalid());
+}
@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DataFrameCache.hpp"
+#include "DataFrameFixture.hpp"
+#include "XlsxFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    // 缓存是单例：每个测试使用自己的目录，结束时恢复为关闭状态和默认上限。
+    // 计数器不会清零，测试只比较前后的差值
+    class DataFrameCacheTest : public ArrowTest {
+    protected:
+        void SetUp() override {
+            cache().setCapacity(DataFrameCache::DEFAULT_CAPACITY);
+            cache().setDirectory(dir_.path() / "cache");
+            ASSERT_TRUE(cache().enabled());
+            before_ = cache().stats();
+        }
+
+        void TearDown() override {
+            cache().setDirectory({});
+            cache().setCapacity(DataFrameCache::DEFAULT_CAPACITY);
+        }
+
+        static DataFrameCache &cache() { return DataFrameCache::getInstance(); }
+
+        // 自 SetUp 以来的计数器增量
+        [[nodiscard]] DataFrameCache::Stats delta() const {
+            const auto now = cache().stats();
+            return {now.hits - before_.hits, now.misses - before_.misses,
+                    now.stores - before_.stores, now.evictions - before_.evictions};
+        }
+
+        // 写一个源文件并生成它的缓存键
+        DataFrameCache::Key sourceKey(const std::string &name, const std::string &content, uint64_t hash = 1) {
+            const std::string path = dir_.file(name);
+            std::ofstream(path, std::ios::binary) << content;
+            auto key = DataFrameCache::makeKey(path, hash);
+            EXPECT_TRUE(key.has_value());
+            return key.value_or(DataFrameCache::Key{});
+        }
+
+        std::vector<std::filesystem::path> entries() const {
+            std::vector<std::filesystem::path> paths;
+            for (const auto &entry: std::filesystem::directory_iterator(cache().directory())) {
+                paths.push_back(entry.path());
+            }
+            return paths;
+        }
+
+        TempDirectory dir_;
+        DataFrameCache::Stats before_;
+    };
+
+    DataFrame sampleFrame(int64_t offset = 0) {
+        Ints ids;
+        Texts names;
+        for (int64_t i = 0; i < 500; ++i) {
+            ids.emplace_back(offset + i);
+            names.push_back(i % 9 == 0 ? std::nullopt : std::optional<std::string>("row" + std::to_string(i)));
+        }
+        return TestFixture::sampleFrame({{"id", int64Array(ids)}, {"name", stringArray(names)}}, 128, 2, "status",
+                                        dictionaryColumn({{"open", "closed"}}, Codes(500, 1), 128));
+    }
+
+    // 让下一次写入或命中的修改时间严格晚于之前的缓存文件
+    void tick() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+TEST_F(DataFrameCacheTest, HashChainsFnv1a) {
+    // FNV-1a 64 位的标准测试向量
+    EXPECT_EQ(DataFrameCache::hash("", 0), 0xcbf29ce484222325ULL);
+    EXPECT_EQ(DataFrameCache::hash("a", 1), 0xaf63dc4c8601ec8cULL);
+    EXPECT_EQ(DataFrameCache::hash("foobar", 6), 0x85944171f73967e8ULL);
+    EXPECT_EQ(DataFrameCache::hash("bar", 3, DataFrameCache::hash("foo", 3)), DataFrameCache::hash("foobar", 6));
+}
+
+TEST_F(DataFrameCacheTest, MakeKeyReadsSizeAndNormalizesPath) {
+    const auto key = sourceKey("source.bin", "12345", 42);
+    EXPECT_EQ(key.size, 5u);
+    EXPECT_EQ(key.content_hash, 42u);
+    EXPECT_TRUE(std::filesystem::path(key.path).is_absolute());
+
+    const auto dotted = DataFrameCache::makeKey((dir_.path() / "." / "source.bin").string(), 42);
+    ASSERT_TRUE(dotted.has_value());
+    EXPECT_EQ(dotted->path, key.path);
+    EXPECT_FALSE(DataFrameCache::makeKey(dir_.file("missing.bin"), 42).has_value());
+}
+
+TEST_F(DataFrameCacheTest, StoreThenLookupHits) {
+    const auto key = sourceKey("source.bin", "abc");
+    EXPECT_FALSE(cache().lookup(key).has_value());
+    EXPECT_EQ(delta().misses, 1u);
+
+    const DataFrame frame = sampleFrame();
+    cache().store(key, frame);
+    EXPECT_EQ(delta().stores, 1u);
+    ASSERT_EQ(entries().size(), 1u);
+    EXPECT_EQ(entries().front().extension(), ".arrow");
+
+    auto cached = cache().lookup(key);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(delta().hits, 1u);
+    EXPECT_EQ(cached->rowCount(), frame.rowCount());
+    EXPECT_EQ(cached->getColumn("status")->type()->id(), arrow::Type::DICTIONARY);
+    expectSameContent(*cached, frame);
+}
+
+TEST_F(DataFrameCacheTest, ChangedSourceOrHashMisses) {
+    const auto key = sourceKey("source.bin", "abc");
+    cache().store(key, sampleFrame());
+
+    auto other_hash = key;
+    other_hash.content_hash = 2;
+    EXPECT_FALSE(cache().lookup(other_hash).has_value());
+
+    // 修改源文件后大小改变，键随之变化
+    const auto rewritten = sourceKey("source.bin", "abcdef");
+    EXPECT_NE(rewritten.size, key.size);
+    EXPECT_FALSE(cache().lookup(rewritten).has_value());
+    EXPECT_EQ(delta().misses, 2u);
+    EXPECT_EQ(delta().hits, 0u);
+
+    EXPECT_TRUE(cache().lookup(key).has_value());
+}
+
+TEST_F(DataFrameCacheTest, CorruptEntryIsDiscarded) {
+    const auto key = sourceKey("source.bin", "abc");
+    cache().store(key, sampleFrame());
+    ASSERT_EQ(entries().size(), 1u);
+    std::ofstream(entries().front(), std::ios::binary | std::ios::trunc) << "not an arrow file";
+
+    EXPECT_FALSE(cache().lookup(key).has_value());
+    EXPECT_EQ(delta().misses, 1u);
+    EXPECT_TRUE(entries().empty());
+}
+
+TEST_F(DataFrameCacheTest, EvictsLeastRecentlyUsedOverCapacity) {
+    const auto a = sourceKey("a.bin", "a");
+    const auto b = sourceKey("b.bin", "b");
+    const auto c = sourceKey("c.bin", "c");
+
+    cache().store(a, sampleFrame(0));
+    ASSERT_EQ(entries().size(), 1u);
+    const auto entry_size = std::filesystem::file_size(entries().front());
+    // 能放下两个条目，放不下三个
+    cache().setCapacity(entry_size * 5 / 2);
+
+    tick();
+    cache().store(b, sampleFrame(1000));
+    tick();
+    // 命中刷新 a 的使用时间，b 成为最久未使用的条目
+    ASSERT_TRUE(cache().lookup(a).has_value());
+    tick();
+    cache().store(c, sampleFrame(2000));
+
+    EXPECT_EQ(delta().evictions, 1u);
+    EXPECT_EQ(entries().size(), 2u);
+    EXPECT_FALSE(cache().lookup(b).has_value());
+    auto cached_a = cache().lookup(a);
+    ASSERT_TRUE(cached_a.has_value());
+    expectSameContent(*cached_a, sampleFrame(0));
+    EXPECT_TRUE(cache().lookup(c).has_value());
+
+    // 降低上限时立即淘汰，刚写入的条目超过上限也会保留
+    cache().setCapacity(1);
+    EXPECT_TRUE(entries().empty());
+    cache().store(a, sampleFrame(0));
+    EXPECT_EQ(entries().size(), 1u);
+}
+
+TEST_F(DataFrameCacheTest, ClearRemovesEntriesButKeepsCounters) {
+    const auto key = sourceKey("source.bin", "abc");
+    cache().store(key, sampleFrame());
+    std::ofstream(cache().directory() / "unrelated.txt") << "keep";
+
+    cache().clear();
+    ASSERT_EQ(entries().size(), 1u);
+    EXPECT_EQ(entries().front().filename(), "unrelated.txt");
+    EXPECT_EQ(delta().stores, 1u);
+    EXPECT_FALSE(cache().lookup(key).has_value());
+}
+
+TEST_F(DataFrameCacheTest, EmptyDirectoryDisablesCache) {
+    const auto key = sourceKey("source.bin", "abc");
+    cache().setDirectory({});
+    EXPECT_FALSE(cache().enabled());
+    cache().store(key, sampleFrame());
+    EXPECT_FALSE(cache().lookup(key).has_value());
+    cache().clear();
+
+    const auto d = delta();
+    EXPECT_EQ(d.hits + d.misses + d.stores + d.evictions, 0u);
+}
+
+TEST_F(DataFrameCacheTest, FromExcelStoresThenHits) {
+    const std::string path = dir_.file("book.xlsx");
+    std::string sheet = R"(<row r="1"><c r="A1" t="inlineStr"><is><t>Id</t></is></c>)"
+                        R"(<c r="B1" t="inlineStr"><is><t>Code</t></is></c></row>)";
+    for (int i = 2; i <= 50; ++i) {
+        const std::string r = std::to_string(i);
+        const std::string code = i == 20 ? R"(t="inlineStr"><is><t>N/A</t></is>)" : "><v>" + r + "</v>";
+        sheet += R"(<row r=")" + r + R"("><c r="A)" + r + R"("><v>)" + r + R"(</v></c><c r="B)" + r + R"(" )" +
+                code + "</c></row>";
+    }
+    writeXlsx(path, sheet);
+
+    const DataFrame loaded = DataFrame::fromExcel(path);
+    EXPECT_EQ(delta().misses, 1u);
+    // 写缓存是线程池上的低优先级任务
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (delta().stores == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(delta().stores, 1u);
+
+    const DataFrame cached = DataFrame::fromExcel(path);
+    EXPECT_EQ(delta().hits, 1u);
+    ASSERT_EQ(cached.getColumnNames(), loaded.getColumnNames());
+    EXPECT_EQ(columnValues<int64_t>(cached, "Id"), columnValues<int64_t>(loaded, "Id"));
+    EXPECT_EQ(columnValues<std::string>(cached, "Code"), columnValues<std::string>(loaded, "Code"));
+
+    // 加载报告随缓存保存
+    ASSERT_EQ(cached.loadReport().size(), loaded.loadReport().size());
+    for (size_t i = 0; i < loaded.loadReport().size(); ++i) {
+        EXPECT_EQ(cached.loadReport()[i].column, loaded.loadReport()[i].column);
+        EXPECT_TRUE(cached.loadReport()[i].type->Equals(*loaded.loadReport()[i].type));
+        EXPECT_EQ(cached.loadReport()[i].values, loaded.loadReport()[i].values);
+        EXPECT_EQ(cached.loadReport()[i].coerced, loaded.loadReport()[i].coerced);
+    }
+    EXPECT_EQ(loaded.loadReport()[1].coerced, 48);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+#include "DataFrameFixture.hpp"
+#include "XlsxFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    using DataFrameCsvTest = ArrowTest;
+
+    constexpr int64_t ROWS = 3000;
+
+    // 中文 "中文" 的 UTF-8 和 GBK 编码
+    const std::string CHINESE_UTF8 = "\xE4\xB8\xAD\xE6\x96\x87";
+    const std::string CHINESE_GBK = "\xD6\xD0\xCE\xC4";
+
+    Texts sampleNames() {
+        Texts names;
+        for (int64_t i = 0; i < ROWS; ++i) {
+            // 长度不同，多字节字符会落在转码分块的边界上
+            names.push_back(i % 10 == 0 ? std::nullopt
+                                        : std::optional<std::string>(CHINESE_UTF8 + std::string(i % 7, 'x') +
+                                                                     std::to_string(i)));
+        }
+        return names;
+    }
+
+    // id、score、name 和一个字典列；name 含中文和空值
+    DataFrame sampleFrame() {
+        Ints ids;
+        Doubles scores;
+        Codes codes;
+        for (int64_t i = 0; i < ROWS; ++i) {
+            ids.emplace_back(i);
+            scores.push_back(i % 9 == 0 ? std::nullopt : std::optional<double>(i * 0.25));
+            codes.emplace_back(static_cast<int32_t>(i % 2));
+        }
+        const auto dept = dictionaryColumn({{"\xE9\x94\x80\xE5\x94\xAE", "IT"}}, codes, 1000);
+        return TestFixture::sampleFrame({{"id", int64Array(ids)}, {"score", doubleArray(scores)},
+                                         {"name", stringArray(sampleNames())}}, 1000, 3, "dept", dept);
+    }
+
+    std::string readBytes(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void expectSampleContent(const DataFrame &loaded) {
+        const DataFrame frame = sampleFrame();
+        ASSERT_EQ(loaded.getColumnNames(), frame.getColumnNames());
+        EXPECT_EQ(columnValues<int64_t>(loaded, "id"), columnValues<int64_t>(frame, "id"));
+        EXPECT_EQ(columnValues<double>(loaded, "score"), columnValues<double>(frame, "score"));
+        EXPECT_EQ(columnValues<std::string>(loaded, "name"), columnValues<std::string>(frame, "name"));
+        // 字典列写出为字符串，读回为字符串列
+        EXPECT_EQ(loaded.getColumn("dept")->type()->id(), arrow::Type::STRING);
+        EXPECT_EQ(columnValues<std::string>(loaded, "dept"), columnValues<std::string>(frame, "dept"));
+    }
+}
+
+TEST_F(DataFrameCsvTest, GbkTsvRoundTrip) {
+    TempDirectory dir;
+    const std::string path = dir.file("gbk.tsv");
+    CsvWriteOptions write_options;
+    write_options.delimiter = '\t';
+    write_options.encoding = "GBK";
+    write_options.batch_rows = 700;
+    ASSERT_TRUE(sampleFrame().toCsv(path, write_options).ok());
+
+    const std::string bytes = readBytes(path);
+    EXPECT_NE(bytes.find(CHINESE_GBK), std::string::npos);
+    EXPECT_EQ(bytes.find(CHINESE_UTF8), std::string::npos);
+    EXPECT_EQ(bytes.rfind("\"id\"\t\"score\"\t\"name\"\t\"dept\"", 0), 0u);
+
+    // 块很小，转码时多字节字符会被切在两次读取之间
+    CsvReadOptions read_options;
+    read_options.delimiter = '\t';
+    read_options.encoding = "GBK";
+    read_options.block_size = 4096;
+    TTB_ASSERT_OK_AND_ASSIGN(explicit_gbk, DataFrame::fromCsv(path, read_options));
+    expectSampleContent(explicit_gbk);
+
+    // 不指定编码时按文件开头检测
+    read_options.encoding.clear();
+    TTB_ASSERT_OK_AND_ASSIGN(detected, DataFrame::fromCsv(path, read_options));
+    expectSampleContent(detected);
+}
+
+TEST_F(DataFrameCsvTest, Utf8BomAndHeaderOptions) {
+    TempDirectory dir;
+    const std::string path = dir.file("utf8.csv");
+    CsvWriteOptions write_options;
+    write_options.utf8_bom = true;
+    ASSERT_TRUE(sampleFrame().toCsv(path, write_options).ok());
+    EXPECT_EQ(readBytes(path).rfind("\xEF\xBB\xBF\"id\"", 0), 0u);
+    TTB_ASSERT_OK_AND_ASSIGN(loaded, DataFrame::fromCsv(path));
+    expectSampleContent(loaded);
+
+    // 没有列名行时列名为 f0、f1……
+    const std::string headless = dir.file("headless.csv");
+    write_options.utf8_bom = false;
+    write_options.include_header = false;
+    ASSERT_TRUE(sampleFrame().toCsv(headless, write_options).ok());
+    CsvReadOptions read_options;
+    read_options.has_header = false;
+    TTB_ASSERT_OK_AND_ASSIGN(generated, DataFrame::fromCsv(headless, read_options));
+    EXPECT_EQ(generated.getColumnNames(), (std::vector<std::string>{"f0", "f1", "f2", "f3"}));
+    EXPECT_EQ(generated.rowCount(), static_cast<size_t>(ROWS));
+    EXPECT_EQ(columnValues<std::string>(generated, "f2"), sampleNames());
+}
+
+TEST_F(DataFrameCsvTest, ColumnSelectionTypesAndTimestamps) {
+    TempDirectory dir;
+    const std::string path = dir.file("typed.csv");
+    std::ofstream(path, std::ios::binary) << "id,at,day,note\n"
+                                             "1,2024-01-02T03:04:05,2024/01/02 03:04:05,a\n"
+                                             "2,,2024/12/31,\n"
+                                             "3,2024-06-30 23:59:59,,c\n";
+
+    CsvReadOptions options;
+    options.encoding = "UTF-8";
+    options.columns = {"note", "id", "day", "at"};
+    options.column_types = {{"id", arrow::float64()}};
+    TTB_ASSERT_OK_AND_ASSIGN(loaded, DataFrame::fromCsv(path, options));
+    EXPECT_EQ(loaded.getColumnNames(), (std::vector<std::string>{"note", "id", "day", "at"}));
+    EXPECT_EQ(columnValues<double>(loaded, "id"), (Doubles{1.0, 2.0, 3.0}));
+    // 空字段读为空值
+    EXPECT_EQ(columnValues<std::string>(loaded, "note"), (Texts{"a", std::nullopt, "c"}));
+    for (const auto &name: {"at", "day"}) {
+        const auto column = loaded.getColumn(name);
+        ASSERT_EQ(column->type()->id(), arrow::Type::TIMESTAMP) << name << ": " << column->type()->ToString();
+        EXPECT_EQ(column->null_count(), 1) << name;
+    }
+    const auto at = std::static_pointer_cast<arrow::TimestampScalar>(loaded.getColumn("at")->GetScalar(0).ValueOrDie());
+    const auto day = std::static_pointer_cast<arrow::TimestampScalar>(loaded.getColumn("day")->GetScalar(0).ValueOrDie());
+    EXPECT_EQ(at->ToString(), day->ToString());
+}
+
+TEST_F(DataFrameCsvTest, InvalidArgumentsReturnErrors) {
+    TempDirectory dir;
+    const DataFrame frame = sampleFrame();
+    CsvWriteOptions write_options;
+    write_options.encoding = "NO-SUCH-ENCODING";
+    EXPECT_TRUE(frame.toCsv(dir.file("bad.csv"), write_options).IsInvalid());
+    EXPECT_TRUE(DataFrame().toCsv(dir.file("empty.csv")).IsInvalid());
+
+    const std::string path = dir.file("sample.csv");
+    ASSERT_TRUE(frame.toCsv(path).ok());
+    CsvReadOptions read_options;
+    read_options.encoding = "NO-SUCH-ENCODING";
+    EXPECT_TRUE(DataFrame::fromCsv(path, read_options).status().IsInvalid());
+    read_options.encoding.clear();
+    read_options.columns = {"missing"};
+    EXPECT_FALSE(DataFrame::fromCsv(path, read_options).ok());
+    EXPECT_FALSE(DataFrame::fromCsv(dir.file("missing.csv")).ok());
+}
@@ -0,0 +1,389 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DataFrameFixture.hpp"
+#include "XlsxFixture.hpp"
+#include "XlsxStreamReader.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    using DataFrameExcelTest = ArrowTest;
+
+    std::string inlineCell(const std::string &ref, const std::string &text) {
+        return R"(<c r=")" + ref + R"(" t="inlineStr"><is><t>)" + text + "</t></is></c>";
+    }
+
+    std::string sharedCell(const std::string &ref, int index) {
+        return R"(<c r=")" + ref + R"(" t="s"><v>)" + std::to_string(index) + "</v></c>";
+    }
+
+    std::string numberCell(const std::string &ref, const std::string &value, int style = 0) {
+        return R"(<c r=")" + ref + R"(" s=")" + std::to_string(style) + R"("><v>)" + value + "</v></c>";
+    }
+
+    std::string row(int number, const std::string &cells) {
+        return R"(<row r=")" + std::to_string(number) + R"(">)" + cells + "</row>";
+    }
+
+    // 共享字符串表的顺序与字母顺序不同，排序结果可以区分按编码还是按文本比较
+    const std::string STATUS_STRINGS =
+            "<sst><si><t>open</t></si><si><t>closed</t></si><si><t>pending</t></si>"
+            "<si><t>HR</t></si><si><t>IT</t></si></sst>";
+
+    // Id, Status, Dept；第 6 行状态为空，第 7 行状态是不在共享字符串表里的内联文本
+    std::string statusSheet() {
+        std::string xml = row(1, inlineCell("A1", "Id") + inlineCell("B1", "Status") + inlineCell("C1", "Dept"));
+        const std::vector<std::optional<int> > status = {1, 0, 2, 0, std::nullopt, -1, 1};
+        for (int i = 0; i < static_cast<int>(status.size()); ++i) {
+            const std::string r = std::to_string(i + 2);
+            std::string cells = numberCell("A" + r, std::to_string(i + 1));
+            if (status[i] && *status[i] >= 0) {
+                cells += sharedCell("B" + r, *status[i]);
+            } else if (status[i]) {
+                cells += inlineCell("B" + r, "archived");
+            }
+            cells += sharedCell("C" + r, 3 + i % 2);
+            xml += row(i + 2, cells);
+        }
+        return xml;
+    }
+
+    std::string boolCell(const std::string &ref, bool value) {
+        return R"(<c r=")" + ref + R"(" t="b"><v>)" + (value ? "1" : "0") + "</v></c>";
+    }
+
+    std::string textCell(const std::string &ref, const std::string &text) {
+        return R"(<c r=")" + ref + R"(" t="str"><v>)" + text + "</v></c>";
+    }
+
+    // 每列在后面的行遇到放不下的值：
+    // A 整数 -> 小数，B 整数 -> 文本，C 日期 -> 文本，D 布尔中夹着数字 -> 文本，E 前两行为空，F 共享字符串中夹着数字，G 全是日期
+    std::string wideningSheet() {
+        std::string xml = row(1, inlineCell("A1", "Int") + inlineCell("B1", "Code") + inlineCell("C1", "When") +
+                                 inlineCell("D1", "Flag") + inlineCell("E1", "Late") + inlineCell("F1", "Kind") +
+                                 inlineCell("G1", "Date"));
+        xml += row(2, numberCell("A2", "1") + numberCell("B2", "10") + numberCell("C2", "45000.5", 1) +
+                      boolCell("D2", true) + sharedCell("F2", 0) + numberCell("G2", "45001", 1));
+        xml += row(3, numberCell("A3", "2") + inlineCell("B3", "N/A") + numberCell("C3", "45001", 2) +
+                      boolCell("D3", false) + numberCell("F3", "3.5") + numberCell("G3", "45002.25", 1));
+        xml += row(4, numberCell("A4", "3") + numberCell("B4", "30") + textCell("C4", "later") +
+                      numberCell("D4", "7") + numberCell("E4", "5") + sharedCell("F4", 1));
+        xml += row(5, numberCell("A5", "4.5") + numberCell("C5", "45002", 1) + numberCell("E5", "6") +
+                      sharedCell("F5", 0) + numberCell("G5", "45003", 2));
+        return xml;
+    }
+
+    const DataFrame::ColumnLoadReport *reportFor(const DataFrame &frame, const std::string &column) {
+        for (const auto &entry: frame.loadReport()) {
+            if (entry.column == column) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    Ints ids(const DataFrame &frame) {
+        return columnValues<int64_t>(frame, "Id");
+    }
+}
+
+TEST_F(DataFrameExcelTest, SharedStringColumnsAreDictionaryEncoded) {
+    TempDirectory dir;
+    const std::string path = dir.file("status.xlsx");
+    writeXlsx(path, statusSheet(), STATUS_STRINGS);
+
+    const DataFrame frame = DataFrame::fromExcel(path);
+    ASSERT_EQ(frame.rowCount(), 7u);
+    EXPECT_EQ(frame.getColumnNames(), (std::vector<std::string>{"Id", "Status", "Dept"}));
+
+    const auto dictionary_type = arrow::dictionary(arrow::int32(), arrow::utf8());
+    const auto status = frame.getColumn("Status");
+    ASSERT_TRUE(status->type()->Equals(*dictionary_type)) << status->type()->ToString();
+    EXPECT_TRUE(frame.getColumn("Dept")->type()->Equals(*dictionary_type));
+    EXPECT_EQ(frame.getColumn("Id")->type()->id(), arrow::Type::INT64);
+
+    // 每列的字典只含本列用到的文本，按第一次出现的顺序编码，内联文本和共享字符串一样编入字典
+    auto dictionaryOf = [](const std::shared_ptr<arrow::ChunkedArray> &column) {
+        Codes codes;
+        std::shared_ptr<arrow::Array> dictionary;
+        for (const auto &chunk: column->chunks()) {
+            const auto &array = static_cast<const arrow::DictionaryArray &>(*chunk);
+            EXPECT_TRUE(!dictionary || dictionary == array.dictionary());
+            dictionary = array.dictionary();
+            const auto &indices = static_cast<const arrow::Int32Array &>(*array.indices());
+            for (int64_t i = 0; i < indices.length(); ++i) {
+                codes.push_back(indices.IsNull(i) ? std::nullopt : std::optional<int32_t>(indices.Value(i)));
+            }
+        }
+        std::vector<std::string> entries;
+        for (int64_t i = 0; i < dictionary->length(); ++i) {
+            entries.push_back(static_cast<const arrow::StringArray &>(*dictionary).GetString(i));
+        }
+        return std::make_pair(codes, entries);
+    };
+    const auto [codes, entries] = dictionaryOf(status);
+    EXPECT_EQ(codes, (Codes{0, 1, 2, 1, std::nullopt, 3, 0}));
+    EXPECT_EQ(entries, (std::vector<std::string>{"closed", "open", "pending", "archived"}));
+    EXPECT_EQ(dictionaryOf(frame.getColumn("Dept")).second, (std::vector<std::string>{"HR", "IT"}));
+
+    EXPECT_EQ(columnValues<std::string>(frame, "Status"),
+              (Texts{"closed", "open", "pending", "open", std::nullopt,
+                  "archived", "closed"}));
+}
+
+TEST_F(DataFrameExcelTest, FilterAndSortOnDictionaryCodes) {
+    TempDirectory dir;
+    const std::string path = dir.file("status.xlsx");
+    writeXlsx(path, statusSheet(), STATUS_STRINGS);
+    const DataFrame frame = DataFrame::fromExcel(path);
+
+    TTB_ASSERT_OK_AND_ASSIGN(open, frame.filter("Status", arrow::MakeScalar("open")));
+    EXPECT_EQ(ids(open), (Ints{2, 4}));
+
+    TTB_ASSERT_OK_AND_ASSIGN(extra, frame.filter("Status", arrow::MakeScalar("archived")));
+    EXPECT_EQ(ids(extra), (Ints{6}));
+
+    TTB_ASSERT_OK_AND_ASSIGN(missing, frame.filter("Status", arrow::MakeScalar("unknown")));
+    EXPECT_EQ(missing.rowCount(), 0u);
+
+    TTB_ASSERT_OK_AND_ASSIGN(not_open, frame.filter("Status", arrow::MakeScalar("open"), "not_equal"));
+    EXPECT_EQ(ids(not_open), (Ints{1, 3, 6, 7}));
+
+    TTB_ASSERT_OK_AND_ASSIGN(in_set, frame.filter(
+                                 Predicate::isIn("Status", stringArray({"open", "archived"}))));
+    EXPECT_EQ(ids(in_set), (Ints{2, 4, 6}));
+
+    // 按文本而不是编码排序，相同值保持原有顺序，空值在最后
+    TTB_ASSERT_OK_AND_ASSIGN(sorted, frame.sort("Status"));
+    EXPECT_EQ(ids(sorted), (Ints{6, 1, 7, 2, 4, 3, 5}));
+    EXPECT_TRUE(sorted.getColumn("Status")->type()->id() == arrow::Type::DICTIONARY);
+
+    TTB_ASSERT_OK_AND_ASSIGN(descending, frame.sort({{"Status", false, true}}));
+    EXPECT_EQ(ids(descending), (Ints{5, 3, 2, 4, 1, 7, 6}));
+}
+
+TEST_F(DataFrameExcelTest, ColumnsWidenInsteadOfDroppingValues) {
+    TempDirectory dir;
+    const std::string path = dir.file("widen.xlsx");
+    writeXlsx(path, wideningSheet(), "<sst><si><t>x</t></si><si><t>y</t></si></sst>", "A1:G5");
+
+    const DataFrame frame = DataFrame::fromExcel(path);
+    ASSERT_EQ(frame.rowCount(), 4u);
+
+    EXPECT_EQ(frame.getColumn("Int")->type()->id(), arrow::Type::DOUBLE);
+    EXPECT_EQ(columnValues<double>(frame, "Int"), (Doubles{1.0, 2.0, 3.0, 4.5}));
+
+    EXPECT_EQ(frame.getColumn("Code")->type()->id(), arrow::Type::STRING);
+    EXPECT_EQ(columnValues<std::string>(frame, "Code"),
+              (Texts{"10", "N/A", "30", std::nullopt}));
+
+    // 日期放宽为文本时按本地时间格式化
+    EXPECT_EQ(frame.getColumn("When")->type()->id(), arrow::Type::STRING);
+    EXPECT_EQ(columnValues<std::string>(frame, "When"),
+              (Texts{"2023-03-15 12:00:00", "2023-03-16 00:00:00", "later",
+                  "2023-03-17 00:00:00"}));
+
+    EXPECT_EQ(columnValues<std::string>(frame, "Flag"),
+              (Texts{"TRUE", "FALSE", "7", std::nullopt}));
+
+    // 第一个值出现之前的行补为空值
+    EXPECT_EQ(frame.getColumn("Late")->type()->id(), arrow::Type::INT64);
+    EXPECT_EQ(columnValues<int64_t>(frame, "Late"),
+              (Ints{std::nullopt, std::nullopt, 5, 6}));
+
+    // 字典列可以容纳数字，数字的文本追加到字典
+    EXPECT_EQ(frame.getColumn("Kind")->type()->id(), arrow::Type::DICTIONARY);
+    EXPECT_EQ(columnValues<std::string>(frame, "Kind"),
+              (Texts{"x", "3.5", "y", "x"}));
+
+    const auto date = frame.getColumn("Date");
+    ASSERT_EQ(date->type()->id(), arrow::Type::TIMESTAMP);
+    const auto dates = std::static_pointer_cast<arrow::TimestampArray>(
+        arrow::Concatenate(date->chunks()).ValueOrDie());
+    EXPECT_EQ(dates->Value(1) - dates->Value(0), 30LL * 3600 * 1000000);
+    EXPECT_TRUE(dates->IsNull(2));
+    EXPECT_EQ(dates->Value(3) - dates->Value(0), 2LL * 86400 * 1000000);
+}
+
+TEST_F(DataFrameExcelTest, LoadReportCountsCoercedValues) {
+    TempDirectory dir;
+    const std::string path = dir.file("widen.xlsx");
+    writeXlsx(path, wideningSheet(), "<sst><si><t>x</t></si><si><t>y</t></si></sst>", "A1:G5");
+
+    const DataFrame frame = DataFrame::fromExcel(path);
+    ASSERT_EQ(frame.loadReport().size(), 7u);
+
+    struct Expected {
+        const char *column;
+        arrow::Type::type type;
+        int64_t values;
+        int64_t coerced;
+    };
+    const Expected expected[] = {
+        {"Int", arrow::Type::DOUBLE, 4, 3},
+        {"Code", arrow::Type::STRING, 3, 2},
+        {"When", arrow::Type::STRING, 4, 3},
+        {"Flag", arrow::Type::STRING, 3, 3},
+        {"Late", arrow::Type::INT64, 2, 0},
+        {"Kind", arrow::Type::DICTIONARY, 4, 1},
+        {"Date", arrow::Type::TIMESTAMP, 3, 0},
+    };
+    for (const auto &e: expected) {
+        const auto *entry = reportFor(frame, e.column);
+        ASSERT_NE(entry, nullptr) << e.column;
+        EXPECT_EQ(entry->type->id(), e.type) << e.column;
+        EXPECT_EQ(entry->values, e.values) << e.column;
+        EXPECT_EQ(entry->coerced, e.coerced) << e.column;
+    }
+
+    // 不是从 xlsx 读取的 DataFrame 没有报告
+    EXPECT_TRUE(frameOf({{"a", int64Array({1})}}).loadReport().empty());
+}
+
+TEST_F(DataFrameExcelTest, WideningConvertsEarlierChunks) {
+    // 超过一个构建分块（至少 1000 行）之后才出现文本，已封装的分块也要转换
+    constexpr int rows = 2500;
+    std::string xml = row(1, inlineCell("A1", "Value"));
+    for (int i = 0; i < rows; ++i) {
+        const std::string r = std::to_string(i + 2);
+        xml += row(i + 2, i == 2400 ? inlineCell("A" + r, "text") : numberCell("A" + r, std::to_string(i)));
+    }
+    TempDirectory dir;
+    const std::string path = dir.file("chunks.xlsx");
+    writeXlsx(path, xml, "<sst/>", "A1:A" + std::to_string(rows + 1));
+
+    const DataFrame frame = DataFrame::fromExcel(path);
+    ASSERT_EQ(frame.rowCount(), static_cast<size_t>(rows));
+    EXPECT_GT(frame.getColumn("Value")->num_chunks(), 1);
+    const auto values = columnValues<std::string>(frame, "Value");
+    for (int i = 0; i < rows; ++i) {
+        ASSERT_EQ(values[i], i == 2400 ? std::string("text") : std::to_string(i)) << "row " << i;
+    }
+    ASSERT_EQ(frame.loadReport().size(), 1u);
+    EXPECT_EQ(frame.loadReport()[0].coerced, rows - 1);
+}
+
+TEST_F(DataFrameExcelTest, ToSaveExcelRoundTripsThroughFromExcel) {
+    // 跨越 toSaveExcel 的写出批次（4096 行），各列的分块边界互不对齐
+    constexpr int64_t rows = 5000;
+    Ints id_values;
+    Doubles scores;
+    Texts names;
+    Codes codes;
+    std::vector<std::optional<bool> > flags;
+    // 2023-11 到 2024-01 之间，不经过夏令时切换，按本地时间往返不会有歧义
+    arrow::TimestampBuilder stamps(arrow::timestamp(arrow::TimeUnit::SECOND), arrow::default_memory_pool());
+    for (int64_t i = 0; i < rows; ++i) {
+        id_values.push_back(i % 13 == 0 ? std::nullopt : std::optional<int64_t>(i * 1000003));
+        scores.push_back(i % 7 == 0 ? std::nullopt : std::optional<double>(i + 0.25));
+        names.push_back(i % 11 == 0 ? std::nullopt : std::optional<std::string>("n<" + std::to_string(i % 50) + ">"));
+        codes.push_back(i % 17 == 0 ? std::nullopt : std::optional<int32_t>(static_cast<int32_t>(i % 3)));
+        flags.push_back(i % 5 == 0 ? std::nullopt : std::optional<bool>(i % 2 == 0));
+        ASSERT_TRUE((i % 19 == 0 ? stamps.AppendNull() : stamps.Append(1700000000 + i * 1000)).ok());
+    }
+    const auto status = dictionaryColumn({{"open", "closed", "pending"}, {"pending", "open", "closed"}}, codes,
+                                         rows / 2);
+    const DataFrame frame = sampleFrame({
+        {"id", int64Array(id_values)},
+        {"score", doubleArray(scores)},
+        {"name", stringArray(names)},
+        {"flag", buildArray<arrow::BooleanBuilder>(flags)},
+        {"at", stamps.Finish().ValueOrDie()},
+    }, 1700, 3, "status", status);
+
+    TempDirectory dir;
+    const std::string path = dir.file("round_trip.xlsx");
+    ASSERT_TRUE(frame.toSaveExcel(path));
+    EXPECT_FALSE(frame.toSaveExcel(path));
+    EXPECT_TRUE(frame.toSaveExcel(path, true));
+    EXPECT_FALSE(DataFrame().toSaveExcel(dir.file("empty.xlsx")));
+
+    const DataFrame loaded = DataFrame::fromExcel(path);
+    ASSERT_EQ(loaded.getColumnNames(), frame.getColumnNames());
+    ASSERT_EQ(loaded.rowCount(), static_cast<size_t>(rows));
+
+    EXPECT_EQ(loaded.getColumn("id")->type()->id(), arrow::Type::INT64);
+    EXPECT_EQ(columnValues<int64_t>(loaded, "id"), id_values);
+    EXPECT_EQ(loaded.getColumn("score")->type()->id(), arrow::Type::DOUBLE);
+    EXPECT_EQ(columnValues<double>(loaded, "score"), scores);
+    // 文本写入共享字符串表，读回来是字典列
+    EXPECT_EQ(loaded.getColumn("name")->type()->id(), arrow::Type::DICTIONARY);
+    EXPECT_EQ(columnValues<std::string>(loaded, "name"), names);
+    EXPECT_EQ(columnValues<std::string>(loaded, "status"), columnValues<std::string>(frame, "status"));
+    EXPECT_EQ(loaded.getColumn("flag")->type()->id(), arrow::Type::BOOL);
+    EXPECT_EQ(columnValues<bool>(loaded, "flag"), flags);
+
+    const auto at = loaded.getColumn("at");
+    ASSERT_TRUE(at->type()->Equals(*arrow::timestamp(arrow::TimeUnit::MICRO))) << at->type()->ToString();
+    const auto written = std::static_pointer_cast<arrow::TimestampArray>(
+        arrow::Concatenate(frame.getColumn("at")->chunks()).ValueOrDie());
+    const auto read = std::static_pointer_cast<arrow::TimestampArray>(
+        arrow::Concatenate(at->chunks()).ValueOrDie());
+    for (int64_t i = 0; i < rows; ++i) {
+        ASSERT_EQ(read->IsNull(i), written->IsNull(i)) << "row " << i;
+        if (!written->IsNull(i)) {
+            ASSERT_EQ(read->Value(i), written->Value(i) * 1000000) << "row " << i;
+        }
+    }
+
+    for (const auto &entry: loaded.loadReport()) {
+        EXPECT_EQ(entry.coerced, 0) << entry.column;
+    }
+}
+
+TEST_F(DataFrameExcelTest, ToSaveExcelSkipsUnusedDictionaryValues) {
+    // 字典中没有被任何行引用的值不写入共享字符串表，读回的字典也只有用到的值
+    const DataFrame frame = frameOf({{"status", dictionaryArray({"unused", "open", "spare", "closed"},
+                                                                {1, 3, std::nullopt, 1})}});
+    TempDirectory dir;
+    const std::string path = dir.file("dictionary.xlsx");
+    ASSERT_TRUE(frame.toSaveExcel(path));
+
+    const XlsxStreamReader reader(path);
+    std::vector<std::string> shared;
+    for (uint32_t i = 0; i < reader.sharedStringCount(); ++i) {
+        shared.emplace_back(reader.sharedString(i));
+    }
+    EXPECT_EQ(std::count(shared.begin(), shared.end(), "unused"), 0);
+    EXPECT_EQ(std::count(shared.begin(), shared.end(), "spare"), 0);
+
+    const DataFrame loaded = DataFrame::fromExcel(path);
+    EXPECT_EQ(columnValues<std::string>(loaded, "status"),
+              (Texts{"open", "closed", std::nullopt, "open"}));
+    const auto &chunk = static_cast<const arrow::DictionaryArray &>(*loaded.getColumn("status")->chunk(0));
+    EXPECT_EQ(chunk.dictionary()->length(), 2);
+}
+
+TEST_F(DataFrameExcelTest, ToSaveExcelWritesUnrepresentableTimestampsAsText) {
+    // 换算为微秒会溢出的秒数写为 #NUM!，早于 1900 年的时间写为本地时间文本
+    arrow::TimestampBuilder stamps(arrow::timestamp(arrow::TimeUnit::SECOND), arrow::default_memory_pool());
+    ASSERT_TRUE(stamps.Append(1700000000).ok());
+    ASSERT_TRUE(stamps.Append(std::numeric_limits<int64_t>::max() / 2).ok());
+    ASSERT_TRUE(stamps.Append(std::numeric_limits<int64_t>::min() / 2).ok());
+    ASSERT_TRUE(stamps.AppendNull().ok());
+    ASSERT_TRUE(stamps.Append(-2300000000LL).ok());
+    const DataFrame frame = frameOf({{"at", stamps.Finish().ValueOrDie()}});
+
+    TempDirectory dir;
+    const std::string path = dir.file("stamps.xlsx");
+    ASSERT_TRUE(frame.toSaveExcel(path));
+
+    const DataFrame loaded = DataFrame::fromExcel(path);
+    ASSERT_EQ(loaded.getColumn("at")->type()->id(), arrow::Type::STRING);
+    const auto values = columnValues<std::string>(loaded, "at");
+    ASSERT_EQ(values.size(), 5u);
+    ASSERT_TRUE(values[0].has_value());
+    EXPECT_EQ(values[0]->substr(0, 9), "2023-11-1");
+    EXPECT_EQ(values[1], "#NUM!");
+    EXPECT_EQ(values[2], "#NUM!");
+    EXPECT_EQ(values[3], std::nullopt);
+    ASSERT_TRUE(values[4].has_value());
+    EXPECT_EQ(values[4]->substr(0, 5), "1897-");
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+#include "DataFrameFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+namespace cp = arrow::compute;
+
+namespace {
+    using DataFrameFilterTest = ArrowTest;
+
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    // row 是行号；id、score、name、dept 各有空值，score 有 NaN。
+    // 其余列每 4 行一个分块，dept 由两个字典不同的分块组成，批次边界是两者的并集
+    DataFrame sampleFrame() {
+        const auto dept = dictionaryColumn({{"HR", "IT", "Ops"}, {"Ops", "HR", "IT", "unused"}},
+                                           {0, 1, std::nullopt, 1, 2, 1, 2, std::nullopt, 0, 1}, 5);
+        return TestFixture::sampleFrame({
+            {"row", int64Array({0, 1, 2, 3, 4, 5, 6, 7, 8, 9})},
+            {"id", int64Array({1, 2, 3, 4, 5, 6, std::nullopt, 8, 9, 10})},
+            {"score", doubleArray({1.5, std::nullopt, 7.0, NaN, 3.0, 9.5, 2.0, 4.0, std::nullopt, 5.5})},
+            {"name", stringArray({"alpha", "beta", std::nullopt, "Alphabet", "gamma", "delta", "beta", "epsilon",
+                                  "ALPHA", "zeta"})},
+        }, 4, 4, "dept", dept);
+    }
+
+    using Rows = Ints;
+
+    // 过滤后剩下的行号
+    Rows filteredRows(const DataFrame &frame, const cp::Expression &predicate) {
+        auto filtered = frame.filter(predicate);
+        EXPECT_TRUE(filtered.ok()) << predicate.ToString() << ": " << filtered.status().ToString();
+        return filtered.ok() ? columnValues<int64_t>(*filtered, "row") : Rows{};
+    }
+
+    std::shared_ptr<arrow::Scalar> text(const std::string &value) {
+        return arrow::MakeScalar(value);
+    }
+}
+
+TEST_F(DataFrameFilterTest, CompareDropsNullsAndNaN) {
+    const DataFrame frame = sampleFrame();
+    EXPECT_EQ(filteredRows(frame, Predicate::compare("score", "greater", arrow::MakeScalar(3.0))),
+              (Rows{2, 5, 7, 9}));
+    EXPECT_EQ(filteredRows(frame, Predicate::compare("id", "less_equal", arrow::MakeScalar<int64_t>(4))),
+              (Rows{0, 1, 2, 3}));
+    EXPECT_EQ(filteredRows(frame, Predicate::compare("name", "equal", text("beta"))), (Rows{1, 6}));
+
+    // 字典列在字典上比较，两个分块的编码不同
+    EXPECT_EQ(filteredRows(frame, Predicate::compare("dept", "equal", text("IT"))), (Rows{1, 3, 6}));
+    EXPECT_EQ(filteredRows(frame, Predicate::compare("dept", "not_equal", text("IT"))), (Rows{0, 4, 5, 8, 9}));
+    EXPECT_EQ(filteredRows(frame, Predicate::compare("dept", "greater", text("HR"))), (Rows{1, 3, 4, 6, 8}));
+    EXPECT_TRUE(filteredRows(frame, Predicate::compare("dept", "equal", text("unused"))).empty());
+
+    // 与按列比较的 filter 重载结果一致，保留列类型
+    TTB_ASSERT_OK_AND_ASSIGN(simple, frame.filter("dept", text("IT")));
+    EXPECT_EQ(columnValues<int64_t>(simple, "row"), (Rows{1, 3, 6}));
+    EXPECT_EQ(simple.getColumn("dept")->type()->id(), arrow::Type::DICTIONARY);
+    EXPECT_EQ(columnValues<std::string>(simple, "name"),
+              (Texts{"beta", "Alphabet", "beta"}));
+}
+
+TEST_F(DataFrameFilterTest, SetRangeAndNullPredicates) {
+    const DataFrame frame = sampleFrame();
+    // 值集合里的空值匹配空单元格
+    EXPECT_EQ(filteredRows(frame, Predicate::isIn("dept", stringArray({"HR", std::nullopt}))),
+              (Rows{0, 2, 5, 7, 9}));
+    EXPECT_EQ(filteredRows(frame, Predicate::isIn("dept", stringArray({"Ops"}))), (Rows{4, 8}));
+    EXPECT_EQ(filteredRows(frame, Predicate::isIn("id", int64Array({2, 6, std::nullopt}))), (Rows{1, 5, 6}));
+
+    EXPECT_EQ(filteredRows(frame, Predicate::between("score", arrow::MakeScalar(2.0), arrow::MakeScalar(5.5))),
+              (Rows{4, 6, 7, 9}));
+
+    EXPECT_EQ(filteredRows(frame, Predicate::isNull("score")), (Rows{1, 8}));
+    EXPECT_EQ(filteredRows(frame, Predicate::isNull("dept")), (Rows{2, 7}));
+    EXPECT_EQ(filteredRows(frame, Predicate::isValid("name")), (Rows{0, 1, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+TEST_F(DataFrameFilterTest, TextMatching) {
+    const DataFrame frame = sampleFrame();
+    EXPECT_EQ(filteredRows(frame, Predicate::contains("name", "alpha")), (Rows{0}));
+    EXPECT_EQ(filteredRows(frame, Predicate::contains("name", "alpha", true)), (Rows{0, 3, 8}));
+    EXPECT_EQ(filteredRows(frame, Predicate::matches("name", "^[a-d]")), (Rows{0, 1, 5, 6}));
+    EXPECT_EQ(filteredRows(frame, Predicate::matches("name", "^alpha$", true)), (Rows{0, 8}));
+    EXPECT_EQ(filteredRows(frame, Predicate::contains("dept", "p")), (Rows{4, 8}));
+    EXPECT_EQ(filteredRows(frame, Predicate::matches("dept", "^(HR|IT)$")), (Rows{0, 1, 3, 5, 6, 9}));
+}
+
+TEST_F(DataFrameFilterTest, CombinedPredicatesUseKleeneLogic) {
+    const DataFrame frame = sampleFrame();
+    const auto it = Predicate::compare("dept", "equal", text("IT"));
+
+    EXPECT_EQ(filteredRows(frame, cp::and_(Predicate::compare("dept", "equal", text("HR")),
+                                           Predicate::compare("score", "greater", arrow::MakeScalar(2.0)))),
+              (Rows{5, 9}));
+    EXPECT_EQ(filteredRows(frame, cp::or_(Predicate::isNull("dept"), Predicate::contains("name", "eta"))),
+              (Rows{1, 2, 6, 7, 9}));
+    // 空值取反仍是空值，这些行不保留
+    EXPECT_EQ(filteredRows(frame, cp::not_(it)), (Rows{0, 4, 5, 8, 9}));
+    // 同一字典列的子条件整体在字典上求值
+    EXPECT_EQ(filteredRows(frame, cp::or_(it, Predicate::compare("dept", "equal", text("Ops")))),
+              (Rows{1, 3, 4, 6, 8}));
+    EXPECT_EQ(filteredRows(frame, cp::or_(Predicate::isNull("dept"), cp::not_(it))), (Rows{0, 2, 4, 5, 7, 8, 9}));
+    // dept 为空值、score 不为空值时 null or false 仍是空值
+    EXPECT_EQ(filteredRows(frame, cp::or_(it, Predicate::isNull("score"))), (Rows{1, 3, 6, 8}));
+    // 同时引用字典列和其他列的条件按行解码求值
+    EXPECT_EQ(filteredRows(frame, cp::equal(Predicate::column("dept"), Predicate::column("name"))), Rows{});
+    EXPECT_EQ(filteredRows(frame, cp::and_(cp::greater(Predicate::column("score"), Predicate::column("id")),
+                                           Predicate::compare("dept", "equal", text("HR")))),
+              (Rows{0, 5}));
+}
+
+TEST_F(DataFrameFilterTest, MatchesRowByRowReferenceAcrossBatches) {
+    // 每列的分块大小不同，批次数量很多
+    constexpr int64_t rows = 5000;
+    Ints row_numbers;
+    Doubles scores;
+    Texts names;
+    Codes codes;
+    uint32_t seed = 12345;
+    auto next = [&seed] {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7FFF;
+    };
+    for (int64_t i = 0; i < rows; ++i) {
+        row_numbers.emplace_back(i);
+        const auto r = next();
+        scores.push_back(r % 10 == 0 ? std::nullopt : std::optional<double>(r % 100));
+        names.push_back(next() % 8 == 0 ? std::nullopt : std::optional<std::string>("n" + std::to_string(next() % 5)));
+        codes.push_back(next() % 6 == 0 ? std::nullopt : std::optional<int32_t>(static_cast<int32_t>(next() % 3)));
+    }
+    const std::vector<std::string> depts = {"HR", "IT", "Ops"};
+    const DataFrame frame = sampleFrame({{"row", int64Array(row_numbers)}, {"score", doubleArray(scores)},
+                                         {"name", stringArray(names)}}, 333, 3, "dept",
+                                        dictionaryColumn({depts}, codes, 777));
+
+    // (dept == IT and score > 50) or name is null
+    const auto predicate = cp::or_(cp::and_(Predicate::compare("dept", "equal", text("IT")),
+                                            Predicate::compare("score", "greater", arrow::MakeScalar(50.0))),
+                                   Predicate::isNull("name"));
+    Rows expected;
+    for (int64_t i = 0; i < rows; ++i) {
+        // 空值参与 and 时只有另一边为 false 才有确定结果，结果为空值的行不保留
+        const bool both = codes[i] && *codes[i] == 1 && scores[i] && *scores[i] > 50;
+        if (!names[i] || both) {
+            expected.emplace_back(i);
+        }
+    }
+    EXPECT_EQ(filteredRows(frame, predicate), expected);
+}
+
+TEST_F(DataFrameFilterTest, InvalidPredicatesReturnErrors) {
+    const DataFrame frame = sampleFrame();
+    EXPECT_FALSE(frame.filter(Predicate::compare("missing", "equal", arrow::MakeScalar<int64_t>(1))).ok());
+    EXPECT_TRUE(frame.filter(Predicate::column("score")).status().IsTypeError());
+    EXPECT_FALSE(frame.filter("missing", arrow::MakeScalar<int64_t>(1)).ok());
+    EXPECT_FALSE(DataFrame().filter(Predicate::isNull("row")).ok());
+}
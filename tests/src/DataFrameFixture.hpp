@@ -0,0 +1,173 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include "DataFrame.hpp"
+#include "DataFrameGroupBy.hpp"
+
+// arrow::Result 不成功时让当前测试失败并返回，成功时把值移动到 lhs
+#define TTB_ASSERT_OK_AND_ASSIGN(lhs, expr)                                 \
+    auto lhs##_result = (expr);                                             \
+    ASSERT_TRUE(lhs##_result.ok()) << lhs##_result.status().ToString();     \
+    auto lhs = std::move(lhs##_result).ValueOrDie()
+
+namespace TinaToolBox {
+    namespace TestFixture {
+        // DataFrame 测试的基类：Arrow 21 起计算函数需要显式注册。
+        // 不需要额外状态的测试文件用别名作为测试套件名，例如 using DataFrameJoinTest = ArrowTest
+        class ArrowTest : public ::testing::Test {
+        protected:
+            static void SetUpTestSuite() {
+#if ARROW_VERSION_MAJOR >= 21
+                ASSERT_TRUE(arrow::compute::Initialize().ok());
+#endif
+            }
+        };
+
+        using Ints = std::vector<std::optional<int64_t> >;
+        using Doubles = std::vector<std::optional<double> >;
+        using Texts = std::vector<std::optional<std::string> >;
+        using Codes = std::vector<std::optional<int32_t> >;
+
+        template<typename Builder, typename T>
+        std::shared_ptr<arrow::Array> buildArray(const std::vector<std::optional<T> > &values) {
+            Builder builder;
+            for (const auto &value: values) {
+                if (value) {
+                    EXPECT_TRUE(builder.Append(*value).ok());
+                } else {
+                    EXPECT_TRUE(builder.AppendNull().ok());
+                }
+            }
+            return builder.Finish().ValueOrDie();
+        }
+
+        inline std::shared_ptr<arrow::Array> int64Array(const Ints &values) {
+            return buildArray<arrow::Int64Builder>(values);
+        }
+
+        inline std::shared_ptr<arrow::Array> doubleArray(const Doubles &values) {
+            return buildArray<arrow::DoubleBuilder>(values);
+        }
+
+        inline std::shared_ptr<arrow::Array> stringArray(const Texts &values) {
+            return buildArray<arrow::StringBuilder>(values);
+        }
+
+        // dictionary<int32, utf8>，与 fromExcel 产生的字典列类型相同
+        inline std::shared_ptr<arrow::Array> dictionaryArray(const std::vector<std::string> &dictionary,
+                                                             const Codes &codes) {
+            Texts entries(dictionary.begin(), dictionary.end());
+            return arrow::DictionaryArray::FromArrays(arrow::dictionary(arrow::int32(), arrow::utf8()),
+                                                      buildArray<arrow::Int32Builder>(codes),
+                                                      stringArray(entries)).ValueOrDie();
+        }
+
+        // 各列切成 chunk_rows 行的分块（0 表示不切分），用于覆盖跨分块的读取
+        inline DataFrame frameOf(const std::vector<std::pair<std::string, std::shared_ptr<arrow::Array> > > &columns,
+                                 int64_t chunk_rows = 0) {
+            arrow::FieldVector fields;
+            arrow::ChunkedArrayVector arrays;
+            for (const auto &[name, array]: columns) {
+                fields.push_back(arrow::field(name, array->type()));
+                arrow::ArrayVector chunks;
+                if (chunk_rows <= 0) {
+                    chunks.push_back(array);
+                } else {
+                    for (int64_t offset = 0; offset < array->length(); offset += chunk_rows) {
+                        chunks.push_back(array->Slice(offset, chunk_rows));
+                    }
+                }
+                arrays.push_back(std::make_shared<arrow::ChunkedArray>(std::move(chunks), array->type()));
+            }
+            return DataFrame(arrow::Table::Make(arrow::schema(fields), arrays));
+        }
+
+        // 字典列：codes 每 chunk_rows 行一个分块，相邻分块轮流使用 dictionaries 中的字典，
+        // 同一编码在不同分块中可以对应不同的文本
+        inline std::shared_ptr<arrow::ChunkedArray> dictionaryColumn(
+            const std::vector<std::vector<std::string> > &dictionaries, const Codes &codes, int64_t chunk_rows) {
+            arrow::ArrayVector chunks;
+            const auto rows = static_cast<int64_t>(codes.size());
+            for (int64_t offset = 0; offset < rows; offset += chunk_rows) {
+                const auto end = std::min(rows, offset + chunk_rows);
+                chunks.push_back(dictionaryArray(dictionaries[chunks.size() % dictionaries.size()],
+                                                 Codes(codes.begin() + offset, codes.begin() + end)));
+            }
+            return std::make_shared<arrow::ChunkedArray>(std::move(chunks),
+                                                         arrow::dictionary(arrow::int32(), arrow::utf8()));
+        }
+
+        // 同 dictionaryColumn，按文本给出值：每个分块中的文本换成该分块字典中的编码，不在字典中的文本为空值
+        inline std::shared_ptr<arrow::ChunkedArray> dictionaryColumnOf(
+            const std::vector<std::vector<std::string> > &dictionaries, const Texts &values, int64_t chunk_rows) {
+            Codes codes;
+            for (size_t i = 0; i < values.size(); ++i) {
+                const auto &dictionary = dictionaries[i / static_cast<size_t>(chunk_rows) % dictionaries.size()];
+                const auto found = values[i] ? std::find(dictionary.begin(), dictionary.end(), *values[i])
+                                             : dictionary.end();
+                codes.push_back(found == dictionary.end() ? std::nullopt
+                                                          : std::optional<int32_t>(static_cast<int32_t>(
+                                                              found - dictionary.begin())));
+            }
+            return dictionaryColumn(dictionaries, codes, chunk_rows);
+        }
+
+        // 各测试文件的样例表：columns 按 chunk_rows 行切分（同 frameOf），再把字典列 dictionary 插入到第 position 列，
+        // 它的分块边界可以与其余列不同
+        inline DataFrame sampleFrame(const std::vector<std::pair<std::string, std::shared_ptr<arrow::Array> > > &columns,
+                                     int64_t chunk_rows, int position, const std::string &name,
+                                     const std::shared_ptr<arrow::ChunkedArray> &dictionary) {
+            const auto base = frameOf(columns, chunk_rows);
+            return DataFrame(base.table()->AddColumn(position, arrow::field(name, dictionary->type()), dictionary)
+                .ValueOrDie());
+        }
+
+        // 通过 ColumnAccessor 按行读出整列，空值为 std::nullopt
+        template<typename T>
+        std::vector<std::optional<T> > columnValues(const DataFrame &frame, const std::string &column) {
+            auto accessor = frame.columnAccessor<T>(column);
+            EXPECT_TRUE(accessor.ok()) << accessor.status().ToString();
+            std::vector<std::optional<T> > values;
+            if (accessor.ok()) {
+                for (int64_t row = 0; row < accessor->length(); ++row) {
+                    values.push_back(accessor->get(row));
+                }
+            }
+            return values;
+        }
+
+        // 列名、顺序和逐行内容相同（忽略分块方式和字典的具体编码）；columns 为空时比较 expected 的全部列
+        inline void expectSameContent(const DataFrame &actual, const DataFrame &expected,
+                                      const std::vector<std::string> &columns = {}) {
+            const auto names = columns.empty() ? expected.getColumnNames() : columns;
+            ASSERT_EQ(actual.getColumnNames(), names);
+            ASSERT_EQ(actual.rowCount(), expected.rowCount());
+            for (const auto &name: names) {
+                const auto a = actual.getColumn(name);
+                const auto e = expected.getColumn(name);
+                ASSERT_TRUE(a->type()->Equals(*e->type())) << name << ": " << a->type()->ToString();
+                if (e->type()->id() == arrow::Type::DICTIONARY) {
+                    EXPECT_EQ(columnValues<std::string>(actual, name), columnValues<std::string>(expected, name)) << name;
+                } else {
+                    EXPECT_TRUE(a->Equals(*e)) << name;
+                }
+            }
+        }
+
+        inline Aggregation of(AggregateFunction function, std::string column = {}, std::string name = {}) {
+            Aggregation aggregation;
+            aggregation.function = function;
+            aggregation.column = std::move(column);
+            aggregation.name = std::move(name);
+            return aggregation;
+        }
+    } // namespace TestFixture
+} // namespace TinaToolBox
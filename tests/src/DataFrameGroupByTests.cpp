@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DataFrameFixture.hpp"
+#include "DataFrameGroupBy.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    using DataFrameGroupByTest = ArrowTest;
+
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    // dept 为字典列，两个分块的字典不同
+    DataFrame sampleFrame() {
+        const auto dept = dictionaryColumn({{"IT", "HR"}, {"Ops", "HR", "IT"}},
+                                           {0, 1, 0, std::nullopt, 1, 2, std::nullopt, 0}, 4);
+        return TestFixture::sampleFrame({
+            {"score", doubleArray({1.0, std::nullopt, NaN, 2.5, 4.0, 3.0, std::nullopt, NaN})},
+            {"qty", int64Array({10, std::nullopt, 5, 1, 2, std::nullopt, 7, std::nullopt})},
+            {"name", stringArray({"b", "a", "c", std::nullopt, "a", "a", "z", std::nullopt})},
+            {"flag", buildArray<arrow::BooleanBuilder>(std::vector<std::optional<bool> >{
+                 true, false, true, std::nullopt, true, true, false, std::nullopt})},
+        }, 3, 0, "dept", dept);
+    }
+
+    // 浮点结果逐个比较，NaN 与 NaN 视为相同
+    void expectDoubles(const DataFrame &frame, const std::string &column, const Doubles &expected) {
+        const auto actual = columnValues<double>(frame, column);
+        ASSERT_EQ(actual.size(), expected.size()) << column;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQ(actual[i].has_value(), expected[i].has_value()) << column << " group " << i;
+            if (expected[i] && std::isnan(*expected[i])) {
+                EXPECT_TRUE(std::isnan(*actual[i])) << column << " group " << i;
+            } else if (expected[i]) {
+                EXPECT_DOUBLE_EQ(*actual[i], *expected[i]) << column << " group " << i;
+            }
+        }
+    }
+}
+
+TEST_F(DataFrameGroupByTest, AggregatesSkipNullsAndNaN) {
+    TTB_ASSERT_OK_AND_ASSIGN(result, sampleFrame().groupBy({"dept"}).agg({
+                                 of(AggregateFunction::Count),
+                                 of(AggregateFunction::Count, "score"),
+                                 of(AggregateFunction::Sum, "score"),
+                                 of(AggregateFunction::Mean, "score"),
+                                 of(AggregateFunction::Sum, "qty", "total"),
+                                 of(AggregateFunction::Mean, "qty"),
+                                 of(AggregateFunction::Min, "score"),
+                                 of(AggregateFunction::Max, "score"),
+                                 of(AggregateFunction::Min, "name"),
+                                 of(AggregateFunction::Max, "name"),
+                                 of(AggregateFunction::CountDistinct, "name"),
+                                 of(AggregateFunction::CountDistinct, "score"),
+                                 of(AggregateFunction::Sum, "flag"),
+                             }));
+    EXPECT_EQ(result.getColumnNames(), (std::vector<std::string>{
+                  "dept", "count(*)", "count(score)", "sum(score)", "mean(score)", "total", "mean(qty)",
+                  "min(score)", "max(score)", "min(name)", "max(name)", "count_distinct(name)",
+                  "count_distinct(score)", "sum(flag)"}));
+
+    // 各组按第一次出现的顺序排列，空值键也是一组；键列保持字典类型
+    EXPECT_EQ(result.getColumn("dept")->type()->id(), arrow::Type::DICTIONARY);
+    EXPECT_EQ(columnValues<std::string>(result, "dept"), (Texts{"IT", "HR", std::nullopt, "Ops"}));
+
+    EXPECT_EQ(columnValues<int64_t>(result, "count(*)"), (Ints{3, 2, 2, 1}));
+    // NaN 不是空值，参与计数；求和与平均值遇到 NaN 结果为 NaN
+    EXPECT_EQ(columnValues<int64_t>(result, "count(score)"), (Ints{3, 1, 1, 1}));
+    expectDoubles(result, "sum(score)", {NaN, 4.0, 2.5, NaN});
+    expectDoubles(result, "mean(score)", {NaN, 4.0, 2.5, NaN});
+    // 整数列的和仍为 INT64，组内没有非空值时为空值
+    EXPECT_EQ(result.getColumn("total")->type()->id(), arrow::Type::INT64);
+    EXPECT_EQ(columnValues<int64_t>(result, "total"), (Ints{15, 2, 8, std::nullopt}));
+    expectDoubles(result, "mean(qty)", {7.5, 2.0, 4.0, std::nullopt});
+    // 极值忽略 NaN，只有 NaN 的组为空值
+    expectDoubles(result, "min(score)", {1.0, 4.0, 2.5, std::nullopt});
+    expectDoubles(result, "max(score)", {3.0, 4.0, 2.5, std::nullopt});
+    EXPECT_EQ(columnValues<std::string>(result, "min(name)"), (Texts{"a", "a", "z", std::nullopt}));
+    EXPECT_EQ(columnValues<std::string>(result, "max(name)"), (Texts{"c", "a", "z", std::nullopt}));
+    EXPECT_EQ(columnValues<int64_t>(result, "count_distinct(name)"), (Ints{3, 1, 1, 0}));
+    EXPECT_EQ(columnValues<int64_t>(result, "count_distinct(score)"), (Ints{3, 1, 1, 1}));
+    EXPECT_EQ(result.getColumn("sum(flag)")->type()->id(), arrow::Type::INT64);
+    EXPECT_EQ(columnValues<int64_t>(result, "sum(flag)"), (Ints{3, 1, 0, std::nullopt}));
+}
+
+TEST_F(DataFrameGroupByTest, FloatingKeysGroupNaNAndSignedZero) {
+    const DataFrame frame = frameOf({
+        {"key", doubleArray({0.0, -0.0, NaN, -NaN, std::nullopt, 1.5, std::nullopt})},
+        {"value", int64Array({1, 2, 3, 4, 5, 6, 7})},
+    });
+    TTB_ASSERT_OK_AND_ASSIGN(result, frame.groupBy({"key"}).agg({of(AggregateFunction::Sum, "value")}));
+    ASSERT_EQ(result.rowCount(), 4u);
+    expectDoubles(result, "key", {0.0, NaN, std::nullopt, 1.5});
+    EXPECT_EQ(columnValues<int64_t>(result, "sum(value)"), (Ints{3, 7, 12, 6}));
+}
+
+TEST_F(DataFrameGroupByTest, MultipleKeysMatchReferenceInParallel) {
+    // 超过 PARALLEL_ROWS，按键的哈希分区并行聚合，结果仍按第一次出现的顺序
+    const int64_t rows = GroupBy::PARALLEL_ROWS * 3 + 17;
+    const std::vector<std::string> depts = {"HR", "IT", "Ops", "Sales"};
+    Texts dept;
+    Ints group;
+    Ints qty;
+    Doubles score;
+    Texts name;
+    uint32_t seed = 99;
+    auto next = [&seed] {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7FFF;
+    };
+    for (int64_t i = 0; i < rows; ++i) {
+        const auto d = next();
+        dept.push_back(d % 10 == 0 ? std::nullopt : std::optional<std::string>(depts[d % depts.size()]));
+        const auto g = next();
+        group.push_back(g % 17 == 0 ? std::nullopt : std::optional<int64_t>(g % 50));
+        const auto q = next();
+        qty.push_back(q % 5 == 0 ? std::nullopt : std::optional<int64_t>(q % 1000 - 300));
+        const auto s = next();
+        score.push_back(s % 9 == 0 ? std::nullopt : s % 9 == 1 ? std::optional<double>(NaN)
+                                                            : std::optional<double>(s % 777 * 0.25));
+        const auto n = next();
+        name.push_back(n % 7 == 0 ? std::nullopt : std::optional<std::string>("n" + std::to_string(n % 40)));
+    }
+
+    // 各分块的字典顺序不同
+    std::vector<std::vector<std::string> > dictionaries;
+    for (size_t i = 0; i < depts.size(); ++i) {
+        dictionaries.push_back(depts);
+        std::rotate(dictionaries.back().begin(), dictionaries.back().begin() + i, dictionaries.back().end());
+    }
+    const DataFrame frame = sampleFrame({{"group", int64Array(group)}, {"qty", int64Array(qty)},
+                                         {"score", doubleArray(score)}, {"name", stringArray(name)}}, 30000, 0,
+                                        "dept", dictionaryColumnOf(dictionaries, dept, 40000));
+
+    struct Expected {
+        int64_t count = 0;
+        int64_t qty_sum = 0;
+        int64_t qty_count = 0;
+        std::optional<double> min_score;
+        std::optional<double> max_score;
+        std::set<std::string> names;
+    };
+    using Key = std::pair<std::optional<std::string>, std::optional<int64_t> >;
+    std::vector<Key> order;
+    std::map<Key, Expected> expected;
+    for (int64_t i = 0; i < rows; ++i) {
+        const Key key{dept[i], group[i]};
+        auto [it, inserted] = expected.try_emplace(key);
+        if (inserted) {
+            order.push_back(key);
+        }
+        auto &e = it->second;
+        ++e.count;
+        if (qty[i]) {
+            e.qty_sum += *qty[i];
+            ++e.qty_count;
+        }
+        if (score[i] && !std::isnan(*score[i])) {
+            e.min_score = e.min_score ? std::min(*e.min_score, *score[i]) : *score[i];
+            e.max_score = e.max_score ? std::max(*e.max_score, *score[i]) : *score[i];
+        }
+        if (name[i]) {
+            e.names.insert(*name[i]);
+        }
+    }
+
+    TTB_ASSERT_OK_AND_ASSIGN(result, frame.groupBy({"dept", "group"}).agg({
+                                 of(AggregateFunction::Count),
+                                 of(AggregateFunction::Sum, "qty"),
+                                 of(AggregateFunction::Mean, "qty"),
+                                 of(AggregateFunction::Min, "score"),
+                                 of(AggregateFunction::Max, "score"),
+                                 of(AggregateFunction::CountDistinct, "name"),
+                             }));
+    ASSERT_EQ(result.rowCount(), order.size());
+    const auto result_dept = columnValues<std::string>(result, "dept");
+    const auto result_group = columnValues<int64_t>(result, "group");
+    const auto counts = columnValues<int64_t>(result, "count(*)");
+    const auto sums = columnValues<int64_t>(result, "sum(qty)");
+    const auto means = columnValues<double>(result, "mean(qty)");
+    const auto minimums = columnValues<double>(result, "min(score)");
+    const auto maximums = columnValues<double>(result, "max(score)");
+    const auto distinct = columnValues<int64_t>(result, "count_distinct(name)");
+    for (size_t i = 0; i < order.size(); ++i) {
+        const auto &e = expected.at(order[i]);
+        ASSERT_EQ(result_dept[i], order[i].first) << "group " << i;
+        ASSERT_EQ(result_group[i], order[i].second) << "group " << i;
+        EXPECT_EQ(counts[i], e.count) << "group " << i;
+        if (e.qty_count > 0) {
+            EXPECT_EQ(sums[i], e.qty_sum) << "group " << i;
+            ASSERT_TRUE(means[i].has_value());
+            EXPECT_DOUBLE_EQ(*means[i], static_cast<double>(e.qty_sum) / static_cast<double>(e.qty_count));
+        } else {
+            EXPECT_FALSE(sums[i].has_value());
+            EXPECT_FALSE(means[i].has_value());
+        }
+        EXPECT_EQ(minimums[i], e.min_score) << "group " << i;
+        EXPECT_EQ(maximums[i], e.max_score) << "group " << i;
+        EXPECT_EQ(distinct[i], static_cast<int64_t>(e.names.size())) << "group " << i;
+    }
+}
+
+TEST_F(DataFrameGroupByTest, InvalidAggregationsReturnErrors) {
+    const DataFrame frame = sampleFrame();
+    EXPECT_FALSE(frame.groupBy({"missing"}).agg({of(AggregateFunction::Count)}).ok());
+    EXPECT_FALSE(frame.groupBy({"dept"}).agg({of(AggregateFunction::Sum, "missing")}).ok());
+    EXPECT_TRUE(frame.groupBy({"dept"}).agg({of(AggregateFunction::Sum)}).status().IsInvalid());
+    EXPECT_TRUE(frame.groupBy({"dept"}).agg({of(AggregateFunction::Sum, "name")}).status().IsTypeError());
+    EXPECT_TRUE(frame.groupBy({"dept"}).agg({of(AggregateFunction::Mean, "dept")}).status().IsTypeError());
+    EXPECT_FALSE(DataFrame().groupBy({"dept"}).agg({of(AggregateFunction::Count)}).ok());
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+#include <arrow/util/compression.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include "DataFrameFixture.hpp"
+#include "XlsxFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    using DataFrameIoTest = ArrowTest;
+
+    constexpr int64_t ROWS = 1000;
+    constexpr int64_t ROW_GROUP = 100;
+
+    // 按 id 递增，每个行组的 id 范围互不重叠；各类型都有空值，字典列由两个分块组成且字典不同
+    DataFrame sampleFrame() {
+        Ints ids;
+        Doubles scores;
+        Texts names;
+        Codes codes;
+        arrow::TimestampBuilder stamps(arrow::timestamp(arrow::TimeUnit::MICRO), arrow::default_memory_pool());
+        for (int64_t i = 0; i < ROWS; ++i) {
+            ids.emplace_back(i);
+            scores.push_back(i % 7 == 0 ? std::nullopt : std::optional<double>(i * 0.5));
+            names.push_back(i % 11 == 0 ? std::nullopt : std::optional<std::string>("name" + std::to_string(i % 13)));
+            codes.push_back(i % 17 == 0 ? std::nullopt : std::optional<int32_t>(static_cast<int32_t>(i % 3)));
+            EXPECT_TRUE((i % 19 == 0 ? stamps.AppendNull() : stamps.Append(1700000000000000LL + i * 1000)).ok());
+        }
+        const auto status = dictionaryColumn({{"open", "closed", "pending"}, {"pending", "open", "closed"}}, codes,
+                                             ROWS / 2);
+        return TestFixture::sampleFrame({
+            {"id", int64Array(ids)},
+            {"score", doubleArray(scores)},
+            {"name", stringArray(names)},
+            {"at", stamps.Finish().ValueOrDie()},
+        }, 0, 2, "status", status);
+    }
+
+    bool codecAvailable(arrow::Compression::type type) {
+        return arrow::util::Codec::IsAvailable(type);
+    }
+
+    // 把第 row_group 个行组所有列块的字节改成垃圾数据，读取这个行组就会失败
+    void corruptRowGroup(const std::string &path, int row_group) {
+        std::vector<std::pair<int64_t, int64_t> > ranges;
+        {
+            auto reader = parquet::ParquetFileReader::OpenFile(path);
+            auto metadata = reader->metadata()->RowGroup(row_group);
+            for (int c = 0; c < metadata->num_columns(); ++c) {
+                auto chunk = metadata->ColumnChunk(c);
+                int64_t start = chunk->data_page_offset();
+                if (chunk->has_dictionary_page()) {
+                    start = std::min(start, chunk->dictionary_page_offset());
+                }
+                ranges.emplace_back(start, chunk->total_compressed_size());
+            }
+        }
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        for (const auto &[offset, size]: ranges) {
+            file.seekp(offset);
+            const std::string garbage(static_cast<size_t>(size), '\xA5');
+            file.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+        }
+    }
+
+    ColumnFilter idFilter(const std::string &comparison, int64_t value) {
+        return ColumnFilter{"id", arrow::MakeScalar(value), comparison};
+    }
+}
+
+TEST_F(DataFrameIoTest, ParquetRoundTripKeepsArrowTypes) {
+    TempDirectory dir;
+    const DataFrame frame = sampleFrame();
+    for (const auto compression: {ColumnarCompression::None, ColumnarCompression::Snappy,
+                                  ColumnarCompression::ZSTD}) {
+        const std::string path = dir.file("sample_" + std::to_string(static_cast<int>(compression)) + ".parquet");
+        ColumnarWriteOptions options;
+        options.compression = compression;
+        options.row_group_size = ROW_GROUP;
+        const auto status = frame.toParquet(path, options);
+        if (status.IsNotImplemented()) {
+            continue;
+        }
+        ASSERT_TRUE(status.ok()) << status.ToString();
+
+        TTB_ASSERT_OK_AND_ASSIGN(loaded, DataFrame::fromParquet(path));
+        expectSameContent(loaded, frame);
+    }
+    EXPECT_FALSE(DataFrame().toParquet(dir.file("empty.parquet")).ok());
+    EXPECT_FALSE(DataFrame::fromParquet(dir.file("missing.parquet")).ok());
+}
+
+TEST_F(DataFrameIoTest, ParquetProjectionAndFilters) {
+    TempDirectory dir;
+    const std::string path = dir.file("sample.parquet");
+    ColumnarWriteOptions write_options;
+    write_options.row_group_size = ROW_GROUP;
+    ASSERT_TRUE(sampleFrame().toParquet(path, write_options).ok());
+
+    // 按给出的顺序投影；过滤条件中的列不必出现在投影里
+    ColumnarReadOptions options;
+    options.columns = {"status", "score"};
+    options.filters = {idFilter("greater_equal", 990), {"name", arrow::MakeScalar("name6"), "not_equal"}};
+    TTB_ASSERT_OK_AND_ASSIGN(loaded, DataFrame::fromParquet(path, options));
+    EXPECT_EQ(loaded.getColumnNames(), (std::vector<std::string>{"status", "score"}));
+    // 990 的 name 为空值，994 的 name 为 name6，都不满足 not_equal
+    EXPECT_EQ(columnValues<double>(loaded, "score"),
+              (Doubles{495.5, 496.0, 496.5, 497.5, 498.0, 498.5, 499.0, 499.5}));
+    EXPECT_EQ(columnValues<std::string>(loaded, "status").front(), "open");
+
+    options.columns = {"missing"};
+    EXPECT_FALSE(DataFrame::fromParquet(path, options).ok());
+}
+
+TEST_F(DataFrameIoTest, ParquetFiltersSkipRowGroupsByStatistics) {
+    if (!codecAvailable(arrow::Compression::ZSTD)) {
+        GTEST_SKIP() << "ZSTD is not available";
+    }
+    TempDirectory dir;
+    const std::string path = dir.file("pruned.parquet");
+    ColumnarWriteOptions write_options;
+    write_options.row_group_size = ROW_GROUP;
+    ASSERT_TRUE(sampleFrame().toParquet(path, write_options).ok());
+    {
+        auto reader = parquet::ParquetFileReader::OpenFile(path);
+        ASSERT_EQ(reader->metadata()->num_row_groups(), ROWS / ROW_GROUP);
+    }
+
+    // 破坏第一个行组（id 0..99）：只有在统计信息排除它时读取才能成功
+    corruptRowGroup(path, 0);
+    EXPECT_FALSE(DataFrame::fromParquet(path).ok());
+
+    struct Case {
+        ColumnFilter filter;
+        int64_t first;
+        int64_t count;
+    };
+    const Case cases[] = {
+        {idFilter("greater_equal", 100), 100, 900},
+        {idFilter("greater", 99), 100, 900},
+        {idFilter("equal", 250), 250, 1},
+        {idFilter("equal", 5000), 0, 0},
+    };
+    for (const auto &c: cases) {
+        ColumnarReadOptions options;
+        options.columns = {"id"};
+        options.filters = {c.filter};
+        auto loaded = DataFrame::fromParquet(path, options);
+        ASSERT_TRUE(loaded.ok()) << c.filter.comparison_operator << ": " << loaded.status().ToString();
+        ASSERT_EQ(loaded->rowCount(), static_cast<size_t>(c.count));
+        if (c.count > 0) {
+            EXPECT_EQ(columnValues<int64_t>(*loaded, "id").front(), c.first);
+        }
+    }
+
+    // 条件覆盖被破坏的行组时不能跳过
+    ColumnarReadOptions options;
+    options.filters = {idFilter("less", 150)};
+    EXPECT_FALSE(DataFrame::fromParquet(path, options).ok());
+}
+
+TEST_F(DataFrameIoTest, FeatherRoundTripProjectionAndFilters) {
+    TempDirectory dir;
+    const DataFrame frame = sampleFrame();
+    for (const auto compression: {ColumnarCompression::None, ColumnarCompression::LZ4,
+                                  ColumnarCompression::ZSTD}) {
+        const std::string path = dir.file("sample_" + std::to_string(static_cast<int>(compression)) + ".feather");
+        ColumnarWriteOptions options;
+        options.compression = compression;
+        options.row_group_size = ROW_GROUP;
+        const auto status = frame.toFeather(path, options);
+        if (status.IsNotImplemented()) {
+            continue;
+        }
+        ASSERT_TRUE(status.ok()) << status.ToString();
+
+        TTB_ASSERT_OK_AND_ASSIGN(loaded, DataFrame::fromFeather(path));
+        expectSameContent(loaded, frame);
+
+        ColumnarReadOptions read_options;
+        read_options.columns = {"name", "id"};
+        read_options.filters = {idFilter("less", 3)};
+        TTB_ASSERT_OK_AND_ASSIGN(projected, DataFrame::fromFeather(path, read_options));
+        EXPECT_EQ(projected.getColumnNames(), (std::vector<std::string>{"name", "id"}));
+        EXPECT_EQ(columnValues<int64_t>(projected, "id"), (Ints{0, 1, 2}));
+        EXPECT_EQ(columnValues<std::string>(projected, "name"),
+                  (Texts{std::nullopt, "name1", "name2"}));
+    }
+
+    ColumnarWriteOptions snappy;
+    snappy.compression = ColumnarCompression::Snappy;
+    EXPECT_TRUE(frame.toFeather(dir.file("snappy.feather"), snappy).IsInvalid());
+}
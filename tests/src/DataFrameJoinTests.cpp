@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "DataFrameFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    using DataFrameJoinTest = ArrowTest;
+
+    DataFrame leftFrame() {
+        return frameOf({
+            {"id", int64Array({1, 2, 2, 3, std::nullopt, 5})},
+            {"name", stringArray({"a", "b", "c", "d", "e", "f"})},
+            {"value", int64Array({10, 11, 12, 13, 14, 15})},
+        }, 4);
+    }
+
+    // extra_rows 为不匹配的附加行，用来让右表比左表大，走在左表上建哈希表的分支
+    DataFrame rightFrame(int extra_rows) {
+        Ints ids = {2, 1, 2, 7, std::nullopt, 1};
+        Texts labels = {"x", "y", "z", "w", "v", "u"};
+        Ints values = {100, 101, 102, 103, 104, 105};
+        for (int i = 0; i < extra_rows; ++i) {
+            ids.emplace_back(1000 + i);
+            labels.emplace_back("extra");
+            values.emplace_back(0);
+        }
+        return frameOf({{"id", int64Array(ids)}, {"label", stringArray(labels)}, {"value", int64Array(values)}}, 5);
+    }
+}
+
+TEST_F(DataFrameJoinTest, AllJoinTypesKeepLeftRowOrder) {
+    const DataFrame left = leftFrame();
+    // 右表比左表小和比左表大时分别在两侧建哈希表，结果相同
+    for (const int extra_rows: {0, 10}) {
+        SCOPED_TRACE("extra right rows: " + std::to_string(extra_rows));
+        const DataFrame right = rightFrame(extra_rows);
+
+        // 同一左行匹配的多个右行按右表的行序排列；空值键不匹配
+        TTB_ASSERT_OK_AND_ASSIGN(inner, left.join(right, {"id"}));
+        EXPECT_EQ(inner.getColumnNames(), (std::vector<std::string>{"id", "name", "value", "label", "value_right"}));
+        EXPECT_EQ(columnValues<std::string>(inner, "name"), (Texts{"a", "a", "b", "b", "c", "c"}));
+        EXPECT_EQ(columnValues<std::string>(inner, "label"), (Texts{"y", "u", "x", "z", "x", "z"}));
+        EXPECT_EQ(columnValues<int64_t>(inner, "value_right"), (Ints{101, 105, 100, 102, 100, 102}));
+        EXPECT_EQ(columnValues<int64_t>(inner, "id"), (Ints{1, 1, 2, 2, 2, 2}));
+
+        TTB_ASSERT_OK_AND_ASSIGN(outer, left.join(right, {"id"}, JoinType::Left, "_r"));
+        EXPECT_EQ(outer.getColumnNames(), (std::vector<std::string>{"id", "name", "value", "label", "value_r"}));
+        EXPECT_EQ(columnValues<std::string>(outer, "name"), (Texts{"a", "a", "b", "b", "c", "c", "d", "e", "f"}));
+        EXPECT_EQ(columnValues<std::string>(outer, "label"),
+                  (Texts{"y", "u", "x", "z", "x", "z", std::nullopt, std::nullopt, std::nullopt}));
+        EXPECT_EQ(columnValues<int64_t>(outer, "value"), (Ints{10, 10, 11, 11, 12, 12, 13, 14, 15}));
+
+        // Semi / Anti 只返回左表的列，每个左行最多一次；空值键的行属于 Anti
+        TTB_ASSERT_OK_AND_ASSIGN(semi, left.join(right, {"id"}, JoinType::Semi));
+        EXPECT_EQ(semi.getColumnNames(), left.getColumnNames());
+        EXPECT_EQ(columnValues<std::string>(semi, "name"), (Texts{"a", "b", "c"}));
+        TTB_ASSERT_OK_AND_ASSIGN(anti, left.join(right, {"id"}, JoinType::Anti));
+        EXPECT_EQ(columnValues<std::string>(anti, "name"), (Texts{"d", "e", "f"}));
+    }
+}
+
+TEST_F(DataFrameJoinTest, KeysWithDifferentNamesAndTypes) {
+    const DataFrame left = frameOf({
+        {"code", int64Array({1, 2, 3, 2})},
+        {"dept", stringArray({"IT", "HR", "IT", "Ops"})},
+    });
+    // 右表的整数键是 INT32、文本键是字典列，分别转换和解码后比较
+    const auto codes = buildArray<arrow::Int32Builder>(Codes{1, 2, 2, 3});
+    const DataFrame right = sampleFrame({{"number", codes}, {"budget", doubleArray({1.5, 2.5, 3.5, 4.5})}}, 2, 1,
+                                        "team", dictionaryColumn({{"HR", "IT"}, {"Ops", "IT"}}, {1, 0, 0, 1}, 2));
+
+    TTB_ASSERT_OK_AND_ASSIGN(joined, left.join(right, {"code", "dept"}, {"number", "team"}));
+    EXPECT_EQ(joined.getColumnNames(), (std::vector<std::string>{"code", "dept", "budget"}));
+    EXPECT_EQ(columnValues<int64_t>(joined, "code"), (Ints{1, 2, 3, 2}));
+    EXPECT_EQ(columnValues<double>(joined, "budget"), (Doubles{1.5, 2.5, 4.5, 3.5}));
+
+    // 两边都是字典列且字典不同时先统一字典
+    const DataFrame left_dictionary = frameOf({{"dept", dictionaryArray({"IT", "HR"}, {0, 1, std::nullopt, 0})},
+                                               {"row", int64Array({0, 1, 2, 3})}});
+    TTB_ASSERT_OK_AND_ASSIGN(unified, left_dictionary.join(right, {"dept"}, {"team"}, JoinType::Left));
+    EXPECT_EQ(columnValues<int64_t>(unified, "row"), (Ints{0, 0, 1, 2, 3, 3}));
+    EXPECT_EQ(columnValues<double>(unified, "budget"), (Doubles{1.5, 4.5, 2.5, std::nullopt, 1.5, 4.5}));
+}
+
+TEST_F(DataFrameJoinTest, LargeJoinMatchesReference) {
+    // 超过 JOIN_PROBE_BLOCK_ROWS，探测分块并行；两边交换大小以覆盖两个建表分支
+    const int64_t large = DataFrame::JOIN_PROBE_BLOCK_ROWS * 2 + 123;
+    const int64_t small = 7000;
+    auto make = [](int64_t rows, int64_t modulo, int null_every, const std::string &row_name) {
+        Ints keys;
+        Ints row_numbers;
+        for (int64_t i = 0; i < rows; ++i) {
+            keys.push_back(i % null_every == 0 ? std::nullopt : std::optional<int64_t>(i * 7919 % modulo));
+            row_numbers.emplace_back(i);
+        }
+        return std::make_pair(keys, frameOf({{"key", int64Array(keys)}, {row_name, int64Array(row_numbers)}}, 10000));
+    };
+    for (const bool left_is_large: {true, false}) {
+        SCOPED_TRACE(left_is_large ? "large left" : "large right");
+        const auto [left_keys, left] = make(left_is_large ? large : small, 6000, 97, "lrow");
+        const auto [right_keys, right] = make(left_is_large ? small : large, 5000, 89, "rrow");
+
+        std::unordered_map<int64_t, std::vector<int64_t> > index;
+        for (size_t r = 0; r < right_keys.size(); ++r) {
+            if (right_keys[r]) {
+                index[*right_keys[r]].push_back(static_cast<int64_t>(r));
+            }
+        }
+        Ints expected_left;
+        Ints expected_right;
+        Ints expected_anti;
+        for (size_t l = 0; l < left_keys.size(); ++l) {
+            const auto found = left_keys[l] ? index.find(*left_keys[l]) : index.end();
+            if (found == index.end()) {
+                expected_anti.emplace_back(static_cast<int64_t>(l));
+                continue;
+            }
+            for (const int64_t r: found->second) {
+                expected_left.emplace_back(static_cast<int64_t>(l));
+                expected_right.emplace_back(r);
+            }
+        }
+
+        TTB_ASSERT_OK_AND_ASSIGN(inner, left.join(right, {"key"}));
+        ASSERT_EQ(columnValues<int64_t>(inner, "lrow"), expected_left);
+        ASSERT_EQ(columnValues<int64_t>(inner, "rrow"), expected_right);
+
+        TTB_ASSERT_OK_AND_ASSIGN(anti, left.join(right, {"key"}, JoinType::Anti));
+        ASSERT_EQ(columnValues<int64_t>(anti, "lrow"), expected_anti);
+
+        TTB_ASSERT_OK_AND_ASSIGN(outer, left.join(right, {"key"}, JoinType::Left));
+        EXPECT_EQ(outer.rowCount(), expected_left.size() + expected_anti.size());
+        TTB_ASSERT_OK_AND_ASSIGN(semi, left.join(right, {"key"}, JoinType::Semi));
+        EXPECT_EQ(semi.rowCount(), left_keys.size() - expected_anti.size());
+    }
+}
+
+TEST_F(DataFrameJoinTest, InvalidKeysReturnErrors) {
+    const DataFrame left = leftFrame();
+    const DataFrame right = rightFrame(0);
+    EXPECT_TRUE(left.join(right, std::vector<std::string>{}).status().IsInvalid());
+    EXPECT_TRUE(left.join(right, {"id", "name"}, {"id"}).status().IsInvalid());
+    EXPECT_FALSE(left.join(right, {"missing"}).ok());
+    EXPECT_FALSE(left.join(right, {"id"}, {"missing"}).ok());
+    // 文本无法转换为整数键
+    EXPECT_TRUE(left.join(right, {"id"}, {"label"}).status().IsTypeError());
+    EXPECT_FALSE(DataFrame().join(right, {"id"}).ok());
+    EXPECT_FALSE(left.join(DataFrame(), {"id"}).ok());
+}
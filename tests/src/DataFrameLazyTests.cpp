@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <arrow/util/compression.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include "DataFrameFixture.hpp"
+#include "DataFrameLazy.hpp"
+#include "XlsxFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+namespace cp = arrow::compute;
+
+namespace {
+    using DataFrameLazyTest = ArrowTest;
+
+    using Key = DataFrame::SortKey;
+
+    constexpr int64_t ROWS = 2000;
+    constexpr int64_t ROW_GROUP = 100;
+
+    // 按 id 递增；score 重复较多且有空值，name 有空值，dept 由两个字典不同的分块组成
+    DataFrame sampleFrame() {
+        Ints ids;
+        Doubles scores;
+        Texts names;
+        Codes codes;
+        for (int64_t i = 0; i < ROWS; ++i) {
+            ids.emplace_back(i);
+            scores.push_back(i % 13 == 0 ? std::nullopt : std::optional<double>((i * 37 % 101) * 0.5));
+            names.push_back(i % 11 == 0 ? std::nullopt : std::optional<std::string>("name" + std::to_string(i % 29)));
+            codes.push_back(i % 17 == 0 ? std::nullopt : std::optional<int32_t>(static_cast<int32_t>(i % 3)));
+        }
+        const auto dept = dictionaryColumn({{"HR", "IT", "Ops"}, {"Ops", "HR", "IT"}}, codes, ROWS / 2);
+        return TestFixture::sampleFrame({{"id", int64Array(ids)}, {"score", doubleArray(scores)},
+                                         {"name", stringArray(names)}}, 300, 3, "dept", dept);
+    }
+
+    // 前 rows 行
+    DataFrame head(const DataFrame &frame, int64_t rows) {
+        return DataFrame(frame.table()->Slice(0, rows));
+    }
+
+    std::string text(const std::shared_ptr<arrow::Scalar> &value) {
+        return value->ToString();
+    }
+
+    // 把第 row_group 个行组所有列块的字节改成垃圾数据，读取这个行组就会失败
+    void corruptRowGroup(const std::string &path, int row_group) {
+        std::vector<std::pair<int64_t, int64_t> > ranges;
+        {
+            auto reader = parquet::ParquetFileReader::OpenFile(path);
+            auto metadata = reader->metadata()->RowGroup(row_group);
+            for (int c = 0; c < metadata->num_columns(); ++c) {
+                auto chunk = metadata->ColumnChunk(c);
+                int64_t start = chunk->data_page_offset();
+                if (chunk->has_dictionary_page()) {
+                    start = std::min(start, chunk->dictionary_page_offset());
+                }
+                ranges.emplace_back(start, chunk->total_compressed_size());
+            }
+        }
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        for (const auto &[offset, size]: ranges) {
+            file.seekp(offset);
+            const std::string garbage(static_cast<size_t>(size), '\xA5');
+            file.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+        }
+    }
+}
+
+TEST_F(DataFrameLazyTest, FilterMovesBeforeSortAndLimitFoldsIntoTopK) {
+    const DataFrame frame = sampleFrame();
+    const auto no_name = Predicate::isNull("name");
+    const LazyFrame query = frame.lazy()
+            .sort({{"score", false}})
+            .filter("id", arrow::MakeScalar<int64_t>(10), "greater")
+            .filter(no_name)
+            .select({"id", "score"})
+            .limit(5)
+            .limit(3);
+
+    // 两个过滤合并后越过排序，截取折叠为 topK；只读取输出列和过滤、排序用到的列
+    EXPECT_EQ(query.explain(), "Scan frame columns=[id, score, name]\n"
+                               "Filter (id greater 10) " + no_name.ToString() + "\n"
+                               "TopK 3 by score desc\n"
+                               "Project [id, score]\n");
+
+    TTB_ASSERT_OK_AND_ASSIGN(lazy, query.collect());
+    TTB_ASSERT_OK_AND_ASSIGN(filtered, frame.filter(cp::and_(
+                                 Predicate::compare("id", "greater", arrow::MakeScalar<int64_t>(10)), no_name)));
+    TTB_ASSERT_OK_AND_ASSIGN(eager, filtered.topK({{"score", false}}, 3));
+    expectSameContent(lazy, eager, {"id", "score"});
+}
+
+TEST_F(DataFrameLazyTest, ConsecutiveSortsMergeKeys) {
+    const DataFrame frame = sampleFrame();
+    // 排序是稳定的：后一次排序的键优先
+    const LazyFrame query = frame.lazy().sort({{"dept"}}).sort({{"score", true, true}});
+    EXPECT_EQ(query.explain(), "Scan frame columns=*\n"
+                               "Sort score asc nulls first, dept asc\n");
+
+    TTB_ASSERT_OK_AND_ASSIGN(lazy, query.collect());
+    TTB_ASSERT_OK_AND_ASSIGN(by_dept, frame.sort(std::vector<Key>{{"dept"}}));
+    TTB_ASSERT_OK_AND_ASSIGN(eager, by_dept.sort(std::vector<Key>{{"score", true, true}}));
+    expectSameContent(lazy, eager, frame.getColumnNames());
+}
+
+TEST_F(DataFrameLazyTest, FiltersDoNotCrossLimits) {
+    const DataFrame frame = sampleFrame();
+    const auto ten = arrow::MakeScalar(10.0);
+
+    // 截取之后的过滤不能提前，只作用于截取出的行
+    const LazyFrame limited = frame.lazy().limit(100).filter("score", ten, "less").sort({{"id", false}});
+    EXPECT_EQ(limited.explain(), "Scan frame columns=*\n"
+                                 "Limit 100\n"
+                                 "Filter (score less " + text(ten) + ")\n"
+                                 "Sort id desc\n");
+    TTB_ASSERT_OK_AND_ASSIGN(lazy_limited, limited.collect());
+    TTB_ASSERT_OK_AND_ASSIGN(filtered, head(frame, 100).filter("score", ten, "less"));
+    TTB_ASSERT_OK_AND_ASSIGN(eager_limited, filtered.sort("id", false));
+    expectSameContent(lazy_limited, eager_limited, frame.getColumnNames());
+
+    // topK 之后的过滤和截取
+    const auto contains = Predicate::contains("name", "1");
+    const LazyFrame top = frame.lazy().sort({{"score"}, {"id", false}}).limit(50).filter(contains)
+            .select({"name", "dept", "id"}).limit(7);
+    EXPECT_EQ(top.explain(), "Scan frame columns=[name, dept, id, score]\n"
+                             "TopK 50 by score asc, id desc\n"
+                             "Filter " + contains.ToString() + "\n"
+                             "Limit 7\n"
+                             "Project [name, dept, id]\n");
+    TTB_ASSERT_OK_AND_ASSIGN(lazy_top, top.collect());
+    TTB_ASSERT_OK_AND_ASSIGN(top_rows, frame.topK({{"score"}, {"id", false}}, 50));
+    TTB_ASSERT_OK_AND_ASSIGN(matching, top_rows.filter(contains));
+    expectSameContent(lazy_top, head(matching, 7), {"name", "dept", "id"});
+}
+
+TEST_F(DataFrameLazyTest, ScanParquetPushesComparisonsToRowGroups) {
+    if (!arrow::util::Codec::IsAvailable(arrow::Compression::ZSTD)) {
+        GTEST_SKIP() << "ZSTD is not available";
+    }
+    TempDirectory dir;
+    const std::string path = dir.file("sample.parquet");
+    const DataFrame frame = sampleFrame();
+    ColumnarWriteOptions options;
+    options.row_group_size = ROW_GROUP;
+    ASSERT_TRUE(frame.toParquet(path, options).ok());
+    // 破坏第一个行组（id 0..99）：只有比较条件下推到读取并跳过它时 collect 才能成功
+    corruptRowGroup(path, 0);
+    EXPECT_FALSE(LazyFrame::scanParquet(path).collect().ok());
+
+    const auto threshold = arrow::MakeScalar<int64_t>(100);
+    const LazyFrame query = LazyFrame::scanParquet(path)
+            .filter("id", threshold, "greater_equal")
+            .select({"score", "dept"})
+            .sort({{"score", false}})
+            .limit(20);
+    // 下推到读取的比较列不必读出
+    EXPECT_EQ(query.explain(), "Scan parquet " + path + " columns=[score, dept] filter=(id greater_equal 100)\n"
+                               "TopK 20 by score desc\n"
+                               "Project [score, dept]\n");
+    TTB_ASSERT_OK_AND_ASSIGN(lazy, query.collect());
+    TTB_ASSERT_OK_AND_ASSIGN(filtered, frame.filter("id", threshold, "greater_equal"));
+    TTB_ASSERT_OK_AND_ASSIGN(eager, filtered.topK({{"score", false}}, 20));
+    expectSameContent(lazy, eager, {"score", "dept"});
+
+    // 同一过滤中的表达式留在读取之后求值，简单比较仍然下推
+    const auto no_name = Predicate::isNull("name");
+    const LazyFrame mixed = LazyFrame::scanParquet(path).filter(no_name).filter("id", threshold, "greater_equal");
+    EXPECT_EQ(mixed.explain(), "Scan parquet " + path + " columns=* filter=(id greater_equal 100)\n"
+                               "Filter " + no_name.ToString() + "\n");
+    TTB_ASSERT_OK_AND_ASSIGN(lazy_mixed, mixed.collect());
+    TTB_ASSERT_OK_AND_ASSIGN(eager_mixed, filtered.filter(no_name));
+    expectSameContent(lazy_mixed, eager_mixed, frame.getColumnNames());
+}
+
+TEST_F(DataFrameLazyTest, ScanFeatherMatchesEager) {
+    TempDirectory dir;
+    const std::string path = dir.file("sample.feather");
+    const DataFrame frame = sampleFrame();
+    ColumnarWriteOptions options;
+    options.compression = ColumnarCompression::None;
+    options.row_group_size = ROW_GROUP;
+    ASSERT_TRUE(frame.toFeather(path, options).ok());
+
+    const auto name = arrow::MakeScalar("name3");
+    const LazyFrame query = LazyFrame::scanFeather(path)
+            .filter("name", name, "not_equal")
+            .filter("dept", arrow::MakeScalar("IT"))
+            .select({"id", "name"})
+            .limit(40);
+    EXPECT_EQ(query.explain(), "Scan feather " + path + " columns=[id, name]"
+                               " filter=(name not_equal name3) filter=(dept equal IT)\n"
+                               "Limit 40\n"
+                               "Project [id, name]\n");
+    TTB_ASSERT_OK_AND_ASSIGN(lazy, query.collect());
+    TTB_ASSERT_OK_AND_ASSIGN(not_name, frame.filter("name", name, "not_equal"));
+    TTB_ASSERT_OK_AND_ASSIGN(eager, not_name.filter("dept", arrow::MakeScalar("IT")));
+    expectSameContent(lazy, head(eager, 40), {"id", "name"});
+}
+
+TEST_F(DataFrameLazyTest, PlanErrorsSurfaceAtCollect) {
+    const DataFrame frame = sampleFrame();
+    const auto one = arrow::MakeScalar<int64_t>(1);
+    const std::vector<LazyFrame> invalid = {
+        // 投影之后不能再引用被去掉的列
+        frame.lazy().select({"id"}).filter("score", arrow::MakeScalar(1.0), "greater"),
+        frame.lazy().select({"id"}).filter(Predicate::isNull("name")),
+        frame.lazy().select({"id"}).sort({{"score"}}),
+        frame.lazy().filter("id", one, "like"),
+        frame.lazy().sort({}),
+        frame.lazy().limit(-1),
+    };
+    for (const auto &query: invalid) {
+        EXPECT_EQ(query.explain().rfind("Invalid plan: ", 0), 0u) << query.explain();
+        EXPECT_TRUE(query.collect().status().IsInvalid()) << query.explain();
+    }
+
+    // 源表的列只有执行时才知道
+    EXPECT_FALSE(frame.lazy().select({"missing"}).collect().ok());
+    EXPECT_FALSE(frame.lazy().filter("missing", one).collect().ok());
+    EXPECT_FALSE(DataFrame().lazy().collect().ok());
+    TempDirectory dir;
+    EXPECT_FALSE(LazyFrame::scanParquet(dir.file("missing.parquet")).collect().ok());
+    EXPECT_FALSE(LazyFrame::scanFeather(dir.file("missing.feather")).filter("id", one).collect().ok());
+}
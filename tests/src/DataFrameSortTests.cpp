@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+#include "DataFrameFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    using DataFrameSortTest = ArrowTest;
+
+    using Key = DataFrame::SortKey;
+    using Rows = Ints;
+
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    // 各列的原始值，用于计算期望的排序结果
+    struct Data {
+        Ints group;
+        Doubles score;
+        Texts name;
+        Texts dept;
+
+        [[nodiscard]] size_t size() const { return group.size(); }
+    };
+
+    // 0 为普通值，1 为 NaN，2 为空值
+    template<typename T>
+    int rank(const std::optional<T> &value) {
+        if (!value) {
+            return 2;
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            return std::isnan(*value) ? 1 : 0;
+        } else {
+            return 0;
+        }
+    }
+
+    // 与 DataFrame::sort 约定相同的单键比较：空值在最外侧、NaN 在其内侧，位置只由 nulls_first 决定
+    template<typename T>
+    int compareValues(const std::optional<T> &a, const std::optional<T> &b, const Key &key) {
+        const int ra = rank(a);
+        const int rb = rank(b);
+        if (ra != rb) {
+            return (ra < rb) == key.nulls_first ? 1 : -1;
+        }
+        if (ra != 0 || *a == *b) {
+            return 0;
+        }
+        return (*a < *b) == key.ascending ? -1 : 1;
+    }
+
+    // 用 std::stable_sort 得到的行号顺序
+    Rows expectedOrder(const Data &data, const std::vector<Key> &keys) {
+        std::vector<int64_t> order(data.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = static_cast<int64_t>(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+            for (const auto &key: keys) {
+                int result = 0;
+                if (key.column == "group") {
+                    result = compareValues(data.group[a], data.group[b], key);
+                } else if (key.column == "score") {
+                    result = compareValues(data.score[a], data.score[b], key);
+                } else if (key.column == "name") {
+                    result = compareValues(data.name[a], data.name[b], key);
+                } else {
+                    result = compareValues(data.dept[a], data.dept[b], key);
+                }
+                if (result != 0) {
+                    return result < 0;
+                }
+            }
+            return false;
+        });
+        return Rows(order.begin(), order.end());
+    }
+
+    uint32_t nextRandom(uint32_t &seed) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7FFF;
+    }
+
+    // 键大量重复，各列都有空值，score 有 NaN
+    Data randomData(int64_t rows, uint32_t seed) {
+        const std::vector<std::string> depts = {"Ops", "HR", "IT", "Sales"};
+        Data data;
+        for (int64_t i = 0; i < rows; ++i) {
+            const auto r = nextRandom(seed);
+            data.group.push_back(r % 13 == 0 ? std::nullopt : std::optional<int64_t>(r % 7 - 3));
+            const auto s = nextRandom(seed);
+            data.score.push_back(s % 11 == 0 ? std::nullopt : s % 11 == 1 ? std::optional<double>(NaN)
+                                                                        : std::optional<double>((s % 20) * 0.5));
+            const auto n = nextRandom(seed);
+            data.name.push_back(n % 9 == 0 ? std::nullopt : std::optional<std::string>("n" + std::to_string(n % 6)));
+            const auto d = nextRandom(seed);
+            data.dept.push_back(d % 8 == 0 ? std::nullopt : std::optional<std::string>(depts[d % depts.size()]));
+        }
+        return data;
+    }
+
+    // 每 chunk_rows 行一个分块；dept 是字典列，相邻分块的字典顺序不同
+    DataFrame frameFrom(const Data &data, int64_t chunk_rows) {
+        Ints row_numbers;
+        for (size_t i = 0; i < data.size(); ++i) {
+            row_numbers.emplace_back(static_cast<int64_t>(i));
+        }
+        const auto dept = dictionaryColumnOf({{"Ops", "HR", "IT", "Sales"}, {"Sales", "IT", "HR", "Ops", "unused"}},
+                                             data.dept, chunk_rows);
+        return sampleFrame({{"row", int64Array(row_numbers)}, {"group", int64Array(data.group)},
+                            {"score", doubleArray(data.score)}, {"name", stringArray(data.name)}},
+                           chunk_rows, 4, "dept", dept);
+    }
+
+    std::string describe(const std::vector<Key> &keys) {
+        std::string text;
+        for (const auto &key: keys) {
+            text += key.column + (key.ascending ? " asc" : " desc") + (key.nulls_first ? " nulls first; " : "; ");
+        }
+        return text;
+    }
+
+    const std::vector<std::vector<Key> > KEY_SETS = {
+        {{"score", true, false}},
+        {{"score", false, true}},
+        {{"dept", true, false}, {"score", false, false}},
+        {{"dept", false, true}, {"name", true, false}},
+        {{"group", true, true}, {"dept", true, false}, {"score", true, true}},
+        {{"name", false, false}, {"group", false, true}},
+    };
+}
+
+TEST_F(DataFrameSortTest, NullsAndNaNFollowNullsFirst) {
+    Data data;
+    data.group = {1, 2, 3, 4, 5, 6};
+    data.score = {2.0, std::nullopt, NaN, 1.0, std::nullopt, NaN};
+    data.name = {"b", "a", std::nullopt, "c", "a", std::nullopt};
+    data.dept = {"IT", std::nullopt, "HR", "IT", "Ops", "HR"};
+    const DataFrame frame = frameFrom(data, 4);
+
+    auto order = [&](const std::vector<Key> &keys) {
+        auto sorted = frame.sort(keys);
+        EXPECT_TRUE(sorted.ok()) << sorted.status().ToString();
+        return sorted.ok() ? columnValues<int64_t>(*sorted, "row") : Rows{};
+    };
+    // 空值和 NaN 都相同时保持原有顺序
+    EXPECT_EQ(order({{"score", true, false}}), (Rows{3, 0, 2, 5, 1, 4}));
+    EXPECT_EQ(order({{"score", false, false}}), (Rows{0, 3, 2, 5, 1, 4}));
+    EXPECT_EQ(order({{"score", true, true}}), (Rows{1, 4, 2, 5, 3, 0}));
+    EXPECT_EQ(order({{"score", false, true}}), (Rows{1, 4, 2, 5, 0, 3}));
+    // 字典列按文本排序，与编码无关
+    EXPECT_EQ(order({{"dept", true, false}, {"name", false, true}}), (Rows{2, 5, 3, 0, 4, 1}));
+
+    // 单列重载：升序，空值在最后
+    TTB_ASSERT_OK_AND_ASSIGN(by_name, frame.sort("name"));
+    EXPECT_EQ(columnValues<int64_t>(by_name, "row"), (Rows{1, 4, 0, 3, 2, 5}));
+    EXPECT_EQ(by_name.getColumn("dept")->type()->id(), arrow::Type::DICTIONARY);
+}
+
+TEST_F(DataFrameSortTest, MultiKeySortIsStableAcrossChunks) {
+    const Data data = randomData(20000, 7);
+    const DataFrame frame = frameFrom(data, 1234);
+    for (const auto &keys: KEY_SETS) {
+        TTB_ASSERT_OK_AND_ASSIGN(sorted, frame.sort(keys));
+        ASSERT_EQ(columnValues<int64_t>(sorted, "row"), expectedOrder(data, keys)) << describe(keys);
+        // 其余列随行一起移动
+        EXPECT_EQ(columnValues<std::string>(sorted, "dept").front(),
+                  data.dept[*columnValues<int64_t>(sorted, "row").front()]);
+    }
+}
+
+TEST_F(DataFrameSortTest, TopKMatchesSortPrefix) {
+    const Data data = randomData(20000, 11);
+    const DataFrame frame = frameFrom(data, 999);
+    for (const auto &keys: KEY_SETS) {
+        const Rows expected = expectedOrder(data, keys);
+        for (const int64_t k: {0, 1, 17, 5000, 20000, 25000}) {
+            TTB_ASSERT_OK_AND_ASSIGN(top, frame.topK(keys, k));
+            const auto count = std::min<size_t>(static_cast<size_t>(k), expected.size());
+            ASSERT_EQ(columnValues<int64_t>(top, "row"), Rows(expected.begin(), expected.begin() + count))
+                << describe(keys) << " k=" << k;
+        }
+    }
+}
+
+TEST_F(DataFrameSortTest, ParallelSortMatchesReference) {
+    // 超过 PARALLEL_SORT_ROWS 时分段并行排序后归并，相同键跨段时也要保持原有顺序
+    const int64_t rows = DataFrame::PARALLEL_SORT_ROWS + 12345;
+    const Data data = randomData(rows, 3);
+    const DataFrame frame = frameFrom(data, 100000);
+    const std::vector<Key> keys = {{"group", false, false}, {"score", true, true}};
+    const Rows expected = expectedOrder(data, keys);
+
+    TTB_ASSERT_OK_AND_ASSIGN(sorted, frame.sort(keys));
+    ASSERT_EQ(columnValues<int64_t>(sorted, "row"), expected);
+
+    TTB_ASSERT_OK_AND_ASSIGN(top, frame.topK(keys, 1000));
+    EXPECT_EQ(columnValues<int64_t>(top, "row"), Rows(expected.begin(), expected.begin() + 1000));
+}
+
+TEST_F(DataFrameSortTest, InvalidArgumentsReturnErrors) {
+    const DataFrame frame = frameFrom(randomData(10, 1), 4);
+    EXPECT_FALSE(frame.sort(std::vector<Key>{}).ok());
+    EXPECT_FALSE(frame.sort("missing").ok());
+    EXPECT_FALSE(frame.sort(std::vector<Key>{{"missing"}}).ok());
+    EXPECT_TRUE(frame.topK({{"score"}}, -1).status().IsInvalid());
+    EXPECT_FALSE(DataFrame().sort(std::vector<Key>{{"score"}}).ok());
+    EXPECT_FALSE(DataFrame().topK({{"score"}}, 1).ok());
+}
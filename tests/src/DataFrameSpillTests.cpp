@@ -0,0 +1,312 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <arrow/util/byte_size.h>
+#include "DataFrameFixture.hpp"
+#include "DataFrameGroupBy.hpp"
+#include "DataFrameSpill.hpp"
+#include "XlsxFixture.hpp"
+
+using namespace TinaToolBox;
+using namespace TinaToolBox::TestFixture;
+
+namespace {
+    // 内存预算是进程级的设置，每个测试结束时恢复为不限制
+    class DataFrameSpillTest : public ArrowTest {
+    protected:
+        void SetUp() override {
+            DataFrame::setMemoryBudget(0);
+            before_ = spillFiles();
+        }
+
+        void TearDown() override {
+            DataFrame::setMemoryBudget(0);
+        }
+
+        // 系统临时目录中的溢出文件
+        static std::set<std::filesystem::path> spillFiles() {
+            std::set<std::filesystem::path> paths;
+            for (const auto &entry: std::filesystem::directory_iterator(std::filesystem::temp_directory_path())) {
+                if (entry.path().filename().string().rfind("ttb_spill_", 0) == 0) {
+                    paths.insert(entry.path());
+                }
+            }
+            return paths;
+        }
+
+        // SetUp 之后新建且仍然存在的溢出文件
+        [[nodiscard]] std::vector<std::filesystem::path> newSpillFiles() const {
+            std::vector<std::filesystem::path> paths;
+            for (const auto &path: spillFiles()) {
+                if (before_.count(path) == 0) {
+                    paths.push_back(path);
+                }
+            }
+            return paths;
+        }
+
+        std::set<std::filesystem::path> before_;
+    };
+
+    // 超过外部排序的一段（SPILL_BATCH_ROWS 行），预算很小时分成多段再归并
+    constexpr int64_t ROWS = DataFrame::SPILL_BATCH_ROWS * 3 + 4321;
+
+    // 键大量重复且有空值；dept 是字典列，相邻分块的字典不同
+    DataFrame sampleFrame() {
+        Ints rows;
+        Ints groups;
+        Doubles scores;
+        Texts names;
+        Codes codes;
+        uint32_t seed = 17;
+        auto next = [&seed] {
+            seed = seed * 1103515245u + 12345u;
+            return (seed >> 16) & 0x7FFF;
+        };
+        for (int64_t i = 0; i < ROWS; ++i) {
+            rows.emplace_back(i);
+            const auto g = next();
+            groups.push_back(g % 23 == 0 ? std::nullopt : std::optional<int64_t>(g % 50));
+            const auto s = next();
+            scores.push_back(s % 19 == 0 ? std::nullopt : std::optional<double>((s % 400) * 0.25));
+            names.emplace_back("n" + std::to_string(next() % 300));
+        }
+        // 相邻分块的字典分别有 3 个和 4 个值
+        constexpr int64_t chunk_rows = 50000;
+        for (int64_t i = 0; i < ROWS; ++i) {
+            const uint32_t size = i / chunk_rows % 2 == 0 ? 3 : 4;
+            codes.push_back(i % 31 == 0 ? std::nullopt : std::optional<int32_t>(static_cast<int32_t>(next() % size)));
+        }
+        const auto dept = dictionaryColumn({{"HR", "IT", "Ops"}, {"Ops", "Sales", "HR", "IT"}}, codes, chunk_rows);
+        return TestFixture::sampleFrame({{"row", int64Array(rows)}, {"group", int64Array(groups)},
+                                         {"score", doubleArray(scores)}, {"name", stringArray(names)}},
+                                        chunk_rows, 4, "dept", dept);
+    }
+}
+
+TEST_F(DataFrameSpillTest, SpilledFrameOwnsItsFileUntilReleased) {
+    std::shared_ptr<arrow::Table> slice;
+    {
+        const DataFrame frame = sampleFrame();
+        TTB_ASSERT_OK_AND_ASSIGN(spilled, frame.spill());
+        EXPECT_TRUE(spilled.isSpilled());
+        EXPECT_FALSE(frame.isSpilled());
+        expectSameContent(spilled, frame);
+        EXPECT_EQ(newSpillFiles().size(), 1u);
+
+        // 已经溢出的 DataFrame 不再写新文件；派生的 DataFrame 不标记，但仍然引用同一个文件
+        TTB_ASSERT_OK_AND_ASSIGN(again, spilled.spill());
+        EXPECT_TRUE(again.isSpilled());
+        EXPECT_EQ(newSpillFiles().size(), 1u);
+        TTB_ASSERT_OK_AND_ASSIGN(filtered, spilled.filter("group", arrow::MakeScalar<int64_t>(7)));
+        EXPECT_FALSE(filtered.isSpilled());
+
+        slice = spilled.table()->Slice(10, 5);
+    }
+    // 切片共享映射的缓冲区，文件在它释放前保留
+    ASSERT_EQ(newSpillFiles().size(), 1u);
+    EXPECT_EQ(slice->num_rows(), 5);
+    EXPECT_EQ(columnValues<int64_t>(DataFrame(slice), "row"),
+              (Ints{10, 11, 12, 13, 14}));
+    slice.reset();
+    EXPECT_TRUE(newSpillFiles().empty());
+
+    EXPECT_TRUE(DataFrame().spill().status().IsInvalid());
+}
+
+TEST_F(DataFrameSpillTest, SpillFileWritesBatchesAndReadsThemBack) {
+    const auto batch = arrow::RecordBatch::Make(arrow::schema({arrow::field("id", arrow::int64())}), 3,
+                                                {int64Array({1, 2, std::nullopt})});
+    {
+        SpillFile file;
+        EXPECT_FALSE(file.reader().ok());
+        ASSERT_TRUE(file.write(*batch).ok());
+        ASSERT_TRUE(file.write(*batch).ok());
+        ASSERT_TRUE(file.close().ok());
+        EXPECT_EQ(file.rowCount(), 6);
+        EXPECT_FALSE(file.write(*batch).ok());
+
+        TTB_ASSERT_OK_AND_ASSIGN(reader, file.reader());
+        EXPECT_EQ(reader->num_record_batches(), 2);
+        TTB_ASSERT_OK_AND_ASSIGN(table, file.read());
+        EXPECT_EQ(columnValues<int64_t>(DataFrame(table), "id"),
+                  (Ints{1, 2, std::nullopt, 1, 2, std::nullopt}));
+        EXPECT_TRUE(std::filesystem::exists(file.path()));
+    }
+    EXPECT_TRUE(newSpillFiles().empty());
+
+    // 没有写入时不创建文件
+    SpillFile empty;
+    ASSERT_TRUE(empty.close().ok());
+    TTB_ASSERT_OK_AND_ASSIGN(nothing, empty.read());
+    EXPECT_EQ(nothing, nullptr);
+    EXPECT_FALSE(std::filesystem::exists(empty.path()));
+}
+
+TEST_F(DataFrameSpillTest, ExternalSortMatchesInMemorySort) {
+    const DataFrame frame = sampleFrame();
+    const std::vector<std::vector<DataFrame::SortKey> > key_sets = {
+        {{"group", true, false}, {"score", false, true}},
+        {{"dept", false, true}, {"name", true, false}},
+    };
+    for (const auto &keys: key_sets) {
+        SCOPED_TRACE(keys.front().column);
+        DataFrame::setMemoryBudget(0);
+        TTB_ASSERT_OK_AND_ASSIGN(in_memory, frame.sort(keys));
+        EXPECT_FALSE(in_memory.isSpilled());
+
+        // 预算很小时每段只有 SPILL_BATCH_ROWS 行；相同键的行保持原有顺序，与内存中的稳定排序相同
+        DataFrame::setMemoryBudget(1);
+        TTB_ASSERT_OK_AND_ASSIGN(external, frame.sort(keys));
+        EXPECT_TRUE(external.isSpilled());
+        expectSameContent(external, in_memory);
+        // 各段的临时文件已删除，只剩结果的文件
+        EXPECT_EQ(newSpillFiles().size(), 1u);
+    }
+    EXPECT_TRUE(newSpillFiles().empty());
+}
+
+TEST_F(DataFrameSpillTest, PartitionedGroupByMatchesInMemory) {
+    const DataFrame frame = sampleFrame();
+    const std::vector<Aggregation> aggregations = {
+        of(AggregateFunction::Count),
+        of(AggregateFunction::Count, "score"),
+        of(AggregateFunction::Sum, "row"),
+        of(AggregateFunction::Mean, "score"),
+        of(AggregateFunction::Min, "name"),
+        of(AggregateFunction::Max, "score"),
+        of(AggregateFunction::CountDistinct, "name"),
+    };
+    for (const auto &keys: std::vector<std::vector<std::string> >{{"group"}, {"dept", "group"}, {"name"}}) {
+        SCOPED_TRACE(keys.front());
+        DataFrame::setMemoryBudget(0);
+        TTB_ASSERT_OK_AND_ASSIGN(in_memory, frame.groupBy(keys).agg(aggregations));
+
+        // 分区写入临时文件后逐个聚合，各组仍按第一次出现的顺序排列
+        DataFrame::setMemoryBudget(1);
+        TTB_ASSERT_OK_AND_ASSIGN(partitioned, frame.groupBy(keys).agg(aggregations));
+        expectSameContent(partitioned, in_memory);
+    }
+    EXPECT_TRUE(newSpillFiles().empty());
+
+    // 预算只影响执行方式，错误与内存中相同
+    EXPECT_FALSE(frame.groupBy({"missing"}).agg(aggregations).ok());
+}
+
+TEST_F(DataFrameSpillTest, SpillFileExtendsChangingDictionaries) {
+    // 第二个批次的字典与第一个不同，写入时合并为 {a, b, c}，以增量字典写入
+    const auto schema = arrow::schema({arrow::field("dept", arrow::dictionary(arrow::int32(), arrow::utf8()))});
+    const auto first = arrow::RecordBatch::Make(schema, 3, {dictionaryArray({"a", "b"}, {1, std::nullopt, 0})});
+    const auto second = arrow::RecordBatch::Make(schema, 3, {dictionaryArray({"c", "b"}, {0, 1, 0})});
+    SpillFile file;
+    ASSERT_TRUE(file.write(*first).ok());
+    ASSERT_TRUE(file.write(*second).ok());
+    ASSERT_TRUE(file.write(*first).ok());
+    ASSERT_TRUE(file.close().ok());
+    TTB_ASSERT_OK_AND_ASSIGN(table, file.read());
+    EXPECT_EQ(columnValues<std::string>(DataFrame(table), "dept"),
+              (Texts{"b", std::nullopt, "a", "c", "b", "c", "b", std::nullopt, "a"}));
+}
+
+TEST_F(DataFrameSpillTest, CsvAndParquetSpillWhileLoading) {
+    TempDirectory dir;
+    const DataFrame frame = sampleFrame();
+    const std::string csv = dir.file("sample.csv");
+    ASSERT_TRUE(frame.toCsv(csv).ok());
+    const std::string parquet = dir.file("sample.parquet");
+    ColumnarWriteOptions write_options;
+    write_options.row_group_size = 20000;
+    ASSERT_TRUE(frame.toParquet(parquet, write_options).ok());
+
+    // 按批次读取，每个批次都是一次预算检查
+    CsvReadOptions csv_options;
+    csv_options.block_size = 1 << 18;
+    ColumnarReadOptions parquet_options;
+    parquet_options.columns = {"dept", "row", "score"};
+    parquet_options.filters = {{"group", arrow::MakeScalar<int64_t>(40), "less"}};
+    const std::vector<std::function<arrow::Result<DataFrame>()> > loaders = {
+        [&] { return DataFrame::fromCsv(csv, csv_options); },
+        [&] { return DataFrame::fromParquet(parquet); },
+        [&] { return DataFrame::fromParquet(parquet, parquet_options); },
+    };
+    for (size_t i = 0; i < loaders.size(); ++i) {
+        SCOPED_TRACE(i);
+        DataFrame::setMemoryBudget(0);
+        TTB_ASSERT_OK_AND_ASSIGN(in_memory, loaders[i]());
+        EXPECT_FALSE(in_memory.isSpilled());
+
+        // 读到一半超过预算：之前的批次写入文件，之后的批次直接写入文件
+        const int64_t allocated = arrow::default_memory_pool()->bytes_allocated();
+        DataFrame::setMemoryBudget(allocated + arrow::util::TotalBufferSize(*in_memory.table()) / 2);
+        TTB_ASSERT_OK_AND_ASSIGN(halfway, loaders[i]());
+        EXPECT_TRUE(halfway.isSpilled());
+        expectSameContent(halfway, in_memory);
+        EXPECT_EQ(newSpillFiles().size(), 1u);
+
+        DataFrame::setMemoryBudget(1);
+        TTB_ASSERT_OK_AND_ASSIGN(spilled, loaders[i]());
+        EXPECT_TRUE(spilled.isSpilled());
+        expectSameContent(spilled, in_memory);
+    }
+    EXPECT_TRUE(newSpillFiles().empty());
+
+    // 负数按 0 处理
+    DataFrame::setMemoryBudget(-5);
+    EXPECT_EQ(DataFrame::memoryBudget(), 0);
+}
+
+TEST_F(DataFrameSpillTest, ExcelSpillsChunksWhileParsing) {
+    // 超过多个构建分块（至少 1000 行）。分块溢出之后列还会放宽类型：
+    // A 大整数 -> 小数 -> 文本，B 共享字符串中夹着内联文本，C 前半为空，D 日期 -> 文本
+    constexpr int rows = 4500;
+    const auto cell = [](const std::string &ref, const std::string &attributes, const std::string &value) {
+        return R"(<c r=")" + ref + R"(" )" + attributes + "><v>" + value + "</v></c>";
+    };
+    const auto inline_cell = [](const std::string &ref, const std::string &text) {
+        return R"(<c r=")" + ref + R"(" t="inlineStr"><is><t>)" + text + "</t></is></c>";
+    };
+    std::string xml = R"(<row r="1">)" + inline_cell("A1", "Amount") + inline_cell("B1", "Dept") +
+                      inline_cell("C1", "Late") + inline_cell("D1", "When") + "</row>";
+    for (int i = 0; i < rows; ++i) {
+        const std::string r = std::to_string(i + 2);
+        std::string cells;
+        if (i == 4000) {
+            cells += inline_cell("A" + r, "n/a");
+        } else {
+            cells += cell("A" + r, "", i >= 2500 ? std::to_string(i) + ".5" : std::to_string(i) + "0000000000000");
+        }
+        cells += i % 17 == 5 ? inline_cell("B" + r, "extra" + std::to_string(i % 3))
+                             : cell("B" + r, R"(t="s")", std::to_string(i % 3));
+        if (i >= 2000 && i % 5 != 0) {
+            cells += cell("C" + r, "", std::to_string(i % 7));
+        }
+        cells += i == 3500 ? inline_cell("D" + r, "later") : cell("D" + r, R"(s="1")", std::to_string(45000 + i));
+        xml += R"(<row r=")" + r + R"(">)" + cells + "</row>";
+    }
+    TempDirectory dir;
+    const std::string path = dir.file("spill.xlsx");
+    writeXlsx(path, xml, "<sst><si><t>HR</t></si><si><t>IT</t></si><si><t>Ops</t></si></sst>",
+              "A1:D" + std::to_string(rows + 1));
+
+    const DataFrame in_memory = DataFrame::fromExcel(path);
+    EXPECT_FALSE(in_memory.isSpilled());
+    ASSERT_EQ(in_memory.getColumn("Dept")->type()->id(), arrow::Type::DICTIONARY);
+    EXPECT_EQ(in_memory.getColumn("Amount")->type()->id(), arrow::Type::STRING);
+    EXPECT_EQ(columnValues<std::string>(in_memory, "Amount")[1], "10000000000000");
+
+    DataFrame::setMemoryBudget(1);
+    const DataFrame spilled = DataFrame::fromExcel(path);
+    EXPECT_TRUE(spilled.isSpilled());
+    expectSameContent(spilled, in_memory);
+    ASSERT_EQ(spilled.loadReport().size(), in_memory.loadReport().size());
+    for (size_t i = 0; i < in_memory.loadReport().size(); ++i) {
+        EXPECT_EQ(spilled.loadReport()[i].coerced, in_memory.loadReport()[i].coerced) << i;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include "ZipWriter.hpp"
+
+namespace TinaToolBox {
+    namespace TestFixture {
+        // 测试用的临时目录，析构时连同其中的文件一起删除
+        class TempDirectory {
+        public:
+            TempDirectory() {
+                static std::atomic_int counter{0};
+                path_ = std::filesystem::temp_directory_path() /
+                        ("ttb_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                         "_" + std::to_string(counter++));
+                std::filesystem::create_directories(path_);
+            }
+
+            ~TempDirectory() {
+                std::error_code ec;
+                std::filesystem::remove_all(path_, ec);
+            }
+
+            TempDirectory(const TempDirectory &) = delete;
+            TempDirectory &operator=(const TempDirectory &) = delete;
+
+            [[nodiscard]] const std::filesystem::path &path() const { return path_; }
+
+            [[nodiscard]] std::string file(const std::string &name) const { return (path_ / name).string(); }
+
+        private:
+            std::filesystem::path path_;
+        };
+
+        // 手写 XML 组装的最小 xlsx，不经过 XlsxStreamWriter，用于独立检验读取端。
+        // 工作簿有两个工作表，激活的是第二个（"Data"，对应 sheet1.xml）。
+        // 样式：0 常规，1 内置日期格式 14，2 自定义日期格式，3 带引号文本的数字格式（不是日期）
+        inline void writeXlsx(const std::string &path, const std::string &sheet_data,
+                              const std::string &shared_strings = "<sst/>",
+                              const std::string &dimension = "") {
+            ZipWriter zip(path);
+            zip.beginEntry("[Content_Types].xml");
+            zip.write(R"(<?xml version="1.0"?><Types/>)");
+            zip.beginEntry("_rels/.rels");
+            zip.write(R"(<?xml version="1.0" encoding="UTF-8"?><Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">)"
+                R"(<Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="xl/workbook.xml"/></Relationships>)");
+            zip.beginEntry("xl/workbook.xml");
+            zip.write(R"(<?xml version="1.0"?><workbook xmlns="x" xmlns:r="r"><workbookPr date1904="false"/>)"
+                R"(<bookViews><workbookView activeTab="1"/></bookViews><sheets><sheet name="Other" sheetId="1" r:id="rId2"/>)"
+                R"(<sheet name="Data" sheetId="2" r:id="rId1"/></sheets></workbook>)");
+            zip.beginEntry("xl/_rels/workbook.xml.rels");
+            zip.write(R"(<Relationships><Relationship Id="rId1" Type="http://x/worksheet" Target="worksheets/sheet1.xml"/>)"
+                R"(<Relationship Id="rId2" Type="http://x/worksheet" Target="/xl/worksheets/sheet2.xml"/>)"
+                R"(<Relationship Id="rId3" Type="http://x/styles" Target="styles.xml"/>)"
+                R"(<Relationship Id="rId4" Type="http://x/sharedStrings" Target="sharedStrings.xml"/></Relationships>)");
+            zip.beginEntry("xl/styles.xml");
+            zip.write(R"(<styleSheet><numFmts count="2"><numFmt numFmtId="164" formatCode="yyyy\-mm\-dd;@"/>)"
+                R"(<numFmt numFmtId="165" formatCode="&quot;day&quot;0.00"/></numFmts><cellStyleXfs><xf numFmtId="14"/></cellStyleXfs>)"
+                R"(<cellXfs count="4"><xf numFmtId="0"/><xf numFmtId="14"/><xf numFmtId="164"/><xf numFmtId="165"/></cellXfs></styleSheet>)");
+            zip.beginEntry("xl/sharedStrings.xml");
+            zip.write(shared_strings);
+            zip.beginEntry("xl/worksheets/sheet2.xml");
+            zip.write("<worksheet><sheetData/></worksheet>");
+            zip.beginEntry("xl/worksheets/sheet1.xml");
+            zip.write(R"(<?xml version="1.0"?><worksheet xmlns="main">)");
+            if (!dimension.empty()) {
+                zip.write(R"(<dimension ref=")" + dimension + R"("/>)");
+            }
+            zip.write("<sheetData>" + sheet_data + "</sheetData></worksheet>");
+            zip.close();
+        }
+    } // namespace TestFixture
+} // namespace TinaToolBox
@@ -0,0 +1,421 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "XlsxFixture.hpp"
+#include "XlsxStreamReader.hpp"
+#include "XlsxStreamWriter.hpp"
+#include "ZipArchive.hpp"
+#include "ZipWriter.hpp"
+
+using namespace TinaToolBox;
+using TestFixture::TempDirectory;
+
+namespace {
+    // 行回调收到的单元格，文本在回调结束后失效，这里复制一份
+    struct RowCells {
+        std::uint64_t row = 0;
+        std::vector<XlsxStreamReader::Cell> cells;
+        std::vector<std::string> texts;
+    };
+
+    XlsxStreamReader::RowCallback collectRows(std::vector<RowCells> &rows) {
+        return [&rows](std::uint64_t row, const std::vector<XlsxStreamReader::Cell> &cells) {
+            RowCells copy{row, cells, {}};
+            for (auto &cell: copy.cells) {
+                copy.texts.emplace_back(cell.text);
+                cell.text = {};
+            }
+            rows.push_back(std::move(copy));
+        };
+    }
+
+    void expectSameRows(const std::vector<RowCells> &actual, const std::vector<RowCells> &expected) {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQ(actual[i].row, expected[i].row);
+            ASSERT_EQ(actual[i].cells.size(), expected[i].cells.size()) << "row " << expected[i].row;
+            for (size_t c = 0; c < expected[i].cells.size(); ++c) {
+                const auto &a = actual[i].cells[c];
+                const auto &e = expected[i].cells[c];
+                EXPECT_EQ(a.column, e.column);
+                EXPECT_EQ(a.type, e.type);
+                EXPECT_EQ(a.number, e.number);
+                EXPECT_EQ(a.shared_index, e.shared_index);
+                EXPECT_EQ(a.is_date, e.is_date);
+                EXPECT_EQ(actual[i].texts[c], expected[i].texts[c]);
+            }
+        }
+    }
+
+    // rows 行混合类型的数据，行号有间隔，部分单元格省略 r 属性
+    std::string generatedSheet(int rows, bool with_references = true) {
+        std::string xml;
+        for (int i = 1; i <= rows; ++i) {
+            const int row = i + i / 10;
+            xml += with_references ? "<row r=\"" + std::to_string(row) + "\">" : "<row>";
+            xml += R"(<c t="s"><v>)" + std::to_string(i % 3) + "</v></c>";
+            xml += "<c><v>" + std::to_string(i * 0.25) + "</v></c>";
+            if (i % 4 != 0) {
+                xml += R"(<c r="D)" + std::to_string(row) + R"(" s="1"><v>)" + std::to_string(45000 + i) + "</v></c>";
+            }
+            xml += R"(<c t="inlineStr"><is><t>text )" + std::to_string(i) + "</t></is></c>";
+            xml += "</row>";
+        }
+        return xml;
+    }
+
+    const std::string SHARED_STRINGS =
+            R"(<sst uniqueCount="3"><si><t>Name</t></si><si><r><t>Rich </t></r><r><t>&amp;text</t></r><rPh><t>PH</t></rPh></si>)"
+            R"(<si><t xml:space="preserve"> 中文&#x4E2D; </t></si></sst>)";
+
+    const std::string SHEET_DATA =
+            R"(<row r="1"><c r="A1" t="s"><v>0</v></c><c r="B1" t="inlineStr"><is><t>Value</t></is></c><c r="C1" t="str"><v>When</v></c><c t="str"><v>Flag</v></c></row>)"
+            R"(<row r="2"><c r="A2" t="s"><v>1</v></c><c r="B2"><v>1.5</v></c><c r="C2" s="1"><v>45000.5</v></c><c r="D2" t="b"><v>1</v></c><c r="E2" s="3"/></row>)"
+            R"(<row r="4"><c r="B4" s="3"><v>-2</v></c><c r="C4" s="2"><v>45001</v></c><c r="D4" t="e"><v>#N/A</v></c></row>)";
+}
+
+TEST(XlsxStreamTest, ZipWriterEntriesReadBack) {
+    TempDirectory dir;
+    const std::string path = dir.file("entries.zip");
+
+    std::string large;
+    for (int i = 0; i < 200000; ++i) {
+        large += std::to_string(i * 7919 % 1000003);
+        large += ',';
+    }
+    {
+        ZipWriter zip(path);
+        zip.beginEntry("small.txt");
+        zip.write("hello");
+        zip.write(" zip");
+        zip.beginEntry("dir/large.csv", 9);
+        // 分多次写入，跨越输出缓冲区
+        for (size_t offset = 0; offset < large.size(); offset += 4093) {
+            zip.write(std::string_view(large).substr(offset, 4093));
+        }
+        zip.beginEntry("empty");
+        zip.close();
+    }
+
+    ZipArchive archive(path);
+    ASSERT_EQ(archive.entries().size(), 3u);
+    EXPECT_EQ(archive.find("missing"), nullptr);
+
+    std::string content;
+    ASSERT_TRUE(archive.readAll("small.txt", content));
+    EXPECT_EQ(content, "hello zip");
+    ASSERT_TRUE(archive.readAll("empty", content));
+    EXPECT_TRUE(content.empty());
+    EXPECT_FALSE(archive.readAll("missing", content));
+
+    const auto *entry = archive.find("dir/large.csv");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->uncompressed_size, large.size());
+    EXPECT_LT(entry->compressed_size, entry->uncompressed_size);
+
+    // 小缓冲区逐块读取，读到末尾时校验 CRC32
+    auto reader = archive.open(*entry);
+    std::string streamed;
+    char buffer[1000];
+    while (const size_t n = reader->read(buffer, sizeof(buffer))) {
+        streamed.append(buffer, n);
+        EXPECT_EQ(reader->uncompressedBytesRead(), streamed.size());
+    }
+    EXPECT_EQ(streamed, large);
+}
+
+TEST(XlsxStreamTest, RejectsFilesThatAreNotZip) {
+    TempDirectory dir;
+    const std::string path = dir.file("plain.xlsx");
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not a zip archive";
+    }
+    EXPECT_THROW(ZipArchive archive(path), std::runtime_error);
+    EXPECT_THROW(XlsxStreamReader reader(path), std::runtime_error);
+    EXPECT_THROW(XlsxStreamReader reader(dir.file("missing.xlsx")), std::runtime_error);
+}
+
+TEST(XlsxStreamTest, ReadsWorkbookPartsAndSharedStrings) {
+    TempDirectory dir;
+    const std::string path = dir.file("book.xlsx");
+    TestFixture::writeXlsx(path, SHEET_DATA, SHARED_STRINGS, "A1:E4");
+
+    XlsxStreamReader reader(path);
+    ASSERT_EQ(reader.sheets().size(), 2u);
+    EXPECT_EQ(reader.sheets()[0].name, "Other");
+    EXPECT_EQ(reader.sheets()[0].path, "xl/worksheets/sheet2.xml");
+    EXPECT_EQ(reader.sheets()[1].name, "Data");
+    EXPECT_EQ(reader.sheets()[1].path, "xl/worksheets/sheet1.xml");
+    EXPECT_EQ(reader.activeSheet(), 1u);
+    EXPECT_FALSE(reader.date1904());
+
+    // 富文本的各段连接起来，注音（rPh）不计入
+    ASSERT_EQ(reader.sharedStringCount(), 3u);
+    EXPECT_EQ(reader.sharedString(0), "Name");
+    EXPECT_EQ(reader.sharedString(1), "Rich &text");
+    EXPECT_EQ(reader.sharedString(2), " 中文中 ");
+
+    const auto dimension = reader.dimension(1);
+    EXPECT_EQ(dimension.rows, 4u);
+    EXPECT_EQ(dimension.columns, 5u);
+    EXPECT_EQ(reader.dimension(0).rows, 0u);
+}
+
+TEST(XlsxStreamTest, ReadSheetReportsCellsAndProgress) {
+    TempDirectory dir;
+    const std::string path = dir.file("book.xlsx");
+    TestFixture::writeXlsx(path, SHEET_DATA, SHARED_STRINGS);
+
+    XlsxStreamReader reader(path);
+    std::vector<RowCells> rows;
+    std::uint64_t last_parsed = 0;
+    std::uint64_t total = 0;
+    reader.readSheet(reader.activeSheet(), collectRows(rows), [&](std::uint64_t parsed, std::uint64_t bytes) {
+        EXPECT_GE(parsed, last_parsed);
+        last_parsed = parsed;
+        total = bytes;
+    });
+    EXPECT_EQ(total, reader.sheetSize(reader.activeSheet()));
+    EXPECT_EQ(last_parsed, total);
+
+    // 没有值的单元格（E2）不出现，空行（第 3 行）不回调
+    ASSERT_EQ(rows.size(), 3u);
+    using Type = XlsxStreamReader::Cell::Type;
+
+    const auto &header = rows[0];
+    EXPECT_EQ(header.row, 1u);
+    ASSERT_EQ(header.cells.size(), 4u);
+    EXPECT_EQ(header.cells[0].type, Type::SharedString);
+    EXPECT_EQ(header.cells[0].shared_index, 0u);
+    EXPECT_EQ(header.cells[1].type, Type::String);
+    EXPECT_EQ(header.texts[1], "Value");
+    EXPECT_EQ(header.texts[2], "When");
+    // 没有 r 属性的单元格紧跟前一个单元格
+    EXPECT_EQ(header.cells[3].column, 3u);
+    EXPECT_EQ(header.texts[3], "Flag");
+
+    const auto &first = rows[1];
+    EXPECT_EQ(first.row, 2u);
+    ASSERT_EQ(first.cells.size(), 4u);
+    EXPECT_EQ(first.cells[0].shared_index, 1u);
+    EXPECT_EQ(first.cells[1].type, Type::Number);
+    EXPECT_DOUBLE_EQ(first.cells[1].number, 1.5);
+    EXPECT_FALSE(first.cells[1].is_date);
+    EXPECT_DOUBLE_EQ(first.cells[2].number, 45000.5);
+    EXPECT_TRUE(first.cells[2].is_date);
+    EXPECT_EQ(first.cells[3].type, Type::Boolean);
+    EXPECT_DOUBLE_EQ(first.cells[3].number, 1.0);
+
+    const auto &second = rows[2];
+    EXPECT_EQ(second.row, 4u);
+    ASSERT_EQ(second.cells.size(), 3u);
+    EXPECT_EQ(second.cells[0].column, 1u);
+    EXPECT_DOUBLE_EQ(second.cells[0].number, -2.0);
+    // 格式代码中引号内的 "day" 不是日期占位符
+    EXPECT_FALSE(second.cells[0].is_date);
+    EXPECT_TRUE(second.cells[1].is_date);
+    EXPECT_EQ(second.cells[2].type, Type::Error);
+    EXPECT_EQ(second.texts[2], "#N/A");
+}
+
+TEST(XlsxStreamTest, CallbackExceptionAbortsRead) {
+    TempDirectory dir;
+    const std::string path = dir.file("book.xlsx");
+    TestFixture::writeXlsx(path, SHEET_DATA, SHARED_STRINGS);
+
+    XlsxStreamReader reader(path);
+    int calls = 0;
+    EXPECT_THROW(reader.readSheet(reader.activeSheet(), [&](std::uint64_t, const auto &) {
+        ++calls;
+        throw std::logic_error("stop");
+    }), std::logic_error);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(XlsxStreamTest, CellReferenceAndDateFormatHelpers) {
+    EXPECT_EQ(XlsxStreamReader::columnFromReference("A1"), 0);
+    EXPECT_EQ(XlsxStreamReader::columnFromReference("Z9"), 25);
+    EXPECT_EQ(XlsxStreamReader::columnFromReference("AA10"), 26);
+    EXPECT_EQ(XlsxStreamReader::columnFromReference("XFD1048576"), 16383);
+    EXPECT_EQ(XlsxStreamReader::columnFromReference("12"), -1);
+
+    EXPECT_TRUE(XlsxStreamReader::isDateFormat(14, ""));
+    EXPECT_TRUE(XlsxStreamReader::isDateFormat(22, ""));
+    EXPECT_FALSE(XlsxStreamReader::isDateFormat(0, "General"));
+    EXPECT_TRUE(XlsxStreamReader::isDateFormat(164, "yyyy\\-mm\\-dd;@"));
+    EXPECT_TRUE(XlsxStreamReader::isDateFormat(164, "[$-409]h:mm AM/PM"));
+    EXPECT_FALSE(XlsxStreamReader::isDateFormat(165, "\"day\"0.00"));
+    EXPECT_FALSE(XlsxStreamReader::isDateFormat(166, "[Red]0.00"));
+}
+
+TEST(XlsxStreamTest, SplitRangesParseLikeSequentialRead) {
+    TempDirectory dir;
+    const std::string path = dir.file("split.xlsx");
+    TestFixture::writeXlsx(path, generatedSheet(3000), SHARED_STRINGS);
+
+    XlsxStreamReader reader(path);
+    const size_t sheet = reader.activeSheet();
+    std::vector<RowCells> sequential;
+    reader.readSheet(sheet, collectRows(sequential));
+    ASSERT_EQ(sequential.size(), 3000u);
+
+    // 每个片段独立解析后按顺序拼接，结果与顺序读取相同
+    std::vector<std::string> ranges;
+    std::uint64_t last_parsed = 0;
+    reader.splitSheet(sheet, 2048, [&ranges](std::string &&xml) {
+        ranges.push_back(std::move(xml));
+    }, [&last_parsed](std::uint64_t parsed, std::uint64_t) {
+        last_parsed = parsed;
+    });
+    EXPECT_EQ(last_parsed, reader.sheetSize(sheet));
+    ASSERT_GT(ranges.size(), 4u);
+
+    std::uint64_t total_bytes = 0;
+    std::vector<RowCells> split;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        total_bytes += ranges[i].size();
+        if (i > 0) {
+            EXPECT_EQ(ranges[i].rfind("<row r=\"", 0), 0u) << "range " << i;
+        }
+        reader.parseRange(ranges[i], collectRows(split));
+    }
+    EXPECT_EQ(total_bytes, reader.sheetSize(sheet));
+    expectSameRows(split, sequential);
+}
+
+TEST(XlsxStreamTest, SplitRangesParseInAnyOrder) {
+    TempDirectory dir;
+    const std::string path = dir.file("split.xlsx");
+    TestFixture::writeXlsx(path, generatedSheet(500), SHARED_STRINGS);
+
+    XlsxStreamReader reader(path);
+    std::vector<RowCells> sequential;
+    reader.readSheet(reader.activeSheet(), collectRows(sequential));
+
+    std::vector<std::string> ranges;
+    reader.splitSheet(reader.activeSheet(), 1024, [&ranges](std::string &&xml) {
+        ranges.push_back(std::move(xml));
+    });
+    ASSERT_GT(ranges.size(), 2u);
+
+    // 片段不依赖前面片段的解析状态：倒序解析后按片段序号拼回
+    std::vector<std::vector<RowCells> > parsed(ranges.size());
+    for (size_t i = ranges.size(); i-- > 0;) {
+        reader.parseRange(ranges[i], collectRows(parsed[i]));
+    }
+    std::vector<RowCells> split;
+    for (auto &rows: parsed) {
+        split.insert(split.end(), rows.begin(), rows.end());
+    }
+    expectSameRows(split, sequential);
+}
+
+TEST(XlsxStreamTest, SheetWithoutRowNumbersIsOneRange) {
+    TempDirectory dir;
+    const std::string path = dir.file("unnumbered.xlsx");
+    TestFixture::writeXlsx(path, generatedSheet(200, false), SHARED_STRINGS);
+
+    XlsxStreamReader reader(path);
+    std::vector<RowCells> sequential;
+    reader.readSheet(reader.activeSheet(), collectRows(sequential));
+    ASSERT_EQ(sequential.size(), 200u);
+    EXPECT_EQ(sequential.back().row, 200u);
+
+    int calls = 0;
+    std::vector<RowCells> split;
+    reader.splitSheet(reader.activeSheet(), 256, [&](std::string &&xml) {
+        ++calls;
+        reader.parseRange(xml, collectRows(split));
+    });
+    EXPECT_EQ(calls, 1);
+    expectSameRows(split, sequential);
+}
+
+TEST(XlsxStreamTest, FindRowBoundary) {
+    const std::string xml = R"(<row r="1"><c/></row><row><c/></row><row r="3" spans="1:2"><c/></row><rows/>)";
+    const size_t third = xml.find(R"(<row r="3")");
+    EXPECT_EQ(XlsxStreamReader::findRowBoundary(xml), third);
+    EXPECT_EQ(XlsxStreamReader::findRowBoundary(std::string_view(xml).substr(0, third)), 0u);
+    EXPECT_EQ(XlsxStreamReader::findRowBoundary("<sheetData><rowBreaks/>"), std::string_view::npos);
+}
+
+TEST(XlsxStreamTest, StreamWriterOutputReadsBack) {
+    TempDirectory dir;
+    const std::string path = dir.file("written.xlsx");
+    using Out = XlsxStreamWriter::Cell;
+    auto cell = [](std::uint32_t column, Out::Type type, double number = 0.0, std::string_view text = {}) {
+        Out c;
+        c.column = column;
+        c.type = type;
+        c.number = number;
+        c.text = text;
+        return c;
+    };
+    {
+        XlsxStreamWriter writer(path, {4, 3}, "Q&A");
+        const auto shared = writer.sharedString("dup");
+        EXPECT_EQ(writer.sharedString("dup"), shared);
+
+        writer.writeRow(1, {cell(0, Out::Type::String, 0, "name"), cell(1, Out::Type::String, 0, "<a & \"b\">"),
+                            cell(2, Out::Type::String, 0, " padded ")});
+        writer.writeRow(2, {cell(0, Out::Type::Number, 1.5), cell(1, Out::Type::Date, 45000.25),
+                            cell(2, Out::Type::Boolean, 1.0)});
+        // 第 3 行不写出；NaN 写为错误值；控制字符和 _xHHHH_ 形式的原文要能还原
+        Out dup = cell(0, Out::Type::SharedString);
+        dup.shared_index = shared;
+        writer.writeRow(4, {dup, cell(1, Out::Type::Number, std::nan("")),
+                            cell(2, Out::Type::String, 0, "_x0041_\x01end")});
+
+        EXPECT_THROW(writer.writeRow(4, {}), std::runtime_error);
+        writer.writeRow(5, {});
+        EXPECT_THROW(writer.writeRow(6, {cell(XlsxStreamWriter::MAX_COLUMNS, Out::Type::Number)}),
+                     std::runtime_error);
+        writer.finish();
+        EXPECT_THROW(writer.writeRow(7, {}), std::runtime_error);
+    }
+
+    XlsxStreamReader reader(path);
+    ASSERT_EQ(reader.sheets().size(), 1u);
+    EXPECT_EQ(reader.sheets()[0].name, "Q&A");
+    const auto dimension = reader.dimension(0);
+    EXPECT_EQ(dimension.rows, 4u);
+    EXPECT_EQ(dimension.columns, 3u);
+    ASSERT_EQ(reader.sharedStringCount(), 5u);
+
+    std::vector<RowCells> rows;
+    reader.readSheet(0, collectRows(rows));
+    ASSERT_EQ(rows.size(), 3u);
+    using Type = XlsxStreamReader::Cell::Type;
+    auto text = [&](const RowCells &row, size_t index) {
+        return row.cells[index].type == Type::SharedString
+                   ? std::string(reader.sharedString(row.cells[index].shared_index))
+                   : row.texts[index];
+    };
+
+    ASSERT_EQ(rows[0].cells.size(), 3u);
+    EXPECT_EQ(text(rows[0], 0), "name");
+    EXPECT_EQ(text(rows[0], 1), "<a & \"b\">");
+    EXPECT_EQ(text(rows[0], 2), " padded ");
+
+    ASSERT_EQ(rows[1].cells.size(), 3u);
+    EXPECT_EQ(rows[1].cells[0].type, Type::Number);
+    EXPECT_DOUBLE_EQ(rows[1].cells[0].number, 1.5);
+    EXPECT_FALSE(rows[1].cells[0].is_date);
+    EXPECT_DOUBLE_EQ(rows[1].cells[1].number, 45000.25);
+    EXPECT_TRUE(rows[1].cells[1].is_date);
+    EXPECT_EQ(rows[1].cells[2].type, Type::Boolean);
+    EXPECT_DOUBLE_EQ(rows[1].cells[2].number, 1.0);
+
+    EXPECT_EQ(rows[2].row, 4u);
+    ASSERT_EQ(rows[2].cells.size(), 3u);
+    EXPECT_EQ(rows[2].cells[0].type, Type::SharedString);
+    EXPECT_EQ(text(rows[2], 0), "dup");
+    EXPECT_EQ(rows[2].cells[1].type, Type::Error);
+    EXPECT_EQ(rows[2].texts[1], "#NUM!");
+    EXPECT_EQ(text(rows[2], 2), "_x0041_\x01end");
+}
@@ -4,7 +4,15 @@
 #include <vector>
 #include <future>
 #include <random>
+#include <array>
+#include <numeric>
 #include "ThreadPool.hpp"
+#include "TaskGraph.hpp"
+#include "ThreadPoolGroup.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 using namespace TinaToolBox;
 using namespace std::chrono_literals;
@@ -199,6 +207,92 @@ TEST_F(ThreadPoolTest, ThreadSafeQueueTryPopBatchBoundary) {
     }
 }
 
+TEST_F(ThreadPoolTest, ThreadSafeQueueFairShareBatchLocksOnce) {
+    ThreadSafeQueue<int> queue;
+    std::vector<int> items(40);
+    std::iota(items.begin(), items.end(), 0);
+    queue.push_batch(items.begin(), items.end());
+    EXPECT_EQ(queue.lockCount(), 1u);
+
+    // 4 个消费者时每次取走当前元素数的 1/4，份额和出队在同一次加锁内完成
+    std::vector<int> batch;
+    EXPECT_EQ(queue.try_pop_batch(batch, 100, 4), 10u);
+    EXPECT_EQ(batch.front(), 0);
+    EXPECT_EQ(queue.lockCount(), 2u);
+    EXPECT_EQ(queue.try_pop_batch(batch, 100, 4), 7u);
+    EXPECT_EQ(batch.front(), 10);
+    EXPECT_EQ(queue.lockCount(), 3u);
+    // 份额受 max_items 限制，不足 1 个时至少取 1 个
+    EXPECT_EQ(queue.try_pop_batch(batch, 2, 1), 2u);
+    EXPECT_EQ(queue.try_pop_batch(batch, 100, 1000), 1u);
+    EXPECT_EQ(queue.lockCount(), 5u);
+
+    size_t drained = 20;
+    while (queue.try_pop_batch(batch, 100, 4) > 0) {
+        drained += batch.size();
+    }
+    EXPECT_EQ(drained, items.size());
+
+    // 无锁环形队列的语义相同
+    ThreadSafeQueue<int, LockFreeRingPolicy<64> > ring;
+    ring.push_batch(items.begin(), items.end());
+    EXPECT_EQ(ring.try_pop_batch(batch, 100, 4), 10u);
+    EXPECT_EQ(ring.try_pop_batch(batch, 3, 1), 3u);
+    EXPECT_EQ(batch.front(), 10);
+}
+
+// 无锁环形队列：先进先出、容量上限和多生产者多消费者下不丢不重
+TEST_F(ThreadPoolTest, LockFreeRingQueue) {
+    ThreadSafeQueue<int, LockFreeRingPolicy<8> > ring;
+    EXPECT_TRUE(ring.empty());
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(ring.try_push(i));
+    }
+    EXPECT_FALSE(ring.try_push(8));
+    EXPECT_EQ(ring.size(), 8u);
+
+    std::vector<int> batch;
+    EXPECT_EQ(ring.try_pop_batch(batch, 5), 5u);
+    EXPECT_EQ(batch, (std::vector<int>{0, 1, 2, 3, 4}));
+    int value = -1;
+    ASSERT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(value, 5);
+    EXPECT_EQ(ring.pop(), 6);
+    ring.clear();
+    EXPECT_FALSE(ring.pop_for(value, std::chrono::milliseconds(5)));
+
+    ThreadSafeQueue<std::unique_ptr<int>, LockFreeRingPolicy<64> > queue;
+    constexpr int producers = 4;
+    constexpr int per_producer = 20000;
+    std::vector<std::atomic_int> seen(producers * per_producer);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < per_producer; ++i) {
+                queue.push(std::make_unique<int>(p * per_producer + i));
+            }
+        });
+    }
+    std::atomic_int consumed{0};
+    for (int c = 0; c < 4; ++c) {
+        threads.emplace_back([&queue, &seen, &consumed] {
+            std::unique_ptr<int> item;
+            while (consumed.load() < producers * per_producer) {
+                if (queue.pop_for(item, std::chrono::milliseconds(1))) {
+                    ++seen[*item];
+                    ++consumed;
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (auto &count: seen) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
 TEST_F(ThreadPoolTest, Shutdown) {
     ThreadPool pool;
     std::atomic<int> counter{0};
@@ -246,4 +340,608 @@ TEST_F(ThreadPoolTest, PoolStats) {
     const auto& stats = pool.getStats(); 
     EXPECT_EQ(stats.tasks_completed, 1);  // 期望成功完成1个任务
     EXPECT_EQ(stats.tasks_failed, 1);     // 期望失败1个任务
-}
\ No newline at end of file
+}
+
+TEST_F(ThreadPoolTest, WorkStealingPostAndWait) {
+    ThreadPool pool(4, ThreadPool::SchedulingMode::WorkStealing);
+    EXPECT_EQ(pool.schedulingMode(), ThreadPool::SchedulingMode::WorkStealing);
+    std::atomic<int> counter{0};
+
+    for (int i = 0; i < 1000; ++i) {
+        pool.post([&counter] {
+            ++counter;
+        });
+    }
+
+    pool.waitForAll();
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST_F(ThreadPoolTest, WorkStealingNestedSubmit) {
+    ThreadPool pool(4, ThreadPool::SchedulingMode::WorkStealing);
+    std::atomic<int> counter{0};
+
+    // 工作线程内部提交的子任务进入本地队列，由空闲线程窃取执行
+    for (int i = 0; i < 10; ++i) {
+        pool.post([&pool, &counter] {
+            for (int j = 0; j < 100; ++j) {
+                pool.post([&counter] {
+                    ++counter;
+                });
+            }
+        });
+    }
+
+    pool.waitForAll();
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST_F(ThreadPoolTest, WorkStealingSubmitWithResult) {
+    ThreadPool pool(2, ThreadPool::SchedulingMode::WorkStealing);
+
+    auto future = pool.submit([] {
+        return 42;
+    });
+    auto failed = pool.submit([] {
+        throw std::runtime_error("Failed task");
+    });
+
+    EXPECT_EQ(future.get(), 42);
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST_F(ThreadPoolTest, WorkStealingTaskPriority) {
+    ThreadPool pool(1, ThreadPool::SchedulingMode::WorkStealing);
+    std::vector<int> results;
+    std::mutex results_mutex;
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+
+    // 先用一个任务占住唯一的工作线程，保证后续任务都在队列中排队
+    pool.post([gate_future] {
+        gate_future.wait();
+    });
+
+    pool.post([&] {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        results.push_back(1);
+    }, ThreadPool::TaskPriority::Low);
+
+    pool.post([&] {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        results.push_back(2);
+    }, ThreadPool::TaskPriority::Normal);
+
+    pool.post([&] {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        results.push_back(3);
+    }, ThreadPool::TaskPriority::High);
+
+    gate.set_value();
+    pool.waitForAll();
+
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results[0], 3);
+    EXPECT_EQ(results[1], 2);
+    EXPECT_EQ(results[2], 1);
+}
+
+TEST_F(ThreadPoolTest, AllocationFreeSubmit) {
+    ThreadPool pool(2);
+    constexpr int NUM_TASKS = 1000;
+
+    // 逐个提交并等待，共享状态在 arena 中循环复用
+    for (int i = 0; i < NUM_TASKS; ++i) {
+        auto future = pool.submit([i] {
+            return i;
+        });
+        EXPECT_EQ(future.get(), i);
+    }
+    pool.waitForAll();
+
+    const auto &stats = pool.getStats();
+    EXPECT_EQ(stats.task_heap_allocations, 0);
+    EXPECT_GE(stats.state_arena_allocations, NUM_TASKS);
+    // 只有首次填充 slab 时才分配堆内存
+    EXPECT_LE(stats.state_heap_allocations, 2);
+}
+
+TEST_F(ThreadPoolTest, LargeCallableFallsBackToHeap) {
+    ThreadPool pool(1);
+    std::array<char, TaskFunction::INLINE_SIZE * 2> payload{};
+    payload[0] = 7;
+
+    auto future = pool.submit([payload] {
+        return static_cast<int>(payload[0]);
+    });
+
+    EXPECT_EQ(future.get(), 7);
+    EXPECT_EQ(pool.getStats().task_heap_allocations, 1);
+}
+
+TEST_F(ThreadPoolTest, MoveOnlyCallable) {
+    ThreadPool pool(2);
+    auto value = std::make_unique<int>(5);
+
+    auto future = pool.submit([value = std::move(value)] {
+        return *value * 2;
+    });
+
+    EXPECT_EQ(future.get(), 10);
+}
+
+TEST_F(ThreadPoolTest, ParallelFor) {
+    ThreadPool pool(4);
+    std::vector<int> values(10000, 0);
+
+    pool.parallel_for(0, values.size(), 16, [&values](size_t i) {
+        values[i] = static_cast<int>(i) * 2;
+    });
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], static_cast<int>(i) * 2);
+    }
+
+    // 区间形式的函数体
+    std::atomic<size_t> covered{0};
+    pool.parallel_for(100, 200, 0, [&covered](size_t begin, size_t end) {
+        covered += end - begin;
+    });
+    EXPECT_EQ(covered.load(), 100);
+}
+
+TEST_F(ThreadPoolTest, ParallelForNestedInWorker) {
+    ThreadPool pool(2, ThreadPool::SchedulingMode::WorkStealing);
+    std::atomic<int> counter{0};
+
+    // 在工作线程内部嵌套调用，调用线程自己参与执行，不会因等待而死锁
+    pool.parallel_for(0, 8, 1, [&](size_t) {
+        pool.parallel_for(0, 100, 1, [&](size_t) {
+            ++counter;
+        });
+    });
+
+    EXPECT_EQ(counter.load(), 800);
+}
+
+TEST_F(ThreadPoolTest, ParallelForPropagatesException) {
+    ThreadPool pool(4);
+
+    EXPECT_THROW(pool.parallel_for(0, 1000, 1, [](size_t i) {
+        if (i == 500) {
+            throw std::runtime_error("parallel_for failure");
+        }
+    }), std::runtime_error);
+}
+
+TEST_F(ThreadPoolTest, ParallelReduceAndTransform) {
+    ThreadPool pool(4);
+
+    auto sum = pool.parallel_reduce(size_t{0}, size_t{100001}, 64, int64_t{0},
+                                    [](size_t i) { return static_cast<int64_t>(i); },
+                                    [](int64_t a, int64_t b) { return a + b; });
+    EXPECT_EQ(sum, int64_t{100000} * 100001 / 2);
+
+    // 非交换的归约（字符串拼接）仍然保持原始顺序
+    auto joined = pool.parallel_reduce(size_t{0}, size_t{10}, 1, std::string(),
+                                       [](size_t i) { return std::to_string(i); },
+                                       [](std::string a, const std::string &b) { return a + b; });
+    EXPECT_EQ(joined, "0123456789");
+
+    std::vector<int> input(1000);
+    std::iota(input.begin(), input.end(), 0);
+    std::vector<int> output(input.size());
+    pool.parallel_transform(input.begin(), input.end(), output.begin(), 32, [](int v) {
+        return v * v;
+    });
+    for (size_t i = 0; i < input.size(); ++i) {
+        ASSERT_EQ(output[i], input[i] * input[i]);
+    }
+}
+
+TEST_F(ThreadPoolTest, AsyncThenChain) {
+    ThreadPool pool(2);
+
+    auto future = pool.async([] {
+        return 20;
+    }).then([](int value) {
+        return value + 1;
+    }).then([](int value) {
+        return std::to_string(value * 2);
+    });
+
+    EXPECT_EQ(future.get(), "42");
+
+    // void 前驱与 void 续体
+    std::atomic<int> counter{0};
+    auto done = pool.async([&counter] {
+        ++counter;
+    }).then([&counter] {
+        ++counter;
+    });
+    done.get();
+    EXPECT_EQ(counter.load(), 2);
+}
+
+TEST_F(ThreadPoolTest, AsyncThenPropagatesException) {
+    ThreadPool pool(2);
+    std::atomic_bool continuation_ran{false};
+
+    auto future = pool.async([]() -> int {
+        throw std::runtime_error("Test exception");
+    }).then([&continuation_ran](int value) {
+        continuation_ran = true;
+        return value;
+    });
+
+    EXPECT_THROW(future.get(), std::runtime_error);
+    EXPECT_FALSE(continuation_ran.load());
+}
+
+TEST_F(ThreadPoolTest, TaskGraphRespectsDependencies) {
+    ThreadPool pool(4, ThreadPool::SchedulingMode::WorkStealing);
+    constexpr size_t COLUMNS = 16;
+    std::vector<std::atomic_bool> detected(COLUMNS);
+    std::vector<std::atomic_bool> converted(COLUMNS);
+    std::atomic_bool order_violated{false};
+    std::atomic<size_t> assembled_columns{0};
+
+    TaskGraph graph;
+    auto assemble = graph.emplace([&] {
+        for (size_t col = 0; col < COLUMNS; ++col) {
+            if (converted[col]) {
+                ++assembled_columns;
+            }
+        }
+    });
+    for (size_t col = 0; col < COLUMNS; ++col) {
+        auto detect = graph.emplace([&, col] {
+            detected[col] = true;
+        });
+        auto convert = detect.then([&, col] {
+            if (!detected[col]) {
+                order_violated = true;
+            }
+            converted[col] = true;
+        });
+        convert.precede(assemble);
+    }
+
+    graph.run(pool).get();
+
+    EXPECT_FALSE(order_violated.load());
+    EXPECT_EQ(assembled_columns.load(), COLUMNS);
+}
+
+TEST_F(ThreadPoolTest, TaskGraphStartsNodeWhenOwnInputsReady) {
+    ThreadPool pool(2);
+    std::promise<void> slow_gate;
+    auto slow_gate_future = slow_gate.get_future().share();
+    std::promise<void> fast_done;
+    auto fast_done_future = fast_done.get_future();
+
+    // 慢分支阻塞时，快分支的后继不必等待慢分支
+    TaskGraph graph;
+    graph.emplace([slow_gate_future] {
+        slow_gate_future.wait();
+    });
+    graph.emplace([] {
+    }).then([&fast_done] {
+        fast_done.set_value();
+    });
+
+    auto run = graph.run(pool);
+    EXPECT_EQ(fast_done_future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    slow_gate.set_value();
+    run.get();
+}
+
+TEST_F(ThreadPoolTest, TaskGraphErrors) {
+    ThreadPool pool(2);
+
+    TaskGraph failing;
+    std::atomic_bool skipped_ran{false};
+    failing.emplace([] {
+        throw std::runtime_error("node failure");
+    }).then([&skipped_ran] {
+        skipped_ran = true;
+    });
+    EXPECT_THROW(failing.run(pool).get(), std::runtime_error);
+    EXPECT_FALSE(skipped_ran.load());
+
+    TaskGraph cyclic;
+    auto a = cyclic.emplace([] {
+    });
+    auto b = a.then([] {
+    });
+    b.precede(a);
+    EXPECT_THROW(cyclic.run(pool), std::logic_error);
+}
+
+TEST_F(ThreadPoolTest, CancelledTasksAreDiscarded) {
+    ThreadPool pool(1);
+
+    // 阻塞唯一的工作线程，让后续任务留在队列中
+    std::promise<void> gate;
+    std::promise<void> started;
+    auto gate_future = gate.get_future().share();
+    pool.post([gate_future, &started] {
+        started.set_value();
+        gate_future.wait();
+    });
+    started.get_future().wait();
+
+    CancellationSource source;
+    std::atomic_int executed{0};
+    std::vector<std::future<void> > futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.submit([&executed] { ++executed; }, source.token()));
+    }
+    auto unrelated = pool.submit([] { return 7; });
+
+    source.cancel();
+    gate.set_value();
+    pool.waitForAll();
+
+    for (auto &future: futures) {
+        EXPECT_THROW(future.get(), TaskCancelledException);
+    }
+    EXPECT_EQ(unrelated.get(), 7);
+    EXPECT_EQ(executed.load(), 0);
+    EXPECT_EQ(pool.getStats().tasks_cancelled.load(), 100u);
+}
+
+TEST_F(ThreadPoolTest, ExpiredDeadlineSkipsTask) {
+    ThreadPool pool(1, ThreadPool::SchedulingMode::WorkStealing);
+
+    // 本地队列后进先出，必须确认阻塞任务已开始执行，后续任务才会留在队列中
+    std::promise<void> gate;
+    std::promise<void> started;
+    auto gate_future = gate.get_future().share();
+    pool.post([gate_future, &started] {
+        started.set_value();
+        gate_future.wait();
+    });
+    started.get_future().wait();
+
+    ThreadPool::TaskOptions options;
+    options.deadline = ThreadPool::Clock::now() + std::chrono::milliseconds(10);
+    std::atomic_bool ran{false};
+    auto expired = pool.submit([&ran] { ran = true; }, options);
+    auto chained = pool.async([] { return 1; }, options).then([](int value) { return value + 1; });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    gate.set_value();
+
+    EXPECT_THROW(expired.get(), TaskCancelledException);
+    EXPECT_THROW(chained.get(), TaskCancelledException);
+    EXPECT_FALSE(ran.load());
+}
+
+TEST_F(ThreadPoolTest, ShutdownReportsPendingTasksAsCancelled) {
+    auto pool = std::make_unique<ThreadPool>(1);
+
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+    std::promise<void> started;
+    pool->post([gate_future, &started] {
+        started.set_value();
+        gate_future.wait();
+    });
+    started.get_future().wait();
+    auto pending = pool->submit([] { return 1; });
+
+    std::thread releaser([&gate] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate.set_value();
+    });
+    pool->shutdown();
+    releaser.join();
+
+    EXPECT_THROW(pending.get(), TaskCancelledException);
+}
+
+TEST_F(ThreadPoolTest, ShutdownRacingWithSubmitResolvesEveryFuture) {
+    for (int round = 0; round < 20; ++round) {
+        ThreadPool pool(2);
+        std::atomic_bool go{false};
+        std::vector<std::vector<std::future<int> > > futures(4);
+        std::vector<std::thread> submitters;
+        for (auto &list: futures) {
+            submitters.emplace_back([&pool, &go, &list] {
+                while (!go) {
+                    std::this_thread::yield();
+                }
+                for (int i = 0; i < 200; ++i) {
+                    list.push_back(pool.submit([i] { return i; }));
+                }
+            });
+        }
+        go = true;
+        pool.shutdown();
+        for (auto &submitter: submitters) {
+            submitter.join();
+        }
+
+        // 与 shutdown 交错的提交要么被拒绝，要么在清空队列时被丢弃，future 都应立即就绪
+        for (auto &list: futures) {
+            for (auto &future: list) {
+                ASSERT_EQ(future.wait_for(0ms), std::future_status::ready);
+            }
+        }
+        pool.waitForAll();
+    }
+}
+
+TEST_F(ThreadPoolTest, TaskGraphCancellation) {
+    ThreadPool pool(2);
+    CancellationSource source;
+
+    std::atomic_bool second_ran{false};
+    TaskGraph graph;
+    graph.emplace([&source] {
+        source.cancel();
+    }).then([&second_ran] {
+        second_ran = true;
+    });
+
+    EXPECT_THROW(graph.run(pool, source.token()).get(), TaskCancelledException);
+    EXPECT_FALSE(second_ran.load());
+}
+
+TEST_F(ThreadPoolTest, ConfigThreadCountNameAndStack) {
+    ThreadPool::Config config;
+    config.thread_count = 3;
+    config.mode = ThreadPool::SchedulingMode::WorkStealing;
+    config.thread_name_prefix = "CfgTest";
+    config.stack_size = 8 * 1024 * 1024;
+    ThreadPool pool(config);
+    EXPECT_EQ(pool.threadCount(), 3u);
+
+    // 较大的栈上数组，验证自定义栈大小下任务正常运行
+    auto result = pool.submit([] {
+        volatile char buffer[2 * 1024 * 1024];
+        buffer[0] = 1;
+        buffer[sizeof(buffer) - 1] = 2;
+        return buffer[0] + buffer[sizeof(buffer) - 1];
+    });
+    EXPECT_EQ(result.get(), 3);
+
+#ifdef __linux__
+    auto name = pool.submit([] {
+        char buffer[16] = {};
+        pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+        return std::string(buffer);
+    });
+    EXPECT_EQ(name.get().rfind("CfgTest-", 0), 0u);
+#endif
+}
+
+TEST_F(ThreadPoolTest, ConfigAffinityAndNodeGroups) {
+    const auto nodes = ThreadPlatform::numaNodes();
+    ASSERT_FALSE(nodes.empty());
+    ASSERT_FALSE(nodes.front().cpus.empty());
+
+#ifdef __linux__
+    ThreadPool::Config config;
+    config.thread_count = 2;
+    const int cpu = nodes.front().cpus.front();
+    config.affinity = {{cpu}};
+    ThreadPool pinned(config);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(pinned.submit([] { return sched_getcpu(); }).get(), cpu);
+    }
+#endif
+
+    ThreadPool::Config grouped;
+    grouped.thread_count = 4;
+    grouped.numa_aware = true;
+    ThreadPool numa_pool(grouped);
+    EXPECT_EQ(numa_pool.submit([] { return 1; }).get(), 1);
+
+    ThreadPoolGroup group;
+    EXPECT_EQ(group.nodeCount(), nodes.size());
+    std::atomic_int counter{0};
+    for (size_t i = 0; i < 100; ++i) {
+        group.poolFor(i).post([&counter] { ++counter; });
+    }
+    group.waitForAll();
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST_F(ThreadPoolTest, LatencyHistogramBuckets) {
+    for (std::uint64_t value: {0ull, 1ull, 7ull, 8ull, 15ull, 16ull, 1000ull, 123456789ull, ~0ull}) {
+        const size_t index = HistogramSnapshot::bucketIndex(value);
+        ASSERT_LT(index, HistogramSnapshot::BUCKET_COUNT);
+        EXPECT_LE(HistogramSnapshot::bucketLowerBound(index), value);
+        EXPECT_GE(HistogramSnapshot::bucketUpperBound(index), value);
+    }
+
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value);
+    }
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 1000u);
+    EXPECT_EQ(snapshot.max, 1000u);
+    EXPECT_DOUBLE_EQ(snapshot.mean(), 500.5);
+    // 子桶相对误差不超过 1/8
+    EXPECT_NEAR(static_cast<double>(snapshot.percentile(0.5)), 500.0, 500.0 / 8);
+    EXPECT_NEAR(static_cast<double>(snapshot.percentile(0.99)), 990.0, 990.0 / 8);
+    EXPECT_EQ(snapshot.percentile(1.0), 1000u);
+}
+
+TEST_F(ThreadPoolTest, TelemetrySnapshot) {
+    ThreadPool pool(2);
+    for (int i = 0; i < 10; ++i) {
+        pool.post([] { std::this_thread::sleep_for(std::chrono::milliseconds(2)); },
+                  ThreadPool::TaskPriority::High);
+    }
+    for (int i = 0; i < 200; ++i) {
+        pool.post([] {
+        }, ThreadPool::TaskPriority::Low);
+    }
+    pool.waitForAll();
+
+    auto snapshot = pool.telemetry();
+    const auto high = static_cast<size_t>(ThreadPool::TaskPriority::High);
+    const auto low = static_cast<size_t>(ThreadPool::TaskPriority::Low);
+    EXPECT_EQ(snapshot.run_time[high].count, 10u);
+    EXPECT_EQ(snapshot.run_time[low].count, 200u);
+    EXPECT_EQ(snapshot.queue_wait[low].count, 200u);
+    EXPECT_GE(snapshot.run_time[high].percentile(0.5), 2000000u);
+    EXPECT_GT(snapshot.queue_depth.count, 0u);
+
+    ASSERT_EQ(snapshot.workers.size(), 2u);
+    std::uint64_t tasks_run = 0;
+    for (const auto &worker: snapshot.workers) {
+        tasks_run += worker.tasks_run;
+        EXPECT_GE(worker.utilization, 0.0);
+        EXPECT_LE(worker.utilization, 1.0);
+    }
+    EXPECT_EQ(tasks_run, 210u);
+}
+
+TEST_F(ThreadPoolTest, IdleWorkersStayAsleep) {
+    for (auto mode: {ThreadPool::SchedulingMode::SharedQueue, ThreadPool::SchedulingMode::WorkStealing}) {
+        ThreadPool pool(4, mode);
+        pool.post([] {
+        });
+        pool.waitForAll();
+        // 等工作线程自旋结束进入休眠
+        std::this_thread::sleep_for(50ms);
+
+        // 没有新任务时不应有任何唤醒
+        const auto before = pool.idleWakeups();
+        std::this_thread::sleep_for(200ms);
+        EXPECT_EQ(pool.idleWakeups(), before);
+
+        // 所有线程都在休眠，新任务必须唤醒其中一个才能执行
+        pool.post([] {
+        });
+        pool.waitForAll();
+        EXPECT_GT(pool.idleWakeups(), before);
+    }
+}
+
+TEST_F(ThreadPoolTest, TelemetryCanBeDisabled) {
+    ThreadPool::Config config;
+    config.thread_count = 2;
+    config.telemetry = false;
+    ThreadPool pool(config);
+    for (int i = 0; i < 100; ++i) {
+        pool.post([] {
+        });
+    }
+    pool.waitForAll();
+
+    // 关闭遥测后不记录直方图和各线程的执行次数
+    auto snapshot = pool.telemetry();
+    const auto normal = static_cast<size_t>(ThreadPool::TaskPriority::Normal);
+    EXPECT_EQ(snapshot.run_time[normal].count, 0u);
+    EXPECT_EQ(snapshot.queue_wait[normal].count, 0u);
+    ASSERT_EQ(snapshot.workers.size(), 2u);
+    for (const auto &worker: snapshot.workers) {
+        EXPECT_EQ(worker.tasks_run, 0u);
+    }
+}